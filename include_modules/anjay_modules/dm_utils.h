@@ -213,6 +213,25 @@ bool _anjay_dm_handler_implemented(anjay_t *anjay,
                                    const anjay_dm_module_t *current_module,
                                    size_t handler_offset);
 
+/**
+ * Checks whether a whole Instance may be read using the instance_read handler
+ * instead of calling resource_present and resource_read for each Resource.
+ * This is not the case if instance_read is not implemented, or if it would
+ * bypass an overlay module that implements any of the per-Resource handlers.
+ *
+ * @param anjay          Anjay object to operate on
+ *
+ * @param obj_ptr        Object whose handlers to check
+ *
+ * @param current_module The module after which to start search for handlers in
+ *                       the overlays
+ *
+ * @return Boolean value determining whether instance_read may be called
+ */
+bool _anjay_dm_instance_read_usable(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    const anjay_dm_module_t *current_module);
+
 int _anjay_dm_object_read_default_attrs(anjay_t *anjay,
                                         const anjay_dm_object_def_t *const *obj_ptr,
                                         anjay_ssid_t ssid,
@@ -284,6 +303,12 @@ int _anjay_dm_resource_read(anjay_t *anjay,
                             anjay_rid_t rid,
                             anjay_output_ctx_t *ctx,
                             const anjay_dm_module_t *current_module);
+int _anjay_dm_instance_read(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            const uint8_t *requested_rids,
+                            anjay_output_ctx_t *ctx,
+                            const anjay_dm_module_t *current_module);
 int _anjay_dm_resource_write(anjay_t *anjay,
                              const anjay_dm_object_def_t *const *obj_ptr,
                              anjay_iid_t iid,
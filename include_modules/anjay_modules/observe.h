@@ -24,9 +24,17 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 
 void _anjay_observe_gc(anjay_t *anjay);
 
+/**
+ * Marks the effective attributes cached for all Observe entries as outdated.
+ * Shall be called whenever the attributes might have been changed in a way
+ * that is not signalled through the notification queue.
+ */
+void _anjay_observe_invalidate_attrs(anjay_t *anjay);
+
 #else // WITH_OBSERVE
 
 #define _anjay_observe_gc(...) ((void) 0)
+#define _anjay_observe_invalidate_attrs(...) ((void) 0)
 
 #endif // WITH_OBSERVE
 
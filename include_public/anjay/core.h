@@ -23,6 +23,7 @@
 #include <avsystem/commons/coap/tx_params.h>
 #include <avsystem/commons/list.h>
 #include <avsystem/commons/net.h>
+#include <avsystem/commons/stream.h>
 #include <avsystem/commons/time.h>
 
 #ifdef __cplusplus
@@ -87,6 +88,55 @@ void anjay_smsdrv_cleanup(anjay_smsdrv_t **smsdrv_ptr);
         /* .max_retransmit = */ 0          \
     }
 
+/**
+ * Limits of the queue of notifications that are waiting to be sent, e.g.
+ * because the server is offline or the notifications are being stored in
+ * accordance with the Notification Storing When Disabled or Offline resource.
+ */
+typedef struct {
+    /**
+     * Maximum number of queued notification values. 0 means no limit.
+     */
+    size_t max_values;
+
+    /**
+     * Maximum total size, in bytes, of encoded payloads of queued notification
+     * values. 0 means no limit.
+     */
+    size_t max_bytes;
+} anjay_notify_queue_limits_t;
+
+/**
+ * Action taken when storing a new notification value would exceed one of the
+ * limits configured using @ref anjay_notify_queue_limits_t .
+ *
+ * Values may only be dropped from the queue of the server connection the new
+ * value is destined to. Notifications that are already sent and waiting for
+ * an Acknowledgement, as well as error notifications that cancel
+ * an observation, are never dropped.
+ */
+typedef enum {
+    /**
+     * The oldest queued value of the same observation is dropped. If there is
+     * no such value, the oldest queued value of any other observation is
+     * dropped instead. This is repeated until the new value fits.
+     */
+    ANJAY_NOTIFY_QUEUE_DROP_OLDEST,
+
+    /**
+     * Queued values that are superseded by a newer value of the same
+     * observation (including the one being stored) are dropped, oldest first,
+     * so that only the latest value of each observation is retained. If this
+     * is not enough, the new value is not stored.
+     */
+    ANJAY_NOTIFY_QUEUE_KEEP_LATEST,
+
+    /**
+     * The new value is not stored.
+     */
+    ANJAY_NOTIFY_QUEUE_REJECT
+} anjay_notify_queue_policy_t;
+
 typedef struct anjay_configuration {
     /**
      * Endpoint name as presented to the LwM2M server. Must be non-NULL, or
@@ -134,6 +184,19 @@ typedef struct anjay_configuration {
      */
     size_t msg_cache_size;
 
+    /**
+     * Number of bytes reserved for caching block-wise responses to Read and
+     * Discover requests. If not 0, the whole payload of each response that
+     * does not fit in a single message is retained for EXCHANGE_LIFETIME, and
+     * further blocks of it requested by the server in separate exchanges are
+     * sent from the cache, instead of generating the whole response again.
+     * Each such block-wise response carries an ETag option then.
+     *
+     * NOTE: at most one response is cached for each server connection.
+     * Responses larger than this limit are not cached at all.
+     */
+    size_t block_response_cache_size;
+
     /**
      * Socket configuration to use when creating UDP sockets.
      *
@@ -228,6 +291,94 @@ typedef struct anjay_configuration {
      * bootstrap sequence.
      */
     bool disable_server_initiated_bootstrap;
+
+    /**
+     * Number of scheduler jobs for which storage is preallocated when the
+     * Anjay object is created. Jobs are created frequently (e.g. for each
+     * notification or retransmission), so using a preallocated pool avoids
+     * repeated heap allocations during normal operation.
+     *
+     * Jobs whose data does not fit in a pool slot (see the
+     * SCHED_POOL_SLOT_DATA_SIZE CMake option), as well as ones scheduled when
+     * the pool is exhausted, are allocated on the heap as usual. See
+     * @ref anjay_get_sched_pool_hits and @ref anjay_get_sched_pool_misses .
+     *
+     * If 0, no pool is preallocated and all jobs are allocated on the heap.
+     */
+    size_t sched_pool_size;
+
+    /**
+     * Maximum number of Confirmable notifications that may be awaiting
+     * an Acknowledgement at the same time on a single server connection
+     * (NSTART, as defined in RFC 7252, section 4.7).
+     *
+     * Values greater than 1 allow the queue of stored notifications to be
+     * delivered in fewer round trips, e.g. after a Queue Mode connection comes
+     * back online. Each notification is retransmitted independently.
+     *
+     * If 0, the value of 1 recommended by RFC 7252 is used.
+     */
+    size_t max_notifications_in_flight;
+
+    /**
+     * If set to true, whenever several values of the same observed path are
+     * waiting to be sent (e.g. because the resource changed multiple times
+     * while the server was unreachable), only the newest one is sent when the
+     * queue is flushed. Notifications for different observations are then
+     * sent back-to-back, one value per message.
+     *
+     * This is applied independently of <c>notify_queue_overflow_policy</c>,
+     * which only governs what happens when the queue limits are reached.
+     *
+     * This reduces the number of packets and radio wake-ups, at the cost of
+     * not delivering the intermediate values stored in accordance with the
+     * Notification Storing When Disabled or Offline resource.
+     *
+     * See also @ref anjay_get_num_notifications_sent ,
+     * @ref anjay_get_notifications_tx_bytes and
+     * @ref anjay_get_num_coalesced_notifications .
+     */
+    bool coalesce_notifications;
+
+    /**
+     * If set to true, effective attributes (pmin, pmax, gt, lt, st) of each
+     * observed path are cached, instead of being queried from the data model
+     * each time a notification is considered.
+     *
+     * The cache is invalidated whenever attributes are changed by a Write
+     * Attributes request, when the Server object or the set of instances of
+     * any object changes, and when the Attribute Storage module is purged or
+     * restored. It is thus only safe to enable this option if attribute
+     * handlers of all objects return values that can only change as a result
+     * of one of these events. Otherwise, @ref anjay_notify_instances_changed
+     * may be called after changing the attributes to force recalculation.
+     */
+    bool cache_observe_attributes;
+
+    /**
+     * Limits of the queue of notifications waiting to be sent, applied
+     * separately to each server connection. By default, the queue is
+     * unlimited.
+     */
+    anjay_notify_queue_limits_t notify_queue_limits_per_connection;
+
+    /**
+     * Limits of the queues of notifications waiting to be sent, applied to
+     * the sum of queues of all server connections. By default, the queues are
+     * unlimited.
+     *
+     * If the same value is queued for multiple connections in the same
+     * format, its payload is shared and counted towards <c>max_bytes</c> only
+     * once. The per-connection limits count the payload of each queued value.
+     */
+    anjay_notify_queue_limits_t notify_queue_limits_total;
+
+    /**
+     * Action taken when a limit of the notification queue would be exceeded.
+     *
+     * See also @ref anjay_get_num_dropped_notifications .
+     */
+    anjay_notify_queue_policy_t notify_queue_overflow_policy;
 } anjay_configuration_t;
 
 /**
@@ -628,6 +779,76 @@ int anjay_exit_offline(anjay_t *anjay);
  */
 bool anjay_all_connections_failed(anjay_t *anjay);
 
+/**
+ * Dumps the state of all observations to @p out_stream: observed paths with
+ * their tokens, the last notified values used to evaluate the pmin, pmax, gt,
+ * lt and st attributes, and notifications queued but not yet acknowledged.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param out_stream    Stream to write to.
+ *
+ * @returns 0 on success, a negative value in case of error. If Observe support
+ *          is not compiled in, nothing is written and 0 is returned.
+ */
+int anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out_stream);
+
+/**
+ * Replaces the state of all observations with one previously stored using
+ * @ref anjay_observe_persist, e.g. in a previous run of the application.
+ *
+ * Notification timers are resumed according to the timestamps of the restored
+ * values, and queued notifications are sent as soon as their servers are
+ * online. This is only useful if the servers also retained the observations,
+ * i.e. if they consider the client to still be registered.
+ *
+ * Observations for servers that no longer exist are removed when the server
+ * list is next reloaded.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param in_stream Stream to read from.
+ *
+ * @returns 0 on success, a negative value in case of error. In the latter case,
+ *          the current state of observations is left intact. If Observe
+ *          support is not compiled in, nothing is read and 0 is returned.
+ */
+int anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in_stream);
+
+/**
+ * Dumps the DTLS sessions most recently negotiated with LwM2M servers into the
+ * @p out_stream . Together with @ref anjay_dtls_sessions_restore, this allows
+ * the sessions to be resumed after a restart of the application, avoiding full
+ * handshakes.
+ *
+ * At most <c>DTLS_SESSION_CACHE_SIZE</c> sessions (a CMake option) are cached,
+ * keyed by server hostname and port.
+ *
+ * Note that the persisted data contains session keys, and shall be stored
+ * with appropriate care.
+ *
+ * @param anjay      Anjay object to operate on.
+ * @param out_stream Stream to write to.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_dtls_sessions_persist(anjay_t *anjay,
+                                avs_stream_abstract_t *out_stream);
+
+/**
+ * Replaces the cached DTLS sessions with ones previously stored using
+ * @ref anjay_dtls_sessions_persist. The restored sessions are offered during
+ * subsequent handshakes with servers with matching hostname and port. To take
+ * effect for initial connections, it shall be called before the first call to
+ * @ref anjay_sched_run.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param in_stream Stream to read from.
+ *
+ * @returns 0 on success, a negative value in case of error. In the latter case,
+ *          the cached sessions are left intact.
+ */
+int anjay_dtls_sessions_restore(anjay_t *anjay,
+                                avs_stream_abstract_t *in_stream);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
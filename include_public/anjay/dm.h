@@ -426,6 +426,57 @@ typedef int anjay_dm_resource_read_t(anjay_t *anjay,
                                      anjay_rid_t rid,
                                      anjay_output_ctx_t *ctx);
 
+/**
+ * Checks whether a Resource has been requested in a call to the
+ * @ref anjay_dm_instance_read_t handler.
+ *
+ * @param RequestedRids Bitmap passed to the handler.
+ * @param Index         Index of the Resource ID in the
+ *                      <c>supported_rids.rids</c> array of the Object.
+ */
+#define ANJAY_DM_RID_REQUESTED(RequestedRids, Index) \
+        (!!((RequestedRids)[(Index) / 8] & (1 << ((Index) % 8))))
+
+/**
+ * A handler that reads values of multiple Resources of an Object Instance in a
+ * single call. It is optional, and may be implemented in addition to
+ * @ref anjay_dm_resource_read_t for Objects whose Instances are cheaper to
+ * read as a whole, e.g. ones backed by a hardware register block or a database
+ * row.
+ *
+ * If this handler is implemented, it is used instead of calling
+ * @ref anjay_dm_resource_present_t and @ref anjay_dm_resource_read_t for each
+ * Resource when reading (or observing) a whole Object Instance or Object.
+ *
+ * For each requested Resource that is PRESENT, the handler shall call
+ * @ref anjay_ret_resource_id , followed by exactly one of the
+ * <c>anjay_ret_*</c> functions that return a value. Resources shall be returned
+ * in order of ascending Resource IDs. Requested Resources that are not present
+ * shall be skipped.
+ *
+ * @param anjay          Anjay object to operate on.
+ * @param obj_ptr        Object definition pointer, as passed to
+ *                       @ref anjay_register_object .
+ * @param iid            Object Instance ID.
+ * @param requested_rids Bitmap of the requested Resources. Bit <c>i</c> of the
+ *                       bitmap (see @ref ANJAY_DM_RID_REQUESTED) corresponds to
+ *                       <c>(*obj_ptr)->supported_rids.rids[i]</c>. Resources
+ *                       that are not readable according to
+ *                       @ref anjay_dm_resource_operations_t are never
+ *                       requested.
+ * @param ctx            Output context to write the Resource values to.
+ *
+ * @returns This handler should return:
+ * - 0 on success,
+ * - a negative value in case of error, with the same semantics as for
+ *   @ref anjay_dm_resource_read_t .
+ */
+typedef int anjay_dm_instance_read_t(anjay_t *anjay,
+                                     const anjay_dm_object_def_t *const *obj_ptr,
+                                     anjay_iid_t iid,
+                                     const uint8_t *requested_rids,
+                                     anjay_output_ctx_t *ctx);
+
 /**
  * A handler that writes the Resource value.
  *
@@ -707,6 +758,9 @@ typedef struct {
     anjay_dm_transaction_commit_t *transaction_commit;
     /** Rollback changes made in a transaction, @ref anjay_dm_transaction_rollback_t */
     anjay_dm_transaction_rollback_t *transaction_rollback;
+
+    /** Get values of multiple Resources at once (optional), @ref anjay_dm_instance_read_t */
+    anjay_dm_instance_read_t *instance_read;
 } anjay_dm_handlers_t;
 
 /** A simple array-plus-size container for a list of supported Resource IDs. */
@@ -746,6 +800,30 @@ typedef struct {
         }
 #endif // __cplusplus
 
+/**
+ * Optional static information about the Resources listed in
+ * @ref anjay_dm_supported_rids_t , for Objects whose shape does not change at
+ * runtime. It allows the library to perform presence and operation checks
+ * without calling the corresponding handlers.
+ *
+ * Both fields refer to Resources by their index in the
+ * <c>supported_rids.rids</c> array, and may be left NULL independently.
+ *
+ * This information only replaces the handlers of the Object itself. Handlers
+ * of installed overlay modules, if any, are still called.
+ */
+typedef struct {
+    /** Array of exactly <c>supported_rids.count</c> masks of operations
+     * supported on each Resource. If set, it is used instead of the
+     * @ref anjay_dm_resource_operations_t handler. */
+    const anjay_dm_resource_op_mask_t *operations;
+    /** Bitset of at least <c>(supported_rids.count + 7) / 8</c> bytes, in the
+     * same format as used by @ref ANJAY_DM_RID_REQUESTED . Resources whose bits
+     * are set are considered PRESENT in every Object Instance, and the
+     * @ref anjay_dm_resource_present_t handler is not called for them. */
+    const uint8_t *always_present;
+} anjay_dm_static_rids_info_t;
+
 /** A struct defining an LwM2M Object. */
 struct anjay_dm_object_def_struct {
     /** Object ID */
@@ -764,6 +842,10 @@ struct anjay_dm_object_def_struct {
 
     /** Handler callbacks for this object. */
     anjay_dm_handlers_t handlers;
+
+    /** Optional static information about supported Resources, see
+     * @ref anjay_dm_static_rids_info_t . */
+    anjay_dm_static_rids_info_t static_rids_info;
 };
 
 /**
@@ -187,6 +187,19 @@ int anjay_ret_bool(anjay_output_ctx_t *ctx, bool value);
  */
 int anjay_ret_objlnk(anjay_output_ctx_t *ctx, anjay_oid_t oid, anjay_iid_t iid);
 
+/**
+ * Assigns a Resource ID to the next value returned using one of the
+ * anjay_ret_* functions.
+ *
+ * This function may only be used in the @ref anjay_dm_instance_read_t handler.
+ *
+ * @param ctx Output context passed to the handler.
+ * @param rid Resource ID to assign.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_ret_resource_id(anjay_output_ctx_t *ctx, anjay_rid_t rid);
+
 /**
  * Begins returing an array of values from the data model handler.
  *
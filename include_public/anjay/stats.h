@@ -51,6 +51,62 @@ uint64_t anjay_get_num_incoming_retransmissions(anjay_t *anjay);
  */
 uint64_t anjay_get_num_outgoing_retransmissions(anjay_t *anjay);
 
+/**
+ * @returns the number of scheduler jobs whose storage was taken from the
+ *          preallocated pool configured with
+ *          <c>anjay_configuration_t::sched_pool_size</c>.
+ */
+uint64_t anjay_get_sched_pool_hits(anjay_t *anjay);
+
+/**
+ * @returns the number of scheduler jobs that had to be allocated on the heap,
+ *          either because the preallocated pool was exhausted or because the
+ *          job data did not fit in a pool slot.
+ */
+uint64_t anjay_get_sched_pool_misses(anjay_t *anjay);
+
+/**
+ * @returns the number of CoAP messages carrying Observe notifications sent by
+ *          the client, not counting retransmissions.
+ */
+uint64_t anjay_get_num_notifications_sent(anjay_t *anjay);
+
+/**
+ * @returns the total size of CoAP messages carrying Observe notifications sent
+ *          by the client, not counting retransmissions. Notifications sent
+ *          using block-wise transfers are not included.
+ */
+uint64_t anjay_get_notifications_tx_bytes(anjay_t *anjay);
+
+/**
+ * @returns the number of queued notification values that were not sent because
+ *          a newer value of the same observation was sent instead. Always 0
+ *          unless <c>anjay_configuration_t::coalesce_notifications</c> is set.
+ */
+uint64_t anjay_get_num_coalesced_notifications(anjay_t *anjay);
+
+/**
+ * @returns the number of notification values that were dropped or not stored
+ *          at all because of the limits set using
+ *          <c>anjay_configuration_t::notify_queue_limits_per_connection</c> and
+ *          <c>anjay_configuration_t::notify_queue_limits_total</c>.
+ */
+uint64_t anjay_get_num_dropped_notifications(anjay_t *anjay);
+
+/**
+ * @returns the number of successful DTLS handshakes performed with LwM2M
+ *          servers, including ones that resumed a previous session.
+ */
+uint64_t anjay_get_num_dtls_handshakes(anjay_t *anjay);
+
+/**
+ * @returns the number of successful DTLS handshakes with LwM2M servers that
+ *          resumed a previous session, instead of performing a full handshake.
+ *          Divided by @ref anjay_get_num_dtls_handshakes, it yields the session
+ *          resumption hit rate.
+ */
+uint64_t anjay_get_num_dtls_sessions_resumed(anjay_t *anjay);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
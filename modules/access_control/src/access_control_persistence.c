@@ -213,6 +213,11 @@ int anjay_access_control_restore(anjay_t *anjay, avs_stream_abstract_t *in) {
     if (!(retval = restore(anjay, ac, in))) {
         _anjay_access_control_clear_modified(ac);
         ac_log(INFO, "Access Control state restored");
+        if (anjay_notify_instances_changed(anjay,
+                                           ANJAY_DM_OID_ACCESS_CONTROL)) {
+            ac_log(WARNING, "could not schedule notifications about restored "
+                            "Access Control state");
+        }
     }
     return retval;
 }
@@ -370,6 +370,16 @@ static int set_acl(anjay_t *anjay,
     if (!ac_instance_needs_inserting) {
         if (!result) {
             _anjay_access_control_mark_modified(ac);
+            anjay_notify_queue_t dm_changes = NULL;
+            if ((result = _anjay_notify_queue_resource_change(
+                            &dm_changes, ANJAY_DM_OID_ACCESS_CONTROL,
+                            ac_instance->iid, ANJAY_DM_RID_ACCESS_CONTROL_ACL))
+                    || (result = _anjay_notify_flush(anjay, &dm_changes))) {
+                ac_log(ERROR, "could not perform notifications about changed "
+                              "ACL of /%u/%u", ANJAY_DM_OID_ACCESS_CONTROL,
+                       ac_instance->iid);
+                _anjay_notify_clear_queue(&dm_changes);
+            }
         }
         return result;
     }
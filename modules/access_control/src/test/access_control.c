@@ -129,3 +129,58 @@ AVS_UNIT_TEST(access_control, set_acl) {
 
     DM_TEST_FINISH;
 }
+
+static bool action_allowed(anjay_t *anjay,
+                           anjay_iid_t iid,
+                           anjay_ssid_t ssid,
+                           anjay_request_action_t action) {
+    const anjay_action_info_t info = {
+        .oid = TEST_OID,
+        .iid = iid,
+        .ssid = ssid,
+        .action = action
+    };
+    return _anjay_access_control_action_allowed(anjay, &info);
+}
+
+AVS_UNIT_TEST(access_control, index_follows_set_acl) {
+    DM_TEST_INIT_GENERIC((&FAKE_SECURITY, &TEST), (1, 2), ());
+    const anjay_iid_t iid = 1;
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_install(anjay));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    _anjay_mock_dm_expect_instance_present(anjay, &TEST, iid, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_set_acl(
+            anjay, TEST_OID, iid, 2, ANJAY_ACCESS_MASK_READ));
+
+    AVS_UNIT_ASSERT_TRUE(action_allowed(anjay, iid, 2, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_FALSE(action_allowed(anjay, iid, 2, ANJAY_ACTION_WRITE));
+    AVS_UNIT_ASSERT_FALSE(action_allowed(anjay, iid, 1, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->access_control_index.obj);
+
+    // modifying an existing ACL updates the index in place
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_set_acl(
+            anjay, TEST_OID, iid, 2, ANJAY_ACCESS_MASK_WRITE));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->access_control_index.obj);
+    AVS_UNIT_ASSERT_FALSE(action_allowed(anjay, iid, 2, ANJAY_ACTION_READ));
+    AVS_UNIT_ASSERT_TRUE(action_allowed(anjay, iid, 2, ANJAY_ACTION_WRITE));
+
+    // adding an instance causes the index to be rebuilt, even before the
+    // scheduled notifications are flushed
+    _anjay_mock_dm_expect_instance_present(anjay, &TEST, 2, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_set_acl(
+            anjay, TEST_OID, 2, 1, ANJAY_ACCESS_MASK_EXECUTE));
+    AVS_UNIT_ASSERT_TRUE(anjay->access_control_index.scheduled_changes_pending);
+    AVS_UNIT_ASSERT_TRUE(action_allowed(anjay, 2, 1, ANJAY_ACTION_EXECUTE));
+    AVS_UNIT_ASSERT_FALSE(
+            anjay->access_control_index.scheduled_changes_pending);
+    AVS_UNIT_ASSERT_TRUE(action_allowed(anjay, iid, 2, ANJAY_ACTION_WRITE));
+
+    // changes already applied are not applied again when flushed
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->access_control_index.obj);
+    AVS_UNIT_ASSERT_TRUE(action_allowed(anjay, 2, 1, ANJAY_ACTION_EXECUTE));
+
+    DM_TEST_FINISH;
+}
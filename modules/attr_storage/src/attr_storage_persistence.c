@@ -23,6 +23,7 @@
 
 #include <anjay_modules/dm_utils.h>
 #include <anjay_modules/io_utils.h>
+#include <anjay_modules/observe.h>
 #include <anjay_modules/raw_buffer.h>
 
 #include "mod_attr_storage.h"
@@ -461,6 +462,7 @@ int anjay_attr_storage_restore(anjay_t *anjay, avs_stream_abstract_t *in) {
         fas_log(INFO, "Attribute Storage state restored");
     }
     fas->modified_since_persist = (retval != 0);
+    _anjay_observe_invalidate_attrs(anjay);
     return retval;
 }
 
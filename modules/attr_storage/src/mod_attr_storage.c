@@ -24,6 +24,7 @@
 #include <avsystem/commons/stream/stream_membuf.h>
 
 #include <anjay_modules/dm_utils.h>
+#include <anjay_modules/observe.h>
 #include <anjay_modules/raw_buffer.h>
 
 #include "mod_attr_storage.h"
@@ -125,6 +126,7 @@ void anjay_attr_storage_purge(anjay_t *anjay) {
     }
     _anjay_attr_storage_clear(fas);
     _anjay_attr_storage_mark_modified(fas);
+    _anjay_observe_invalidate_attrs(anjay);
 }
 
 //// HELPERS ///////////////////////////////////////////////////////////////////
@@ -16,9 +16,12 @@
 
 #include <anjay_config.h>
 
+#include <assert.h>
+
 #include <anjay_modules/raw_buffer.h>
 
 #include "access_control_utils.h"
+#include "anjay_core.h"
 #include "io_core.h"
 #include "servers_utils.h"
 
@@ -47,13 +50,6 @@ static int read_u32(anjay_t *anjay,
     return 0;
 }
 
-typedef struct {
-    anjay_oid_t oid;
-    anjay_iid_t oiid;
-    anjay_ssid_t ssid;
-    anjay_access_mask_t result;
-} get_mask_data_t;
-
 static int read_resources(anjay_t *anjay,
                           anjay_iid_t access_control_iid,
                           anjay_oid_t *out_oid,
@@ -75,127 +71,347 @@ static int read_resources(anjay_t *anjay,
     return 0;
 }
 
-static int get_mask_from_ctx(anjay_input_ctx_t *ctx,
-                             anjay_ssid_t *inout_ssid,
-                             anjay_access_mask_t *out_mask) {
+static int read_acl_from_ctx(
+        anjay_input_ctx_t *ctx,
+        AVS_LIST(anjay_access_control_index_acl_entry_t) *out_acl) {
     anjay_input_ctx_t *array_ctx = anjay_get_array(ctx);
     if (!array_ctx) {
         return -1;
     }
 
-    anjay_ssid_t ssid_lookup = *inout_ssid;
-    int32_t num_iterations = 0;
-    int result = 0;
+    AVS_LIST(anjay_access_control_index_acl_entry_t) *tail = out_acl;
+    int result;
     uint16_t current_ssid;
     int32_t current_mask;
-    *out_mask = ANJAY_ACCESS_MASK_NONE;
     while (!(result = anjay_get_array_index(array_ctx, &current_ssid))
             && !(result = anjay_get_i32(array_ctx, &current_mask))) {
-        if (current_ssid == ssid_lookup || current_ssid == 0) {
-            // Found an entry for the given ssid or the default ACL entry
-            *inout_ssid = current_ssid;
-            *out_mask = (anjay_access_mask_t) current_mask;
-            if (current_ssid) {
-                // not the default
-                return 0;
-            }
+        if (!AVS_LIST_INSERT_NEW(anjay_access_control_index_acl_entry_t,
+                                 tail)) {
+            anjay_log(ERROR, "out of memory");
+            return -1;
         }
-        ++num_iterations;
+        (*tail)->ssid = current_ssid;
+        (*tail)->mask = (anjay_access_mask_t) current_mask;
+        AVS_LIST_ADVANCE_PTR(&tail);
     }
-    // use the invalid SSID as a result if the ACL is empty
-    *inout_ssid = (num_iterations ? 0 : UINT16_MAX);
     return result == ANJAY_GET_INDEX_END ? 0 : result;
 }
 
-static int get_mask(anjay_t *anjay,
-                    const anjay_dm_object_def_t *const *obj,
+static int read_acl(anjay_t *anjay,
                     anjay_iid_t ac_iid,
-                    void *in_data) {
-    (void) obj;
-    get_mask_data_t *data = (get_mask_data_t *) in_data;
-    anjay_oid_t res_oid;
-    anjay_iid_t res_oiid;
-    anjay_ssid_t res_owner;
+                    AVS_LIST(anjay_access_control_index_acl_entry_t) *out_acl) {
+    const anjay_uri_path_t path =
+            MAKE_RESOURCE_PATH(ANJAY_DM_OID_ACCESS_CONTROL, ac_iid,
+                               ANJAY_DM_RID_ACCESS_CONTROL_ACL);
 
-    if (read_resources(anjay, ac_iid, &res_oid, &res_oiid, &res_owner)) {
+    anjay_input_ctx_t *ctx = _anjay_dm_read_as_input_ctx(anjay, &path);
+    if (!ctx) {
         return -1;
     }
+    int result = read_acl_from_ctx(ctx, out_acl);
+    _anjay_input_ctx_destroy(&ctx);
+    if (result) {
+        anjay_log(ERROR, "failed to read ACL!");
+        AVS_LIST_CLEAR(out_acl);
+    }
+    return result;
+}
 
-    if (res_oiid != data->oiid || res_oid != data->oid) {
-        return ANJAY_FOREACH_CONTINUE;
+static int index_entry_cmp(const void *left_, const void *right_) {
+    const anjay_access_control_index_entry_t *left =
+            (const anjay_access_control_index_entry_t *) left_;
+    const anjay_access_control_index_entry_t *right =
+            (const anjay_access_control_index_entry_t *) right_;
+    if (left->oid != right->oid) {
+        return left->oid < right->oid ? -1 : 1;
+    } else if (left->oiid != right->oiid) {
+        return left->oiid < right->oiid ? -1 : 1;
+    } else if (left->ac_iid != right->ac_iid) {
+        return left->ac_iid < right->ac_iid ? -1 : 1;
     }
+    return 0;
+}
 
-    const anjay_uri_path_t path =
-            MAKE_RESOURCE_PATH(ANJAY_DM_OID_ACCESS_CONTROL,
-                               (anjay_iid_t) ac_iid,
-                               ANJAY_DM_RID_ACCESS_CONTROL_ACL);
+static int index_entry_ptr_cmp(const void *left_, const void *right_) {
+    const anjay_access_control_index_entry_t *left =
+            *(const anjay_access_control_index_entry_t *const *) left_;
+    const anjay_access_control_index_entry_t *right =
+            *(const anjay_access_control_index_entry_t *const *) right_;
+    if (left->ac_iid != right->ac_iid) {
+        return left->ac_iid < right->ac_iid ? -1 : 1;
+    }
+    return 0;
+}
 
-    anjay_input_ctx_t *ctx = _anjay_dm_read_as_input_ctx(anjay, &path);
-    if (!ctx) {
-        return -1;
+void _anjay_access_control_index_cleanup(anjay_access_control_index_t *index) {
+    AVS_RBTREE_DELETE(&index->entries_by_ac_iid);
+    AVS_RBTREE_DELETE(&index->entries) {
+        AVS_LIST_CLEAR(&(*index->entries)->acl);
     }
+    index->obj = NULL;
+}
 
-    anjay_ssid_t found_ssid = data->ssid;
-    anjay_access_mask_t mask;
-    int result = get_mask_from_ctx(ctx, &found_ssid, &mask);
-    _anjay_input_ctx_destroy(&ctx);
+static int index_instance(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj,
+                          anjay_iid_t ac_iid,
+                          void *index_) {
+    (void) obj;
+    anjay_access_control_index_t *index =
+            (anjay_access_control_index_t *) index_;
 
+    AVS_RBTREE_ELEM(anjay_access_control_index_entry_t) entry =
+            AVS_RBTREE_ELEM_NEW(anjay_access_control_index_entry_t);
+    if (!entry) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    entry->ac_iid = ac_iid;
+    int result = read_resources(anjay, ac_iid, &entry->oid, &entry->oiid,
+                                &entry->owner);
     if (result) {
-        anjay_log(ERROR, "failed to read ACL!");
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
         return result;
     }
+    entry->acl_invalid = !!read_acl(anjay, ac_iid, &entry->acl);
 
-    if (found_ssid == data->ssid) {
-        // Found the ACL
-        data->result = mask;
-        return ANJAY_FOREACH_BREAK;
-    } else if (found_ssid == UINT16_MAX) {
-        if (res_owner == data->ssid) {
-            // Empty ACL, and given ssid is an owner of the instance
-            data->result = ANJAY_ACCESS_MASK_FULL & ~ANJAY_ACCESS_MASK_CREATE;
-            return ANJAY_FOREACH_BREAK;
-        }
-    } else if (!found_ssid) {
-        // Default ACL
-        data->result = mask;
+    AVS_RBTREE_ELEM(anjay_access_control_index_entry_t *) entry_ptr =
+            AVS_RBTREE_ELEM_NEW(anjay_access_control_index_entry_t *);
+    if (!entry_ptr) {
+        anjay_log(ERROR, "out of memory");
+        AVS_LIST_CLEAR(&entry->acl);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
+        return -1;
     }
-    // Not the iid we were looking for
-    return ANJAY_FOREACH_CONTINUE;
+    *entry_ptr = entry;
+    if (AVS_RBTREE_INSERT(index->entries_by_ac_iid, entry_ptr) != entry_ptr) {
+        // should not happen, as instances are removed before being indexed
+        // again
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry_ptr);
+        AVS_LIST_CLEAR(&entry->acl);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
+        return -1;
+    }
+    // cannot fail, as the Access Control instance ID is a part of the key
+    AVS_RBTREE_INSERT(index->entries, entry);
+    return 0;
 }
 
-static anjay_access_mask_t
-access_control_mask(anjay_t *anjay,
-                    const anjay_action_info_t *info) {
-    get_mask_data_t data = {
-        .oid = info->oid,
-        .oiid = info->iid,
-        .ssid = info->ssid,
-        .result = ANJAY_ACCESS_MASK_NONE
+static void index_remove_instance(anjay_access_control_index_t *index,
+                                  anjay_iid_t ac_iid) {
+    anjay_access_control_index_entry_t key = {
+        .ac_iid = ac_iid
     };
+    anjay_access_control_index_entry_t *const key_ptr = &key;
+    AVS_RBTREE_ELEM(anjay_access_control_index_entry_t *) entry_ptr =
+            AVS_RBTREE_FIND(index->entries_by_ac_iid, &key_ptr);
+    if (entry_ptr) {
+        AVS_RBTREE_ELEM(anjay_access_control_index_entry_t) entry = *entry_ptr;
+        AVS_RBTREE_DELETE_ELEM(index->entries_by_ac_iid, &entry_ptr);
+        AVS_LIST_CLEAR(&entry->acl);
+        AVS_RBTREE_DELETE_ELEM(index->entries, &entry);
+    }
+}
 
-    const anjay_dm_object_def_t *const *obj =
-            _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_ACCESS_CONTROL);
-    if (_anjay_dm_foreach_instance(anjay, obj, get_mask, &data)) {
-        return ANJAY_ACCESS_MASK_NONE;
+/**
+ * Checks whether the Access Control object has uncommitted changes. The index
+ * shall not be built from such state, as it might still be rolled back without
+ * any notification.
+ */
+static bool in_transaction(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj) {
+    AVS_LIST(const anjay_dm_object_def_t *const *) it;
+    AVS_LIST_FOREACH(it, anjay->transaction_state.objs_in_transaction) {
+        if (*it == obj) {
+            return true;
+        }
     }
-    return data.result;
+    return false;
 }
 
-static bool can_instantiate(anjay_t *anjay,
-                            const anjay_action_info_t *info) {
-    get_mask_data_t data = {
-        .oid = info->oid,
-        .oiid = ANJAY_IID_INVALID,
-        .ssid = info->ssid,
-        .result = ANJAY_ACCESS_MASK_NONE
+static void update_index(anjay_t *anjay,
+                         const anjay_notify_queue_object_entry_t *ac_changes);
+
+/**
+ * Changes reported using anjay_notify_changed() and similar APIs are only
+ * flushed from the scheduler, so the ones that have been queued since the
+ * index was last updated need to be taken into account before using it.
+ */
+static void apply_scheduled_changes(anjay_t *anjay) {
+    AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, anjay->scheduled_notify.queue) {
+        if (it->oid == ANJAY_DM_OID_ACCESS_CONTROL) {
+            update_index(anjay, it);
+        }
+        if (it->oid >= ANJAY_DM_OID_ACCESS_CONTROL) {
+            return;
+        }
+    }
+}
+
+static anjay_access_control_index_t *get_index(anjay_t *anjay) {
+    anjay_access_control_index_t *index = &anjay->access_control_index;
+    const anjay_dm_object_def_t *const *obj = get_access_control(anjay);
+    if (index->scheduled_changes_pending) {
+        index->scheduled_changes_pending = false;
+        apply_scheduled_changes(anjay);
+    }
+    if (index->obj && index->obj == obj) {
+        return index;
+    }
+
+    _anjay_access_control_index_cleanup(index);
+    if (!obj) {
+        return NULL;
+    }
+    if (!(index->entries = AVS_RBTREE_NEW(anjay_access_control_index_entry_t,
+                                          index_entry_cmp))
+            || !(index->entries_by_ac_iid =
+                    AVS_RBTREE_NEW(anjay_access_control_index_entry_t *,
+                                   index_entry_ptr_cmp))) {
+        anjay_log(ERROR, "out of memory");
+        _anjay_access_control_index_cleanup(index);
+        return NULL;
+    }
+    if (_anjay_dm_foreach_instance(anjay, obj, index_instance, index)) {
+        anjay_log(ERROR, "could not build the Access Control index");
+        _anjay_access_control_index_cleanup(index);
+        return NULL;
+    }
+    if (!in_transaction(anjay, obj)) {
+        index->obj = obj;
+    }
+    return index;
+}
+
+static void update_index(anjay_t *anjay,
+                         const anjay_notify_queue_object_entry_t *ac_changes) {
+    anjay_access_control_index_t *index = &anjay->access_control_index;
+    assert(ac_changes->oid == ANJAY_DM_OID_ACCESS_CONTROL);
+    if (!index->obj) {
+        return;
+    }
+    if (ac_changes->instance_set_changes.instance_set_changed
+            || index->obj != get_access_control(anjay)
+            || in_transaction(anjay, index->obj)) {
+        _anjay_access_control_index_cleanup(index);
+        return;
+    }
+
+    int32_t last_iid = -1;
+    AVS_LIST(anjay_notify_queue_resource_entry_t) it;
+    AVS_LIST_FOREACH(it, ac_changes->resources_changed) {
+        if (it->iid == last_iid) {
+            continue;
+        }
+        last_iid = it->iid;
+        index_remove_instance(index, it->iid);
+        if (index_instance(anjay, index->obj, it->iid, index)) {
+            anjay_log(WARNING, "could not update the Access Control index for "
+                               "/%u/%u", ANJAY_DM_OID_ACCESS_CONTROL, it->iid);
+            _anjay_access_control_index_cleanup(index);
+            return;
+        }
+    }
+}
+
+void _anjay_access_control_index_update(
+        anjay_t *anjay,
+        anjay_notify_queue_t queue,
+        const anjay_notify_queue_object_entry_t *ac_changes) {
+    if (queue == anjay->scheduled_notify.queue) {
+        if (!anjay->access_control_index.scheduled_changes_pending) {
+            // already applied by an access check
+            return;
+        }
+        anjay->access_control_index.scheduled_changes_pending = false;
+    }
+    update_index(anjay, ac_changes);
+}
+
+void _anjay_access_control_index_changes_scheduled(anjay_t *anjay) {
+    anjay->access_control_index.scheduled_changes_pending = true;
+}
+
+/**
+ * Looks up the ACL entry for @p ssid, falling back to the default entry
+ * (SSID 0). Sets @p *out_found_ssid to the SSID of the entry found, 0 if the
+ * ACL is not empty but there is no matching entry, or UINT16_MAX if the ACL is
+ * empty.
+ */
+static void
+get_mask_from_acl(AVS_LIST(anjay_access_control_index_acl_entry_t) acl,
+                  anjay_ssid_t ssid,
+                  anjay_ssid_t *out_found_ssid,
+                  anjay_access_mask_t *out_mask) {
+    *out_found_ssid = (acl ? 0 : UINT16_MAX);
+    *out_mask = ANJAY_ACCESS_MASK_NONE;
+    AVS_LIST(anjay_access_control_index_acl_entry_t) it;
+    AVS_LIST_FOREACH(it, acl) {
+        if (it->ssid == ssid || it->ssid == 0) {
+            // Found an entry for the given ssid or the default ACL entry
+            *out_mask = it->mask;
+            if (it->ssid) {
+                // not the default
+                *out_found_ssid = it->ssid;
+                return;
+            }
+        }
+    }
+}
+
+static anjay_access_mask_t get_mask(anjay_t *anjay,
+                                    anjay_oid_t oid,
+                                    anjay_iid_t oiid,
+                                    anjay_ssid_t ssid) {
+    anjay_access_control_index_t *index = get_index(anjay);
+    if (!index) {
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+
+    const anjay_access_control_index_entry_t lower_bound = {
+        .oid = oid,
+        .oiid = oiid,
+        .ac_iid = 0
     };
+    anjay_access_mask_t result = ANJAY_ACCESS_MASK_NONE;
+    AVS_RBTREE_ELEM(anjay_access_control_index_entry_t) entry =
+            AVS_RBTREE_LOWER_BOUND(index->entries, &lower_bound);
+    for (; entry && entry->oid == oid && entry->oiid == oiid;
+            entry = AVS_RBTREE_ELEM_NEXT(entry)) {
+        if (entry->acl_invalid) {
+            return ANJAY_ACCESS_MASK_NONE;
+        }
 
-    const anjay_dm_object_def_t *const *obj =
-            _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_ACCESS_CONTROL);
-    if (_anjay_dm_foreach_instance(anjay, obj, get_mask, &data)) {
-        return false;
+        anjay_ssid_t found_ssid;
+        anjay_access_mask_t mask;
+        get_mask_from_acl(entry->acl, ssid, &found_ssid, &mask);
+
+        if (found_ssid == ssid) {
+            // Found the ACL
+            return mask;
+        } else if (found_ssid == UINT16_MAX) {
+            if (entry->owner == ssid) {
+                // Empty ACL, and given ssid is an owner of the instance
+                return ANJAY_ACCESS_MASK_FULL & ~ANJAY_ACCESS_MASK_CREATE;
+            }
+        } else if (!found_ssid) {
+            // Default ACL
+            result = mask;
+        }
     }
-    return data.result & ANJAY_ACCESS_MASK_CREATE;
+    return result;
+}
+
+static anjay_access_mask_t
+access_control_mask(anjay_t *anjay,
+                    const anjay_action_info_t *info) {
+    return get_mask(anjay, info->oid, info->iid, info->ssid);
+}
+
+static bool can_instantiate(anjay_t *anjay,
+                            const anjay_action_info_t *info) {
+    return get_mask(anjay, info->oid, ANJAY_IID_INVALID, info->ssid)
+            & ANJAY_ACCESS_MASK_CREATE;
 }
 
 typedef struct {
@@ -223,6 +439,10 @@ static bool is_single_ssid_environment(anjay_t *anjay) {
     return non_bootstrap_count == 1;
 }
 
+bool _anjay_access_control_required(anjay_t *anjay) {
+    return get_access_control(anjay) && !is_single_ssid_environment(anjay);
+}
+
 bool _anjay_access_control_action_allowed(anjay_t *anjay,
                                           const anjay_action_info_t *info) {
     if (info->oid == ANJAY_DM_OID_SECURITY) {
@@ -17,7 +17,12 @@
 #ifndef ACCESS_CONTROL_UTILS_H
 #define ACCESS_CONTROL_UTILS_H
 
-#include "anjay_core.h"
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/rbtree.h>
+
+#include <anjay_modules/dm_utils.h>
+#include <anjay_modules/notify.h>
+
 #include "dm_core.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -31,12 +36,86 @@ typedef struct {
 
 #ifdef WITH_ACCESS_CONTROL
 
+typedef struct {
+    anjay_ssid_t ssid;
+    anjay_access_mask_t mask;
+} anjay_access_control_index_acl_entry_t;
+
+/**
+ * Contents of a single Access Control object instance, relevant for access
+ * checks. Entries are ordered by (oid, oiid, ac_iid).
+ */
+typedef struct {
+    anjay_oid_t oid;
+    anjay_iid_t oiid;
+    anjay_iid_t ac_iid;
+    anjay_ssid_t owner;
+    // true if the ACL resource could not be read; access checks that reach
+    // such entry fail, like they would when reading the data model directly
+    bool acl_invalid;
+    AVS_LIST(anjay_access_control_index_acl_entry_t) acl;
+} anjay_access_control_index_entry_t;
+
+/**
+ * In-memory copy of the Access Control object, so that access checks do not
+ * need to iterate over all of its instances. It is built lazily on the first
+ * check, and then kept up to date by @ref _anjay_access_control_index_update
+ * called whenever changes to the Access Control object are flushed from a
+ * notify queue.
+ */
+typedef struct {
+    // Access Control object the index has been built from; NULL if the index
+    // is not built
+    const anjay_dm_object_def_t *const *obj;
+    AVS_RBTREE(anjay_access_control_index_entry_t) entries;
+    // the same elements as in entries, ordered by ac_iid
+    AVS_RBTREE(anjay_access_control_index_entry_t *) entries_by_ac_iid;
+    // true if changes to the Access Control object have been queued in
+    // anjay_t::scheduled_notify, and not yet applied to the index
+    bool scheduled_changes_pending;
+} anjay_access_control_index_t;
+
+void _anjay_access_control_index_cleanup(anjay_access_control_index_t *index);
+
+/**
+ * Updates the index after changes to the Access Control object described by
+ * @p ac_changes. Changes to the set of instances cause the whole index to be
+ * rebuilt on next use; changes to resources only cause the affected instances
+ * to be read again.
+ *
+ * If @p ac_changes is a part of anjay_t::scheduled_notify, it is only applied
+ * if that has not already been done by an access check performed since the
+ * changes were queued.
+ */
+void _anjay_access_control_index_update(
+        anjay_t *anjay,
+        anjay_notify_queue_t queue,
+        const anjay_notify_queue_object_entry_t *ac_changes);
+
+/**
+ * Informs the index that changes to the Access Control object have been added
+ * to anjay_t::scheduled_notify. They are applied once, on the next access
+ * check or when the queue is flushed, whichever comes first.
+ */
+void _anjay_access_control_index_changes_scheduled(anjay_t *anjay);
+
 bool _anjay_access_control_action_allowed(anjay_t *anjay,
                                           const anjay_action_info_t* info);
 
+/**
+ * Checks whether results of _anjay_access_control_action_allowed() may depend
+ * on the SSID, i.e. whether the Access Control object is present and there is
+ * more than one server.
+ */
+bool _anjay_access_control_required(anjay_t *anjay);
+
 #else
 
 #define _anjay_access_control_action_allowed(anjay, info) ((void) (info), true)
+#define _anjay_access_control_required(anjay) ((void) (anjay), false)
+#define _anjay_access_control_index_update(anjay, queue, ac_changes) \
+        ((void) (anjay), (void) (queue), (void) (ac_changes))
+#define _anjay_access_control_index_changes_scheduled(anjay) ((void) (anjay))
 
 #endif
 
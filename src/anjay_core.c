@@ -107,7 +107,13 @@ static int init(anjay_t *anjay,
         return -1;
     }
 
-    anjay->sched = _anjay_sched_new(anjay);
+    if (_anjay_coap_stream_set_block_response_cache_size(
+            anjay->comm_stream, config->block_response_cache_size)) {
+        anjay_log(ERROR, "Could not create block-wise response cache");
+        return -1;
+    }
+
+    anjay->sched = _anjay_sched_new(anjay, config->sched_pool_size);
     if (!anjay->sched) {
         anjay_log(ERROR, "Out of memory");
         return -1;
@@ -115,7 +121,13 @@ static int init(anjay_t *anjay,
 
     _anjay_bootstrap_init(anjay, !config->disable_server_initiated_bootstrap);
     if (_anjay_observe_init(&anjay->observe,
-                            config->confirmable_notifications)) {
+                            config->confirmable_notifications,
+                            config->max_notifications_in_flight,
+                            config->coalesce_notifications,
+                            config->cache_observe_attributes,
+                            &config->notify_queue_limits_per_connection,
+                            &config->notify_queue_limits_total,
+                            config->notify_queue_overflow_policy)) {
         return -1;
     }
 
@@ -185,6 +197,7 @@ static void anjay_delete_impl(anjay_t *anjay, bool deregister) {
     // we want to clear this now so that notifications won't be sent during
     // _anjay_sched_delete()
     _anjay_observe_cleanup(&anjay->observe, anjay->sched);
+    _anjay_coap_async_cleanup(anjay);
 
     _anjay_sched_del(anjay->sched, &anjay->reload_servers_sched_job_handle);
     _anjay_sched_del(anjay->sched, &anjay->scheduled_notify.handle);
@@ -206,8 +219,13 @@ static void anjay_delete_impl(anjay_t *anjay, bool deregister) {
     assert(avs_stream_net_getsock(anjay->comm_stream) == NULL);
     avs_stream_cleanup(&anjay->comm_stream);
 
+    _anjay_registration_dm_cache_cleanup(anjay);
+    _anjay_dtls_session_cache_cleanup(&anjay->dtls_session_cache);
     _anjay_dm_cleanup(anjay);
     _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
+#ifdef WITH_ACCESS_CONTROL
+    _anjay_access_control_index_cleanup(&anjay->access_control_index);
+#endif // WITH_ACCESS_CONTROL
 
     avs_free(anjay->in_buffer);
     avs_free(anjay->out_buffer);
@@ -701,6 +719,21 @@ static int handle_request(anjay_t *anjay,
     return result ? result : finish_result;
 }
 
+static void reject_unexpected_response(anjay_t *anjay,
+                                       const avs_coap_msg_t *msg) {
+    anjay_log(DEBUG, "unexpected response: %s",
+              AVS_COAP_CODE_STRING(avs_coap_msg_get_code(msg)));
+    if (avs_coap_msg_get_type(msg) != AVS_COAP_MSG_CONFIRMABLE) {
+        return;
+    }
+    avs_net_abstract_socket_t *socket =
+            _anjay_connection_get_online_socket(anjay->current_connection);
+    if (socket) {
+        avs_coap_ctx_send_empty(anjay->coap_ctx, socket, AVS_COAP_MSG_RESET,
+                                avs_coap_msg_get_id(msg));
+    }
+}
+
 static int handle_incoming_message(anjay_t *anjay) {
     int result = -1;
 
@@ -716,6 +749,9 @@ static int handle_incoming_message(anjay_t *anjay) {
         if (result == AVS_COAP_CTX_ERR_DUPLICATE) {
             anjay_log(TRACE, "duplicate request received");
             return 0;
+        } else if (result == ANJAY_COAP_STREAM_REQUEST_HANDLED) {
+            anjay_log(TRACE, "request handled using cached response");
+            return 0;
         } else if (result == AVS_COAP_CTX_ERR_MSG_WAS_PING) {
             anjay_log(TRACE, "received CoAP ping");
             return 0;
@@ -725,6 +761,23 @@ static int handle_incoming_message(anjay_t *anjay) {
         }
     }
 
+    avs_coap_msg_type_t msg_type = avs_coap_msg_get_type(request_msg);
+    if ((msg_type == AVS_COAP_MSG_ACKNOWLEDGEMENT
+                || msg_type == AVS_COAP_MSG_RESET
+                || !avs_coap_msg_is_request(request_msg))
+            && !_anjay_coap_async_handle_response(anjay, request_msg)) {
+        return 0;
+    }
+    if (msg_type == AVS_COAP_MSG_ACKNOWLEDGEMENT) {
+        anjay_log(DEBUG, "unexpected Acknowledgement, ignoring");
+        return 0;
+    }
+    if (msg_type != AVS_COAP_MSG_RESET
+            && !avs_coap_msg_is_request(request_msg)) {
+        reject_unexpected_response(anjay, request_msg);
+        return 0;
+    }
+
     avs_coap_msg_identity_t request_identity = AVS_COAP_MSG_IDENTITY_EMPTY;
     anjay_request_t request;
     if (_anjay_coap_stream_get_request_identity(anjay->comm_stream,
@@ -785,14 +838,12 @@ void _anjay_release_server_stream(anjay_t *anjay) {
     _anjay_release_server_stream_without_scheduling_queue(anjay);
 }
 
-static int udp_serve(anjay_t *anjay,
-                     avs_net_abstract_socket_t *ready_socket) {
+static int udp_serve(anjay_t *anjay, anjay_server_info_t *server) {
     anjay_connection_ref_t connection = {
-        .server = _anjay_servers_find_by_udp_socket(anjay, ready_socket),
+        .server = server,
         .conn_type = ANJAY_CONNECTION_UDP
     };
-    if (!connection.server
-            || _anjay_bind_server_stream(anjay, connection)) {
+    if (_anjay_bind_server_stream(anjay, connection)) {
         return -1;
     }
 
@@ -804,13 +855,19 @@ static int udp_serve(anjay_t *anjay,
 
 int anjay_serve(anjay_t *anjay,
                 avs_net_abstract_socket_t *ready_socket) {
+    anjay_server_info_t *server =
+            _anjay_servers_find_by_udp_socket(anjay, ready_socket);
+    if (server) {
+        return udp_serve(anjay, server);
+    }
+
 #ifdef WITH_DOWNLOADER
     if (!_anjay_downloader_handle_packet(&anjay->downloader, ready_socket)) {
         return 0;
     }
 #endif // WITH_DOWNLOADER
 
-    return udp_serve(anjay, ready_socket);
+    return -1;
 }
 
 int anjay_sched_time_to_next(anjay_t *anjay,
@@ -843,6 +900,7 @@ int anjay_sched_calculate_wait_time_ms(anjay_t *anjay, int limit_ms) {
 
 int anjay_sched_run(anjay_t *anjay) {
     ssize_t tasks_executed = _anjay_sched_run(anjay->sched);
+    _anjay_observe_read_cache_clear(&anjay->observe);
     if (tasks_executed < 0) {
         anjay_log(ERROR, "sched_run failed");
         return -1;
@@ -919,6 +977,82 @@ uint64_t anjay_get_num_outgoing_retransmissions(anjay_t *anjay) {
 #endif
 }
 
+uint64_t anjay_get_sched_pool_hits(anjay_t *anjay) {
+    uint64_t hits;
+    _anjay_sched_pool_stats(anjay->sched, &hits, NULL);
+    return hits;
+}
+
+uint64_t anjay_get_sched_pool_misses(anjay_t *anjay) {
+    uint64_t misses;
+    _anjay_sched_pool_stats(anjay->sched, NULL, &misses);
+    return misses;
+}
+
+int anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out_stream) {
+    return _anjay_observe_persist(anjay, out_stream);
+}
+
+int anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in_stream) {
+    return _anjay_observe_restore(anjay, in_stream);
+}
+
+int anjay_dtls_sessions_persist(anjay_t *anjay,
+                                avs_stream_abstract_t *out_stream) {
+    return _anjay_dtls_session_cache_persist(&anjay->dtls_session_cache,
+                                             out_stream);
+}
+
+int anjay_dtls_sessions_restore(anjay_t *anjay,
+                                avs_stream_abstract_t *in_stream) {
+    return _anjay_dtls_session_cache_restore(&anjay->dtls_session_cache,
+                                             in_stream);
+}
+
+uint64_t anjay_get_num_dtls_handshakes(anjay_t *anjay) {
+    return anjay->dtls_session_cache.num_handshakes;
+}
+
+uint64_t anjay_get_num_dtls_sessions_resumed(anjay_t *anjay) {
+    return anjay->dtls_session_cache.num_resumed;
+}
+
+uint64_t anjay_get_num_notifications_sent(anjay_t *anjay) {
+#ifdef WITH_OBSERVE
+    return anjay->observe.stats.packets_sent;
+#else
+    (void) anjay;
+    return 0;
+#endif
+}
+
+uint64_t anjay_get_notifications_tx_bytes(anjay_t *anjay) {
+#ifdef WITH_OBSERVE
+    return anjay->observe.stats.bytes_sent;
+#else
+    (void) anjay;
+    return 0;
+#endif
+}
+
+uint64_t anjay_get_num_coalesced_notifications(anjay_t *anjay) {
+#ifdef WITH_OBSERVE
+    return anjay->observe.stats.values_coalesced;
+#else
+    (void) anjay;
+    return 0;
+#endif
+}
+
+uint64_t anjay_get_num_dropped_notifications(anjay_t *anjay) {
+#ifdef WITH_OBSERVE
+    return anjay->observe.stats.values_dropped;
+#else
+    (void) anjay;
+    return 0;
+#endif
+}
+
 
 #ifdef ANJAY_TEST
 #include "test/anjay.c"
@@ -21,6 +21,8 @@
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/net.h>
 
+#include "access_control_utils.h"
+#include "coap_async.h"
 #include "dm_core.h"
 #include "observe/observe_core.h"
 
@@ -49,17 +51,23 @@ struct anjay_struct {
     anjay_dm_t dm;
     uint16_t udp_listen_port;
     anjay_servers_t *servers;
+    anjay_registration_dm_cache_t registration_dm_cache;
+    anjay_dtls_session_cache_t dtls_session_cache;
     anjay_sched_handle_t reload_servers_sched_job_handle;
 #ifdef WITH_OBSERVE
     anjay_observe_state_t observe;
 #endif
 #ifdef WITH_BOOTSTRAP
     anjay_bootstrap_t bootstrap;
+#endif
+#ifdef WITH_ACCESS_CONTROL
+    anjay_access_control_index_t access_control_index;
 #endif
     avs_coap_tx_params_t udp_tx_params;
     avs_coap_ctx_t *coap_ctx;
     avs_stream_abstract_t *comm_stream;
     anjay_connection_ref_t current_connection;
+    anjay_coap_async_t coap_async;
     anjay_scheduled_notify_t scheduled_notify;
 
     const char *endpoint_name;
@@ -98,9 +106,16 @@ void _anjay_release_server_stream(anjay_t *anjay);
  * @param anjay Pointer to the Anjay object, passed to scheduled jobs. Not
  *              dereferenced by the scheduler object.
  *
+ * @param pool_size Number of job slots to preallocate. May be 0, in which
+ *                  case all jobs are allocated on the heap.
+ *
  * @returns Created scheduler object, or NULL if there is not enough memory.
  */
-anjay_sched_t *_anjay_sched_new(anjay_t *anjay);
+anjay_sched_t *_anjay_sched_new(anjay_t *anjay, size_t pool_size);
+
+void _anjay_sched_pool_stats(anjay_sched_t *sched,
+                             uint64_t *out_hits,
+                             uint64_t *out_misses);
 
 VISIBILITY_PRIVATE_HEADER_END
 
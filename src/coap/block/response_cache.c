@@ -0,0 +1,424 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <avsystem/commons/coap/block_utils.h>
+#include <avsystem/commons/coap/msg_builder.h>
+#include <avsystem/commons/coap/msg_opt.h>
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/memory.h>
+
+#include "../coap_log.h"
+
+#include "response_cache.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    avs_net_abstract_socket_t *socket;
+    avs_time_monotonic_t expires;
+
+    uint8_t request_code;
+    // critical options of the request, other than BLOCK2, serialized as
+    // consecutive (uint32_t optnum, uint32_t length, uint8_t value[length])
+    uint8_t *request_key;
+    size_t request_key_size;
+
+    uint8_t response_code;
+    uint16_t format;
+    uint8_t etag[ANJAY_COAP_BLOCK_RESPONSE_ETAG_SIZE];
+    uint16_t block_size;
+
+    uint8_t *payload;
+    size_t payload_size;
+    size_t payload_capacity;
+} response_cache_entry_t;
+
+struct coap_block_response_cache {
+    size_t max_size;
+    // memory used by entries, not including the one being recorded
+    size_t size;
+    uint32_t last_etag;
+    // ordered by the time of recording, oldest first
+    AVS_LIST(response_cache_entry_t) entries;
+    AVS_LIST(response_cache_entry_t) recorded;
+};
+
+static size_t entry_size(const response_cache_entry_t *entry) {
+    return sizeof(*entry) + entry->request_key_size + entry->payload_capacity;
+}
+
+static void entry_cleanup(response_cache_entry_t *entry) {
+    avs_free(entry->request_key);
+    avs_free(entry->payload);
+}
+
+static void delete_entry(coap_block_response_cache_t *cache,
+                         AVS_LIST(response_cache_entry_t) *entry_ptr) {
+    assert(cache->size >= entry_size(*entry_ptr));
+    cache->size -= entry_size(*entry_ptr);
+    entry_cleanup(*entry_ptr);
+    AVS_LIST_DELETE(entry_ptr);
+}
+
+static bool is_opt_critical(uint32_t opt_number) {
+    return opt_number % 2;
+}
+
+#define REQUEST_KEY_OPT_HEADER_SIZE (2 * sizeof(uint32_t))
+
+static size_t serialize_request_key(const avs_coap_msg_t *request,
+                                    uint8_t *out_key) {
+    size_t size = 0;
+    for (avs_coap_opt_iterator_t optit = avs_coap_opt_begin(request);
+            !avs_coap_opt_end(&optit); avs_coap_opt_next(&optit)) {
+        uint32_t optnum = avs_coap_opt_number(&optit);
+        if (optnum == AVS_COAP_OPT_BLOCK2 || !is_opt_critical(optnum)) {
+            continue;
+        }
+        uint32_t length = avs_coap_opt_content_length(optit.curr_opt);
+        if (out_key) {
+            memcpy(out_key + size, &optnum, sizeof(optnum));
+            memcpy(out_key + size + sizeof(optnum), &length, sizeof(length));
+            memcpy(out_key + size + REQUEST_KEY_OPT_HEADER_SIZE,
+                   avs_coap_opt_value(optit.curr_opt), length);
+        }
+        size += REQUEST_KEY_OPT_HEADER_SIZE + length;
+    }
+    return size;
+}
+
+static bool request_matches(const response_cache_entry_t *entry,
+                            const avs_coap_msg_t *request) {
+    if (avs_coap_msg_get_code(request) != entry->request_code
+            || serialize_request_key(request, NULL)
+                    != entry->request_key_size) {
+        return false;
+    }
+
+    uint8_t *key = (uint8_t *) avs_malloc(entry->request_key_size + 1);
+    if (!key) {
+        coap_log(ERROR, "out of memory");
+        return false;
+    }
+    serialize_request_key(request, key);
+    bool result = !memcmp(key, entry->request_key, entry->request_key_size);
+    avs_free(key);
+    return result;
+}
+
+static void remove_expired(coap_block_response_cache_t *cache) {
+    const avs_time_monotonic_t now = avs_time_monotonic_now();
+    AVS_LIST(response_cache_entry_t) *entry_ptr;
+    AVS_LIST(response_cache_entry_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(entry_ptr, helper, &cache->entries) {
+        if (!avs_time_monotonic_before(now, (*entry_ptr)->expires)) {
+            delete_entry(cache, entry_ptr);
+        }
+    }
+}
+
+coap_block_response_cache_t *
+_anjay_coap_block_response_cache_new(size_t max_size) {
+    coap_block_response_cache_t *cache = (coap_block_response_cache_t *)
+            avs_calloc(1, sizeof(coap_block_response_cache_t));
+    if (!cache) {
+        coap_log(ERROR, "out of memory");
+        return NULL;
+    }
+    cache->max_size = max_size;
+    return cache;
+}
+
+void _anjay_coap_block_response_cache_delete(
+        coap_block_response_cache_t **cache_ptr) {
+    if (cache_ptr && *cache_ptr) {
+        _anjay_coap_block_response_cache_abort(*cache_ptr);
+        while ((*cache_ptr)->entries) {
+            delete_entry(*cache_ptr, &(*cache_ptr)->entries);
+        }
+        avs_free(*cache_ptr);
+        *cache_ptr = NULL;
+    }
+}
+
+static int ensure_payload_capacity(coap_block_response_cache_t *cache,
+                                   response_cache_entry_t *entry,
+                                   size_t payload_size) {
+    if (payload_size <= entry->payload_capacity) {
+        return 0;
+    }
+
+    const size_t size_without_payload =
+            entry_size(entry) - entry->payload_capacity;
+    if (size_without_payload > cache->max_size
+            || payload_size > cache->max_size - size_without_payload) {
+        coap_log(DEBUG, "response too large to be cached");
+        return -1;
+    }
+
+    size_t new_capacity = AVS_MAX(entry->payload_capacity * 2, payload_size);
+    new_capacity = AVS_MIN(new_capacity,
+                           cache->max_size - size_without_payload);
+    uint8_t *new_payload =
+            (uint8_t *) avs_realloc(entry->payload, new_capacity);
+    if (!new_payload) {
+        coap_log(ERROR, "out of memory");
+        return -1;
+    }
+    entry->payload = new_payload;
+    entry->payload_capacity = new_capacity;
+    return 0;
+}
+
+static int append_payload(coap_block_response_cache_t *cache,
+                          response_cache_entry_t *entry,
+                          const void *data,
+                          size_t data_length) {
+    if (!data_length) {
+        return 0;
+    }
+    if (ensure_payload_capacity(cache, entry,
+                                entry->payload_size + data_length)) {
+        return -1;
+    }
+    memcpy(entry->payload + entry->payload_size, data, data_length);
+    entry->payload_size += data_length;
+    return 0;
+}
+
+int _anjay_coap_block_response_cache_start(
+        coap_block_response_cache_t *cache,
+        avs_net_abstract_socket_t *socket,
+        const avs_coap_msg_t *request,
+        const avs_coap_msg_t *response_prefix,
+        avs_coap_msg_info_t *response_info) {
+    _anjay_coap_block_response_cache_abort(cache);
+
+    AVS_LIST(response_cache_entry_t) entry =
+            AVS_LIST_NEW_ELEMENT(response_cache_entry_t);
+    if (!entry) {
+        coap_log(ERROR, "out of memory");
+        return -1;
+    }
+
+    entry->socket = socket;
+    entry->request_code = avs_coap_msg_get_code(request);
+    entry->request_key_size = serialize_request_key(request, NULL);
+    entry->response_code = avs_coap_msg_get_code(response_prefix);
+
+    uint32_t etag = ++cache->last_etag;
+    for (size_t i = ANJAY_COAP_BLOCK_RESPONSE_ETAG_SIZE; i-- > 0;) {
+        entry->etag[i] = (uint8_t) etag;
+        etag >>= 8;
+    }
+
+    if (avs_coap_msg_get_content_format(response_prefix, &entry->format)) {
+        goto error;
+    }
+    // +1 to avoid avs_malloc(0) for requests without critical options
+    if (!(entry->request_key =
+                  (uint8_t *) avs_malloc(entry->request_key_size + 1))) {
+        coap_log(ERROR, "out of memory");
+        goto error;
+    }
+    serialize_request_key(request, entry->request_key);
+
+    if (append_payload(cache, entry, avs_coap_msg_payload(response_prefix),
+                       avs_coap_msg_payload_length(response_prefix))
+            || avs_coap_msg_info_opt_opaque(response_info, AVS_COAP_OPT_ETAG,
+                                            entry->etag,
+                                            sizeof(entry->etag))) {
+        goto error;
+    }
+
+    cache->recorded = entry;
+    return 0;
+error:
+    entry_cleanup(entry);
+    AVS_LIST_DELETE(&entry);
+    return -1;
+}
+
+bool
+_anjay_coap_block_response_cache_recording(coap_block_response_cache_t *cache) {
+    return cache && cache->recorded;
+}
+
+void _anjay_coap_block_response_cache_append(
+        coap_block_response_cache_t *cache,
+        const void *data,
+        size_t data_length) {
+    if (_anjay_coap_block_response_cache_recording(cache)
+            && append_payload(cache, cache->recorded, data, data_length)) {
+        _anjay_coap_block_response_cache_abort(cache);
+    }
+}
+
+void _anjay_coap_block_response_cache_commit(
+        coap_block_response_cache_t *cache,
+        uint16_t block_size,
+        avs_time_duration_t lifetime) {
+    if (!_anjay_coap_block_response_cache_recording(cache)) {
+        return;
+    }
+
+    AVS_LIST(response_cache_entry_t) entry = cache->recorded;
+    cache->recorded = NULL;
+    entry->block_size = block_size;
+    entry->expires = avs_time_monotonic_add(avs_time_monotonic_now(), lifetime);
+
+    _anjay_coap_block_response_cache_forget_socket(cache, entry->socket);
+    remove_expired(cache);
+    assert(entry_size(entry) <= cache->max_size);
+    while (cache->entries
+            && cache->size + entry_size(entry) > cache->max_size) {
+        delete_entry(cache, &cache->entries);
+    }
+
+    cache->size += entry_size(entry);
+    AVS_LIST_APPEND(&cache->entries, entry);
+    coap_log(TRACE, "cached %lu B block-wise response",
+             (unsigned long) entry->payload_size);
+}
+
+void
+_anjay_coap_block_response_cache_abort(coap_block_response_cache_t *cache) {
+    if (_anjay_coap_block_response_cache_recording(cache)) {
+        entry_cleanup(cache->recorded);
+        AVS_LIST_DELETE(&cache->recorded);
+    }
+}
+
+static response_cache_entry_t *find_entry(coap_block_response_cache_t *cache,
+                                          avs_net_abstract_socket_t *socket,
+                                          const avs_coap_msg_t *request) {
+    AVS_LIST(response_cache_entry_t) entry;
+    AVS_LIST_FOREACH(entry, cache->entries) {
+        if (entry->socket == socket) {
+            return request_matches(entry, request) ? entry : NULL;
+        }
+    }
+    return NULL;
+}
+
+static int send_block(avs_coap_ctx_t *coap_ctx,
+                      avs_net_abstract_socket_t *socket,
+                      const avs_coap_msg_t *request,
+                      const response_cache_entry_t *entry,
+                      const avs_coap_block_info_t *block) {
+    const size_t offset = (size_t) block->seq_num * block->size;
+    const size_t payload_size =
+            AVS_MIN(block->size, entry->payload_size - offset);
+
+    avs_coap_msg_info_t info = avs_coap_msg_info_init();
+    info.type = AVS_COAP_MSG_ACKNOWLEDGEMENT;
+    info.code = entry->response_code;
+    info.identity = avs_coap_msg_get_identity(request);
+
+    int result = -1;
+    void *storage = NULL;
+    if (avs_coap_msg_info_opt_opaque(&info, AVS_COAP_OPT_ETAG,
+                                     entry->etag, sizeof(entry->etag))
+            || avs_coap_msg_info_opt_content_format(&info, entry->format)
+            || avs_coap_msg_info_opt_block(&info, block)) {
+        goto cleanup;
+    }
+
+    const size_t storage_size =
+            avs_coap_msg_info_get_packet_storage_size(&info, payload_size);
+    if (!(storage = avs_malloc(storage_size))) {
+        coap_log(ERROR, "out of memory");
+        goto cleanup;
+    }
+
+    avs_coap_msg_builder_t builder;
+    if (avs_coap_msg_builder_init(&builder,
+                                  avs_coap_ensure_aligned_buffer(storage),
+                                  storage_size, &info)
+            || avs_coap_msg_builder_payload(&builder, entry->payload + offset,
+                                            payload_size) != payload_size) {
+        goto cleanup;
+    }
+
+    coap_log(TRACE, "sending cached block %" PRIu32 " (size %" PRIu16 ")",
+             block->seq_num, block->size);
+    result = avs_coap_ctx_send(coap_ctx, socket,
+                               avs_coap_msg_builder_get_msg(&builder));
+cleanup:
+    avs_free(storage);
+    avs_coap_msg_info_reset(&info);
+    return result;
+}
+
+int _anjay_coap_block_response_cache_serve(coap_block_response_cache_t *cache,
+                                           avs_coap_ctx_t *coap_ctx,
+                                           avs_net_abstract_socket_t *socket,
+                                           const avs_coap_msg_t *request) {
+    avs_coap_block_info_t requested;
+    if (!cache
+            || avs_coap_msg_get_type(request) != AVS_COAP_MSG_CONFIRMABLE
+            || avs_coap_get_block_info(request, AVS_COAP_BLOCK2, &requested)
+            || !requested.valid
+            || requested.seq_num == 0) {
+        return ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS;
+    }
+
+    remove_expired(cache);
+    const response_cache_entry_t *entry = find_entry(cache, socket, request);
+    if (!entry) {
+        return ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS;
+    }
+
+    // both sizes are powers of two, so the offset is always block-aligned
+    const size_t offset = (size_t) requested.seq_num * requested.size;
+    if (offset >= entry->payload_size) {
+        return ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS;
+    }
+
+    avs_coap_block_info_t block = {
+        .type = AVS_COAP_BLOCK2,
+        .valid = true,
+        .size = AVS_MIN(requested.size, entry->block_size)
+    };
+    block.seq_num = (uint32_t) (offset / block.size);
+    block.has_more = (offset + block.size < entry->payload_size);
+
+    return send_block(coap_ctx, socket, request, entry, &block);
+}
+
+void _anjay_coap_block_response_cache_forget_socket(
+        coap_block_response_cache_t *cache,
+        avs_net_abstract_socket_t *socket) {
+    if (!cache) {
+        return;
+    }
+    if (cache->recorded && cache->recorded->socket == socket) {
+        _anjay_coap_block_response_cache_abort(cache);
+    }
+
+    AVS_LIST(response_cache_entry_t) *entry_ptr;
+    AVS_LIST(response_cache_entry_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(entry_ptr, helper, &cache->entries) {
+        if ((*entry_ptr)->socket == socket) {
+            delete_entry(cache, entry_ptr);
+        }
+    }
+}
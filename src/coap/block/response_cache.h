@@ -0,0 +1,162 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_BLOCK_RESPONSE_CACHE_H
+#define ANJAY_COAP_BLOCK_RESPONSE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <avsystem/commons/coap/ctx.h>
+#include <avsystem/commons/coap/msg.h>
+#include <avsystem/commons/coap/msg_info.h>
+#include <avsystem/commons/net.h>
+#include <avsystem/commons/time.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+#ifdef WITH_BLOCK_SEND
+
+/**
+ * Cache of complete payloads of recently sent block-wise responses.
+ *
+ * While a block-wise response is being generated, its whole payload is
+ * recorded. Once complete, the recording is kept for EXCHANGE_LIFETIME, so that
+ * BLOCK2 requests for further blocks arriving as separate exchanges (i.e. not
+ * during the block-wise transfer initiated by the original request) can be
+ * served directly from memory, without generating the whole response again.
+ *
+ * Each response served from the cache carries an ETag option, so that the
+ * server is able to detect blocks that come from different representations.
+ *
+ * At most one response is cached per socket. The total amount of memory used
+ * by cached responses is limited by the size passed to
+ * @ref _anjay_coap_block_response_cache_new - the least recently recorded
+ * responses are dropped to make space for new ones.
+ */
+typedef struct coap_block_response_cache coap_block_response_cache_t;
+
+/** Size of the ETag option attached to cached responses. */
+#define ANJAY_COAP_BLOCK_RESPONSE_ETAG_SIZE 4
+
+/**
+ * Returned by @ref _anjay_coap_block_response_cache_serve if the request could
+ * not be handled using cached data.
+ */
+#define ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS 1
+
+/**
+ * @param max_size Maximum number of bytes that may be used by cached responses.
+ *
+ * @returns Newly created cache object, or NULL in case of an out-of-memory
+ *          condition.
+ */
+coap_block_response_cache_t *
+_anjay_coap_block_response_cache_new(size_t max_size);
+
+void _anjay_coap_block_response_cache_delete(
+        coap_block_response_cache_t **cache_ptr);
+
+/**
+ * Starts recording a response to @p request . Any response being recorded is
+ * discarded.
+ *
+ * @param cache           Cache object to operate on.
+ * @param socket          Socket the response is sent through.
+ * @param request         Request being responded to.
+ * @param response_prefix Response message, as built so far. Its code,
+ *                        Content-Format and the payload written so far are
+ *                        recorded.
+ * @param response_info   Message info used to construct the remaining parts
+ *                        of the response. The ETag option identifying the
+ *                        recorded representation is added to it.
+ *
+ * @returns 0 on success, a negative value in case of error. On error, nothing
+ *          is being recorded.
+ */
+int _anjay_coap_block_response_cache_start(
+        coap_block_response_cache_t *cache,
+        avs_net_abstract_socket_t *socket,
+        const avs_coap_msg_t *request,
+        const avs_coap_msg_t *response_prefix,
+        avs_coap_msg_info_t *response_info);
+
+/**
+ * @returns true if a response is being recorded, false otherwise.
+ */
+bool
+_anjay_coap_block_response_cache_recording(coap_block_response_cache_t *cache);
+
+/**
+ * Appends @p data to the response being recorded. If the recorded response
+ * grows above the cache size limit, the recording is silently discarded.
+ */
+void _anjay_coap_block_response_cache_append(
+        coap_block_response_cache_t *cache,
+        const void *data,
+        size_t data_length);
+
+/**
+ * Finishes the recording, making the recorded response available for
+ * @ref _anjay_coap_block_response_cache_serve until @p lifetime passes.
+ *
+ * @param cache      Cache object to operate on.
+ * @param block_size Largest block size that may be used for serving the
+ *                   response.
+ * @param lifetime   Time for which the response shall be kept in the cache.
+ */
+void _anjay_coap_block_response_cache_commit(
+        coap_block_response_cache_t *cache,
+        uint16_t block_size,
+        avs_time_duration_t lifetime);
+
+/**
+ * Discards the response being recorded, if any.
+ */
+void
+_anjay_coap_block_response_cache_abort(coap_block_response_cache_t *cache);
+
+/**
+ * Attempts to handle a BLOCK2 @p request received through @p socket using
+ * a cached response. Only requests for blocks other than the first one, with
+ * the same code and critical options (other than BLOCK2) as the request that
+ * originally caused the response to be recorded, are handled.
+ *
+ * @returns
+ * - 0 if the appropriate block of a cached response has been sent,
+ * - ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS if no matching response is cached,
+ * - a negative value in case of error.
+ */
+int _anjay_coap_block_response_cache_serve(coap_block_response_cache_t *cache,
+                                           avs_coap_ctx_t *coap_ctx,
+                                           avs_net_abstract_socket_t *socket,
+                                           const avs_coap_msg_t *request);
+
+/**
+ * Drops the response cached for @p socket , if any. MUST be called before the
+ * socket is destroyed, so that a socket later allocated at the same address
+ * does not get access to responses generated for another one.
+ */
+void _anjay_coap_block_response_cache_forget_socket(
+        coap_block_response_cache_t *cache,
+        avs_net_abstract_socket_t *socket);
+
+#endif // WITH_BLOCK_SEND
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_COAP_BLOCK_RESPONSE_CACHE_H
@@ -392,3 +392,8 @@ int _anjay_coap_block_transfer_finish(coap_block_transfer_ctx_t *ctx) {
 
     return flush_blocks(ctx, FINAL_BLOCK_SEND);
 }
+
+uint16_t
+_anjay_coap_block_transfer_block_size(const coap_block_transfer_ctx_t *ctx) {
+    return ctx->block.size;
+}
@@ -35,6 +35,13 @@ int _anjay_coap_block_transfer_write(coap_block_transfer_ctx_t *ctx,
 
 int _anjay_coap_block_transfer_finish(coap_block_transfer_ctx_t *ctx);
 
+/**
+ * @returns Size of blocks used by the transfer. Note that it may be lowered by
+ *          the remote host while the transfer is in progress.
+ */
+uint16_t
+_anjay_coap_block_transfer_block_size(const coap_block_transfer_ctx_t *ctx);
+
 #else
 
 #define _anjay_coap_block_transfer_delete(ctx) ((void) 0)
@@ -79,6 +79,13 @@ int _anjay_coap_stream_setup_request(
 int _anjay_coap_stream_set_error(avs_stream_abstract_t *stream,
                                  uint8_t code);
 
+/**
+ * Returned by @ref _anjay_coap_stream_get_incoming_msg if the received request
+ * has already been responded to by the stream itself (e.g. using a cached
+ * block-wise response), and requires no further handling.
+ */
+#define ANJAY_COAP_STREAM_REQUEST_HANDLED 2
+
 /** NOTE: Pointer acquired with this function is only valid until receiving next
  * CoAP packet. Note that this might mean invalidation during the same stream
  * exchange if block transfer is in progress. */
@@ -89,11 +96,55 @@ int _anjay_coap_stream_get_request_identity(
         avs_stream_abstract_t *stream,
         avs_coap_msg_identity_t *out_identity);
 
+#define ANJAY_COAP_STREAM_BLOCKWISE 1
+
+/**
+ * Finalizes the request prepared with @ref _anjay_coap_stream_setup_request
+ * and the data written to the stream so far, without sending it.
+ *
+ * This allows the caller to send the message on its own, without waiting for
+ * the response (see coap_async.h). The stream shall be reset afterwards.
+ *
+ * NOTE: Pointer acquired with this function is only valid until the stream is
+ * reset or written to.
+ *
+ * @returns
+ * - 0 on success,
+ * - ANJAY_COAP_STREAM_BLOCKWISE if the request did not fit in a single message
+ *   and a block-wise transfer has already been started; in that case, the
+ *   request shall be finished with avs_stream_finish_message(),
+ * - a negative value in case of error.
+ */
+int _anjay_coap_stream_build_request(avs_stream_abstract_t *stream,
+                                     const avs_coap_msg_t **out_msg);
+
 void _anjay_coap_stream_set_block_request_validator(
         avs_stream_abstract_t *stream,
         anjay_coap_block_request_validator_t *validator,
         void *validator_arg);
 
+/**
+ * Enables caching of block-wise responses to GET requests, so that BLOCK2
+ * requests for their further blocks, sent as separate exchanges, may be handled
+ * without generating the whole response again.
+ *
+ * @param stream   CoAP stream to operate on.
+ * @param max_size Maximum number of bytes used for cached responses. 0 disables
+ *                 the cache.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int _anjay_coap_stream_set_block_response_cache_size(
+        avs_stream_abstract_t *stream,
+        size_t max_size);
+
+/**
+ * Drops any data cached for @p socket . MUST be called before destroying any
+ * socket previously used with the stream.
+ */
+void _anjay_coap_stream_forget_socket(avs_stream_abstract_t *stream,
+                                      avs_net_abstract_socket_t *socket);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_COAP_STREAM_H
@@ -28,6 +28,7 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 
 #define ANJAY_COAP_FORMAT_PLAINTEXT 0
 #define ANJAY_COAP_FORMAT_OPAQUE 42
+#define ANJAY_COAP_FORMAT_SENML_CBOR 112
 #define ANJAY_COAP_FORMAT_TLV 11542
 #define ANJAY_COAP_FORMAT_JSON 11543
 
@@ -360,6 +360,22 @@ int _anjay_coap_client_finish_request(coap_client_t *client) {
     }
 }
 
+int _anjay_coap_client_build_request(coap_client_t *client,
+                                     const avs_coap_msg_t **out_msg) {
+    if (client->state != COAP_CLIENT_STATE_HAS_REQUEST_HEADER) {
+        coap_log(TRACE, "unexpected client state: %d", client->state);
+        return -1;
+    }
+
+    if (has_block_ctx(client)) {
+        coap_log(DEBUG, "request does not fit in a single message");
+        return ANJAY_COAP_STREAM_BLOCKWISE;
+    }
+
+    *out_msg = _anjay_coap_out_build_msg(&client->common.out);
+    return 0;
+}
+
 int _anjay_coap_client_read(coap_client_t *client,
                             size_t *out_bytes_read,
                             char *out_message_finished,
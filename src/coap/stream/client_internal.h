@@ -115,6 +115,17 @@ int _anjay_coap_client_get_or_receive_msg(coap_client_t *client,
  */
 int _anjay_coap_client_finish_request(coap_client_t *client);
 
+/**
+ * Builds the prepared request without sending it.
+ *
+ * @returns
+ * - 0 on success,
+ * - ANJAY_COAP_STREAM_BLOCKWISE if a block-wise transfer is in progress,
+ * - a negative value in case of error.
+ */
+int _anjay_coap_client_build_request(coap_client_t *client,
+                                     const avs_coap_msg_t **out_msg);
+
 int _anjay_coap_client_read(coap_client_t *client,
                             size_t *out_bytes_read,
                             char *out_message_finished,
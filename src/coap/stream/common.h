@@ -20,6 +20,7 @@
 #include <avsystem/commons/coap/msg_builder.h>
 
 #include "../coap_stream.h"
+#include "../block/response_cache.h"
 #include "in.h"
 #include "out.h"
 
@@ -35,6 +36,11 @@ typedef struct coap_stream_common {
 
     coap_input_buffer_t in;
     coap_output_buffer_t out;
+
+#ifdef WITH_BLOCK_SEND
+    // NULL if caching block-wise responses is disabled
+    coap_block_response_cache_t *block_response_cache;
+#endif // WITH_BLOCK_SEND
 } coap_stream_common_t;
 
 int _anjay_coap_common_fill_msg_info(avs_coap_msg_info_t *info,
@@ -41,6 +41,61 @@ VISIBILITY_SOURCE_BEGIN
 #define has_block_ctx(server) (false)
 #endif
 
+#ifdef WITH_BLOCK_SEND
+static void start_recording_response(coap_server_t *server) {
+    coap_block_response_cache_t *cache = server->common.block_response_cache;
+    const avs_coap_msg_t *request =
+            _anjay_coap_in_get_message(&server->common.in);
+    // only Read and Discover responses may be repeated safely
+    if (!cache || avs_coap_msg_get_code(request) != AVS_COAP_CODE_GET) {
+        return;
+    }
+
+    if (_anjay_coap_block_response_cache_start(
+            cache, server->common.socket, request,
+            _anjay_coap_out_build_msg(&server->common.out),
+            &server->common.out.info)) {
+        coap_log(DEBUG, "could not start caching block-wise response");
+    }
+}
+
+static void abort_recording_response(coap_server_t *server) {
+    _anjay_coap_block_response_cache_abort(server->common.block_response_cache);
+}
+
+static void finish_recording_response(coap_server_t *server, int result) {
+    coap_block_response_cache_t *cache = server->common.block_response_cache;
+    if (!_anjay_coap_block_response_cache_recording(cache)) {
+        return;
+    }
+
+    if (result) {
+        abort_recording_response(server);
+    } else {
+        avs_coap_tx_params_t tx_params =
+                avs_coap_ctx_get_tx_params(server->common.coap_ctx);
+        _anjay_coap_block_response_cache_commit(
+                cache, _anjay_coap_block_transfer_block_size(server->block_ctx),
+                avs_coap_exchange_lifetime(&tx_params));
+    }
+}
+
+static bool serve_cached_block(coap_server_t *server,
+                               const avs_coap_msg_t *msg) {
+    int result = _anjay_coap_block_response_cache_serve(
+            server->common.block_response_cache, server->common.coap_ctx,
+            server->common.socket, msg);
+    if (result < 0) {
+        coap_log(WARNING, "could not send cached block response");
+    }
+    return !result;
+}
+#else // WITH_BLOCK_SEND
+#define abort_recording_response(server) ((void) 0)
+#define finish_recording_response(server, result) ((void) 0)
+#define serve_cached_block(server, msg) (false)
+#endif // WITH_BLOCK_SEND
+
 static inline bool has_error(coap_server_t *server) {
     return server->last_error_code != 0;
 }
@@ -58,6 +113,7 @@ void _anjay_coap_server_reset(coap_server_t *server) {
     AVS_LIST_CLEAR(&server->expected_block_opts);
     server->curr_block.valid = false;
     clear_error(server);
+    abort_recording_response(server);
 #ifdef WITH_BLOCK_SEND
     memset(&server->block_relation_validator, 0,
            sizeof(server->block_relation_validator));
@@ -149,11 +205,13 @@ static void setup_error_response(coap_server_t *server) {
 
 int _anjay_coap_server_finish_response(coap_server_t *server) {
     if (has_error(server)) {
+        abort_recording_response(server);
         setup_error_response(server);
     }
 
     if (has_block_ctx(server)) {
         int result = _anjay_coap_block_transfer_finish(server->block_ctx);
+        finish_recording_response(server, result);
         server->request_identity =
                 _anjay_coap_block_response_last_request_id(server->block_ctx);
         _anjay_coap_block_transfer_delete(&server->block_ctx);
@@ -224,20 +282,23 @@ typedef enum process_result {
     /** Not a valid request message. last_error_code may be set to enforce a
      * particular response code. */
     PROCESS_INITIAL_INVALID_REQUEST,
+
+    /** A BLOCK2 request for a non-first block of a cached response, which has
+     * already been responded to. */
+    PROCESS_INITIAL_SERVED_FROM_CACHE,
 } process_result_t;
 
 static process_result_t process_initial_request(coap_server_t *server,
                                                 const avs_coap_msg_t *msg) {
     assert(is_server_reset(server));
 
-    avs_coap_msg_type_t type = avs_coap_msg_get_type(msg);
-    if (!avs_coap_msg_is_request(msg)
-            // incoming Reset may still require some kind of reaction,
-            // so it should be handled by upper layers
-            && type != AVS_COAP_MSG_RESET) {
-        coap_log(DEBUG, "invalid request: %s",
-                 AVS_COAP_CODE_STRING(avs_coap_msg_get_code(msg)));
-        return PROCESS_INITIAL_INVALID_REQUEST;
+    if (!avs_coap_msg_is_request(msg)) {
+        // incoming Reset, Acknowledgement or response may still require some
+        // kind of reaction (e.g. it may conclude an asynchronous exchange),
+        // so it should be handled by upper layers
+        server->state = COAP_SERVER_STATE_HAS_REQUEST;
+        server->request_identity = avs_coap_msg_get_identity(msg);
+        return PROCESS_INITIAL_OK;
     }
 
     avs_coap_block_info_t block1;
@@ -272,6 +333,9 @@ static process_result_t process_initial_request(coap_server_t *server,
                  server->curr_block.size);
 
         if (server->curr_block.seq_num != 0) {
+            if (block2.valid && serve_cached_block(server, msg)) {
+                return PROCESS_INITIAL_SERVED_FROM_CACHE;
+            }
             coap_log(ERROR, "initial block seq_num nonzero");
             _anjay_coap_server_set_error(server,
                                          -ANJAY_ERR_REQUEST_ENTITY_INCOMPLETE);
@@ -326,6 +390,8 @@ static int receive_request(coap_server_t *server) {
                                     msg, server->last_error_code);
         }
         return -1;
+    case PROCESS_INITIAL_SERVED_FROM_CACHE:
+        return ANJAY_COAP_STREAM_REQUEST_HANDLED;
     case PROCESS_INITIAL_OK:
         return 0;
     }
@@ -668,19 +734,34 @@ static int block_write(coap_server_t *server,
         if (!server->static_id_source) {
             return -1;
         }
+        // needs to be done before creating the block context, as it adds
+        // the ETag option to the response
+        start_recording_response(server);
         server->block_ctx = _anjay_coap_block_response_new(
                 block_size, &server->common, server->static_id_source,
                 &server->block_relation_validator);
 
         if (!server->block_ctx) {
+            abort_recording_response(server);
             _anjay_coap_id_source_release(&server->static_id_source);
             return -1;
         }
 
     }
+    _anjay_coap_block_response_cache_append(
+            server->common.block_response_cache, data, data_length);
     int result = _anjay_coap_block_transfer_write(server->block_ctx, data,
                                                   data_length);
+    if (result == AVS_COAP_CTX_ERR_TIMEOUT
+            && _anjay_coap_block_response_cache_recording(
+                    server->common.block_response_cache)) {
+        // The server stopped requesting further blocks within this exchange,
+        // but it may still request them later. Keep generating the response,
+        // so that the cached payload is complete.
+        return 0;
+    }
     if (result) {
+        abort_recording_response(server);
         server->request_identity =
                 _anjay_coap_block_response_last_request_id(server->block_ctx);
         _anjay_coap_block_transfer_delete(&server->block_ctx);
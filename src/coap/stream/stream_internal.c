@@ -268,6 +268,11 @@ static int coap_close(avs_stream_abstract_t *stream_) {
 
     _anjay_coap_id_source_release(&stream->id_source);
 
+#ifdef WITH_BLOCK_SEND
+    _anjay_coap_block_response_cache_delete(
+            &stream->data.common.block_response_cache);
+#endif // WITH_BLOCK_SEND
+
     return 0;
 }
 
@@ -446,6 +451,19 @@ int _anjay_coap_stream_get_request_identity(avs_stream_abstract_t *stream_,
     return 0;
 }
 
+int _anjay_coap_stream_build_request(avs_stream_abstract_t *stream_,
+                                     const avs_coap_msg_t **out_msg) {
+    coap_stream_t *stream = (coap_stream_t*)stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+
+    if (stream->state != STREAM_STATE_CLIENT) {
+        coap_log(ERROR, "build_request called while not in CLIENT state");
+        return -1;
+    }
+
+    return _anjay_coap_client_build_request(get_client(stream), out_msg);
+}
+
 void _anjay_coap_stream_set_block_request_validator(
         avs_stream_abstract_t *stream_,
         anjay_coap_block_request_validator_t *validator,
@@ -456,3 +474,42 @@ void _anjay_coap_stream_set_block_request_validator(
     _anjay_coap_server_set_block_request_relation_validator(
             get_server(stream), validator, validator_arg);
 }
+
+int _anjay_coap_stream_set_block_response_cache_size(
+        avs_stream_abstract_t *stream_,
+        size_t max_size) {
+    coap_stream_t *stream = (coap_stream_t *) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+    assert(is_reset(stream));
+
+#ifdef WITH_BLOCK_SEND
+    _anjay_coap_block_response_cache_delete(
+            &stream->data.common.block_response_cache);
+    if (max_size > 0
+            && !(stream->data.common.block_response_cache =
+                    _anjay_coap_block_response_cache_new(max_size))) {
+        return -1;
+    }
+    return 0;
+#else // WITH_BLOCK_SEND
+    if (max_size > 0) {
+        coap_log(ERROR, "caching block-wise responses not supported");
+        return -1;
+    }
+    return 0;
+#endif // WITH_BLOCK_SEND
+}
+
+void _anjay_coap_stream_forget_socket(avs_stream_abstract_t *stream_,
+                                      avs_net_abstract_socket_t *socket) {
+    coap_stream_t *stream = (coap_stream_t *) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+
+#ifdef WITH_BLOCK_SEND
+    _anjay_coap_block_response_cache_forget_socket(
+            stream->data.common.block_response_cache, socket);
+#else // WITH_BLOCK_SEND
+    (void) stream;
+    (void) socket;
+#endif // WITH_BLOCK_SEND
+}
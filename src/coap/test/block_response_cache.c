@@ -0,0 +1,275 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/mock_clock.h>
+#include <anjay_test/coap/socket.h>
+
+#include <avsystem/commons/coap/ctx.h>
+
+#include "../content_format.h"
+#include "../block/response_cache.h"
+#include "utils.h"
+
+// required by the ETAG() macro
+typedef struct {
+    uint8_t size;
+    uint8_t value[8];
+} anjay_coap_etag_t;
+
+#define FULL_PAYLOAD \
+        "0123456789abcdef" "ghijklmnopqrstuv" "wxyzABCDEFGHIJKL" "MNOPQRS"
+
+#define LIFETIME avs_time_duration_from_scalar(60, AVS_TIME_S)
+
+typedef struct {
+    avs_coap_ctx_t *coap_ctx;
+    avs_net_abstract_socket_t *mocksock;
+    coap_block_response_cache_t *cache;
+} test_env_t;
+
+static test_env_t setup(size_t cache_size) {
+    test_env_t env;
+    memset(&env, 0, sizeof(env));
+    AVS_UNIT_ASSERT_SUCCESS(avs_coap_ctx_create(&env.coap_ctx, 0));
+    _anjay_mocksock_create(&env.mocksock, 1252, 1252);
+    avs_unit_mocksock_expect_connect(env.mocksock, "", "");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(env.mocksock, "", ""));
+    env.cache = _anjay_coap_block_response_cache_new(cache_size);
+    AVS_UNIT_ASSERT_NOT_NULL(env.cache);
+    return env;
+}
+
+static void teardown(test_env_t *env) {
+    _anjay_coap_block_response_cache_delete(&env->cache);
+    AVS_UNIT_ASSERT_NULL(env->cache);
+    avs_unit_mocksock_assert_expects_met(env->mocksock);
+    avs_net_socket_cleanup(&env->mocksock);
+    avs_coap_ctx_cleanup(&env->coap_ctx);
+}
+
+static int record_response(test_env_t *env,
+                           avs_net_abstract_socket_t *socket,
+                           const char *payload,
+                           size_t prefix_length) {
+    const avs_coap_msg_t *request = COAP_MSG(CON, GET, ID(0x1000, "req"),
+                                             NO_PAYLOAD, PATH("3", "0"));
+    const avs_coap_msg_t *prefix =
+            COAP_MSG(ACK, CONTENT, ID(0x1000, "req"),
+                     PAYLOAD_EXTERNAL(payload, prefix_length)
+                     CONTENT_FORMAT(PLAINTEXT));
+
+    avs_coap_msg_info_t info = avs_coap_msg_info_init();
+    int result = _anjay_coap_block_response_cache_start(
+            env->cache, socket, request, prefix, &info);
+    avs_coap_msg_info_reset(&info);
+    if (result) {
+        return result;
+    }
+    _anjay_coap_block_response_cache_append(env->cache,
+                                            payload + prefix_length,
+                                            strlen(payload) - prefix_length);
+    if (!_anjay_coap_block_response_cache_recording(env->cache)) {
+        return -1;
+    }
+    _anjay_coap_block_response_cache_commit(env->cache, 16, LIFETIME);
+    return 0;
+}
+
+static int serve(test_env_t *env, const avs_coap_msg_t *request) {
+    return _anjay_coap_block_response_cache_serve(env->cache, env->coap_ctx,
+                                                  env->mocksock, request);
+}
+
+AVS_UNIT_TEST(block_response_cache, serves_further_blocks) {
+    test_env_t env = setup(4096);
+    AVS_UNIT_ASSERT_SUCCESS(
+            record_response(&env, env.mocksock, FULL_PAYLOAD, 10));
+
+    for (uint32_t seq_num = 1; seq_num < 4; ++seq_num) {
+        const avs_coap_msg_t *response =
+                COAP_MSG(ACK, CONTENT, ID(0x2000 + seq_num, "next"),
+                         BLOCK2(seq_num, 16, FULL_PAYLOAD),
+                         ETAG("\x00\x00\x00\x01"), CONTENT_FORMAT(PLAINTEXT));
+        avs_unit_mocksock_expect_output(env.mocksock, response->content,
+                                        response->length);
+        AVS_UNIT_ASSERT_SUCCESS(serve(
+                &env, COAP_MSG(CON, GET, ID(0x2000 + seq_num, "next"),
+                               BLOCK2(seq_num, 16), PATH("3", "0"))));
+    }
+
+    // the same block may be requested again
+    const avs_coap_msg_t *response =
+            COAP_MSG(ACK, CONTENT, ID(0x3000, "again"),
+                     BLOCK2(1, 16, FULL_PAYLOAD),
+                     ETAG("\x00\x00\x00\x01"), CONTENT_FORMAT(PLAINTEXT));
+    avs_unit_mocksock_expect_output(env.mocksock, response->content,
+                                    response->length);
+    AVS_UNIT_ASSERT_SUCCESS(serve(&env, COAP_MSG(CON, GET, ID(0x3000, "again"),
+                                                 BLOCK2(1, 16),
+                                                 PATH("3", "0"))));
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(block_response_cache, block_size_negotiation) {
+    test_env_t env = setup(4096);
+    AVS_UNIT_ASSERT_SUCCESS(
+            record_response(&env, env.mocksock, FULL_PAYLOAD, 10));
+
+    // smaller blocks are served as requested
+    const avs_coap_msg_t *response =
+            COAP_MSG(ACK, CONTENT, ID(0x2000), BLOCK2(5, 8, FULL_PAYLOAD),
+                     ETAG("\x00\x00\x00\x01"), CONTENT_FORMAT(PLAINTEXT));
+    avs_unit_mocksock_expect_output(env.mocksock, response->content,
+                                    response->length);
+    AVS_UNIT_ASSERT_SUCCESS(serve(&env, COAP_MSG(CON, GET, ID(0x2000),
+                                                 BLOCK2(5, 8),
+                                                 PATH("3", "0"))));
+
+    // larger ones are limited to the size used when generating the response
+    response = COAP_MSG(ACK, CONTENT, ID(0x2001), BLOCK2(2, 16, FULL_PAYLOAD),
+                        ETAG("\x00\x00\x00\x01"), CONTENT_FORMAT(PLAINTEXT));
+    avs_unit_mocksock_expect_output(env.mocksock, response->content,
+                                    response->length);
+    AVS_UNIT_ASSERT_SUCCESS(serve(&env, COAP_MSG(CON, GET, ID(0x2001),
+                                                 BLOCK2(1, 32),
+                                                 PATH("3", "0"))));
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(block_response_cache, mismatched_requests) {
+    test_env_t env = setup(4096);
+    AVS_UNIT_ASSERT_SUCCESS(
+            record_response(&env, env.mocksock, FULL_PAYLOAD, 10));
+
+    // different path
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, GET, ID(0x2000),
+                                               BLOCK2(1, 16),
+                                               PATH("3", "1"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+    // additional critical option
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, GET, ID(0x2001),
+                                               BLOCK2(1, 16), PATH("3", "0"),
+                                               ACCEPT(ANJAY_COAP_FORMAT_TLV))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+    // different method
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, PUT, ID(0x2002),
+                                               BLOCK2(1, 16),
+                                               PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+    // first block is never served from the cache
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, GET, ID(0x2003),
+                                               BLOCK2(0, 16),
+                                               PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+    // past the end of payload
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, GET, ID(0x2004),
+                                               BLOCK2(4, 16),
+                                               PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+    // not a BLOCK2 request
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, GET, ID(0x2005),
+                                               NO_PAYLOAD, PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+
+    // different socket
+    avs_net_abstract_socket_t *other_socket = NULL;
+    _anjay_mocksock_create(&other_socket, 1252, 1252);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_response_cache_serve(
+                                  env.cache, env.coap_ctx, other_socket,
+                                  COAP_MSG(CON, GET, ID(0x2006), BLOCK2(1, 16),
+                                           PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+    avs_net_socket_cleanup(&other_socket);
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(block_response_cache, forget_socket) {
+    test_env_t env = setup(4096);
+    AVS_UNIT_ASSERT_SUCCESS(
+            record_response(&env, env.mocksock, FULL_PAYLOAD, 10));
+
+    _anjay_coap_block_response_cache_forget_socket(env.cache, env.mocksock);
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, GET, ID(0x2000),
+                                               BLOCK2(1, 16),
+                                               PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(block_response_cache, expiration) {
+    test_env_t env = setup(4096);
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(1000, AVS_TIME_S));
+    AVS_UNIT_ASSERT_SUCCESS(
+            record_response(&env, env.mocksock, FULL_PAYLOAD, 10));
+
+    _anjay_mock_clock_advance(LIFETIME);
+    AVS_UNIT_ASSERT_EQUAL(serve(&env, COAP_MSG(CON, GET, ID(0x2000),
+                                               BLOCK2(1, 16),
+                                               PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+
+    _anjay_mock_clock_finish();
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(block_response_cache, size_limit) {
+    // enough for a single response, but not for two of them
+    test_env_t env = setup(256);
+
+    avs_net_abstract_socket_t *other_socket = NULL;
+    _anjay_mocksock_create(&other_socket, 1252, 1252);
+    AVS_UNIT_ASSERT_SUCCESS(
+            record_response(&env, other_socket, FULL_PAYLOAD, 10));
+    AVS_UNIT_ASSERT_SUCCESS(
+            record_response(&env, env.mocksock, FULL_PAYLOAD, 10));
+
+    // the older response got evicted
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_response_cache_serve(
+                                  env.cache, env.coap_ctx, other_socket,
+                                  COAP_MSG(CON, GET, ID(0x2000), BLOCK2(1, 16),
+                                           PATH("3", "0"))),
+                          ANJAY_COAP_BLOCK_RESPONSE_CACHE_MISS);
+    avs_net_socket_cleanup(&other_socket);
+
+    // the newer one is still available
+    const avs_coap_msg_t *response =
+            COAP_MSG(ACK, CONTENT, ID(0x2001), BLOCK2(1, 16, FULL_PAYLOAD),
+                     ETAG("\x00\x00\x00\x02"), CONTENT_FORMAT(PLAINTEXT));
+    avs_unit_mocksock_expect_output(env.mocksock, response->content,
+                                    response->length);
+    AVS_UNIT_ASSERT_SUCCESS(serve(&env, COAP_MSG(CON, GET, ID(0x2001),
+                                                 BLOCK2(1, 16),
+                                                 PATH("3", "0"))));
+
+    // responses that do not fit at all are not cached
+    static char large_payload[1024];
+    memset(large_payload, 'x', sizeof(large_payload) - 1);
+    AVS_UNIT_ASSERT_FAILED(
+            record_response(&env, env.mocksock, large_payload, 10));
+    AVS_UNIT_ASSERT_FALSE(
+            _anjay_coap_block_response_cache_recording(env.cache));
+
+    teardown(&env);
+}
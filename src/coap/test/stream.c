@@ -692,6 +692,76 @@ AVS_UNIT_TEST(coap_stream, response_no_request) {
     teardown_test(&test);
 }
 
+AVS_UNIT_TEST(coap_stream, build_request) {
+    test_data_t test = setup_test();
+
+    const anjay_msg_details_t details = {
+        .msg_type = AVS_COAP_MSG_CONFIRMABLE,
+        .msg_code = AVS_COAP_CODE_CONTENT,
+        .format = ANJAY_COAP_FORMAT_PLAINTEXT
+    };
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_coap_stream_setup_request(test.stream, &details, NULL));
+
+    const char DATA[] = "Bacon ipsum dolor amet";
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(test.stream, DATA,
+                                             sizeof(DATA) - 1));
+
+    // nothing is expected to be sent
+    const avs_coap_msg_t *msg = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_stream_build_request(test.stream,
+                                                             &msg));
+    AVS_UNIT_ASSERT_NOT_NULL(msg);
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_get_type(msg),
+                          AVS_COAP_MSG_CONFIRMABLE);
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_get_code(msg), AVS_COAP_CODE_CONTENT);
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_payload_length(msg), sizeof(DATA) - 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(avs_coap_msg_payload(msg), DATA,
+                                      sizeof(DATA) - 1);
+
+    avs_stream_reset(test.stream);
+    teardown_test(&test);
+}
+
+AVS_UNIT_TEST(coap_stream, incoming_ack) {
+    test_data_t test = setup_test();
+
+    const avs_coap_msg_t *ack = COAP_MSG(ACK, EMPTY, ID(0x0001));
+    avs_unit_mocksock_input(test.mock_socket, ack->content, ack->length);
+
+    // Acknowledgements are passed to the upper layers, so that they may
+    // conclude asynchronous exchanges
+    const avs_coap_msg_t *msg;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_stream_get_incoming_msg(test.stream,
+                                                                &msg));
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_get_type(msg),
+                          AVS_COAP_MSG_ACKNOWLEDGEMENT);
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_get_id(msg), 0x0001);
+
+    teardown_test(&test);
+}
+
+AVS_UNIT_TEST(coap_stream, incoming_response) {
+    test_data_t test = setup_test();
+
+    const avs_coap_msg_t *response = COAP_MSG(CON, CREATED,
+                                              ID(0x0002, "Res"));
+    avs_unit_mocksock_input(test.mock_socket, response->content,
+                            response->length);
+
+    // responses, e.g. Separate Responses to requests sent asynchronously, are
+    // passed to the upper layers as well - nothing is sent in reply here
+    const avs_coap_msg_t *msg;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_stream_get_incoming_msg(test.stream,
+                                                                &msg));
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_get_type(msg),
+                          AVS_COAP_MSG_CONFIRMABLE);
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_get_code(msg), AVS_COAP_CODE_CREATED);
+    AVS_UNIT_ASSERT_EQUAL(avs_coap_msg_get_id(msg), 0x0002);
+
+    teardown_test(&test);
+}
+
 AVS_UNIT_TEST(coap_stream, fuzz_1_invalid_block_size) {
     // According to [ietf-core-block-21], 2.2 "Structure of a Block Option":
     // > The value 7 for SZX (which would indicate a block size of 2048) is
@@ -0,0 +1,358 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+
+#include "anjay_core.h"
+#include "coap_async.h"
+#include "servers_utils.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#define async_log(...) _anjay_log(coap_async, __VA_ARGS__)
+
+struct anjay_coap_async_exchange_struct {
+    anjay_connection_key_t key;
+    avs_coap_msg_identity_t identity;
+    anjay_coap_async_handler_t *handler;
+    avs_coap_retry_state_t retry_state;
+    // either the retransmission or the Separate Response timeout job
+    anjay_sched_handle_t timeout_job;
+    // set after an empty Acknowledgement to a request has been received
+    bool awaiting_separate_response;
+    avs_coap_msg_t *msg;
+};
+
+static AVS_LIST(anjay_coap_async_exchange_t) *
+find_exchange_ptr(anjay_t *anjay,
+                  anjay_connection_key_t key,
+                  uint16_t msg_id) {
+    AVS_LIST(anjay_coap_async_exchange_t) *exchange_ptr;
+    AVS_LIST_FOREACH_PTR(exchange_ptr, &anjay->coap_async.exchanges) {
+        if ((*exchange_ptr)->identity.msg_id == msg_id
+                && (*exchange_ptr)->key.ssid == key.ssid
+                && (*exchange_ptr)->key.type == key.type) {
+            return exchange_ptr;
+        }
+    }
+    return NULL;
+}
+
+static AVS_LIST(anjay_coap_async_exchange_t) *
+find_request_exchange_ptr(anjay_t *anjay,
+                          anjay_connection_key_t key,
+                          const avs_coap_msg_t *response) {
+    AVS_LIST(anjay_coap_async_exchange_t) *exchange_ptr;
+    AVS_LIST_FOREACH_PTR(exchange_ptr, &anjay->coap_async.exchanges) {
+        if ((*exchange_ptr)->key.ssid == key.ssid
+                && (*exchange_ptr)->key.type == key.type
+                && avs_coap_msg_is_request((*exchange_ptr)->msg)
+                && avs_coap_msg_token_matches(response,
+                                              &(*exchange_ptr)->identity)) {
+            return exchange_ptr;
+        }
+    }
+    return NULL;
+}
+
+static void delete_exchange(anjay_t *anjay,
+                            AVS_LIST(anjay_coap_async_exchange_t) *exchange) {
+    _anjay_sched_del(anjay->sched, &(*exchange)->timeout_job);
+    avs_free((*exchange)->msg);
+    AVS_LIST_DELETE(exchange);
+}
+
+static void finish_exchange(anjay_t *anjay,
+                            AVS_LIST(anjay_coap_async_exchange_t) *exchange_ptr,
+                            anjay_coap_async_result_t result,
+                            const avs_coap_msg_t *response) {
+    // detach first, so that the handler is free to create or cancel exchanges
+    AVS_LIST(anjay_coap_async_exchange_t) exchange =
+            AVS_LIST_DETACH(exchange_ptr);
+    anjay_connection_key_t key = exchange->key;
+    uint16_t msg_id = exchange->identity.msg_id;
+    anjay_coap_async_handler_t *handler = exchange->handler;
+    delete_exchange(anjay, &exchange);
+
+    handler(anjay, key, msg_id, result, response);
+}
+
+static avs_net_abstract_socket_t *
+get_online_socket(anjay_t *anjay, anjay_connection_key_t key) {
+    anjay_connection_ref_t ref = {
+        .server = _anjay_servers_find_active(anjay, key.ssid),
+        .conn_type = key.type
+    };
+    avs_net_abstract_socket_t *socket = NULL;
+    if (!ref.server || !(socket = _anjay_connection_get_online_socket(ref))) {
+        async_log(ERROR, "connection for SSID %" PRIu16 " is not online",
+                  key.ssid);
+    }
+    return socket;
+}
+
+static int send_exchange_msg(anjay_t *anjay,
+                             const anjay_coap_async_exchange_t *exchange) {
+    avs_net_abstract_socket_t *socket = get_online_socket(anjay,
+                                                          exchange->key);
+    if (!socket) {
+        return AVS_COAP_CTX_ERR_NETWORK;
+    }
+    return avs_coap_ctx_send(anjay->coap_ctx, socket, exchange->msg);
+}
+
+static void retransmit_job(anjay_t *anjay, const void *exchange_ptr);
+
+static int schedule_retransmission(anjay_t *anjay,
+                                   anjay_coap_async_exchange_t *exchange) {
+    avs_coap_update_retry_state(
+            &exchange->retry_state,
+            _anjay_tx_params_for_conn_type(anjay, exchange->key.type),
+            &anjay->coap_async.rand_seed);
+    _anjay_sched_del(anjay->sched, &exchange->timeout_job);
+    return _anjay_sched(anjay->sched, &exchange->timeout_job,
+                        exchange->retry_state.recv_timeout, retransmit_job,
+                        &exchange, sizeof(exchange));
+}
+
+static AVS_LIST(anjay_coap_async_exchange_t) *
+get_exchange_ptr(anjay_t *anjay, const void *exchange_ptr) {
+    anjay_coap_async_exchange_t *exchange =
+            *(anjay_coap_async_exchange_t *const *) exchange_ptr;
+    AVS_LIST(anjay_coap_async_exchange_t) *list_ptr =
+            find_exchange_ptr(anjay, exchange->key, exchange->identity.msg_id);
+    assert(list_ptr && *list_ptr == exchange);
+    return list_ptr;
+}
+
+static void retransmit_job(anjay_t *anjay, const void *exchange_ptr) {
+    AVS_LIST(anjay_coap_async_exchange_t) *list_ptr =
+            get_exchange_ptr(anjay, exchange_ptr);
+    anjay_coap_async_exchange_t *exchange = *list_ptr;
+
+    const avs_coap_tx_params_t *tx_params =
+            _anjay_tx_params_for_conn_type(anjay, exchange->key.type);
+    if (exchange->retry_state.retry_count > tx_params->max_retransmit) {
+        async_log(ERROR, "Limit of retransmissions reached for message "
+                  "id = %" PRIu16, exchange->identity.msg_id);
+        finish_exchange(anjay, list_ptr, ANJAY_COAP_ASYNC_TIMEOUT, NULL);
+        return;
+    }
+
+    int result = send_exchange_msg(anjay, exchange);
+    if (result) {
+        async_log(ERROR, "could not retransmit message id = %" PRIu16 ": %d",
+                  exchange->identity.msg_id, result);
+    }
+    if (result == AVS_COAP_CTX_ERR_NETWORK) {
+        finish_exchange(anjay, list_ptr, ANJAY_COAP_ASYNC_NETWORK_ERROR, NULL);
+    } else if (schedule_retransmission(anjay, exchange)) {
+        async_log(WARNING, "could not schedule retransmission for message "
+                  "id = %" PRIu16, exchange->identity.msg_id);
+        finish_exchange(anjay, list_ptr, ANJAY_COAP_ASYNC_NETWORK_ERROR, NULL);
+    }
+}
+
+static void separate_response_timeout_job(anjay_t *anjay,
+                                          const void *exchange_ptr) {
+    AVS_LIST(anjay_coap_async_exchange_t) *list_ptr =
+            get_exchange_ptr(anjay, exchange_ptr);
+    async_log(ERROR, "Separate Response to message id = %" PRIu16
+              " not received in time", (*list_ptr)->identity.msg_id);
+    finish_exchange(anjay, list_ptr, ANJAY_COAP_ASYNC_TIMEOUT, NULL);
+}
+
+static void
+wait_for_separate_response(anjay_t *anjay,
+                           AVS_LIST(anjay_coap_async_exchange_t) *list_ptr) {
+    anjay_coap_async_exchange_t *exchange = *list_ptr;
+    async_log(TRACE, "empty ACK received for message id = %" PRIu16
+              ", waiting for Separate Response", exchange->identity.msg_id);
+    exchange->awaiting_separate_response = true;
+    _anjay_sched_del(anjay->sched, &exchange->timeout_job);
+    if (_anjay_sched(anjay->sched, &exchange->timeout_job,
+                     AVS_COAP_SEPARATE_RESPONSE_TIMEOUT,
+                     separate_response_timeout_job,
+                     &exchange, sizeof(exchange))) {
+        async_log(WARNING, "could not schedule Separate Response timeout for "
+                  "message id = %" PRIu16, exchange->identity.msg_id);
+        finish_exchange(anjay, list_ptr, ANJAY_COAP_ASYNC_NETWORK_ERROR, NULL);
+    }
+}
+
+int _anjay_coap_async_send(anjay_t *anjay,
+                           anjay_connection_key_t key,
+                           const avs_coap_msg_t *msg,
+                           anjay_coap_async_handler_t *handler) {
+    assert(avs_coap_msg_get_type(msg) == AVS_COAP_MSG_CONFIRMABLE);
+    assert(handler);
+
+    const uint16_t msg_id = avs_coap_msg_get_id(msg);
+    if (find_exchange_ptr(anjay, key, msg_id)) {
+        async_log(ERROR, "exchange with message id = %" PRIu16
+                  " already in progress", msg_id);
+        return -1;
+    }
+
+    AVS_LIST(anjay_coap_async_exchange_t) exchange =
+            AVS_LIST_NEW_ELEMENT(anjay_coap_async_exchange_t);
+    const size_t msg_size = offsetof(avs_coap_msg_t, content) + msg->length;
+    if (!exchange
+            || !(exchange->msg = (avs_coap_msg_t *) avs_malloc(msg_size))) {
+        async_log(ERROR, "Out of memory");
+        AVS_LIST_CLEAR(&exchange);
+        return -1;
+    }
+    memcpy(exchange->msg, msg, msg_size);
+    exchange->key = key;
+    exchange->identity = avs_coap_msg_get_identity(msg);
+    exchange->handler = handler;
+
+    int result = send_exchange_msg(anjay, exchange);
+    if (!result && (result = schedule_retransmission(anjay, exchange))) {
+        async_log(ERROR, "could not schedule retransmission for message "
+                  "id = %" PRIu16, msg_id);
+    }
+    if (result) {
+        delete_exchange(anjay, &exchange);
+        return result;
+    }
+
+    AVS_LIST_INSERT(&anjay->coap_async.exchanges, exchange);
+    return 0;
+}
+
+static int handle_ack_or_reset(anjay_t *anjay,
+                               anjay_connection_key_t key,
+                               const avs_coap_msg_t *msg) {
+    const uint16_t msg_id = avs_coap_msg_get_id(msg);
+    AVS_LIST(anjay_coap_async_exchange_t) *exchange_ptr =
+            find_exchange_ptr(anjay, key, msg_id);
+    if (!exchange_ptr) {
+        return 1;
+    }
+    if ((*exchange_ptr)->awaiting_separate_response) {
+        async_log(TRACE, "message id = %" PRIu16 " already acknowledged",
+                  msg_id);
+        return 0;
+    }
+
+    if (avs_coap_msg_get_type(msg) == AVS_COAP_MSG_RESET) {
+        async_log(TRACE, "Reset received for message id = %" PRIu16, msg_id);
+        finish_exchange(anjay, exchange_ptr, ANJAY_COAP_ASYNC_RESET, NULL);
+        return 0;
+    }
+
+    if (avs_coap_msg_is_request((*exchange_ptr)->msg)) {
+        if (avs_coap_msg_get_code(msg) == AVS_COAP_CODE_EMPTY) {
+            wait_for_separate_response(anjay, exchange_ptr);
+            return 0;
+        } else if (!avs_coap_msg_token_matches(msg,
+                                               &(*exchange_ptr)->identity)) {
+            async_log(DEBUG, "invalid response to message id = %" PRIu16
+                      ": token mismatch", msg_id);
+            return 1;
+        }
+    }
+    async_log(TRACE, "ACK received for message id = %" PRIu16, msg_id);
+    finish_exchange(anjay, exchange_ptr, ANJAY_COAP_ASYNC_ACKED, msg);
+    return 0;
+}
+
+static int handle_separate_response(anjay_t *anjay,
+                                    anjay_connection_key_t key,
+                                    const avs_coap_msg_t *msg) {
+    // the Separate Response may also arrive before the empty ACK, if the
+    // latter got lost - so the exchange state is not checked here
+    AVS_LIST(anjay_coap_async_exchange_t) *exchange_ptr =
+            find_request_exchange_ptr(anjay, key, msg);
+    if (!exchange_ptr) {
+        return 1;
+    }
+
+    async_log(TRACE, "Separate Response received for message id = %" PRIu16,
+              (*exchange_ptr)->identity.msg_id);
+    if (avs_coap_msg_get_type(msg) == AVS_COAP_MSG_CONFIRMABLE) {
+        avs_net_abstract_socket_t *socket = get_online_socket(anjay, key);
+        if (socket) {
+            avs_coap_ctx_send_empty(anjay->coap_ctx, socket,
+                                    AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                                    avs_coap_msg_get_id(msg));
+        }
+    }
+    finish_exchange(anjay, exchange_ptr, ANJAY_COAP_ASYNC_ACKED, msg);
+    return 0;
+}
+
+int _anjay_coap_async_handle_response(anjay_t *anjay,
+                                      const avs_coap_msg_t *msg) {
+    const anjay_connection_key_t key = {
+        .ssid = _anjay_dm_current_ssid(anjay),
+        .type = anjay->current_connection.conn_type
+    };
+
+    switch (avs_coap_msg_get_type(msg)) {
+    case AVS_COAP_MSG_ACKNOWLEDGEMENT:
+    case AVS_COAP_MSG_RESET:
+        return handle_ack_or_reset(anjay, key, msg);
+    default:
+        if (avs_coap_msg_is_request(msg)) {
+            return 1;
+        }
+        return handle_separate_response(anjay, key, msg);
+    }
+}
+
+void _anjay_coap_async_cancel(anjay_t *anjay,
+                              anjay_connection_key_t key,
+                              uint16_t msg_id) {
+    AVS_LIST(anjay_coap_async_exchange_t) *exchange_ptr =
+            find_exchange_ptr(anjay, key, msg_id);
+    if (exchange_ptr) {
+        delete_exchange(anjay, exchange_ptr);
+    }
+}
+
+void _anjay_coap_async_cleanup(anjay_t *anjay) {
+    while (anjay->coap_async.exchanges) {
+        delete_exchange(anjay, &anjay->coap_async.exchanges);
+    }
+}
+
+int _anjay_coap_async_result_to_error(anjay_coap_async_result_t result) {
+    switch (result) {
+    case ANJAY_COAP_ASYNC_ACKED:
+        return 0;
+    case ANJAY_COAP_ASYNC_RESET:
+        async_log(ERROR, "request rejected with Reset");
+        return -1;
+    case ANJAY_COAP_ASYNC_TIMEOUT:
+        async_log(ERROR, "no response received");
+        return AVS_COAP_CTX_ERR_TIMEOUT;
+    case ANJAY_COAP_ASYNC_NETWORK_ERROR:
+        async_log(ERROR, "network error while waiting for response");
+        return AVS_COAP_CTX_ERR_NETWORK;
+    }
+    AVS_UNREACHABLE("invalid anjay_coap_async_result_t value");
+    return -1;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_ASYNC_H
+#define ANJAY_COAP_ASYNC_H
+
+#include <avsystem/commons/coap/ctx.h>
+#include <avsystem/commons/coap/msg.h>
+#include <avsystem/commons/list.h>
+
+#include "servers.h"
+#include "utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Confirmable exchanges that are driven by the scheduler instead of blocking
+ * the caller until the response arrives.
+ *
+ * Each exchange is a copy of a Confirmable message sent over one of the server
+ * connections. Retransmissions are performed as scheduler jobs, according to
+ * the transmission parameters of the connection. The exchange is concluded
+ * when an Acknowledgement or Reset with a matching Message ID is received in
+ * anjay_serve(), or when the retransmission limit is reached.
+ *
+ * If the message is a request, an empty Acknowledgement only stops the
+ * retransmissions - the exchange is then concluded by a Separate Response with
+ * a matching token, or after AVS_COAP_SEPARATE_RESPONSE_TIMEOUT passes without
+ * one.
+ */
+typedef enum {
+    ANJAY_COAP_ASYNC_ACKED,
+    ANJAY_COAP_ASYNC_RESET,
+    ANJAY_COAP_ASYNC_TIMEOUT,
+    ANJAY_COAP_ASYNC_NETWORK_ERROR
+} anjay_coap_async_result_t;
+
+/**
+ * Called exactly once for each exchange that has not been cancelled.
+ *
+ * @p response is only non-NULL if @p result is ANJAY_COAP_ASYNC_ACKED. It is
+ * then the message that concluded the exchange: the Acknowledgement, possibly
+ * with a piggybacked response, or the Separate Response to a request. It is
+ * only valid until the handler returns.
+ *
+ * Note that the handler may be called from within anjay_serve(), while the
+ * server stream is bound, so it MUST NOT attempt to send any messages through
+ * the stream directly - it shall schedule a job for that instead.
+ */
+typedef void anjay_coap_async_handler_t(anjay_t *anjay,
+                                        anjay_connection_key_t key,
+                                        uint16_t msg_id,
+                                        anjay_coap_async_result_t result,
+                                        const avs_coap_msg_t *response);
+
+typedef struct anjay_coap_async_exchange_struct anjay_coap_async_exchange_t;
+
+typedef struct {
+    AVS_LIST(anjay_coap_async_exchange_t) exchanges;
+    anjay_rand_seed_t rand_seed;
+} anjay_coap_async_t;
+
+/**
+ * Sends a Confirmable message @p msg over the connection identified by @p key
+ * and schedules its retransmissions. The message is copied, so it does not
+ * need to outlive this call.
+ *
+ * @returns 0 on success, or a negative value in case of error. In the latter
+ *          case, no exchange is created and @p handler is never called.
+ */
+int _anjay_coap_async_send(anjay_t *anjay,
+                           anjay_connection_key_t key,
+                           const avs_coap_msg_t *msg,
+                           anjay_coap_async_handler_t *handler);
+
+/**
+ * Concludes the exchange matching the Acknowledgement, Reset or Separate
+ * Response message @p msg received over the currently bound server connection.
+ * A Confirmable Separate Response is acknowledged.
+ *
+ * @returns 0 if a matching exchange was found and its handler was called,
+ *          or a positive value if there is no matching exchange.
+ */
+int _anjay_coap_async_handle_response(anjay_t *anjay,
+                                      const avs_coap_msg_t *msg);
+
+/**
+ * Aborts the exchange identified by @p key and @p msg_id, if it exists. Its
+ * handler is not called.
+ */
+void _anjay_coap_async_cancel(anjay_t *anjay,
+                              anjay_connection_key_t key,
+                              uint16_t msg_id);
+
+/**
+ * Aborts all pending exchanges without calling their handlers.
+ */
+void _anjay_coap_async_cleanup(anjay_t *anjay);
+
+/**
+ * Converts the outcome of an exchange, as passed to the handler, to an error
+ * code compatible with the ones used by the CoAP context.
+ *
+ * @returns 0 for ANJAY_COAP_ASYNC_ACKED, AVS_COAP_CTX_ERR_TIMEOUT or
+ *          AVS_COAP_CTX_ERR_NETWORK for timeouts and network errors,
+ *          respectively, or -1 for ANJAY_COAP_ASYNC_RESET.
+ */
+int _anjay_coap_async_result_to_error(anjay_coap_async_result_t result);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_COAP_ASYNC_H */
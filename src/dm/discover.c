@@ -17,6 +17,7 @@
 #include <anjay_config.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 #include <anjay_modules/time_defs.h>
 
@@ -25,16 +26,36 @@
 
 #include "../dm_core.h"
 #include "../anjay_core.h"
+#include "../number_format.h"
 
 VISIBILITY_SOURCE_BEGIN
 
+static int print_attr(avs_stream_abstract_t *stream,
+                      const char *name,
+                      const char *value,
+                      size_t value_length) {
+    int result;
+    (void) ((result = avs_stream_write(stream, ";", 1))
+            || (result = avs_stream_write(stream, name, strlen(name)))
+            || (result = avs_stream_write(stream, "=", 1))
+            || (result = avs_stream_write(stream, value, value_length)));
+    return result;
+}
+
+static int print_int_attr(avs_stream_abstract_t *stream,
+                          const char *name,
+                          int64_t value) {
+    char buf[ANJAY_INT_STRING_BUF_SIZE];
+    return print_attr(stream, name, buf, _anjay_int64_as_string(value, buf));
+}
+
 static int print_period_attr(avs_stream_abstract_t *stream,
                              const char *name,
                              int32_t t) {
     if (t < 0) {
         return 0;
     }
-    return avs_stream_write_f(stream, ";%s=%lu", name, (unsigned long) t);
+    return print_int_attr(stream, name, t);
 }
 
 #ifdef WITH_CON_ATTR
@@ -43,8 +64,7 @@ static int print_con_attr(avs_stream_abstract_t *stream,
     if (value < 0) {
         return 0;
     }
-    return avs_stream_write_f(stream, ";" ANJAY_CUSTOM_ATTR_CON "=%d",
-                              (int) value);
+    return print_int_attr(stream, ANJAY_CUSTOM_ATTR_CON, value);
 }
 #else // WITH_CON_ATTR
 #define print_con_attr(...) 0
@@ -56,7 +76,8 @@ static int print_double_attr(avs_stream_abstract_t *stream,
     if (isnan(value)) {
         return 0;
     }
-    return avs_stream_write_f(stream, ";%s=%.17g", name, value);
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE];
+    return print_attr(stream, name, buf, _anjay_double_as_string(value, buf));
 }
 
 static int print_attrs(avs_stream_abstract_t *stream,
@@ -75,8 +96,7 @@ static int print_resource_attrs(avs_stream_abstract_t *stream,
                                 const anjay_dm_internal_res_attrs_t *attrs) {
     int result = 0;
     if (resource_dim >= 0) {
-        result = avs_stream_write_f(stream, ";dim=%" PRIu32,
-                                    (uint32_t) resource_dim);
+        result = print_int_attr(stream, "dim", resource_dim);
     }
     if (!result) {
         (void) ((result = print_attrs(stream,
@@ -69,6 +69,18 @@ get_handler_from_overlay(anjay_t *anjay,
     }
 }
 
+/**
+ * Checks whether the call would reach the handler of the object itself, i.e.
+ * no overlay module after @p current_module implements the handler. Static
+ * Resource information declared in the object definition only replaces that
+ * last handler.
+ */
+static bool at_end_of_overlay_chain(anjay_t *anjay,
+                                    const anjay_dm_module_t *current_module,
+                                    size_t handler_offset) {
+    return !get_handler_from_overlay(anjay, current_module, handler_offset);
+}
+
 static const anjay_dm_handlers_t *
 get_handler(anjay_t *anjay,
             const anjay_dm_object_def_t *const *obj_ptr,
@@ -92,6 +104,34 @@ bool _anjay_dm_handler_implemented(anjay_t *anjay,
     return get_handler(anjay, obj_ptr, current_module, handler_offset) != NULL;
 }
 
+/**
+ * Checks whether an overlay module after @p current_module implements the
+ * handler at @p handler_offset, but is not the provider of @p handler, i.e.
+ * would not be called if @p handler was used instead.
+ */
+static bool bypasses_overlay(anjay_t *anjay,
+                             const anjay_dm_module_t *current_module,
+                             const anjay_dm_handlers_t *handler,
+                             size_t handler_offset) {
+    const anjay_dm_handlers_t *overlay =
+            get_handler_from_overlay(anjay, current_module, handler_offset);
+    return overlay && overlay != handler;
+}
+
+bool _anjay_dm_instance_read_usable(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    const anjay_dm_module_t *current_module) {
+    const anjay_dm_handlers_t *handler =
+            get_handler(anjay, obj_ptr, current_module,
+                        offsetof(anjay_dm_handlers_t, instance_read));
+    return handler
+            && !bypasses_overlay(anjay, current_module, handler,
+                                 offsetof(anjay_dm_handlers_t,
+                                          resource_present))
+            && !bypasses_overlay(anjay, current_module, handler,
+                                 offsetof(anjay_dm_handlers_t, resource_read));
+}
+
 #define CHECKED_TAIL_CALL_HANDLER(Anjay, ObjPtr, Current, HandlerName, ...) \
     do { \
         const anjay_dm_handlers_t *handler = \
@@ -224,24 +264,15 @@ _anjay_dm_resource_supported_and_present(anjay_t *anjay,
     return 0;
 }
 
-int _anjay_dm_resource_present(anjay_t *anjay,
-                               const anjay_dm_object_def_t *const *obj_ptr,
-                               anjay_iid_t iid,
-                               anjay_rid_t rid,
-                               const anjay_dm_module_t *current_module) {
-    anjay_log(TRACE, "resource_present /%u/%u/%u", (*obj_ptr)->oid, iid, rid);
-    CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module,
-                              resource_present, anjay, obj_ptr, iid, rid);
-}
-
-bool _anjay_dm_resource_supported(const anjay_dm_object_def_t *const *obj_ptr,
-                                  anjay_rid_t rid) {
-    anjay_log(TRACE, "resource_supported /%u/*/%u", (*obj_ptr)->oid, rid);
+static bool find_rid_index(const anjay_dm_object_def_t *const *obj_ptr,
+                           anjay_rid_t rid,
+                           size_t *out_index) {
     size_t left = 0;
     size_t right = (*obj_ptr)->supported_rids.count;
     while (left < right) {
         size_t mid = (left + right) / 2;
         if ((*obj_ptr)->supported_rids.rids[mid] == rid) {
+            *out_index = mid;
             return true;
         } else if ((*obj_ptr)->supported_rids.rids[mid] < rid) {
             left = mid + 1;
@@ -252,12 +283,47 @@ bool _anjay_dm_resource_supported(const anjay_dm_object_def_t *const *obj_ptr,
     return false;
 }
 
+int _anjay_dm_resource_present(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj_ptr,
+                               anjay_iid_t iid,
+                               anjay_rid_t rid,
+                               const anjay_dm_module_t *current_module) {
+    anjay_log(TRACE, "resource_present /%u/%u/%u", (*obj_ptr)->oid, iid, rid);
+    const uint8_t *always_present = (*obj_ptr)->static_rids_info.always_present;
+    size_t index;
+    if (always_present && find_rid_index(obj_ptr, rid, &index)
+            && ANJAY_DM_RID_REQUESTED(always_present, index)
+            && at_end_of_overlay_chain(anjay, current_module,
+                                       offsetof(anjay_dm_handlers_t,
+                                                resource_present))) {
+        return 1;
+    }
+    CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module,
+                              resource_present, anjay, obj_ptr, iid, rid);
+}
+
+bool _anjay_dm_resource_supported(const anjay_dm_object_def_t *const *obj_ptr,
+                                  anjay_rid_t rid) {
+    anjay_log(TRACE, "resource_supported /%u/*/%u", (*obj_ptr)->oid, rid);
+    size_t index;
+    return find_rid_index(obj_ptr, rid, &index);
+}
+
 int _anjay_dm_resource_operations(anjay_t *anjay,
                                   const anjay_dm_object_def_t *const *obj_ptr,
                                   anjay_rid_t rid,
                                   anjay_dm_resource_op_mask_t *out,
                                   const anjay_dm_module_t *current_module) {
     anjay_log(TRACE, "resource_operations /%u/*/%u", (*obj_ptr)->oid, rid);
+    size_t index;
+    if ((*obj_ptr)->static_rids_info.operations
+            && find_rid_index(obj_ptr, rid, &index)
+            && at_end_of_overlay_chain(anjay, current_module,
+                                       offsetof(anjay_dm_handlers_t,
+                                                resource_operations))) {
+        *out = (*obj_ptr)->static_rids_info.operations[index];
+        return 0;
+    }
     if (!_anjay_dm_handler_implemented(anjay, obj_ptr, current_module,
                                        offsetof(anjay_dm_handlers_t,
                                                 resource_operations))) {
@@ -285,6 +351,18 @@ int _anjay_dm_resource_read(anjay_t *anjay,
                               resource_read, anjay, obj_ptr, iid, rid, ctx);
 }
 
+int _anjay_dm_instance_read(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            const uint8_t *requested_rids,
+                            anjay_output_ctx_t *ctx,
+                            const anjay_dm_module_t *current_module) {
+    anjay_log(TRACE, "instance_read /%u/%u", (*obj_ptr)->oid, iid);
+    CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module,
+                              instance_read, anjay, obj_ptr, iid,
+                              requested_rids, ctx);
+}
+
 int _anjay_dm_resource_write(anjay_t *anjay,
                              const anjay_dm_object_def_t *const *obj_ptr,
                              anjay_iid_t iid,
@@ -19,10 +19,12 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <math.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 
 #include <anjay/core.h>
+#include <avsystem/commons/memory.h>
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/stream/stream_membuf.h>
 #include <avsystem/commons/stream_v_table.h>
@@ -42,6 +44,7 @@
 #include "observe/observe_core.h"
 #include "utils_core.h"
 #include "anjay_core.h"
+#include "interface/register.h"
 #include "access_control_utils.h"
 
 VISIBILITY_SOURCE_BEGIN
@@ -83,6 +86,41 @@ static int validate_version(const anjay_dm_object_def_t *obj_def) {
     return 0;
 }
 
+/**
+ * Returns the index of the first registered Object with OID not less than
+ * @p oid, or dm->objects_count if there is no such Object.
+ */
+static size_t find_object_index(const anjay_dm_t *dm, anjay_oid_t oid) {
+    size_t begin = 0;
+    size_t end = dm->objects_count;
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        assert(dm->objects[mid] && *dm->objects[mid]);
+        if ((*dm->objects[mid])->oid < oid) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+static int ensure_objects_capacity(anjay_dm_t *dm) {
+    if (dm->objects_count < dm->objects_capacity) {
+        return 0;
+    }
+    size_t new_capacity = dm->objects_capacity ? 2 * dm->objects_capacity : 8;
+    const anjay_dm_object_def_t *const **new_objects =
+            (const anjay_dm_object_def_t *const **) avs_realloc(
+                    dm->objects, new_capacity * sizeof(*dm->objects));
+    if (!new_objects) {
+        return -1;
+    }
+    dm->objects = new_objects;
+    dm->objects_capacity = new_capacity;
+    return 0;
+}
+
 int anjay_register_object(anjay_t *anjay,
                           const anjay_dm_object_def_t *const *def_ptr) {
     assert(!anjay->transaction_state.depth);
@@ -93,17 +131,10 @@ int anjay_register_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
-
-    AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-        assert(*obj_iter && **obj_iter);
-
-        if ((***obj_iter)->oid >= (*def_ptr)->oid) {
-            break;
-        }
-    }
-
-    if (*obj_iter && (***obj_iter)->oid == (*def_ptr)->oid) {
+    anjay_dm_t *dm = &anjay->dm;
+    const size_t index = find_object_index(dm, (*def_ptr)->oid);
+    if (index < dm->objects_count
+            && (*dm->objects[index])->oid == (*def_ptr)->oid) {
         anjay_log(ERROR, "data model object /%u already registered",
                   (*def_ptr)->oid);
         return -1;
@@ -114,20 +145,21 @@ int anjay_register_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) new_elem =
-            AVS_LIST_NEW_ELEMENT(const anjay_dm_object_def_t *const *);
-    if (!new_elem) {
+    if (ensure_objects_capacity(dm)) {
         anjay_log(ERROR, "out of memory");
         return -1;
     }
 
-    *new_elem = def_ptr;
-    AVS_LIST_INSERT(obj_iter, new_elem);
+    memmove(&dm->objects[index + 1], &dm->objects[index],
+            (dm->objects_count - index) * sizeof(*dm->objects));
+    dm->objects[index] = def_ptr;
+    ++dm->objects_count;
 
-    anjay_log(INFO, "successfully registered object /%u", (**new_elem)->oid);
-    if (anjay_notify_instances_changed(anjay, (**new_elem)->oid)) {
+    anjay_log(INFO, "successfully registered object /%u", (*def_ptr)->oid);
+    _anjay_registration_dm_cache_update(anjay, (*def_ptr)->oid);
+    if (anjay_notify_instances_changed(anjay, (*def_ptr)->oid)) {
         anjay_log(WARNING, "anjay_notify_instances_changed() failed on /%u",
-                  (**new_elem)->oid);
+                  (*def_ptr)->oid);
     }
     if (anjay_schedule_registration_update(anjay, ANJAY_SSID_ANY)) {
         anjay_log(WARNING, "anjay_schedule_registration_update() failed");
@@ -159,28 +191,24 @@ int anjay_unregister_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
-    AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-        assert(*obj_iter && **obj_iter);
-        if ((***obj_iter)->oid >= (*def_ptr)->oid) {
-            break;
-        }
-    }
-
-    if (!*obj_iter || (***obj_iter)->oid != (*def_ptr)->oid) {
+    anjay_dm_t *dm = &anjay->dm;
+    const size_t index = find_object_index(dm, (*def_ptr)->oid);
+    if (index >= dm->objects_count
+            || (*dm->objects[index])->oid != (*def_ptr)->oid) {
         anjay_log(ERROR, "object %" PRIu16 " is not currently registered",
                   (*def_ptr)->oid);
         return -1;
     }
-    if (**obj_iter != def_ptr) {
+    if (dm->objects[index] != def_ptr) {
         anjay_log(ERROR, "object %" PRIu16 " that is registered is not "
                          "the same as the object passed for unregister",
                   (*def_ptr)->oid);
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) detached =
-            AVS_LIST_DETACH(obj_iter);
+    --dm->objects_count;
+    memmove(&dm->objects[index], &dm->objects[index + 1],
+            (dm->objects_count - index) * sizeof(*dm->objects));
 
     anjay_notify_queue_t notify = NULL;
     if (_anjay_notify_queue_instance_set_unknown_change(&notify,
@@ -197,7 +225,6 @@ int anjay_unregister_object(anjay_t *anjay,
                                  (*def_ptr)->oid);
 #endif // WITH_BOOTSTRAP
     anjay_log(INFO, "successfully unregistered object /%u", (*def_ptr)->oid);
-    AVS_LIST_DELETE(&detached);
     if (anjay_schedule_registration_update(anjay, ANJAY_SSID_ANY)) {
         anjay_log(WARNING, "anjay_schedule_registration_update() failed");
     }
@@ -211,17 +238,18 @@ void _anjay_dm_cleanup(anjay_t *anjay) {
         }
     }
 
-    AVS_LIST_CLEAR(&anjay->dm.objects);
+    avs_free(anjay->dm.objects);
+    anjay->dm.objects = NULL;
+    anjay->dm.objects_count = 0;
+    anjay->dm.objects_capacity = 0;
 }
 
 const anjay_dm_object_def_t *const *
 _anjay_dm_find_object_by_oid(anjay_t *anjay, anjay_oid_t oid) {
-    AVS_LIST(const anjay_dm_object_def_t *const *) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
-        assert(*obj && **obj);
-        if ((**obj)->oid == oid) {
-            return *obj;
-        }
+    const size_t index = find_object_index(&anjay->dm, oid);
+    if (index < anjay->dm.objects_count
+            && (*anjay->dm.objects[index])->oid == oid) {
+        return anjay->dm.objects[index];
     }
     anjay_log(TRACE, "could not found object: /%u not registered", oid);
 
@@ -384,10 +412,49 @@ static int read_resource(anjay_t *anjay,
     return read_present_resource(anjay, obj, iid, rid, out_ctx);
 }
 
+#define READ_INSTANCE_STATIC_BITMAP_SIZE 32
+
+static int read_instance_bulk(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj,
+                              anjay_iid_t iid,
+                              anjay_output_ctx_t *out_ctx) {
+    const size_t bitmap_size = ((*obj)->supported_rids.count + 7) / 8;
+    uint8_t static_bitmap[READ_INSTANCE_STATIC_BITMAP_SIZE] = { 0 };
+    uint8_t *bitmap = static_bitmap;
+    if (bitmap_size > sizeof(static_bitmap)
+            && !(bitmap = (uint8_t *) avs_calloc(1, bitmap_size))) {
+        anjay_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+
+    bool any_requested = false;
+    for (size_t i = 0; i < (*obj)->supported_rids.count; ++i) {
+        if (has_resource_operation_bit(anjay, obj,
+                                       (*obj)->supported_rids.rids[i],
+                                       ANJAY_DM_RESOURCE_OP_BIT_R)) {
+            bitmap[i / 8] |= (uint8_t) (1 << (i % 8));
+            any_requested = true;
+        }
+    }
+
+    int result = 0;
+    if (any_requested) {
+        result = _anjay_dm_instance_read(anjay, obj, iid, bitmap, out_ctx,
+                                         NULL);
+    }
+    if (bitmap != static_bitmap) {
+        avs_free(bitmap);
+    }
+    return result;
+}
+
 static int read_instance(anjay_t *anjay,
                          const anjay_dm_object_def_t *const *obj,
                          anjay_iid_t iid,
                          anjay_output_ctx_t *out_ctx) {
+    if (_anjay_dm_instance_read_usable(anjay, obj, NULL)) {
+        return read_instance_bulk(anjay, obj, iid, out_ctx);
+    }
     for (size_t i = 0; i < (*obj)->supported_rids.count; ++i) {
         int result = ensure_resource_present(anjay, obj, iid,
                                              (*obj)->supported_rids.rids[i]);
@@ -463,12 +530,18 @@ dm_read_spawn_ctx(avs_stream_abstract_t *stream,
             ret = _anjay_handle_requested_format(&requested_format,
                                                  ANJAY_COAP_FORMAT_JSON);
         }
+#endif
+#ifdef WITH_SENML_CBOR
+        if (ret) {
+            ret = _anjay_handle_requested_format(&requested_format,
+                                                 ANJAY_COAP_FORMAT_SENML_CBOR);
+        }
 #endif
         if (ret) {
             *errno_ptr = ret;
             anjay_log(ERROR,
                       "Got option: Accept: %" PRIu16 ", but reads on "
-                      "non-resource paths only support TLV and JSON formats",
+                      "non-resource paths only support hierarchical formats",
                       details->requested_format);
             return NULL;
         }
@@ -854,13 +927,26 @@ static int dm_write(anjay_t *anjay,
                 retval = _anjay_dm_check_if_tlv_rid_matches_uri_rid(in_ctx,
                                                                     uri->rid);
             }
+#ifdef WITH_JSON
+            else if (format == ANJAY_COAP_FORMAT_JSON) {
+                retval = _anjay_input_senml_enter_resource(in_ctx, uri,
+                                                           &in_ctx);
+            }
+#endif
+#ifdef WITH_SENML_CBOR
+            else if (format == ANJAY_COAP_FORMAT_SENML_CBOR) {
+                retval = _anjay_input_senml_enter_resource(in_ctx, uri,
+                                                           &in_ctx);
+            }
+#endif
 
             if (!retval) {
                 retval = write_resource(anjay, obj, uri->iid, uri->rid,
                                         in_ctx, &notify_queue);
             }
         } else {
-            if (action != ANJAY_ACTION_WRITE_UPDATE) {
+            retval = _anjay_input_senml_expect_oid(in_ctx, uri->oid);
+            if (!retval && action != ANJAY_ACTION_WRITE_UPDATE) {
                 retval = _anjay_dm_instance_reset(anjay, obj, uri->iid, NULL);
             }
             if (!retval) {
@@ -1027,6 +1113,7 @@ static int dm_write_attributes(anjay_t *anjay,
 #ifdef WITH_OBSERVE
     if (!result) {
         // ensure that new attributes are "seen" by the observe code
+        _anjay_observe_invalidate_attrs(anjay);
         anjay_observe_key_t key;
         build_observe_key(anjay, &key, request);
         key.format = AVS_COAP_FORMAT_NONE;
@@ -1183,8 +1270,11 @@ static int dm_create(anjay_t *anjay,
     anjay_iid_t new_iid = ANJAY_IID_INVALID;
     anjay_id_type_t stream_first_id_type;
     uint16_t stream_first_id;
-    int result = _anjay_input_get_id(in_ctx,
-                                     &stream_first_id_type, &stream_first_id);
+    int result = _anjay_input_senml_expect_oid(in_ctx, request->uri.oid);
+    if (!result) {
+        result = _anjay_input_get_id(in_ctx, &stream_first_id_type,
+                                     &stream_first_id);
+    }
     if (!result && stream_first_id_type == ANJAY_ID_IID) {
         new_iid = stream_first_id;
         result = dm_create_with_explicit_iid(anjay, obj, &new_iid, in_ctx);
@@ -1352,11 +1442,11 @@ int _anjay_dm_perform_action(anjay_t *anjay,
 int _anjay_dm_foreach_object(anjay_t *anjay,
                              anjay_dm_foreach_object_handler_t *handler,
                              void *data) {
-    AVS_LIST(const anjay_dm_object_def_t *const *) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
-        assert(*obj && **obj);
+    for (size_t i = 0; i < anjay->dm.objects_count; ++i) {
+        const anjay_dm_object_def_t *const *obj = anjay->dm.objects[i];
+        assert(obj && *obj);
 
-        int result = handler(anjay, *obj, data);
+        int result = handler(anjay, obj, data);
         if (result == ANJAY_FOREACH_BREAK) {
             anjay_log(DEBUG, "foreach_object: break on /%u", (**obj)->oid);
             return 0;
@@ -37,7 +37,11 @@ typedef struct {
 } anjay_dm_installed_module_t;
 
 struct anjay_dm {
-    AVS_LIST(const anjay_dm_object_def_t *const *) objects;
+    // registered Objects, sorted by OID so that they can be looked up using
+    // binary search
+    const anjay_dm_object_def_t *const **objects;
+    size_t objects_count;
+    size_t objects_capacity;
     AVS_LIST(anjay_dm_installed_module_t) modules;
 };
 
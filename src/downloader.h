@@ -23,6 +23,7 @@
 
 #include <anjay_modules/downloader.h>
 
+#include "hash_index.h"
 #include "utils_core.h"
 #include "coap/id_source/id_source.h"
 
@@ -37,6 +38,15 @@ typedef struct {
     uintptr_t next_id;
     AVS_LIST(anjay_download_ctx_t) downloads;
 
+    /**
+     * Maps sockets of active downloads to the AVS_LIST(anjay_download_ctx_t) *
+     * pointers to the list links that hold the relevant download contexts.
+     * Rebuilt lazily after each change to the downloads list, which invalidates
+     * those pointers.
+     */
+    anjay_hash_index_t index_by_socket;
+    bool index_valid;
+
     anjay_sched_handle_t reconnect_job_handle;
 } anjay_downloader_t;
 
@@ -67,6 +67,7 @@ static void cleanup_transfer(anjay_downloader_t *dl,
     assert(*ctx);
     assert((*ctx)->common.vtable);
 
+    dl->index_valid = false;
     (*ctx)->common.vtable->cleanup(dl, ctx);
 }
 
@@ -94,6 +95,7 @@ static void reconnect_transfer(anjay_downloader_t *dl,
     assert(*ctx);
     assert((*ctx)->common.vtable);
 
+    dl->index_valid = false;
     int result = (*ctx)->common.vtable->reconnect(dl, ctx);
     if (result) {
         _anjay_downloader_abort_transfer(dl, ctx, ANJAY_DOWNLOAD_ERR_FAILED,
@@ -111,6 +113,8 @@ void _anjay_downloader_cleanup(anjay_downloader_t *dl) {
     }
 
     _anjay_coap_id_source_release(&dl->id_source);
+    _anjay_hash_index_cleanup(&dl->index_by_socket);
+    dl->index_valid = false;
 }
 
 static int get_ctx_socket(anjay_downloader_t *dl,
@@ -128,17 +132,54 @@ static int get_ctx_socket(anjay_downloader_t *dl,
     return result;
 }
 
+static avs_net_abstract_socket_t *
+get_ctx_socket_or_null(anjay_downloader_t *dl, anjay_download_ctx_t *ctx) {
+    avs_net_abstract_socket_t *ctx_socket = NULL;
+    if (get_ctx_socket(dl, ctx, &ctx_socket,
+                       &(anjay_socket_transport_t) {
+                           (anjay_socket_transport_t) 0
+                       })) {
+        return NULL;
+    }
+    return ctx_socket;
+}
+
+static int rebuild_index(anjay_downloader_t *dl) {
+    _anjay_hash_index_clear(&dl->index_by_socket);
+    AVS_LIST(anjay_download_ctx_t) *ctx;
+    AVS_LIST_FOREACH_PTR(ctx, &dl->downloads) {
+        avs_net_abstract_socket_t *ctx_socket =
+                get_ctx_socket_or_null(dl, *ctx);
+        if (ctx_socket
+                && _anjay_hash_index_put(&dl->index_by_socket,
+                                         (uintptr_t) ctx_socket, ctx)) {
+            _anjay_hash_index_clear(&dl->index_by_socket);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static AVS_LIST(anjay_download_ctx_t) *
 find_ctx_ptr_by_socket(anjay_downloader_t *dl,
                        avs_net_abstract_socket_t *socket) {
+    if (!dl->index_valid && !rebuild_index(dl)) {
+        dl->index_valid = true;
+    }
     AVS_LIST(anjay_download_ctx_t) *ctx;
+    if (dl->index_valid
+            && (ctx = (AVS_LIST(anjay_download_ctx_t) *) _anjay_hash_index_get(
+                    &dl->index_by_socket, (uintptr_t) socket))
+            && *ctx
+            && get_ctx_socket_or_null(dl, *ctx) == socket) {
+        return ctx;
+    }
+
+    // The HTTP client may replace the socket used by a download on its own,
+    // so the index might not know about it yet.
     AVS_LIST_FOREACH_PTR(ctx, &dl->downloads) {
-        avs_net_abstract_socket_t *ctx_socket = NULL;
-        if (!get_ctx_socket(dl, *ctx, &ctx_socket,
-                            &(anjay_socket_transport_t) {
-                                (anjay_socket_transport_t) 0
-                            })
-                && ctx_socket == socket) {
+        if (get_ctx_socket_or_null(dl, *ctx) == socket) {
+            dl->index_valid = false;
             return ctx;
         }
     }
@@ -276,6 +317,7 @@ int _anjay_downloader_download(anjay_downloader_t *dl,
 
     if (dl_ctx) {
         AVS_LIST_APPEND(&dl->downloads, dl_ctx);
+        dl->index_valid = false;
 
         assert(dl_ctx->common.id != INVALID_DOWNLOAD_ID);
         dl_log(INFO, "download scheduled: %s", config->url);
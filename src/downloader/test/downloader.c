@@ -67,7 +67,7 @@ static void setup(void) {
     }
 
     ENV.anjay = (anjay_t) {
-        .sched = _anjay_sched_new(&ENV.anjay),
+        .sched = _anjay_sched_new(&ENV.anjay, 0),
         .udp_tx_params = ANJAY_COAP_DEFAULT_UDP_TX_PARAMS
     };
     AVS_UNIT_ASSERT_SUCCESS(avs_coap_ctx_create(&ENV.anjay.coap_ctx, 0));
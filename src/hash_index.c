@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+
+#include "hash_index.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#define MIN_CAPACITY 8
+
+static size_t hash_slot(uintptr_t key, size_t capacity) {
+    // Fibonacci hashing; pointers are aligned, so the low bits are mostly
+    // zeros and cannot be used directly
+    const uint64_t hash = (uint64_t) key * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t) (hash >> 32) & (capacity - 1);
+}
+
+static anjay_hash_index_entry_t *find_slot(anjay_hash_index_entry_t *entries,
+                                           size_t capacity,
+                                           uintptr_t key) {
+    assert(capacity && !(capacity & (capacity - 1)));
+    size_t slot = hash_slot(key, capacity);
+    // there is always at least one free slot, so this terminates
+    while (entries[slot].value && entries[slot].key != key) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return &entries[slot];
+}
+
+static int grow(anjay_hash_index_t *index) {
+    const size_t new_capacity =
+            index->capacity ? 2 * index->capacity : MIN_CAPACITY;
+    anjay_hash_index_entry_t *new_entries = (anjay_hash_index_entry_t *)
+            avs_calloc(new_capacity, sizeof(*new_entries));
+    if (!new_entries) {
+        return -1;
+    }
+    for (size_t i = 0; i < index->capacity; ++i) {
+        if (index->entries[i].value) {
+            *find_slot(new_entries, new_capacity, index->entries[i].key) =
+                    index->entries[i];
+        }
+    }
+    avs_free(index->entries);
+    index->entries = new_entries;
+    index->capacity = new_capacity;
+    return 0;
+}
+
+int _anjay_hash_index_put(anjay_hash_index_t *index,
+                          uintptr_t key,
+                          void *value) {
+    assert(value);
+    // keep the load factor at most 1/2
+    if (2 * (index->size + 1) > index->capacity && grow(index)) {
+        return -1;
+    }
+    anjay_hash_index_entry_t *entry =
+            find_slot(index->entries, index->capacity, key);
+    if (!entry->value) {
+        ++index->size;
+    }
+    entry->key = key;
+    entry->value = value;
+    return 0;
+}
+
+void *_anjay_hash_index_get(const anjay_hash_index_t *index, uintptr_t key) {
+    if (!index->size) {
+        return NULL;
+    }
+    return find_slot(index->entries, index->capacity, key)->value;
+}
+
+void _anjay_hash_index_clear(anjay_hash_index_t *index) {
+    if (index->size) {
+        memset(index->entries, 0, index->capacity * sizeof(*index->entries));
+        index->size = 0;
+    }
+}
+
+void _anjay_hash_index_cleanup(anjay_hash_index_t *index) {
+    avs_free(index->entries);
+    memset(index, 0, sizeof(*index));
+}
+
+#ifdef ANJAY_TEST
+#include "test/hash_index.c"
+#endif // ANJAY_TEST
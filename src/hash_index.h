@@ -0,0 +1,74 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_HASH_INDEX_H
+#define ANJAY_HASH_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct {
+    uintptr_t key;
+    void *value;
+} anjay_hash_index_entry_t;
+
+/**
+ * Simple open-addressing hash map from integer (or pointer) keys to non-NULL
+ * pointers, used to speed up lookups in lists that are scanned often but
+ * change rarely.
+ *
+ * There is no way to remove a single entry - the index is meant to be cleared
+ * and repopulated from the indexed list whenever that list changes. A
+ * zero-initialized structure is a valid, empty index.
+ */
+typedef struct {
+    // capacity is always either 0 or a power of two
+    anjay_hash_index_entry_t *entries;
+    size_t capacity;
+    size_t size;
+} anjay_hash_index_t;
+
+/**
+ * Adds a @p key -> @p value mapping to the index, replacing the previous value
+ * for @p key, if any. @p value MUST NOT be NULL.
+ *
+ * @returns 0 on success, a negative value in case of an out-of-memory
+ *          condition. In that case, the index is left unchanged.
+ */
+int _anjay_hash_index_put(anjay_hash_index_t *index,
+                          uintptr_t key,
+                          void *value);
+
+/**
+ * @returns Value previously stored for @p key, or NULL if there is none.
+ */
+void *_anjay_hash_index_get(const anjay_hash_index_t *index, uintptr_t key);
+
+/**
+ * Removes all entries from the index. Allocated memory is kept for reuse.
+ */
+void _anjay_hash_index_clear(anjay_hash_index_t *index);
+
+/**
+ * Removes all entries from the index and frees all associated memory.
+ */
+void _anjay_hash_index_cleanup(anjay_hash_index_t *index);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_HASH_INDEX_H
@@ -36,9 +36,22 @@
 
 VISIBILITY_SOURCE_BEGIN
 
+static void cancel_request_bootstrap_exchange(anjay_t *anjay) {
+    if (anjay->bootstrap.request_bootstrap_awaiting_response) {
+        _anjay_coap_async_cancel(anjay, (anjay_connection_key_t) {
+            .ssid = ANJAY_SSID_BOOTSTRAP,
+            .type = anjay->bootstrap.request_bootstrap_conn_type
+        }, anjay->bootstrap.request_bootstrap_msg_id);
+        anjay->bootstrap.request_bootstrap_awaiting_response = false;
+    }
+    _anjay_sched_del(anjay->sched,
+                     &anjay->bootstrap.request_bootstrap_response_handle);
+}
+
 static void cancel_client_initiated_bootstrap(anjay_t *anjay) {
     _anjay_sched_del(anjay->sched,
                      &anjay->bootstrap.client_initiated_bootstrap_handle);
+    cancel_request_bootstrap_exchange(anjay);
 }
 
 static int suspend_nonbootstrap_server(anjay_t *anjay,
@@ -297,7 +310,10 @@ static int bootstrap_write(anjay_t *anjay,
         return ANJAY_ERR_NOT_FOUND;
     }
 
-    int retval = -1;
+    int retval = _anjay_input_senml_expect_oid(in_ctx, uri->oid);
+    if (retval) {
+        return retval;
+    }
     switch (uri->type) {
     case ANJAY_PATH_RESOURCE:
         retval = with_instance_on_demand(anjay, obj, uri->iid, in_ctx,
@@ -586,6 +602,7 @@ int _anjay_bootstrap_object_write(anjay_t *anjay,
 static int invoke_action(anjay_t *anjay,
                          const anjay_request_t *request) {
     anjay_input_ctx_t *in_ctx = NULL;
+    anjay_input_ctx_t *write_ctx = NULL;
     const uint16_t format =
             _anjay_translate_legacy_content_format(request->content_format);
     int result = -1;
@@ -597,13 +614,28 @@ static int invoke_action(anjay_t *anjay,
             return result;
         }
 
+        write_ctx = in_ctx;
         if (format == ANJAY_COAP_FORMAT_TLV && _anjay_uri_path_has_rid(&request->uri)) {
             result = _anjay_dm_check_if_tlv_rid_matches_uri_rid(
                     in_ctx, request->uri.rid);
         }
+#ifdef WITH_JSON
+        else if (format == ANJAY_COAP_FORMAT_JSON
+                && _anjay_uri_path_has_rid(&request->uri)) {
+            result = _anjay_input_senml_enter_resource(in_ctx, &request->uri,
+                                                       &write_ctx);
+        }
+#endif
+#ifdef WITH_SENML_CBOR
+        else if (format == ANJAY_COAP_FORMAT_SENML_CBOR
+                && _anjay_uri_path_has_rid(&request->uri)) {
+            result = _anjay_input_senml_enter_resource(in_ctx, &request->uri,
+                                                       &write_ctx);
+        }
+#endif
 
         if (!result) {
-            result = bootstrap_write(anjay, &request->uri, in_ctx);
+            result = bootstrap_write(anjay, &request->uri, write_ctx);
         }
         if (_anjay_input_ctx_destroy(&in_ctx)) {
             anjay_log(ERROR, "input ctx cleanup failed");
@@ -640,11 +672,11 @@ int _anjay_bootstrap_perform_action(anjay_t *anjay,
     return invoke_action(anjay, request);
 }
 
-static int check_request_bootstrap_response(avs_stream_abstract_t *stream) {
-    const avs_coap_msg_t *response;
-    if (_anjay_coap_stream_get_incoming_msg(stream, &response)) {
-        anjay_log(ERROR, "could not get response");
-        return -1;
+static int check_request_bootstrap_response(anjay_coap_async_result_t result,
+                                            const avs_coap_msg_t *response) {
+    int retval = _anjay_coap_async_result_to_error(result);
+    if (retval) {
+        return retval;
     }
 
     const uint8_t code = avs_coap_msg_get_code(response);
@@ -658,6 +690,60 @@ static int check_request_bootstrap_response(avs_stream_abstract_t *stream) {
     return 0;
 }
 
+static int schedule_request_bootstrap(anjay_t *anjay);
+
+static void request_bootstrap_response_job(anjay_t *anjay,
+                                           const void *result_ptr) {
+    int result = *(const int *) result_ptr;
+    if (result == AVS_COAP_CTX_ERR_NETWORK) {
+        anjay_log(ERROR, "network communication error while "
+                         "sending Request Bootstrap");
+        anjay_server_info_t *server =
+                _anjay_servers_find_active(anjay, ANJAY_SSID_BOOTSTRAP);
+        if (server) {
+            _anjay_schedule_server_reconnect(anjay, server);
+        }
+    }
+    if (result) {
+        schedule_request_bootstrap(anjay);
+    } else {
+        start_bootstrap_if_not_already_started(anjay);
+    }
+}
+
+static void
+request_bootstrap_response_handler(anjay_t *anjay,
+                                   anjay_connection_key_t key,
+                                   uint16_t msg_id,
+                                   anjay_coap_async_result_t async_result,
+                                   const avs_coap_msg_t *response) {
+    if (!anjay->bootstrap.request_bootstrap_awaiting_response
+            || key.ssid != ANJAY_SSID_BOOTSTRAP
+            || key.type != anjay->bootstrap.request_bootstrap_conn_type
+            || msg_id != anjay->bootstrap.request_bootstrap_msg_id) {
+        anjay_log(DEBUG, "ignoring stale Request Bootstrap response");
+        return;
+    }
+    anjay->bootstrap.request_bootstrap_awaiting_response = false;
+
+    // we might be called from within anjay_serve(), so the rest of the
+    // procedure, which includes suspending other connections, is deferred
+    int result = check_request_bootstrap_response(async_result, response);
+    if (_anjay_sched_now(anjay->sched,
+                         &anjay->bootstrap.request_bootstrap_response_handle,
+                         request_bootstrap_response_job,
+                         &result, sizeof(result))) {
+        anjay_log(ERROR, "could not schedule request_bootstrap_response_job");
+        // retrying does not involve sending anything, so it's safe here
+        schedule_request_bootstrap(anjay);
+    }
+}
+
+/**
+ * Sends Request Bootstrap as an exchange managed by the coap_async module, so
+ * that the response is not waited for synchronously. It is handled by
+ * request_bootstrap_response_handler().
+ */
 static int send_request_bootstrap(anjay_t *anjay) {
     const anjay_url_t *const server_uri =
             _anjay_server_uri(anjay->current_connection.server);
@@ -666,6 +752,10 @@ static int send_request_bootstrap(anjay_t *anjay) {
         .msg_code = AVS_COAP_CODE_POST,
         .format = AVS_COAP_FORMAT_NONE
     };
+    const anjay_connection_key_t key = {
+        .ssid = ANJAY_SSID_BOOTSTRAP,
+        .type = anjay->current_connection.conn_type
+    };
 
     int result = -1;
     if (_anjay_copy_string_list(&details.uri_path, server_uri->uri_path)
@@ -681,15 +771,22 @@ static int send_request_bootstrap(anjay_t *anjay) {
         goto cleanup;
     }
 
+    avs_coap_msg_identity_t identity;
+    const avs_coap_msg_t *msg = NULL;
     if ((result = _anjay_coap_stream_setup_request(anjay->comm_stream, &details,
                                                    NULL))
-            || (result = avs_stream_finish_message(anjay->comm_stream))
-            || (result = check_request_bootstrap_response(
-                    anjay->comm_stream))) {
+            || (result = _anjay_coap_stream_get_request_identity(
+                    anjay->comm_stream, &identity))
+            || (result = _anjay_coap_stream_build_request(anjay->comm_stream,
+                                                          &msg))
+            || (result = _anjay_coap_async_send(
+                    anjay, key, msg, request_bootstrap_response_handler))) {
         anjay_log(ERROR, "could not request bootstrap");
     } else {
         anjay_log(INFO, "Request Bootstrap sent");
-        result = 0;
+        anjay->bootstrap.request_bootstrap_awaiting_response = true;
+        anjay->bootstrap.request_bootstrap_conn_type = key.type;
+        anjay->bootstrap.request_bootstrap_msg_id = identity.msg_id;
     }
 
 cleanup:
@@ -805,8 +902,6 @@ static void request_bootstrap(anjay_t *anjay, const void *dummy) {
         _anjay_schedule_server_reconnect(anjay, server);
     } else if (result) {
         anjay_log(ERROR, "could not send Request Bootstrap");
-    } else {
-        start_bootstrap_if_not_already_started(anjay);
     }
 
     _anjay_release_server_stream(anjay);
@@ -837,6 +932,8 @@ static int64_t client_hold_off_time_s(anjay_t *anjay) {
 int _anjay_bootstrap_account_prepare(anjay_t *anjay) {
     // schedule Client Initiated Bootstrap if not attempted already
     if (anjay->bootstrap.client_initiated_bootstrap_handle
+            || anjay->bootstrap.request_bootstrap_awaiting_response
+            || anjay->bootstrap.request_bootstrap_response_handle
             || _anjay_can_retry_with_normal_server(anjay)) {
         return 0;
     }
@@ -36,6 +36,11 @@ typedef struct {
     anjay_sched_handle_t client_initiated_bootstrap_handle;
     avs_time_monotonic_t client_initiated_bootstrap_last_attempt;
     avs_time_duration_t client_initiated_bootstrap_holdoff;
+    // Request Bootstrap exchange, see send_request_bootstrap()
+    bool request_bootstrap_awaiting_response;
+    anjay_connection_type_t request_bootstrap_conn_type;
+    uint16_t request_bootstrap_msg_id;
+    anjay_sched_handle_t request_bootstrap_response_handle;
 } anjay_bootstrap_t;
 
 int _anjay_bootstrap_notify_regular_connection_available(anjay_t *anjay);
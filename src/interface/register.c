@@ -20,6 +20,7 @@
 
 #include <avsystem/commons/coap/msg.h>
 #include <avsystem/commons/coap/msg_opt.h>
+#include <avsystem/commons/memory.h>
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/utils.h>
 
@@ -28,6 +29,7 @@
 #include "register.h"
 #include "../dm_core.h"
 #include "../dm/query.h"
+#include "../number_format.h"
 #include "../servers_utils.h"
 #include "../utils_core.h"
 
@@ -87,47 +89,112 @@ static const char *assemble_endpoint_path(char *buffer,
     return buffer;
 }
 
-static int send_objects_list(avs_stream_abstract_t *stream,
-                             AVS_LIST(anjay_dm_cache_object_t) dm) {
+typedef struct {
+    // NULL while only measuring the length of the rendered data
+    char *buf;
+    size_t size;
+} links_writer_t;
+
+static void links_append(links_writer_t *writer,
+                         const char *data,
+                         size_t length) {
+    if (writer->buf) {
+        memcpy(writer->buf + writer->size, data, length);
+    }
+    writer->size += length;
+}
+
+static void links_append_string(links_writer_t *writer, const char *str) {
+    links_append(writer, str, strlen(str));
+}
+
+static void links_append_uint(links_writer_t *writer, unsigned value) {
+    char buf[ANJAY_INT_STRING_BUF_SIZE];
+    links_append(writer, buf, _anjay_uint64_as_string(value, buf));
+}
+
+static void render_link(links_writer_t *writer,
+                        bool *is_first_path,
+                        anjay_oid_t oid,
+                        const anjay_iid_t *iid,
+                        const char *version) {
+    links_append_string(writer, *is_first_path ? "</" : ",</");
+    links_append_uint(writer, oid);
+    if (iid) {
+        links_append_string(writer, "/");
+        links_append_uint(writer, *iid);
+    }
+    links_append_string(writer, ">");
+    if (version && *version) {
+        links_append_string(writer, ";ver=\"");
+        links_append_string(writer, version);
+        links_append_string(writer, "\"");
+    }
+    *is_first_path = false;
+}
+
+static void render_objects_list(links_writer_t *writer,
+                                AVS_LIST(anjay_dm_cache_object_t) dm) {
     // TODO: (LwM2M 5.2.1) </>;rt="oma.lwm2m";ct=100 when JSON is implemented
     bool is_first_path = true;
 
     anjay_dm_cache_object_t *object;
     AVS_LIST_FOREACH(object, dm) {
         if (*object->version || !object->instances) {
-            int result = avs_stream_write_f(stream, "%s</%u>",
-                                            is_first_path ? "" : ",",
-                                            object->oid);
-            if (result) {
-                return result;
-            }
-            if (*object->version) {
-                result = avs_stream_write_f(stream, ";ver=\"%s\"",
-                                            object->version);
-                if (result) {
-                    return result;
-                }
-            }
-
-            is_first_path = false;
+            render_link(writer, &is_first_path, object->oid, NULL,
+                        object->version);
+        }
+
+        anjay_iid_t *iid;
+        AVS_LIST_FOREACH(iid, object->instances) {
+            render_link(writer, &is_first_path, object->oid, iid, NULL);
         }
+    }
+}
+
+/**
+ * Renders the CoRE Link Format payload of Register and Update messages, unless
+ * it is already up to date with the cached list of Objects and Instances. The
+ * list is the same for all servers, so the rendered payload is shared as well.
+ */
+static int ensure_links_rendered(anjay_registration_dm_cache_t *cache) {
+    assert(cache->valid);
+    if (cache->links_generation == cache->generation) {
+        return 0;
+    }
+
+    links_writer_t writer = { NULL, 0 };
+    render_objects_list(&writer, cache->objects);
 
-        if (object->instances) {
-            anjay_iid_t *iid;
-            AVS_LIST_FOREACH(iid, object->instances) {
-                int result = avs_stream_write_f(stream, "%s</%u/%u>",
-                                                is_first_path ? "" : ",",
-                                                object->oid, *iid);
-                if (result) {
-                    return result;
-                }
-                is_first_path = false;
-            }
+    char *links = NULL;
+    if (writer.size) {
+        if (!(links = (char *) avs_malloc(writer.size))) {
+            anjay_log(ERROR, "out of memory");
+            return -1;
         }
+        const size_t size = writer.size;
+        writer = (links_writer_t) { links, 0 };
+        render_objects_list(&writer, cache->objects);
+        assert(writer.size == size);
+        (void) size;
     }
+
+    avs_free(cache->links);
+    cache->links = links;
+    cache->links_size = writer.size;
+    cache->links_generation = cache->generation;
     return 0;
 }
 
+static int send_objects_list(anjay_t *anjay, avs_stream_abstract_t *stream) {
+    anjay_registration_dm_cache_t *cache = &anjay->registration_dm_cache;
+    int result = ensure_links_rendered(cache);
+    if (!result && cache->links_size) {
+        result = avs_stream_write(stream, cache->links, cache->links_size);
+    }
+    return result;
+}
+
 static int get_server_lifetime(anjay_t *anjay,
                                anjay_ssid_t ssid,
                                int64_t *out_lifetime) {
@@ -154,8 +221,46 @@ static int get_server_lifetime(anjay_t *anjay,
     return 0;
 }
 
+/**
+ * Sends the request set up in the server stream as an exchange managed by the
+ * coap_async module. Block-wise transfers are only implemented by the stream
+ * itself, so if the request does not fit in a single message, the whole
+ * exchange is performed synchronously and @p handler is called right away.
+ */
+static int send_request(anjay_t *anjay,
+                        anjay_coap_async_handler_t *handler,
+                        uint16_t *out_msg_id) {
+    const anjay_connection_key_t key = {
+        .ssid = _anjay_server_ssid(anjay->current_connection.server),
+        .type = anjay->current_connection.conn_type
+    };
+    avs_coap_msg_identity_t identity;
+    const avs_coap_msg_t *msg = NULL;
+    int result;
+    if ((result = _anjay_coap_stream_get_request_identity(anjay->comm_stream,
+                                                          &identity))
+            || (result = _anjay_coap_stream_build_request(anjay->comm_stream,
+                                                          &msg)) < 0) {
+        return result;
+    }
+    *out_msg_id = identity.msg_id;
+    if (result != ANJAY_COAP_STREAM_BLOCKWISE) {
+        return _anjay_coap_async_send(anjay, key, msg, handler);
+    }
+
+    if ((result = avs_stream_finish_message(anjay->comm_stream))
+            || (result = _anjay_coap_stream_get_incoming_msg(
+                    anjay->comm_stream, &msg))) {
+        return result;
+    }
+    handler(anjay, key, identity.msg_id, ANJAY_COAP_ASYNC_ACKED, msg);
+    return 0;
+}
+
 static int send_register(anjay_t *anjay,
-                         const anjay_update_parameters_t *params) {
+                         const anjay_update_parameters_t *params,
+                         anjay_coap_async_handler_t *handler,
+                         uint16_t *out_msg_id) {
     const anjay_url_t *const server_uri =
             _anjay_server_uri(anjay->current_connection.server);
     anjay_msg_details_t details = {
@@ -184,8 +289,8 @@ static int send_register(anjay_t *anjay,
     }
 
     if (_anjay_coap_stream_setup_request(anjay->comm_stream, &details, NULL)
-            || send_objects_list(anjay->comm_stream, params->dm)
-            || avs_stream_finish_message(anjay->comm_stream)) {
+            || send_objects_list(anjay, anjay->comm_stream)
+            || send_request(anjay, handler, out_msg_id)) {
         anjay_log(ERROR, "could not send Register message");
     } else {
         anjay_log(INFO, "Register sent");
@@ -198,13 +303,13 @@ cleanup:
     return result;
 }
 
-static int
-check_register_response(avs_stream_abstract_t *stream,
-                        AVS_LIST(const anjay_string_t) *out_endpoint_path) {
-    const avs_coap_msg_t *response;
-    if (_anjay_coap_stream_get_incoming_msg(stream, &response)) {
-        anjay_log(ERROR, "could not get response");
-        return -1;
+int _anjay_register_check_response(
+        anjay_coap_async_result_t result,
+        const avs_coap_msg_t *response,
+        AVS_LIST(const anjay_string_t) *out_endpoint_path) {
+    int retval = _anjay_coap_async_result_to_error(result);
+    if (retval) {
+        return retval;
     }
 
     if (avs_coap_msg_get_code(response) != AVS_COAP_CODE_CREATED) {
@@ -267,6 +372,30 @@ static int compare_iids(const void *left_, const void *right_, size_t size) {
     }
 }
 
+static AVS_LIST(anjay_dm_cache_object_t)
+query_dm_object_entry(anjay_t *anjay, const anjay_dm_object_def_t *const *obj) {
+    AVS_LIST(anjay_dm_cache_object_t) new_object =
+            AVS_LIST_NEW_ELEMENT(anjay_dm_cache_object_t);
+    if (!new_object) {
+        anjay_log(ERROR, "out of memory");
+        return NULL;
+    }
+
+    new_object->oid = (*obj)->oid;
+    AVS_LIST(anjay_iid_t) *instance_insert_ptr = &new_object->instances;
+    if (((*obj)->version
+                && avs_simple_snprintf(new_object->version,
+                                       sizeof(new_object->version),
+                                       "%s", (*obj)->version) < 0)
+            || _anjay_dm_foreach_instance(anjay, obj, query_dm_instance,
+                                          &instance_insert_ptr)) {
+        clear_dm_cache(&new_object);
+        return NULL;
+    }
+    AVS_LIST_SORT(&new_object->instances, compare_iids);
+    return new_object;
+}
+
 static int query_dm_object(anjay_t *anjay,
                            const anjay_dm_object_def_t *const *obj,
                            void *cache_object_insert_ptr_) {
@@ -280,28 +409,13 @@ static int query_dm_object(anjay_t *anjay,
             (AVS_LIST(anjay_dm_cache_object_t) **) cache_object_insert_ptr_;
 
     AVS_LIST(anjay_dm_cache_object_t) new_object =
-            AVS_LIST_NEW_ELEMENT(anjay_dm_cache_object_t);
+            query_dm_object_entry(anjay, obj);
     if (!new_object) {
-        anjay_log(ERROR, "out of memory");
         return -1;
     }
     AVS_LIST_INSERT(*cache_object_insert_ptr, new_object);
     AVS_LIST_ADVANCE_PTR(cache_object_insert_ptr);
-
-    new_object->oid = (*obj)->oid;
-    if ((*obj)->version
-            && avs_simple_snprintf(new_object->version,
-                                   sizeof(new_object->version),
-                                   "%s", (*obj)->version) < 0) {
-        return -1;
-    }
-    AVS_LIST(anjay_iid_t) *instance_insert_ptr = &new_object->instances;
-    int retval = _anjay_dm_foreach_instance(anjay, obj, query_dm_instance,
-                                            &instance_insert_ptr);
-    if (!retval) {
-        AVS_LIST_SORT(&new_object->instances, compare_iids);
-    }
-    return retval;
+    return 0;
 }
 
 static int query_dm(anjay_t *anjay, AVS_LIST(anjay_dm_cache_object_t) *out) {
@@ -316,120 +430,168 @@ static int query_dm(anjay_t *anjay, AVS_LIST(anjay_dm_cache_object_t) *out) {
     return retval;
 }
 
-void _anjay_update_parameters_cleanup(anjay_update_parameters_t *params) {
-    clear_dm_cache(&params->dm);
+static bool iid_lists_equal(AVS_LIST(anjay_iid_t) left,
+                            AVS_LIST(anjay_iid_t) right) {
+    while (left && right) {
+        if (*left != *right) {
+            return false;
+        }
+        AVS_LIST_ADVANCE(&left);
+        AVS_LIST_ADVANCE(&right);
+    }
+    return !(left || right);
+}
+
+static bool dm_cache_objects_equal(const anjay_dm_cache_object_t *left,
+                                   const anjay_dm_cache_object_t *right) {
+    return left->oid == right->oid
+            && strcmp(left->version, right->version) == 0
+            && iid_lists_equal(left->instances, right->instances);
+}
+
+static void invalidate_dm_cache(anjay_registration_dm_cache_t *cache) {
+    clear_dm_cache(&cache->objects);
+    avs_free(cache->links);
+    cache->links = NULL;
+    cache->links_size = 0;
+    cache->valid = false;
+}
+
+static int ensure_dm_cache_valid(anjay_t *anjay) {
+    anjay_registration_dm_cache_t *cache = &anjay->registration_dm_cache;
+    if (cache->valid) {
+        return 0;
+    }
+    assert(!cache->objects);
+    if (query_dm(anjay, &cache->objects)) {
+        return -1;
+    }
+    // we don't know what changed since the list has been invalidated, so
+    // assume that everything did
+    ++cache->generation;
+    cache->valid = true;
+    return 0;
+}
+
+void _anjay_registration_dm_cache_update(anjay_t *anjay, anjay_oid_t oid) {
+    anjay_registration_dm_cache_t *cache = &anjay->registration_dm_cache;
+    if (!cache->valid || oid == ANJAY_DM_OID_SECURITY) {
+        return;
+    }
+
+    AVS_LIST(anjay_dm_cache_object_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &cache->objects) {
+        if ((*entry_ptr)->oid >= oid) {
+            break;
+        }
+    }
+    const bool entry_exists = (*entry_ptr && (*entry_ptr)->oid == oid);
+
+    const anjay_dm_object_def_t *const *obj =
+            _anjay_dm_find_object_by_oid(anjay, oid);
+    if (!obj) {
+        if (entry_exists) {
+            AVS_LIST(anjay_dm_cache_object_t) entry =
+                    AVS_LIST_DETACH(entry_ptr);
+            clear_dm_cache(&entry);
+            ++cache->generation;
+        }
+        return;
+    }
+
+    AVS_LIST(anjay_dm_cache_object_t) new_entry =
+            query_dm_object_entry(anjay, obj);
+    if (!new_entry) {
+        anjay_log(WARNING, "could not update registration data model cache "
+                  "for /%u, will rebuild it on next use", oid);
+        invalidate_dm_cache(cache);
+        return;
+    }
+    if (entry_exists) {
+        if (dm_cache_objects_equal(*entry_ptr, new_entry)) {
+            clear_dm_cache(&new_entry);
+            return;
+        }
+        AVS_LIST(anjay_dm_cache_object_t) old_entry =
+                AVS_LIST_DETACH(entry_ptr);
+        clear_dm_cache(&old_entry);
+    }
+    AVS_LIST_INSERT(entry_ptr, new_entry);
+    ++cache->generation;
+}
+
+void _anjay_registration_dm_cache_cleanup(anjay_t *anjay) {
+    invalidate_dm_cache(&anjay->registration_dm_cache);
 }
 
 static int init_update_parameters(anjay_t *anjay,
                                   anjay_server_info_t *server,
                                   anjay_update_parameters_t *out_params) {
-    if (query_dm(anjay, &out_params->dm)) {
-        goto error;
-    }
-    if (get_server_lifetime(anjay, _anjay_server_ssid(server),
-                            &out_params->lifetime_s)) {
-        goto error;
-    }
-    if (_anjay_server_actual_binding_mode(&out_params->binding_mode, server)) {
-        goto error;
+    if (ensure_dm_cache_valid(anjay)
+            || get_server_lifetime(anjay, _anjay_server_ssid(server),
+                                   &out_params->lifetime_s)
+            || _anjay_server_actual_binding_mode(&out_params->binding_mode,
+                                                 server)) {
+        return -1;
     }
+    out_params->dm_generation = anjay->registration_dm_cache.generation;
     return 0;
-error:
-    _anjay_update_parameters_cleanup(out_params);
-    return -1;
 }
 
 void _anjay_registration_info_cleanup(anjay_registration_info_t *info) {
     AVS_LIST_CLEAR(&info->endpoint_path);
-    _anjay_update_parameters_cleanup(&info->last_update_params);
 }
 
-int _anjay_registration_update_ctx_init(
+int _anjay_registration_update_params_init(
         anjay_t *anjay,
-        anjay_registration_update_ctx_t *out_ctx,
-        anjay_server_info_t *server) {
+        anjay_server_info_t *server,
+        anjay_update_parameters_t *out_params) {
     assert(!anjay->current_connection.server);
-    memset(out_ctx, 0, sizeof(*out_ctx));
-    out_ctx->anjay = anjay;
-    out_ctx->server = server;
-    return init_update_parameters(anjay, server, &out_ctx->new_params);
+    memset(out_params, 0, sizeof(*out_params));
+    return init_update_parameters(anjay, server, out_params);
 }
 
-static int bind_server_stream(anjay_registration_update_ctx_t *ctx) {
-    assert(ctx->server);
+static int bind_server_stream(anjay_t *anjay, anjay_server_info_t *server) {
     anjay_connection_ref_t connection = {
-        .server = ctx->server,
-        .conn_type = _anjay_server_primary_conn_type(ctx->server)
+        .server = server,
+        .conn_type = _anjay_server_primary_conn_type(server)
     };
     if (connection.conn_type == ANJAY_CONNECTION_UNSET) {
         anjay_log(ERROR, "no valid registration connection for server %u",
-                  _anjay_server_ssid(ctx->server));
+                  _anjay_server_ssid(server));
         return -1;
     }
-    if (_anjay_bind_server_stream(ctx->anjay, connection)) {
+    if (_anjay_bind_server_stream(anjay, connection)) {
         anjay_log(ERROR, "could not get stream for server %u",
-                  _anjay_server_ssid(ctx->server));
+                  _anjay_server_ssid(server));
         return -1;
     }
     return 0;
 }
 
-int _anjay_register(anjay_registration_update_ctx_t *ctx) {
-    AVS_LIST(const anjay_string_t) endpoint_path = NULL;
-    if (bind_server_stream(ctx)) {
+int _anjay_register(anjay_t *anjay,
+                    anjay_server_info_t *server,
+                    const anjay_update_parameters_t *params,
+                    anjay_coap_async_handler_t *handler,
+                    uint16_t *out_msg_id) {
+    if (bind_server_stream(anjay, server)) {
         return -1;
     }
-
-    int result = -1;
-    if (send_register(ctx->anjay, &ctx->new_params)
-            || (result = check_register_response(ctx->anjay->comm_stream,
-                                                 &endpoint_path))) {
+    int result = send_register(anjay, params, handler, out_msg_id);
+    if (result) {
         anjay_log(ERROR, "could not register to server %u",
-                  _anjay_dm_current_ssid(ctx->anjay));
-        AVS_LIST_CLEAR(&endpoint_path);
-        goto finish;
+                  _anjay_server_ssid(server));
     }
-
-    _anjay_server_update_registration_info(
-            ctx->anjay->current_connection.server,
-            &endpoint_path, &ctx->new_params);
-    assert(!endpoint_path);
-
-finish:
-    _anjay_release_server_stream(ctx->anjay);
+    _anjay_release_server_stream(anjay);
     return result;
 }
 
-static bool iid_lists_equal(AVS_LIST(anjay_iid_t) left,
-                            AVS_LIST(anjay_iid_t) right) {
-    while (left && right) {
-        if (*left != *right) {
-            return false;
-        }
-        AVS_LIST_ADVANCE(&left);
-        AVS_LIST_ADVANCE(&right);
-    }
-    return !(left || right);
-}
-
-static bool dm_caches_equal(AVS_LIST(anjay_dm_cache_object_t) left,
-                            AVS_LIST(anjay_dm_cache_object_t) right) {
-    while (left && right) {
-        if (left->oid != right->oid
-                || strcmp(left->version, right->version) != 0
-                || !iid_lists_equal(left->instances, right->instances)) {
-            return false;
-        }
-        AVS_LIST_ADVANCE(&left);
-        AVS_LIST_ADVANCE(&right);
-    }
-    return !(left || right);
-}
-
 static int send_update(anjay_t *anjay,
                        AVS_LIST(const anjay_string_t) endpoint_path,
                        const anjay_update_parameters_t *old_params,
-                       const anjay_update_parameters_t *new_params) {
+                       const anjay_update_parameters_t *new_params,
+                       anjay_coap_async_handler_t *handler,
+                       uint16_t *out_msg_id) {
     const int64_t *lifetime_s_ptr = NULL;
     assert(new_params->lifetime_s >= 0);
     if (new_params->lifetime_s != old_params->lifetime_s) {
@@ -441,7 +603,7 @@ static int send_update(anjay_t *anjay,
                     ? NULL : new_params->binding_mode;
 
     bool dm_changed_since_last_update =
-            !dm_caches_equal(old_params->dm, new_params->dm);
+            (old_params->dm_generation != new_params->dm_generation);
     anjay_msg_details_t details = {
         .msg_type = AVS_COAP_MSG_CONFIRMABLE,
         .msg_code = AVS_COAP_CODE_POST,
@@ -457,9 +619,8 @@ static int send_update(anjay_t *anjay,
     if ((result = _anjay_coap_stream_setup_request(anjay->comm_stream, &details,
                                                    NULL))
             || (dm_changed_since_last_update
-                && (result = send_objects_list(anjay->comm_stream,
-                                               new_params->dm)))
-            || (result = avs_stream_finish_message(anjay->comm_stream))) {
+                && (result = send_objects_list(anjay, anjay->comm_stream)))
+            || (result = send_request(anjay, handler, out_msg_id))) {
         anjay_log(ERROR, "could not send Update message");
     } else {
         anjay_log(INFO, "Update sent");
@@ -471,11 +632,11 @@ static int send_update(anjay_t *anjay,
     return result;
 }
 
-static int check_update_response(avs_stream_abstract_t *stream) {
-    const avs_coap_msg_t *response;
-    if (_anjay_coap_stream_get_incoming_msg(stream, &response)) {
-        anjay_log(ERROR, "could not get response");
-        return -1;
+int _anjay_update_check_response(anjay_coap_async_result_t result,
+                                 const avs_coap_msg_t *response) {
+    int retval = _anjay_coap_async_result_to_error(result);
+    if (retval) {
+        return retval;
     }
 
     const uint8_t code = avs_coap_msg_get_code(response);
@@ -510,40 +671,35 @@ static int check_update_response(avs_stream_abstract_t *stream) {
     }
 }
 
-bool _anjay_needs_registration_update(anjay_registration_update_ctx_t *ctx) {
+bool
+_anjay_needs_registration_update(anjay_server_info_t *server,
+                                 const anjay_update_parameters_t *new_params) {
     const anjay_registration_info_t *info =
-            _anjay_server_registration_info(ctx->server);
+            _anjay_server_registration_info(server);
     const anjay_update_parameters_t *old_params = &info->last_update_params;
-    return old_params->lifetime_s != ctx->new_params.lifetime_s
-            || strcmp(old_params->binding_mode, ctx->new_params.binding_mode)
-            || !dm_caches_equal(old_params->dm, ctx->new_params.dm);
+    return old_params->lifetime_s != new_params->lifetime_s
+            || strcmp(old_params->binding_mode, new_params->binding_mode)
+            || old_params->dm_generation != new_params->dm_generation;
 }
 
-int _anjay_update_registration(anjay_registration_update_ctx_t *ctx) {
-    if (bind_server_stream(ctx)) {
+int _anjay_update_registration(anjay_t *anjay,
+                               anjay_server_info_t *server,
+                               const anjay_update_parameters_t *new_params,
+                               anjay_coap_async_handler_t *handler,
+                               uint16_t *out_msg_id) {
+    if (bind_server_stream(anjay, server)) {
         return -1;
     }
-    const anjay_registration_info_t *old_info = _anjay_server_registration_info(
-            ctx->anjay->current_connection.server);
-    int retval = -1;
-    if ((retval = send_update(ctx->anjay, old_info->endpoint_path,
-                              &old_info->last_update_params, &ctx->new_params))
-            || (retval = check_update_response(ctx->anjay->comm_stream))) {
+    const anjay_registration_info_t *old_info =
+            _anjay_server_registration_info(server);
+    int result = send_update(anjay, old_info->endpoint_path,
+                             &old_info->last_update_params, new_params,
+                             handler, out_msg_id);
+    if (result) {
         anjay_log(ERROR, "could not update registration");
-        goto finish;
     }
-
-    _anjay_server_update_registration_info(
-            ctx->anjay->current_connection.server, NULL, &ctx->new_params);
-
-finish:
-    _anjay_release_server_stream(ctx->anjay);
-    return retval;
-}
-
-void
-_anjay_registration_update_ctx_release(anjay_registration_update_ctx_t *ctx) {
-    _anjay_update_parameters_cleanup(&ctx->new_params);
+    _anjay_release_server_stream(anjay);
+    return result;
 }
 
 static int check_deregister_response(avs_stream_abstract_t *stream) {
@@ -589,3 +745,7 @@ avs_time_duration_t
 _anjay_register_time_remaining(const anjay_registration_info_t *info) {
     return avs_time_real_diff(info->expire_time, avs_time_real_now());
 }
+
+#ifdef ANJAY_TEST
+#include "test/register.c"
+#endif // ANJAY_TEST
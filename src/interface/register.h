@@ -18,41 +18,108 @@
 #define ANJAY_INTERFACE_REGISTER_H
 
 #include "../anjay_core.h"
+#include "../coap_async.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
-void _anjay_update_parameters_cleanup(anjay_update_parameters_t *params);
-
 void _anjay_registration_info_cleanup(anjay_registration_info_t *info);
 
-typedef struct {
-    anjay_t *anjay;
-    anjay_server_info_t *server;
-    anjay_update_parameters_t new_params;
-} anjay_registration_update_ctx_t;
+/**
+ * Brings the cached list of Instances of Object @p oid, used for Register and
+ * Update messages, up to date with the data model. Called for each Object whose
+ * set of Instances changed, and for each Object being registered or
+ * unregistered.
+ *
+ * Does nothing if the cache has not been built yet. If querying the data model
+ * fails, the whole cache is discarded and rebuilt on next use.
+ */
+void _anjay_registration_dm_cache_update(anjay_t *anjay, anjay_oid_t oid);
+
+void _anjay_registration_dm_cache_cleanup(anjay_t *anjay);
 
-int _anjay_registration_update_ctx_init(
+/**
+ * Prepares the parameters of a Register or Update message for @p server,
+ * according to the current state of the data model.
+ */
+int _anjay_registration_update_params_init(
         anjay_t *anjay,
-        anjay_registration_update_ctx_t *out_ctx,
-        anjay_server_info_t *server);
+        anjay_server_info_t *server,
+        anjay_update_parameters_t *out_params);
+
+bool
+_anjay_needs_registration_update(anjay_server_info_t *server,
+                                 const anjay_update_parameters_t *new_params);
+
+/**
+ * Sends the Register message with @p params to @p server, without waiting for
+ * the response. The exchange is performed by the coap_async module, so
+ * @p handler is called with the response later, from within anjay_serve() or
+ * a retransmission job. The response shall then be interpreted using
+ * _anjay_register_check_response().
+ *
+ * If the message does not fit in a single CoAP message, the block-wise
+ * transfer is performed synchronously and @p handler is called before this
+ * function returns.
+ *
+ * @param out_msg_id Set to the Message ID that @p handler will be called with.
+ *                   It is set before @p handler might be called.
+ *
+ * @returns 0 on success, or a negative value in case of error, in which case
+ *          @p handler is not called.
+ */
+int _anjay_register(anjay_t *anjay,
+                    anjay_server_info_t *server,
+                    const anjay_update_parameters_t *params,
+                    anjay_coap_async_handler_t *handler,
+                    uint16_t *out_msg_id);
 
-int _anjay_register(anjay_registration_update_ctx_t *ctx);
+/**
+ * Interprets the result of the exchange started with _anjay_register().
+ *
+ * @param out_endpoint_path Set to the registration location returned by the
+ *                          server on success.
+ *
+ * @returns:
+ * - 0 on success,
+ * - a negated CoAP code (e.g. ANJAY_ERR_FORBIDDEN) if the server responded
+ *   with an unexpected code,
+ * - AVS_COAP_CTX_ERR_NETWORK in case of a network error,
+ * - AVS_COAP_CTX_ERR_TIMEOUT if no response has been received,
+ * - -1 in case of any other error.
+ */
+int _anjay_register_check_response(
+        anjay_coap_async_result_t result,
+        const avs_coap_msg_t *response,
+        AVS_LIST(const anjay_string_t) *out_endpoint_path);
 
 #define ANJAY_REGISTRATION_UPDATE_REJECTED 1
 
-bool _anjay_needs_registration_update(anjay_registration_update_ctx_t *ctx);
+/**
+ * Sends the Update message to @p server, without waiting for the response.
+ * Only the parameters that differ between @p new_params and the ones stored in
+ * the registration info of @p server are included. See _anjay_register() for
+ * the semantics of @p handler and @p out_msg_id.
+ */
+int _anjay_update_registration(anjay_t *anjay,
+                               anjay_server_info_t *server,
+                               const anjay_update_parameters_t *new_params,
+                               anjay_coap_async_handler_t *handler,
+                               uint16_t *out_msg_id);
 
 /**
+ * Interprets the result of the exchange started with
+ * _anjay_update_registration().
+ *
  * @returns:
  * - 0 on success,
- * - a negative value on error,
  * - ANJAY_REGISTRATION_UPDATE_REJECTED if the server responded with 4.xx error
- *   so the Update message should not be retransmitted.
+ *   so the Update message should not be retransmitted,
+ * - AVS_COAP_CTX_ERR_NETWORK in case of a network error,
+ * - AVS_COAP_CTX_ERR_TIMEOUT if no response has been received,
+ * - -1 in case of any other error.
  */
-int _anjay_update_registration(anjay_registration_update_ctx_t *ctx);
-
-void
-_anjay_registration_update_ctx_release(anjay_registration_update_ctx_t *ctx);
+int _anjay_update_check_response(anjay_coap_async_result_t result,
+                                 const avs_coap_msg_t *response);
 
 int _anjay_deregister(anjay_t *anjay,
                       AVS_LIST(const anjay_string_t) endpoint_path);
@@ -561,9 +561,9 @@ AVS_UNIT_TEST(bootstrap_reconnect, reconnect) {
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
 
     // mocking reconnect is rather hard, so let's just check it's scheduled...
-    AVS_UNIT_ASSERT_TRUE(anjay->sched->entries
+    AVS_UNIT_ASSERT_TRUE(anjay->sched->heap[0]
             == anjay->servers->servers->next_action_handle);
-    AVS_UNIT_ASSERT_EQUAL(*(anjay_ssid_t *) &anjay->sched->entries->clb_data,
+    AVS_UNIT_ASSERT_EQUAL(*(anjay_ssid_t *) &anjay->sched->heap[0]->clb_data,
                           ANJAY_SSID_BOOTSTRAP);
     _anjay_sched_del(anjay->sched,
                      &anjay->servers->servers->next_action_handle);
@@ -584,10 +584,18 @@ AVS_UNIT_TEST(bootstrap_reconnect, reconnect) {
                                              QUERY("ep=urn:dev:os:anjay-test"));
     avs_unit_mocksock_expect_output(mocksocks[0], request->content,
                                     request->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    // the response is not waited for
+    AVS_UNIT_ASSERT_TRUE(anjay->bootstrap.request_bootstrap_awaiting_response);
+    AVS_UNIT_ASSERT_FALSE(anjay->bootstrap.in_progress);
+
     const avs_coap_msg_t *response = COAP_MSG(AVS_COAP_MSG_ACKNOWLEDGEMENT,
-                                             CREATED, ID(0x69EE), NO_PAYLOAD);
+                                             CHANGED, ID(0x69EE), NO_PAYLOAD);
     avs_unit_mocksock_input(mocksocks[0], response->content, response->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_FALSE(anjay->bootstrap.request_bootstrap_awaiting_response);
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_TRUE(anjay->bootstrap.in_progress);
 
     DM_TEST_FINISH;
 }
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_modules/notify.h>
+
+#include <anjay_test/dm.h>
+
+static void assert_links_equal(anjay_t *anjay, const char *expected) {
+    anjay_registration_dm_cache_t *cache = &anjay->registration_dm_cache;
+    AVS_UNIT_ASSERT_SUCCESS(ensure_dm_cache_valid(anjay));
+    AVS_UNIT_ASSERT_SUCCESS(ensure_links_rendered(cache));
+    AVS_UNIT_ASSERT_EQUAL(cache->links_size, strlen(expected));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(cache->links, expected,
+                                      cache->links_size);
+}
+
+static void flush_instance_set_change(anjay_t *anjay, anjay_oid_t oid) {
+    anjay_notify_queue_t queue = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_set_unknown_change(&queue, oid));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_flush(anjay, &queue));
+}
+
+AVS_UNIT_TEST(registration_dm_cache, object_register_unregister) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ);
+    anjay_registration_dm_cache_t *cache = &anjay->registration_dm_cache;
+
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 1);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, ANJAY_IID_INVALID);
+    assert_links_equal(anjay, "</42/1>");
+    const uint64_t generation = cache->generation;
+    const char *links = cache->links;
+
+    // nothing changed, so the rendered payload is reused
+    assert_links_equal(anjay, "</42/1>");
+    AVS_UNIT_ASSERT_EQUAL(cache->generation, generation);
+    AVS_UNIT_ASSERT_TRUE(cache->links == links);
+
+    // registering an Object only queries that Object
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ_NOATTRS, 0, 0,
+                                      ANJAY_IID_INVALID);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &OBJ_NOATTRS));
+    AVS_UNIT_ASSERT_EQUAL(cache->generation, generation + 1);
+    assert_links_equal(anjay, "</42/1>,</93>");
+
+    // unregistering does not query the data model at all
+    AVS_UNIT_ASSERT_SUCCESS(anjay_unregister_object(anjay, &OBJ_NOATTRS));
+    AVS_UNIT_ASSERT_EQUAL(cache->generation, generation + 2);
+    assert_links_equal(anjay, "</42/1>");
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(registration_dm_cache, instance_add_remove) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ);
+    anjay_registration_dm_cache_t *cache = &anjay->registration_dm_cache;
+
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 1);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, ANJAY_IID_INVALID);
+    assert_links_equal(anjay, "</42/1>");
+    const uint64_t generation = cache->generation;
+
+    // instances are sorted, regardless of the order of iteration
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 2);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, 1);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 2, 0, ANJAY_IID_INVALID);
+    flush_instance_set_change(anjay, 42);
+    AVS_UNIT_ASSERT_EQUAL(cache->generation, generation + 1);
+    assert_links_equal(anjay, "</42/1>,</42/2>");
+
+    // a reported change that did not alter the set of instances keeps the
+    // generation, and the rendered payload, intact
+    const char *links = cache->links;
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 1);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, 2);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 2, 0, ANJAY_IID_INVALID);
+    flush_instance_set_change(anjay, 42);
+    AVS_UNIT_ASSERT_EQUAL(cache->generation, generation + 1);
+    assert_links_equal(anjay, "</42/1>,</42/2>");
+    AVS_UNIT_ASSERT_TRUE(cache->links == links);
+
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 2);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, ANJAY_IID_INVALID);
+    flush_instance_set_change(anjay, 42);
+    AVS_UNIT_ASSERT_EQUAL(cache->generation, generation + 2);
+    assert_links_equal(anjay, "</42/2>");
+
+    // the last instance removed leaves a link to the Object itself
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, ANJAY_IID_INVALID);
+    flush_instance_set_change(anjay, 42);
+    AVS_UNIT_ASSERT_EQUAL(cache->generation, generation + 3);
+    assert_links_equal(anjay, "</42>");
+
+    DM_TEST_FINISH;
+}
+
+static const anjay_dm_object_def_t *const OBJ_WITH_VERSION =
+        &(const anjay_dm_object_def_t) {
+            .oid = 43,
+            .version = "1.1",
+            .supported_rids = ANJAY_DM_SUPPORTED_RIDS(0),
+            .handlers = {
+                ANJAY_MOCK_DM_HANDLERS
+            }
+        };
+
+AVS_UNIT_TEST(registration_dm_cache, links_with_version) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ, &OBJ_WITH_VERSION);
+
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 1);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, ANJAY_IID_INVALID);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ_WITH_VERSION, 0, 0, 0);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ_WITH_VERSION, 1, 0,
+                                      ANJAY_IID_INVALID);
+    assert_links_equal(anjay, "</42/1>,</43>;ver=\"1.1\",</43/0>");
+
+    DM_TEST_FINISH;
+}
@@ -0,0 +1,764 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../io_core.h"
+#include "../utils_core.h"
+#include "senml_in.h"
+
+#define json_log(level, ...) _anjay_log(json, level, __VA_ARGS__)
+
+VISIBILITY_SOURCE_BEGIN
+
+/*
+ * Streaming parser for the LwM2M JSON format (application/vnd.oma.lwm2m+json):
+ *
+ *   {"bn":"/3/0/","e":[{"n":"1","v":42},{"n":"7/0","sv":"text"}]}
+ *
+ * The payload is never buffered as a whole - only a single entry is parsed
+ * at a time, so that large payloads may be received in multiple CoAP blocks.
+ * For the same reason, the "bn" member is required to precede "e".
+ */
+
+/* Maximum nesting level of unknown JSON values that are skipped */
+#define MAX_SKIP_DEPTH 8
+
+/* Longest accepted JSON number literal */
+#define MAX_NUMBER_LENGTH 64
+
+typedef enum {
+    JSON_IN_START,
+    JSON_IN_ENTRIES,
+    JSON_IN_FINISHED
+} json_in_state_t;
+
+typedef struct {
+    senml_reader_t base;
+    avs_stream_abstract_t *stream;
+    bool autoclose;
+    char stream_finished;
+
+    /* chunk of the stream that is being parsed */
+    char chunk[64];
+    size_t chunk_offset;
+    size_t chunk_size;
+
+    json_in_state_t state;
+    bool first_entry;
+    char base_name[SENML_MAX_NAME_SIZE];
+    /* storage for string values, reused across entries */
+    char *value;
+    size_t value_size;
+} json_in_t;
+
+static int peek_char(json_in_t *ctx, char *out_char) {
+    while (ctx->chunk_offset >= ctx->chunk_size) {
+        if (ctx->stream_finished) {
+            json_log(DEBUG, "unexpected end of payload");
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        ctx->chunk_offset = 0;
+        ctx->chunk_size = 0;
+        if (avs_stream_read(ctx->stream, &ctx->chunk_size,
+                            &ctx->stream_finished,
+                            ctx->chunk, sizeof(ctx->chunk))) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+    }
+    *out_char = ctx->chunk[ctx->chunk_offset];
+    return 0;
+}
+
+static int get_char(json_in_t *ctx, char *out_char) {
+    int retval = peek_char(ctx, out_char);
+    if (!retval) {
+        ++ctx->chunk_offset;
+    }
+    return retval;
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static int peek_token(json_in_t *ctx, char *out_char) {
+    int retval;
+    while (!(retval = peek_char(ctx, out_char)) && is_space(*out_char)) {
+        ++ctx->chunk_offset;
+    }
+    return retval;
+}
+
+static int expect_token(json_in_t *ctx, char expected) {
+    char c;
+    int retval = peek_token(ctx, &c);
+    if (!retval) {
+        if (c != expected) {
+            json_log(DEBUG, "expected '%c', got '%c'", expected, c);
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        ++ctx->chunk_offset;
+    }
+    return retval;
+}
+
+static bool at_end(json_in_t *ctx) {
+    while (true) {
+        if (ctx->chunk_offset < ctx->chunk_size) {
+            if (!is_space(ctx->chunk[ctx->chunk_offset++])) {
+                return false;
+            }
+        } else if (ctx->stream_finished) {
+            return true;
+        } else {
+            ctx->chunk_offset = 0;
+            ctx->chunk_size = 0;
+            if (avs_stream_read(ctx->stream, &ctx->chunk_size,
+                                &ctx->stream_finished,
+                                ctx->chunk, sizeof(ctx->chunk))) {
+                return false;
+            }
+        }
+    }
+}
+
+typedef struct {
+    char **buffer;
+    size_t *capacity;
+    /* if false, characters that do not fit in the buffer are dropped */
+    bool growable;
+    size_t length;
+} string_sink_t;
+
+static int sink_put(string_sink_t *sink, char c) {
+    if (sink->length + 1 >= *sink->capacity) {
+        if (!sink->growable) {
+            ++sink->length;
+            return 0;
+        }
+        size_t new_capacity = 2 * *sink->capacity + 16;
+        char *new_buffer = (char *) avs_realloc(*sink->buffer, new_capacity);
+        if (!new_buffer) {
+            json_log(ERROR, "out of memory");
+            return ANJAY_ERR_INTERNAL;
+        }
+        *sink->buffer = new_buffer;
+        *sink->capacity = new_capacity;
+    }
+    (*sink->buffer)[sink->length++] = c;
+    (*sink->buffer)[sink->length] = '\0';
+    return 0;
+}
+
+static int put_utf8(string_sink_t *sink, uint32_t code_point) {
+    char buf[4];
+    size_t length;
+    if (code_point < 0x80) {
+        buf[0] = (char) code_point;
+        length = 1;
+    } else if (code_point < 0x800) {
+        buf[0] = (char) (0xC0 | (code_point >> 6));
+        buf[1] = (char) (0x80 | (code_point & 0x3F));
+        length = 2;
+    } else if (code_point < 0x10000) {
+        buf[0] = (char) (0xE0 | (code_point >> 12));
+        buf[1] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        buf[2] = (char) (0x80 | (code_point & 0x3F));
+        length = 3;
+    } else {
+        buf[0] = (char) (0xF0 | (code_point >> 18));
+        buf[1] = (char) (0x80 | ((code_point >> 12) & 0x3F));
+        buf[2] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        buf[3] = (char) (0x80 | (code_point & 0x3F));
+        length = 4;
+    }
+    int retval = 0;
+    for (size_t i = 0; !retval && i < length; ++i) {
+        retval = sink_put(sink, buf[i]);
+    }
+    return retval;
+}
+
+static int read_hex4(json_in_t *ctx, uint32_t *out_value) {
+    *out_value = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c;
+        int retval = get_char(ctx, &c);
+        if (retval) {
+            return retval;
+        }
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        *out_value = (*out_value << 4) | (uint32_t) digit;
+    }
+    return 0;
+}
+
+static int read_unicode_escape(json_in_t *ctx, string_sink_t *sink) {
+    uint32_t code_point;
+    int retval = read_hex4(ctx, &code_point);
+    if (retval) {
+        return retval;
+    }
+    if (code_point >= 0xD800 && code_point < 0xDC00) {
+        // high surrogate, must be followed by an escaped low surrogate
+        char c1, c2;
+        uint32_t low;
+        if ((retval = get_char(ctx, &c1)) || (retval = get_char(ctx, &c2))) {
+            return retval;
+        }
+        if (c1 != '\\' || c2 != 'u' || (retval = read_hex4(ctx, &low))
+                || low < 0xDC00 || low >= 0xE000) {
+            return retval ? retval : ANJAY_ERR_BAD_REQUEST;
+        }
+        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+    } else if (code_point >= 0xDC00 && code_point < 0xE000) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return put_utf8(sink, code_point);
+}
+
+static int read_string(json_in_t *ctx, string_sink_t *sink) {
+    sink->length = 0;
+    if (*sink->capacity) {
+        (*sink->buffer)[0] = '\0';
+    }
+    int retval = expect_token(ctx, '"');
+    while (!retval) {
+        char c;
+        if ((retval = get_char(ctx, &c))) {
+            break;
+        }
+        if (c == '"') {
+            if (!*sink->capacity) {
+                // make sure that an empty string is NULL-terminated
+                retval = sink_put(sink, '\0');
+                sink->length = 0;
+            }
+            break;
+        } else if ((unsigned char) c < 0x20) {
+            retval = ANJAY_ERR_BAD_REQUEST;
+        } else if (c != '\\') {
+            retval = sink_put(sink, c);
+        } else if (!(retval = get_char(ctx, &c))) {
+            switch (c) {
+            case '"':
+            case '\\':
+            case '/':
+                retval = sink_put(sink, c);
+                break;
+            case 'b':
+                retval = sink_put(sink, '\b');
+                break;
+            case 'f':
+                retval = sink_put(sink, '\f');
+                break;
+            case 'n':
+                retval = sink_put(sink, '\n');
+                break;
+            case 'r':
+                retval = sink_put(sink, '\r');
+                break;
+            case 't':
+                retval = sink_put(sink, '\t');
+                break;
+            case 'u':
+                retval = read_unicode_escape(ctx, sink);
+                break;
+            default:
+                retval = ANJAY_ERR_BAD_REQUEST;
+            }
+        }
+    }
+    return retval;
+}
+
+static int read_fixed_string(json_in_t *ctx, char *buf, size_t buf_size,
+                             size_t *out_length) {
+    size_t capacity = buf_size;
+    string_sink_t sink = {
+        .buffer = &buf,
+        .capacity = &capacity,
+        .growable = false
+    };
+    int retval = read_string(ctx, &sink);
+    *out_length = sink.length;
+    return retval;
+}
+
+static int read_short_string(json_in_t *ctx, char *buf, size_t buf_size) {
+    size_t length;
+    int retval = read_fixed_string(ctx, buf, buf_size, &length);
+    if (!retval && length >= buf_size) {
+        json_log(DEBUG, "string too long");
+        retval = ANJAY_ERR_BAD_REQUEST;
+    }
+    return retval;
+}
+
+static bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.'
+           || c == 'e' || c == 'E';
+}
+
+static int read_raw_number(json_in_t *ctx, char *buf, size_t buf_size) {
+    char c;
+    size_t length = 0;
+    int retval = peek_token(ctx, &c);
+    while (!retval && is_number_char(c)) {
+        if (length + 1 >= buf_size) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        buf[length++] = c;
+        ++ctx->chunk_offset;
+        if (ctx->chunk_offset >= ctx->chunk_size && ctx->stream_finished) {
+            break;
+        }
+        retval = peek_char(ctx, &c);
+    }
+    buf[length] = '\0';
+    return retval;
+}
+
+/*
+ * Validates the JSON number grammar:
+ * -? (0 | [1-9][0-9]*) (\.[0-9]+)? ([eE][+-]?[0-9]+)?
+ *
+ * @returns true if the number is valid and is an integer, i.e. has no
+ *          fraction or exponent part.
+ */
+static int validate_number(const char *str, bool *out_is_integer) {
+    if (*str == '-') {
+        ++str;
+    }
+    if (*str == '0') {
+        ++str;
+    } else if (*str >= '1' && *str <= '9') {
+        while (*str >= '0' && *str <= '9') {
+            ++str;
+        }
+    } else {
+        return -1;
+    }
+    *out_is_integer = true;
+    if (*str == '.') {
+        *out_is_integer = false;
+        if (!(*++str >= '0' && *str <= '9')) {
+            return -1;
+        }
+        while (*str >= '0' && *str <= '9') {
+            ++str;
+        }
+    }
+    if (*str == 'e' || *str == 'E') {
+        *out_is_integer = false;
+        ++str;
+        if (*str == '+' || *str == '-') {
+            ++str;
+        }
+        if (!(*str >= '0' && *str <= '9')) {
+            return -1;
+        }
+        while (*str >= '0' && *str <= '9') {
+            ++str;
+        }
+    }
+    return *str ? -1 : 0;
+}
+
+static int read_number(json_in_t *ctx, senml_record_t *out_record) {
+    char buf[MAX_NUMBER_LENGTH];
+    bool is_integer;
+    int retval = read_raw_number(ctx, buf, sizeof(buf));
+    if (retval) {
+        return retval;
+    }
+    if (validate_number(buf, &is_integer)) {
+        json_log(DEBUG, "invalid number: %s", buf);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    long long ll;
+    if (is_integer && !_anjay_safe_strtoll(buf, &ll)) {
+        out_record->type = SENML_VALUE_INT;
+        out_record->value.i = ll;
+        return 0;
+    }
+    // non-integers, and integers out of int64_t range
+    out_record->type = SENML_VALUE_DOUBLE;
+    return _anjay_safe_strtod(buf, &out_record->value.d)
+            ? ANJAY_ERR_BAD_REQUEST : 0;
+}
+
+static int read_literal(json_in_t *ctx, char *buf, size_t buf_size) {
+    char c;
+    size_t length = 0;
+    int retval = peek_token(ctx, &c);
+    while (!retval && c >= 'a' && c <= 'z') {
+        if (length + 1 >= buf_size) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        buf[length++] = c;
+        ++ctx->chunk_offset;
+        if (ctx->chunk_offset >= ctx->chunk_size && ctx->stream_finished) {
+            break;
+        }
+        retval = peek_char(ctx, &c);
+    }
+    buf[length] = '\0';
+    return retval;
+}
+
+static int read_bool(json_in_t *ctx, senml_record_t *out_record) {
+    char buf[sizeof("false")];
+    int retval = read_literal(ctx, buf, sizeof(buf));
+    if (retval) {
+        return retval;
+    }
+    if (!strcmp(buf, "true")) {
+        out_record->value.b = true;
+    } else if (!strcmp(buf, "false")) {
+        out_record->value.b = false;
+    } else {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    out_record->type = SENML_VALUE_BOOL;
+    return 0;
+}
+
+static int read_objlnk(json_in_t *ctx, senml_record_t *out_record) {
+    char buf[sizeof("65535:65535")];
+    int retval = read_short_string(ctx, buf, sizeof(buf));
+    if (retval) {
+        return retval;
+    }
+    unsigned oid, iid;
+    char tail;
+    if (sscanf(buf, "%u:%u%c", &oid, &iid, &tail) != 2
+            || oid > UINT16_MAX || iid > UINT16_MAX) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    out_record->type = SENML_VALUE_OBJLNK;
+    out_record->value.objlnk.oid = (anjay_oid_t) oid;
+    out_record->value.objlnk.iid = (anjay_iid_t) iid;
+    return 0;
+}
+
+static int skip_value(json_in_t *ctx, unsigned depth);
+
+static int skip_members(json_in_t *ctx, char closing, unsigned depth) {
+    char c;
+    int retval = peek_token(ctx, &c);
+    if (!retval && c == closing) {
+        ++ctx->chunk_offset;
+        return 0;
+    }
+    while (!retval) {
+        if (closing == '}') {
+            char key[1];
+            size_t length;
+            (void) ((retval = read_fixed_string(ctx, key, sizeof(key),
+                                                &length))
+                    || (retval = expect_token(ctx, ':')));
+        }
+        if (retval || (retval = skip_value(ctx, depth + 1))
+                || (retval = peek_token(ctx, &c))) {
+            break;
+        }
+        ++ctx->chunk_offset;
+        if (c == closing) {
+            return 0;
+        } else if (c != ',') {
+            retval = ANJAY_ERR_BAD_REQUEST;
+        }
+    }
+    return retval;
+}
+
+static int skip_value(json_in_t *ctx, unsigned depth) {
+    if (depth > MAX_SKIP_DEPTH) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    char c;
+    int retval = peek_token(ctx, &c);
+    if (retval) {
+        return retval;
+    }
+    if (c == '"') {
+        char buf[1];
+        size_t length;
+        return read_fixed_string(ctx, buf, sizeof(buf), &length);
+    } else if (c == '{' || c == '[') {
+        ++ctx->chunk_offset;
+        return skip_members(ctx, c == '{' ? '}' : ']', depth);
+    } else if (c >= 'a' && c <= 'z') {
+        char buf[sizeof("false")];
+        if ((retval = read_literal(ctx, buf, sizeof(buf)))) {
+            return retval;
+        }
+        return (strcmp(buf, "true") && strcmp(buf, "false")
+                && strcmp(buf, "null")) ? ANJAY_ERR_BAD_REQUEST : 0;
+    } else {
+        senml_record_t dummy;
+        return read_number(ctx, &dummy);
+    }
+}
+
+static int read_string_value(json_in_t *ctx, senml_record_t *out_record) {
+    string_sink_t sink = {
+        .buffer = &ctx->value,
+        .capacity = &ctx->value_size,
+        .growable = true
+    };
+    int retval = read_string(ctx, &sink);
+    if (!retval) {
+        out_record->type = SENML_VALUE_STRING;
+        out_record->data = ctx->value;
+        out_record->data_length = sink.length;
+        // LwM2M JSON carries Opaque values as base64-encoded strings
+        out_record->string_is_base64 = true;
+    }
+    return retval;
+}
+
+static int read_entry_member(json_in_t *ctx,
+                             char *name,
+                             size_t name_size,
+                             senml_record_t *out_record) {
+    char key[sizeof("sv")];
+    size_t key_length;
+    int retval;
+    if ((retval = read_fixed_string(ctx, key, sizeof(key), &key_length))
+            || (retval = expect_token(ctx, ':'))) {
+        return retval;
+    }
+    if (key_length >= sizeof(key)) {
+        return skip_value(ctx, 0);
+    }
+    if (!strcmp(key, "n")) {
+        return read_short_string(ctx, name, name_size);
+    }
+
+    typedef int read_value_t(json_in_t *, senml_record_t *);
+    read_value_t *read_value = NULL;
+    if (!strcmp(key, "v")) {
+        read_value = read_number;
+    } else if (!strcmp(key, "sv")) {
+        read_value = read_string_value;
+    } else if (!strcmp(key, "bv")) {
+        read_value = read_bool;
+    } else if (!strcmp(key, "ov")) {
+        read_value = read_objlnk;
+    }
+    if (!read_value) {
+        return skip_value(ctx, 0);
+    }
+    if (out_record->type != SENML_VALUE_NONE) {
+        json_log(DEBUG, "more than one value in an entry");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return read_value(ctx, out_record);
+}
+
+static int read_entry(json_in_t *ctx, senml_record_t *out_record) {
+    char name[SENML_MAX_NAME_SIZE] = "";
+    char c;
+    int retval;
+    memset(out_record, 0, sizeof(*out_record));
+    out_record->type = SENML_VALUE_NONE;
+    if ((retval = expect_token(ctx, '{'))) {
+        return retval;
+    }
+    do {
+        if ((retval = read_entry_member(ctx, name, sizeof(name), out_record))
+                || (retval = peek_token(ctx, &c))) {
+            return retval;
+        }
+        ++ctx->chunk_offset;
+    } while (c == ',');
+    if (c != '}') {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    if (out_record->type == SENML_VALUE_NONE) {
+        json_log(DEBUG, "entry without a value");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+
+    // both "/3/0" + "/1" and "/3/0/" + "1" are commonly used
+    const char *relative = name;
+    size_t base_length = strlen(ctx->base_name);
+    if (base_length && ctx->base_name[base_length - 1] == '/'
+            && *relative == '/') {
+        ++relative;
+    }
+    char full_name[SENML_MAX_NAME_SIZE];
+    if (avs_simple_snprintf(full_name, sizeof(full_name), "%s%s",
+                            ctx->base_name, relative) < 0) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return _anjay_senml_parse_path(full_name, out_record->path);
+}
+
+/* Parses the top-level object up to the beginning of the "e" array. */
+static int read_preamble(json_in_t *ctx) {
+    char c;
+    int retval;
+    if ((retval = expect_token(ctx, '{')) || (retval = peek_token(ctx, &c))) {
+        return retval;
+    }
+    if (c == '}') {
+        ++ctx->chunk_offset;
+        ctx->state = JSON_IN_FINISHED;
+        return 0;
+    }
+    while (true) {
+        char key[sizeof("bn")];
+        size_t key_length;
+        if ((retval = read_fixed_string(ctx, key, sizeof(key), &key_length))
+                || (retval = expect_token(ctx, ':'))) {
+            return retval;
+        }
+        if (key_length < sizeof(key) && !strcmp(key, "bn")) {
+            retval = read_short_string(ctx, ctx->base_name,
+                                       sizeof(ctx->base_name));
+        } else if (key_length < sizeof(key) && !strcmp(key, "e")) {
+            ctx->state = JSON_IN_ENTRIES;
+            ctx->first_entry = true;
+            return expect_token(ctx, '[');
+        } else {
+            retval = skip_value(ctx, 0);
+        }
+        if (retval || (retval = peek_token(ctx, &c))) {
+            return retval;
+        }
+        ++ctx->chunk_offset;
+        if (c == '}') {
+            ctx->state = JSON_IN_FINISHED;
+            return 0;
+        } else if (c != ',') {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+    }
+}
+
+/* Parses the top-level object after the end of the "e" array. */
+static int read_epilogue(json_in_t *ctx) {
+    char c;
+    int retval;
+    while (!(retval = peek_token(ctx, &c)) && c == ',') {
+        char key[sizeof("bn")];
+        size_t key_length;
+        ++ctx->chunk_offset;
+        if ((retval = read_fixed_string(ctx, key, sizeof(key), &key_length))
+                || (retval = expect_token(ctx, ':'))) {
+            return retval;
+        }
+        if (key_length < sizeof(key)
+                && (!strcmp(key, "bn") || !strcmp(key, "e"))) {
+            json_log(DEBUG, "\"%s\" after \"e\" is not supported", key);
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        if ((retval = skip_value(ctx, 0))) {
+            return retval;
+        }
+    }
+    if (!retval) {
+        ++ctx->chunk_offset;
+        if (c != '}' || !at_end(ctx)) {
+            retval = ANJAY_ERR_BAD_REQUEST;
+        }
+    }
+    return retval;
+}
+
+static int json_next_record(senml_reader_t *reader,
+                            senml_record_t *out_record) {
+    json_in_t *ctx = (json_in_t *) reader;
+    int retval;
+    if (ctx->state == JSON_IN_START && (retval = read_preamble(ctx))) {
+        return retval;
+    }
+    if (ctx->state == JSON_IN_FINISHED) {
+        return ANJAY_GET_INDEX_END;
+    }
+
+    char c;
+    if ((retval = peek_token(ctx, &c))) {
+        return retval;
+    }
+    if (c == ']') {
+        ++ctx->chunk_offset;
+        if ((retval = read_epilogue(ctx))) {
+            return retval;
+        }
+        ctx->state = JSON_IN_FINISHED;
+        return ANJAY_GET_INDEX_END;
+    }
+    if (!ctx->first_entry && (retval = expect_token(ctx, ','))) {
+        return retval;
+    }
+    ctx->first_entry = false;
+    return read_entry(ctx, out_record);
+}
+
+static void json_reader_cleanup(senml_reader_t *reader) {
+    json_in_t *ctx = (json_in_t *) reader;
+    avs_free(ctx->value);
+    if (ctx->autoclose) {
+        avs_stream_cleanup(&ctx->stream);
+    }
+}
+
+static const senml_reader_vtable_t JSON_READER_VTABLE = {
+    .next_record = json_next_record,
+    .cleanup = json_reader_cleanup
+};
+
+int _anjay_input_json_create(anjay_input_ctx_t **out,
+                             avs_stream_abstract_t **stream_ptr,
+                             bool autoclose) {
+    json_in_t *ctx = (json_in_t *) avs_calloc(1, sizeof(json_in_t));
+    if (!ctx) {
+        *out = NULL;
+        return -1;
+    }
+    ctx->base.vtable = &JSON_READER_VTABLE;
+    ctx->stream = *stream_ptr;
+    if (autoclose) {
+        ctx->autoclose = true;
+        *stream_ptr = NULL;
+    }
+    return _anjay_input_senml_create(out, (senml_reader_t *) ctx);
+}
+
+#ifdef ANJAY_TEST
+#include "test/json_in.c"
+#endif
@@ -28,6 +28,7 @@
 #include "../coap/content_format.h"
 
 #include "../io_core.h"
+#include "../number_format.h"
 #include "base64_out.h"
 #include "vtable.h"
 
@@ -250,15 +251,24 @@ static int write_variable(avs_stream_abstract_t *stream,
         return retval;
     }
 
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE];
     switch (type) {
     case JSON_DATA_I32:
-        return avs_stream_write_f(stream, "%" PRIi32, *(const int32_t *) value);
+        return avs_stream_write(
+                stream, buf,
+                _anjay_int64_as_string(*(const int32_t *) value, buf));
     case JSON_DATA_I64:
-        return avs_stream_write_f(stream, "%" PRIi64, *(const int64_t *) value);
+        return avs_stream_write(
+                stream, buf,
+                _anjay_int64_as_string(*(const int64_t *) value, buf));
     case JSON_DATA_F32:
-        return avs_stream_write_f(stream, "%f", *(const float *) value);
+        return avs_stream_write(
+                stream, buf,
+                _anjay_float_as_string(*(const float *) value, buf));
     case JSON_DATA_F64:
-        return avs_stream_write_f(stream, "%f", *(const double *) value);
+        return avs_stream_write(
+                stream, buf,
+                _anjay_double_as_string(*(const double *) value, buf));
     case JSON_DATA_BOOL:
         return avs_stream_write_f(stream, "%s",
                                   (*(const bool *) value) ? "true" : "false");
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_IO_SENML_CBOR_H
+#define ANJAY_IO_SENML_CBOR_H
+
+#include "senml_in.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/* CBOR major types, see RFC 7049, section 2.1 */
+#define SENML_CBOR_MAJOR_UINT 0
+#define SENML_CBOR_MAJOR_NEGATIVE_INT 1
+#define SENML_CBOR_MAJOR_BYTE_STRING 2
+#define SENML_CBOR_MAJOR_TEXT_STRING 3
+#define SENML_CBOR_MAJOR_ARRAY 4
+#define SENML_CBOR_MAJOR_MAP 5
+#define SENML_CBOR_MAJOR_TAG 6
+#define SENML_CBOR_MAJOR_SIMPLE 7
+
+/* values of the 5-bit additional information field */
+#define SENML_CBOR_EXT_LENGTH_1BYTE 24
+#define SENML_CBOR_EXT_LENGTH_2BYTE 25
+#define SENML_CBOR_EXT_LENGTH_4BYTE 26
+#define SENML_CBOR_EXT_LENGTH_8BYTE 27
+#define SENML_CBOR_INDEFINITE_LENGTH 31
+
+/* complete initial bytes of major type 7 items */
+#define SENML_CBOR_FALSE 0xF4
+#define SENML_CBOR_TRUE 0xF5
+#define SENML_CBOR_FLOAT16 0xF9
+#define SENML_CBOR_FLOAT32 0xFA
+#define SENML_CBOR_FLOAT64 0xFB
+#define SENML_CBOR_BREAK 0xFF
+
+/* SenML labels, see RFC 8428, section 6 */
+#define SENML_LABEL_BASE_NAME (-2)
+#define SENML_LABEL_NAME 0
+#define SENML_LABEL_VALUE 2
+#define SENML_LABEL_VALUE_STRING 3
+#define SENML_LABEL_VALUE_BOOL 4
+#define SENML_LABEL_VALUE_DATA 8
+/* LwM2M 1.1 extension; has no integer label */
+#define SENML_LABEL_VALUE_OBJLNK "vlo"
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_IO_SENML_CBOR_H */
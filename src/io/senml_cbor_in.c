@@ -0,0 +1,525 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../io_core.h"
+#include "senml_cbor.h"
+
+#define senml_log(level, ...) _anjay_log(senml_cbor, level, __VA_ARGS__)
+
+VISIBILITY_SOURCE_BEGIN
+
+/* Maximum nesting level of unknown data items that are skipped */
+#define MAX_SKIP_DEPTH 8
+
+/* Initial size of the buffer for string and bytes values. It then grows
+ * geometrically as data is actually read, so that a length declared in the
+ * payload cannot cause a larger allocation than the payload itself. */
+#define MIN_BUFFER_SIZE 64
+
+typedef struct {
+    senml_reader_t base;
+    avs_stream_abstract_t *stream;
+    bool autoclose;
+    bool started;
+    bool indefinite;
+    size_t records_left;
+    /* base name persists across Records until overridden */
+    char base_name[SENML_MAX_NAME_SIZE];
+    /* storage for string and bytes values, reused across Records */
+    char *buffer;
+    size_t buffer_size;
+} senml_cbor_reader_t;
+
+typedef struct {
+    uint8_t major_type;
+    bool indefinite;
+    /* argument of the data item: integer value, length, count or raw bits of
+     * a floating-point value, depending on major_type */
+    uint64_t value;
+} cbor_head_t;
+
+static int read_bytes(senml_cbor_reader_t *reader, void *out, size_t length) {
+    if (length && avs_stream_read_reliably(reader->stream, out, length)) {
+        senml_log(DEBUG, "could not read %lu bytes", (unsigned long) length);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return 0;
+}
+
+static int read_head_from(senml_cbor_reader_t *reader,
+                          uint8_t initial,
+                          cbor_head_t *out_head) {
+    const uint8_t info = initial & 0x1F;
+    out_head->major_type = (uint8_t) (initial >> 5);
+    out_head->indefinite = false;
+    out_head->value = 0;
+    if (info < SENML_CBOR_EXT_LENGTH_1BYTE) {
+        out_head->value = info;
+        return 0;
+    } else if (info == SENML_CBOR_INDEFINITE_LENGTH) {
+        out_head->indefinite = true;
+        return 0;
+    } else if (info > SENML_CBOR_EXT_LENGTH_8BYTE) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    uint8_t buf[8];
+    size_t length = (size_t) 1 << (info - SENML_CBOR_EXT_LENGTH_1BYTE);
+    int retval = read_bytes(reader, buf, length);
+    for (size_t i = 0; !retval && i < length; ++i) {
+        out_head->value = (out_head->value << 8) | buf[i];
+    }
+    return retval;
+}
+
+static int read_head(senml_cbor_reader_t *reader, cbor_head_t *out_head) {
+    uint8_t initial;
+    int retval = read_bytes(reader, &initial, 1);
+    if (!retval) {
+        retval = read_head_from(reader, initial, out_head);
+    }
+    return retval;
+}
+
+static bool is_break(const cbor_head_t *head) {
+    return head->major_type == SENML_CBOR_MAJOR_SIMPLE && head->indefinite;
+}
+
+static int skip_item(senml_cbor_reader_t *reader,
+                     const cbor_head_t *head,
+                     unsigned depth) {
+    if (depth > MAX_SKIP_DEPTH) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    switch (head->major_type) {
+    case SENML_CBOR_MAJOR_UINT:
+    case SENML_CBOR_MAJOR_NEGATIVE_INT:
+        return 0;
+    case SENML_CBOR_MAJOR_SIMPLE:
+        return is_break(head) ? ANJAY_ERR_BAD_REQUEST : 0;
+    case SENML_CBOR_MAJOR_BYTE_STRING:
+    case SENML_CBOR_MAJOR_TEXT_STRING: {
+        if (head->indefinite) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        char buf[64];
+        uint64_t left = head->value;
+        while (left) {
+            size_t chunk = (size_t) AVS_MIN(left, sizeof(buf));
+            int retval = read_bytes(reader, buf, chunk);
+            if (retval) {
+                return retval;
+            }
+            left -= chunk;
+        }
+        return 0;
+    }
+    case SENML_CBOR_MAJOR_ARRAY:
+    case SENML_CBOR_MAJOR_MAP: {
+        const uint64_t multiplier =
+                (head->major_type == SENML_CBOR_MAJOR_MAP) ? 2 : 1;
+        for (uint64_t i = 0; head->indefinite || i < multiplier * head->value;
+                ++i) {
+            cbor_head_t nested;
+            int retval = read_head(reader, &nested);
+            if (!retval && head->indefinite && is_break(&nested)) {
+                return 0;
+            }
+            if (retval || (retval = skip_item(reader, &nested, depth + 1))) {
+                return retval;
+            }
+        }
+        return 0;
+    }
+    case SENML_CBOR_MAJOR_TAG: {
+        cbor_head_t tagged;
+        int retval = read_head(reader, &tagged);
+        if (!retval) {
+            retval = skip_item(reader, &tagged, depth + 1);
+        }
+        return retval;
+    }
+    default:
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int read_short_text(senml_cbor_reader_t *reader,
+                           const cbor_head_t *head,
+                           char *out_buf,
+                           size_t buf_size) {
+    if (head->major_type != SENML_CBOR_MAJOR_TEXT_STRING || head->indefinite
+            || head->value >= buf_size) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    int retval = read_bytes(reader, out_buf, (size_t) head->value);
+    if (!retval) {
+        out_buf[head->value] = '\0';
+    }
+    return retval;
+}
+
+static int read_string_value(senml_cbor_reader_t *reader,
+                             uint8_t expected_major_type,
+                             senml_record_t *out_record) {
+    cbor_head_t head;
+    int retval = read_head(reader, &head);
+    if (retval) {
+        return retval;
+    }
+    if (head.major_type != expected_major_type || head.indefinite
+            || head.value >= SIZE_MAX) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    size_t length = (size_t) head.value;
+    size_t offset = 0;
+    while (offset < length) {
+        if (offset == reader->buffer_size) {
+            size_t new_size =
+                    AVS_MIN(length, AVS_MAX(2 * reader->buffer_size,
+                                            (size_t) MIN_BUFFER_SIZE));
+            char *buffer = (char *) avs_realloc(reader->buffer, new_size);
+            if (!buffer) {
+                senml_log(ERROR, "out of memory");
+                return ANJAY_ERR_INTERNAL;
+            }
+            reader->buffer = buffer;
+            reader->buffer_size = new_size;
+        }
+        size_t chunk = AVS_MIN(length, reader->buffer_size) - offset;
+        if ((retval = read_bytes(reader, reader->buffer + offset, chunk))) {
+            return retval;
+        }
+        offset += chunk;
+    }
+    out_record->data = length ? reader->buffer : "";
+    out_record->data_length = length;
+    return 0;
+}
+
+static double decode_half(uint16_t half) {
+    /* see RFC 7049, Appendix D */
+    const int exponent = (half >> 10) & 0x1F;
+    const int mantissa = half & 0x3FF;
+    double value;
+    if (exponent == 0) {
+        value = ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = (mantissa == 0) ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+static int read_numeric_value(senml_cbor_reader_t *reader,
+                              senml_record_t *out_record) {
+    uint8_t initial;
+    cbor_head_t head;
+    int retval;
+    if ((retval = read_bytes(reader, &initial, 1))
+            || (retval = read_head_from(reader, initial, &head))) {
+        return retval;
+    }
+    switch (head.major_type) {
+    case SENML_CBOR_MAJOR_UINT:
+        if (head.value > INT64_MAX) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        out_record->type = SENML_VALUE_INT;
+        out_record->value.i = (int64_t) head.value;
+        return 0;
+    case SENML_CBOR_MAJOR_NEGATIVE_INT:
+        if (head.value > INT64_MAX) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        out_record->type = SENML_VALUE_INT;
+        out_record->value.i = -1 - (int64_t) head.value;
+        return 0;
+    default:
+        break;
+    }
+    out_record->type = SENML_VALUE_DOUBLE;
+    switch (initial) {
+    case SENML_CBOR_FLOAT16:
+        out_record->value.d = decode_half((uint16_t) head.value);
+        return 0;
+    case SENML_CBOR_FLOAT32: {
+        uint32_t bits = (uint32_t) head.value;
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        out_record->value.d = value;
+        return 0;
+    }
+    case SENML_CBOR_FLOAT64:
+        memcpy(&out_record->value.d, &head.value, sizeof(double));
+        return 0;
+    default:
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int read_bool_value(senml_cbor_reader_t *reader,
+                           senml_record_t *out_record) {
+    uint8_t initial;
+    int retval = read_bytes(reader, &initial, 1);
+    if (retval) {
+        return retval;
+    }
+    if (initial != SENML_CBOR_FALSE && initial != SENML_CBOR_TRUE) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    out_record->type = SENML_VALUE_BOOL;
+    out_record->value.b = (initial == SENML_CBOR_TRUE);
+    return 0;
+}
+
+static int read_objlnk_value(senml_cbor_reader_t *reader,
+                             senml_record_t *out_record) {
+    char buf[sizeof("65535:65535")];
+    cbor_head_t head;
+    int retval;
+    if ((retval = read_head(reader, &head))
+            || (retval = read_short_text(reader, &head, buf, sizeof(buf)))) {
+        return retval;
+    }
+    unsigned oid, iid;
+    char tail;
+    if (sscanf(buf, "%u:%u%c", &oid, &iid, &tail) != 2
+            || oid > UINT16_MAX || iid > UINT16_MAX) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    out_record->type = SENML_VALUE_OBJLNK;
+    out_record->value.objlnk.oid = (anjay_oid_t) oid;
+    out_record->value.objlnk.iid = (anjay_iid_t) iid;
+    return 0;
+}
+
+typedef enum {
+    LABEL_UNKNOWN,
+    LABEL_BASE_NAME,
+    LABEL_NAME,
+    LABEL_VALUE,
+    LABEL_VALUE_STRING,
+    LABEL_VALUE_BOOL,
+    LABEL_VALUE_DATA,
+    LABEL_VALUE_OBJLNK
+} senml_label_t;
+
+static int read_label(senml_cbor_reader_t *reader,
+                      const cbor_head_t *head,
+                      senml_label_t *out_label) {
+    *out_label = LABEL_UNKNOWN;
+    if (head->major_type == SENML_CBOR_MAJOR_TEXT_STRING) {
+        char buf[sizeof(SENML_LABEL_VALUE_OBJLNK)];
+        if (head->indefinite || head->value >= sizeof(buf)) {
+            return skip_item(reader, head, 0);
+        }
+        int retval = read_short_text(reader, head, buf, sizeof(buf));
+        if (!retval && !strcmp(buf, SENML_LABEL_VALUE_OBJLNK)) {
+            *out_label = LABEL_VALUE_OBJLNK;
+        }
+        return retval;
+    }
+
+    int64_t label;
+    if (head->major_type == SENML_CBOR_MAJOR_UINT
+            && head->value <= INT64_MAX) {
+        label = (int64_t) head->value;
+    } else if (head->major_type == SENML_CBOR_MAJOR_NEGATIVE_INT
+            && head->value <= INT64_MAX) {
+        label = -1 - (int64_t) head->value;
+    } else {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    switch (label) {
+    case SENML_LABEL_BASE_NAME:
+        *out_label = LABEL_BASE_NAME;
+        break;
+    case SENML_LABEL_NAME:
+        *out_label = LABEL_NAME;
+        break;
+    case SENML_LABEL_VALUE:
+        *out_label = LABEL_VALUE;
+        break;
+    case SENML_LABEL_VALUE_STRING:
+        *out_label = LABEL_VALUE_STRING;
+        break;
+    case SENML_LABEL_VALUE_BOOL:
+        *out_label = LABEL_VALUE_BOOL;
+        break;
+    case SENML_LABEL_VALUE_DATA:
+        *out_label = LABEL_VALUE_DATA;
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+static int read_field(senml_cbor_reader_t *reader,
+                      senml_label_t label,
+                      char *name,
+                      size_t name_size,
+                      senml_record_t *out_record) {
+    if (label >= LABEL_VALUE && out_record->type != SENML_VALUE_NONE) {
+        senml_log(DEBUG, "more than one value in a SenML Record");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    cbor_head_t head;
+    int retval;
+    switch (label) {
+    case LABEL_BASE_NAME:
+        (void) ((retval = read_head(reader, &head))
+                || (retval = read_short_text(reader, &head, reader->base_name,
+                                             sizeof(reader->base_name))));
+        return retval;
+    case LABEL_NAME:
+        (void) ((retval = read_head(reader, &head))
+                || (retval = read_short_text(reader, &head, name,
+                                             name_size)));
+        return retval;
+    case LABEL_VALUE:
+        return read_numeric_value(reader, out_record);
+    case LABEL_VALUE_STRING:
+        out_record->type = SENML_VALUE_STRING;
+        return read_string_value(reader, SENML_CBOR_MAJOR_TEXT_STRING,
+                                 out_record);
+    case LABEL_VALUE_BOOL:
+        return read_bool_value(reader, out_record);
+    case LABEL_VALUE_DATA:
+        out_record->type = SENML_VALUE_BYTES;
+        return read_string_value(reader, SENML_CBOR_MAJOR_BYTE_STRING,
+                                 out_record);
+    case LABEL_VALUE_OBJLNK:
+        return read_objlnk_value(reader, out_record);
+    default:
+        (void) ((retval = read_head(reader, &head))
+                || (retval = skip_item(reader, &head, 0)));
+        return retval;
+    }
+}
+
+static int senml_cbor_next_record(senml_reader_t *reader_,
+                                  senml_record_t *out_record) {
+    senml_cbor_reader_t *reader = (senml_cbor_reader_t *) reader_;
+    cbor_head_t head;
+    int retval;
+    if (!reader->started) {
+        if ((retval = read_head(reader, &head))) {
+            return retval;
+        }
+        if (head.major_type != SENML_CBOR_MAJOR_ARRAY) {
+            senml_log(DEBUG, "SenML Pack is not an array");
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        reader->started = true;
+        reader->indefinite = head.indefinite;
+        reader->records_left = (size_t) AVS_MIN(head.value, SIZE_MAX);
+    }
+    if (!reader->indefinite && !reader->records_left) {
+        return ANJAY_GET_INDEX_END;
+    }
+    if ((retval = read_head(reader, &head))) {
+        return retval;
+    }
+    if (reader->indefinite && is_break(&head)) {
+        reader->indefinite = false;
+        reader->records_left = 0;
+        return ANJAY_GET_INDEX_END;
+    } else if (!reader->indefinite) {
+        --reader->records_left;
+    }
+    if (head.major_type != SENML_CBOR_MAJOR_MAP) {
+        senml_log(DEBUG, "SenML Record is not a map");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+
+    char name[SENML_MAX_NAME_SIZE] = "";
+    memset(out_record, 0, sizeof(*out_record));
+    out_record->type = SENML_VALUE_NONE;
+    for (uint64_t i = 0; head.indefinite || i < head.value; ++i) {
+        cbor_head_t key;
+        senml_label_t label;
+        if ((retval = read_head(reader, &key))) {
+            return retval;
+        }
+        if (head.indefinite && is_break(&key)) {
+            break;
+        }
+        if ((retval = read_label(reader, &key, &label))
+                || (retval = read_field(reader, label, name, sizeof(name),
+                                        out_record))) {
+            return retval;
+        }
+    }
+    if (out_record->type == SENML_VALUE_NONE) {
+        senml_log(DEBUG, "SenML Record without a value");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+
+    char full_name[SENML_MAX_NAME_SIZE];
+    if (avs_simple_snprintf(full_name, sizeof(full_name), "%s%s",
+                            reader->base_name, name) < 0) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return _anjay_senml_parse_path(full_name, out_record->path);
+}
+
+static void senml_cbor_reader_cleanup(senml_reader_t *reader_) {
+    senml_cbor_reader_t *reader = (senml_cbor_reader_t *) reader_;
+    avs_free(reader->buffer);
+    if (reader->autoclose) {
+        avs_stream_cleanup(&reader->stream);
+    }
+}
+
+static const senml_reader_vtable_t SENML_CBOR_READER_VTABLE = {
+    .next_record = senml_cbor_next_record,
+    .cleanup = senml_cbor_reader_cleanup
+};
+
+int _anjay_input_senml_cbor_create(anjay_input_ctx_t **out,
+                                   avs_stream_abstract_t **stream_ptr,
+                                   bool autoclose) {
+    senml_cbor_reader_t *reader =
+            (senml_cbor_reader_t *) avs_calloc(1, sizeof(senml_cbor_reader_t));
+    if (!reader) {
+        *out = NULL;
+        return -1;
+    }
+    reader->base.vtable = &SENML_CBOR_READER_VTABLE;
+    reader->stream = *stream_ptr;
+    if (autoclose) {
+        reader->autoclose = true;
+        *stream_ptr = NULL;
+    }
+    return _anjay_input_senml_create(out, (senml_reader_t *) reader);
+}
+
+#ifdef ANJAY_TEST
+#include "test/senml_cbor_in.c"
+#endif
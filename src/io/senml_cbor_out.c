@@ -0,0 +1,364 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../coap/content_format.h"
+
+#include "../io_core.h"
+#include "senml_cbor.h"
+#include "vtable.h"
+
+#define senml_log(level, ...) _anjay_log(senml_cbor, level, __VA_ARGS__)
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    const anjay_ret_bytes_ctx_vtable_t *vtable;
+    avs_stream_abstract_t *stream;
+    size_t bytes_left;
+} senml_cbor_bytes_t;
+
+typedef struct {
+    const anjay_output_ctx_vtable_t *vtable;
+    avs_stream_abstract_t *stream;
+    int *errno_ptr;
+    /* OID, IID, RID and RIID of the next Record; -1 if not set */
+    int32_t path[4];
+    /* OID and IID of the last base name written */
+    int32_t base[2];
+    bool returning_bytes;
+    senml_cbor_bytes_t bytes;
+} senml_cbor_out_t;
+
+static int write_header(avs_stream_abstract_t *stream,
+                        uint8_t major_type,
+                        uint64_t value) {
+    uint8_t buf[9];
+    size_t length;
+    if (value < SENML_CBOR_EXT_LENGTH_1BYTE) {
+        buf[0] = (uint8_t) (major_type << 5 | value);
+        length = 1;
+    } else {
+        size_t value_length;
+        if (value <= UINT8_MAX) {
+            buf[0] = SENML_CBOR_EXT_LENGTH_1BYTE;
+            value_length = 1;
+        } else if (value <= UINT16_MAX) {
+            buf[0] = SENML_CBOR_EXT_LENGTH_2BYTE;
+            value_length = 2;
+        } else if (value <= UINT32_MAX) {
+            buf[0] = SENML_CBOR_EXT_LENGTH_4BYTE;
+            value_length = 4;
+        } else {
+            buf[0] = SENML_CBOR_EXT_LENGTH_8BYTE;
+            value_length = 8;
+        }
+        buf[0] = (uint8_t) (buf[0] | major_type << 5);
+        for (size_t i = value_length; i > 0; --i) {
+            buf[i] = (uint8_t) (value & 0xFF);
+            value >>= 8;
+        }
+        length = value_length + 1;
+    }
+    return avs_stream_write(stream, buf, length);
+}
+
+static int write_text(avs_stream_abstract_t *stream, const char *text) {
+    size_t length = strlen(text);
+    int retval = write_header(stream, SENML_CBOR_MAJOR_TEXT_STRING, length);
+    if (!retval) {
+        retval = avs_stream_write(stream, text, length);
+    }
+    return retval;
+}
+
+static int write_int(avs_stream_abstract_t *stream, int64_t value) {
+    if (value >= 0) {
+        return write_header(stream, SENML_CBOR_MAJOR_UINT, (uint64_t) value);
+    }
+    return write_header(stream, SENML_CBOR_MAJOR_NEGATIVE_INT,
+                        (uint64_t) -(value + 1));
+}
+
+static int write_float(avs_stream_abstract_t *stream, float value) {
+    const uint8_t header = SENML_CBOR_FLOAT32;
+    uint32_t portable = _anjay_htonf(value);
+    int retval = avs_stream_write(stream, &header, 1);
+    if (!retval) {
+        retval = avs_stream_write(stream, &portable, sizeof(portable));
+    }
+    return retval;
+}
+
+static int write_double(avs_stream_abstract_t *stream, double value) {
+    if ((double) (float) value == value || value != value) {
+        return write_float(stream, (float) value);
+    }
+    const uint8_t header = SENML_CBOR_FLOAT64;
+    uint64_t portable = _anjay_htond(value);
+    int retval = avs_stream_write(stream, &header, 1);
+    if (!retval) {
+        retval = avs_stream_write(stream, &portable, sizeof(portable));
+    }
+    return retval;
+}
+
+static int write_record_start(senml_cbor_out_t *ctx) {
+    if (ctx->returning_bytes) {
+        if (ctx->bytes.bytes_left) {
+            senml_log(ERROR, "previous bytes value not finished");
+            return -1;
+        }
+        ctx->returning_bytes = false;
+    }
+    if (ctx->path[ANJAY_ID_OID] < 0 || ctx->path[ANJAY_ID_IID] < 0
+            || ctx->path[ANJAY_ID_RID] < 0) {
+        senml_log(ERROR, "value returned without a full Resource path");
+        return -1;
+    }
+
+    /* base name is only repeated when the Object Instance changes */
+    bool write_base = (ctx->base[0] != ctx->path[ANJAY_ID_OID]
+                       || ctx->base[1] != ctx->path[ANJAY_ID_IID]);
+    char buf[SENML_MAX_NAME_SIZE];
+    int retval = write_header(ctx->stream, SENML_CBOR_MAJOR_MAP,
+                              write_base ? 3 : 2);
+    if (!retval && write_base) {
+        avs_simple_snprintf(buf, sizeof(buf), "/%" PRId32 "/%" PRId32 "/",
+                            ctx->path[ANJAY_ID_OID], ctx->path[ANJAY_ID_IID]);
+        if (!(retval = write_int(ctx->stream, SENML_LABEL_BASE_NAME))
+                && !(retval = write_text(ctx->stream, buf))) {
+            ctx->base[0] = ctx->path[ANJAY_ID_OID];
+            ctx->base[1] = ctx->path[ANJAY_ID_IID];
+        }
+    }
+    if (!retval) {
+        if (ctx->path[ANJAY_ID_RIID] >= 0) {
+            avs_simple_snprintf(buf, sizeof(buf), "%" PRId32 "/%" PRId32,
+                                ctx->path[ANJAY_ID_RID],
+                                ctx->path[ANJAY_ID_RIID]);
+        } else {
+            avs_simple_snprintf(buf, sizeof(buf), "%" PRId32,
+                                ctx->path[ANJAY_ID_RID]);
+        }
+        (void) ((retval = write_int(ctx->stream, SENML_LABEL_NAME))
+                || (retval = write_text(ctx->stream, buf)));
+    }
+    return retval;
+}
+
+static int write_value_start(senml_cbor_out_t *ctx, int64_t value_label) {
+    int retval = write_record_start(ctx);
+    if (!retval) {
+        retval = write_int(ctx->stream, value_label);
+    }
+    return retval;
+}
+
+static int senml_cbor_ret_bytes_append(anjay_ret_bytes_ctx_t *ctx_,
+                                       const void *data,
+                                       size_t length) {
+    senml_cbor_bytes_t *ctx = (senml_cbor_bytes_t *) ctx_;
+    int retval = 0;
+    if (length) {
+        if (length > ctx->bytes_left) {
+            retval = -1;
+        } else if (!(retval = avs_stream_write(ctx->stream, data, length))) {
+            ctx->bytes_left -= length;
+        }
+    }
+    return retval;
+}
+
+static const anjay_ret_bytes_ctx_vtable_t SENML_CBOR_BYTES_VTABLE = {
+    .append = senml_cbor_ret_bytes_append
+};
+
+static int *senml_cbor_errno_ptr(anjay_output_ctx_t *ctx) {
+    return ((senml_cbor_out_t *) ctx)->errno_ptr;
+}
+
+static anjay_ret_bytes_ctx_t *senml_cbor_ret_bytes(anjay_output_ctx_t *ctx_,
+                                                   size_t length) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    if (write_value_start(ctx, SENML_LABEL_VALUE_DATA)
+            || write_header(ctx->stream, SENML_CBOR_MAJOR_BYTE_STRING,
+                            length)) {
+        return NULL;
+    }
+    ctx->returning_bytes = true;
+    ctx->bytes.bytes_left = length;
+    return (anjay_ret_bytes_ctx_t *) &ctx->bytes;
+}
+
+static int senml_cbor_ret_string(anjay_output_ctx_t *ctx_, const char *value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    int retval = write_value_start(ctx, SENML_LABEL_VALUE_STRING);
+    if (!retval) {
+        retval = write_text(ctx->stream, value);
+    }
+    return retval;
+}
+
+static int senml_cbor_ret_i64(anjay_output_ctx_t *ctx_, int64_t value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    int retval = write_value_start(ctx, SENML_LABEL_VALUE);
+    if (!retval) {
+        retval = write_int(ctx->stream, value);
+    }
+    return retval;
+}
+
+static int senml_cbor_ret_i32(anjay_output_ctx_t *ctx, int32_t value) {
+    return senml_cbor_ret_i64(ctx, value);
+}
+
+static int senml_cbor_ret_float(anjay_output_ctx_t *ctx_, float value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    int retval = write_value_start(ctx, SENML_LABEL_VALUE);
+    if (!retval) {
+        retval = write_float(ctx->stream, value);
+    }
+    return retval;
+}
+
+static int senml_cbor_ret_double(anjay_output_ctx_t *ctx_, double value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    int retval = write_value_start(ctx, SENML_LABEL_VALUE);
+    if (!retval) {
+        retval = write_double(ctx->stream, value);
+    }
+    return retval;
+}
+
+static int senml_cbor_ret_bool(anjay_output_ctx_t *ctx_, bool value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    int retval = write_value_start(ctx, SENML_LABEL_VALUE_BOOL);
+    if (!retval) {
+        const uint8_t simple = value ? SENML_CBOR_TRUE : SENML_CBOR_FALSE;
+        retval = avs_stream_write(ctx->stream, &simple, 1);
+    }
+    return retval;
+}
+
+static int senml_cbor_ret_objlnk(anjay_output_ctx_t *ctx_,
+                                 anjay_oid_t oid, anjay_iid_t iid) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    char buf[sizeof("65535:65535")];
+    avs_simple_snprintf(buf, sizeof(buf), "%" PRIu16 ":%" PRIu16, oid, iid);
+    int retval;
+    (void) ((retval = write_record_start(ctx))
+            || (retval = write_text(ctx->stream, SENML_LABEL_VALUE_OBJLNK))
+            || (retval = write_text(ctx->stream, buf)));
+    return retval;
+}
+
+static anjay_output_ctx_t *senml_cbor_ret_start(anjay_output_ctx_t *ctx) {
+    return ctx;
+}
+
+static int senml_cbor_ret_finish(anjay_output_ctx_t *ctx) {
+    (void) ctx;
+    return 0;
+}
+
+static int senml_cbor_set_id(anjay_output_ctx_t *ctx_,
+                             anjay_id_type_t type,
+                             uint16_t id) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    if (ctx->returning_bytes && ctx->bytes.bytes_left) {
+        senml_log(ERROR, "previous bytes value not finished");
+        return -1;
+    }
+    ctx->path[type] = id;
+    for (size_t i = (size_t) type + 1; i < AVS_ARRAY_SIZE(ctx->path); ++i) {
+        ctx->path[i] = -1;
+    }
+    return 0;
+}
+
+static int senml_cbor_output_close(anjay_output_ctx_t *ctx_) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    if (ctx->returning_bytes && ctx->bytes.bytes_left) {
+        senml_log(ERROR, "bytes value not finished");
+        return -1;
+    }
+    const uint8_t brk = SENML_CBOR_BREAK;
+    return avs_stream_write(ctx->stream, &brk, 1);
+}
+
+static const anjay_output_ctx_vtable_t SENML_CBOR_OUT_VTABLE = {
+    senml_cbor_errno_ptr,
+    senml_cbor_ret_bytes,
+    senml_cbor_ret_string,
+    senml_cbor_ret_i32,
+    senml_cbor_ret_i64,
+    senml_cbor_ret_float,
+    senml_cbor_ret_double,
+    senml_cbor_ret_bool,
+    senml_cbor_ret_objlnk,
+    senml_cbor_ret_start,
+    senml_cbor_ret_finish,
+    senml_cbor_ret_start,
+    senml_cbor_ret_finish,
+    senml_cbor_set_id,
+    senml_cbor_output_close
+};
+
+anjay_output_ctx_t *
+_anjay_output_senml_cbor_create(avs_stream_abstract_t *stream,
+                                int *errno_ptr,
+                                anjay_msg_details_t *inout_details,
+                                const anjay_uri_path_t *uri) {
+    senml_cbor_out_t *ctx =
+            (senml_cbor_out_t *) avs_calloc(1, sizeof(senml_cbor_out_t));
+    if (!ctx) {
+        return NULL;
+    }
+    ctx->vtable = &SENML_CBOR_OUT_VTABLE;
+    ctx->stream = stream;
+    ctx->errno_ptr = errno_ptr;
+    ctx->path[ANJAY_ID_OID] = _anjay_uri_path_has_oid(uri) ? uri->oid : -1;
+    ctx->path[ANJAY_ID_IID] = _anjay_uri_path_has_iid(uri) ? uri->iid : -1;
+    ctx->path[ANJAY_ID_RID] = _anjay_uri_path_has_rid(uri) ? uri->rid : -1;
+    ctx->path[ANJAY_ID_RIID] = -1;
+    ctx->base[0] = -1;
+    ctx->base[1] = -1;
+    ctx->bytes.vtable = &SENML_CBOR_BYTES_VTABLE;
+    ctx->bytes.stream = stream;
+
+    const uint8_t preamble = SENML_CBOR_MAJOR_ARRAY << 5
+                             | SENML_CBOR_INDEFINITE_LENGTH;
+    if ((*errno_ptr = _anjay_handle_requested_format(
+                 &inout_details->format, ANJAY_COAP_FORMAT_SENML_CBOR))
+            || _anjay_coap_stream_setup_response(stream, inout_details)
+            || avs_stream_write(stream, &preamble, 1)) {
+        avs_free(ctx);
+        return NULL;
+    }
+    return (anjay_output_ctx_t *) ctx;
+}
+
+#ifdef ANJAY_TEST
+#include "test/senml_cbor_out.c"
+#endif
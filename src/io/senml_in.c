@@ -0,0 +1,529 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#include <avsystem/commons/base64.h>
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/utils.h>
+
+#include "../dm_core.h"
+#include "../io_core.h"
+#include "../utils_core.h"
+#include "senml_in.h"
+#include "vtable.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/*
+ * SenML is a flat list of Records, each carrying a full path. To be usable by
+ * the data model code, which expects the TLV-like hierarchy, the Records are
+ * grouped by consecutive runs of equal path prefixes:
+ *
+ * - the top-level context (level 1) returns one Object Instance entry for each
+ *   run of Records with the same IID,
+ * - a nested context created for such entry (level 2) returns one Resource
+ *   entry for each run of Records with the same RID,
+ * - a nested context created for a Resource entry (level 3) returns Resource
+ *   Instance entries.
+ *
+ * All contexts share a single parser state, so that each Record is read from
+ * the underlying reader exactly once.
+ */
+
+#define LEVEL_IID 1
+#define LEVEL_RID 2
+#define LEVEL_RIID 3
+
+typedef struct {
+    senml_reader_t *reader;
+    senml_record_t record;
+    /* true if record is loaded and not yet consumed */
+    bool has_record;
+    bool finished;
+    size_t bytes_read;
+    /* bytes decoded from base64, but not yet returned */
+    uint8_t bytes_cached[3];
+    size_t num_bytes_cached;
+    int32_t oid;
+} senml_state_t;
+
+typedef struct senml_in_struct {
+    const anjay_input_ctx_vtable_t *vtable;
+    senml_state_t *state;
+    anjay_input_ctx_t *child;
+    size_t level;
+    /* path components this context is nested under, indexed by level */
+    uint16_t prefix[LEVEL_RIID];
+    int32_t id;
+    senml_state_t state_storage;
+} senml_in_t;
+
+int _anjay_senml_parse_path(const char *name, int32_t out_path[4]) {
+    for (size_t i = 0; i < 4; ++i) {
+        out_path[i] = -1;
+    }
+    if (*name != '/') {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    for (size_t i = 0; *name; ++i) {
+        if (i >= 4 || *name++ != '/') {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        int32_t value = 0;
+        const char *segment = name;
+        while (*name >= '0' && *name <= '9') {
+            value = 10 * value + (*name++ - '0');
+            if (value > UINT16_MAX) {
+                return ANJAY_ERR_BAD_REQUEST;
+            }
+        }
+        if (name == segment) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        out_path[i] = value;
+    }
+    return 0;
+}
+
+static int load_record(senml_state_t *state) {
+    if (state->has_record) {
+        return 0;
+    } else if (state->finished) {
+        return ANJAY_GET_INDEX_END;
+    }
+    int result = state->reader->vtable->next_record(state->reader,
+                                                    &state->record);
+    if (result == ANJAY_GET_INDEX_END) {
+        state->finished = true;
+        return result;
+    } else if (result) {
+        return result;
+    }
+    if (state->record.path[LEVEL_IID] < 0) {
+        anjay_log(DEBUG, "SenML Record does not refer to an Object Instance");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    if (state->oid < 0) {
+        state->oid = state->record.path[0];
+    } else if (state->oid != state->record.path[0]) {
+        anjay_log(DEBUG, "SenML Record refers to unexpected Object %" PRId32,
+                  state->record.path[0]);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    state->has_record = true;
+    state->bytes_read = 0;
+    state->num_bytes_cached = 0;
+    return 0;
+}
+
+static bool record_in_ctx(senml_in_t *ctx) {
+    for (size_t level = LEVEL_IID; level < ctx->level; ++level) {
+        if (ctx->state->record.path[level] != ctx->prefix[level]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static anjay_id_type_t level_id_type(size_t level) {
+    switch (level) {
+    case LEVEL_IID:
+        return ANJAY_ID_IID;
+    case LEVEL_RID:
+        return ANJAY_ID_RID;
+    default:
+        return ANJAY_ID_RIID;
+    }
+}
+
+static int senml_get_id(anjay_input_ctx_t *ctx_,
+                        anjay_id_type_t *out_type, uint16_t *out_id) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    if (ctx->id < 0) {
+        int result = load_record(ctx->state);
+        if (result) {
+            return result;
+        }
+        if (!record_in_ctx(ctx)) {
+            return ANJAY_GET_INDEX_END;
+        }
+        if (ctx->state->record.path[ctx->level] < 0) {
+            anjay_log(DEBUG, "SenML Record path too short");
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        ctx->id = ctx->state->record.path[ctx->level];
+    }
+    *out_type = level_id_type(ctx->level);
+    *out_id = (uint16_t) ctx->id;
+    return 0;
+}
+
+static int senml_next_entry(anjay_input_ctx_t *ctx_) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    if (ctx->id < 0) {
+        return 0;
+    }
+    int result;
+    while (!(result = load_record(ctx->state))
+            && record_in_ctx(ctx)
+            && ctx->state->record.path[ctx->level] == ctx->id) {
+        ctx->state->has_record = false;
+    }
+    if (result && result != ANJAY_GET_INDEX_END) {
+        return result;
+    }
+    ctx->id = -1;
+    return 0;
+}
+
+static int get_value(senml_in_t *ctx, const senml_record_t **out_record) {
+    anjay_id_type_t type;
+    uint16_t id;
+    int result = senml_get_id((anjay_input_ctx_t *) ctx, &type, &id);
+    if (result) {
+        return result == ANJAY_GET_INDEX_END ? ANJAY_ERR_BAD_REQUEST : result;
+    }
+    if (!ctx->state->has_record
+            || (ctx->level < LEVEL_RIID
+                    && ctx->state->record.path[ctx->level + 1] >= 0)) {
+        // the value has already been consumed, or the entry is not a leaf
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out_record = &ctx->state->record;
+    return 0;
+}
+
+static void flush_cached_bytes(senml_state_t *state,
+                               uint8_t **out_buf,
+                               size_t *buf_size) {
+    size_t bytes_to_copy = AVS_MIN(state->num_bytes_cached, *buf_size);
+    memcpy(*out_buf, state->bytes_cached, bytes_to_copy);
+    memmove(state->bytes_cached, state->bytes_cached + bytes_to_copy,
+            state->num_bytes_cached - bytes_to_copy);
+    state->num_bytes_cached -= bytes_to_copy;
+    *buf_size -= bytes_to_copy;
+    *out_buf += bytes_to_copy;
+}
+
+static int get_base64_bytes(senml_state_t *state,
+                            size_t *out_bytes_read,
+                            bool *out_message_finished,
+                            void *out_buf,
+                            size_t buf_size) {
+    const senml_record_t *record = &state->record;
+    uint8_t *current = (uint8_t *) out_buf;
+    if (record->data_length % 4) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    flush_cached_bytes(state, &current, &buf_size);
+    while (buf_size > 0 && state->bytes_read < record->data_length) {
+        // decode one 4-character quantum at a time
+        char encoded[5];
+        memcpy(encoded, record->data + state->bytes_read, 4);
+        encoded[4] = '\0';
+        ssize_t num_decoded =
+                avs_base64_decode_strict(state->bytes_cached,
+                                         sizeof(state->bytes_cached), encoded);
+        if (num_decoded < 0
+                || (encoded[3] == '='
+                        && state->bytes_read + 4 < record->data_length)) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        state->bytes_read += 4;
+        state->num_bytes_cached = (size_t) num_decoded;
+        flush_cached_bytes(state, &current, &buf_size);
+    }
+    *out_bytes_read = (size_t) (current - (uint8_t *) out_buf);
+    *out_message_finished = (state->bytes_read == record->data_length
+                             && !state->num_bytes_cached);
+    return 0;
+}
+
+static int senml_get_some_bytes(anjay_input_ctx_t *ctx_,
+                                size_t *out_bytes_read,
+                                bool *out_message_finished,
+                                void *out_buf,
+                                size_t buf_size) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    anjay_id_type_t type;
+    uint16_t id;
+    int result = senml_get_id(ctx_, &type, &id);
+    if (result == ANJAY_GET_INDEX_END) {
+        *out_bytes_read = 0;
+        *out_message_finished = true;
+        return 0;
+    }
+    const senml_record_t *record;
+    if (result || (result = get_value(ctx, &record))) {
+        return result;
+    }
+    if (record->type != SENML_VALUE_BYTES
+            && record->type != SENML_VALUE_STRING) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    if (record->type == SENML_VALUE_STRING && record->string_is_base64) {
+        return get_base64_bytes(ctx->state, out_bytes_read,
+                                out_message_finished, out_buf, buf_size);
+    }
+    *out_bytes_read = AVS_MIN(buf_size,
+                              record->data_length - ctx->state->bytes_read);
+    memcpy(out_buf, record->data + ctx->state->bytes_read, *out_bytes_read);
+    ctx->state->bytes_read += *out_bytes_read;
+    *out_message_finished = (ctx->state->bytes_read == record->data_length);
+    return 0;
+}
+
+static int senml_get_string(anjay_input_ctx_t *ctx_,
+                            char *out_buf,
+                            size_t buf_size) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    const senml_record_t *record;
+    int result = get_value(ctx, &record);
+    if (result) {
+        return result;
+    }
+    if (!buf_size || record->type != SENML_VALUE_STRING) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    size_t length = AVS_MIN(buf_size - 1,
+                            record->data_length - ctx->state->bytes_read);
+    memcpy(out_buf, record->data + ctx->state->bytes_read, length);
+    out_buf[length] = '\0';
+    ctx->state->bytes_read += length;
+    return ctx->state->bytes_read == record->data_length
+            ? 0 : ANJAY_BUFFER_TOO_SHORT;
+}
+
+static int get_integer(senml_in_t *ctx, int64_t *out) {
+    const senml_record_t *record;
+    int result = get_value(ctx, &record);
+    if (result) {
+        return result;
+    }
+    if (record->type == SENML_VALUE_INT) {
+        *out = record->value.i;
+        return 0;
+    } else if (record->type == SENML_VALUE_DOUBLE
+            && floor(record->value.d) == record->value.d
+            && record->value.d >= (double) INT64_MIN
+            && record->value.d < (double) INT64_MAX) {
+        *out = (int64_t) record->value.d;
+        return 0;
+    }
+    return ANJAY_ERR_BAD_REQUEST;
+}
+
+static int senml_get_i32(anjay_input_ctx_t *ctx, int32_t *out) {
+    int64_t value;
+    int result = get_integer((senml_in_t *) ctx, &value);
+    if (!result) {
+        if (value != (int32_t) value) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        *out = (int32_t) value;
+    }
+    return result;
+}
+
+static int senml_get_i64(anjay_input_ctx_t *ctx, int64_t *out) {
+    return get_integer((senml_in_t *) ctx, out);
+}
+
+static int senml_get_double(anjay_input_ctx_t *ctx, double *out) {
+    const senml_record_t *record;
+    int result = get_value((senml_in_t *) ctx, &record);
+    if (result) {
+        return result;
+    }
+    switch (record->type) {
+    case SENML_VALUE_INT:
+        *out = (double) record->value.i;
+        return 0;
+    case SENML_VALUE_DOUBLE:
+        *out = record->value.d;
+        return 0;
+    default:
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int senml_get_float(anjay_input_ctx_t *ctx, float *out) {
+    double value;
+    int result = senml_get_double(ctx, &value);
+    if (!result) {
+        *out = (float) value;
+    }
+    return result;
+}
+
+static int senml_get_bool(anjay_input_ctx_t *ctx, bool *out) {
+    const senml_record_t *record;
+    int result = get_value((senml_in_t *) ctx, &record);
+    if (result) {
+        return result;
+    }
+    if (record->type != SENML_VALUE_BOOL) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out = record->value.b;
+    return 0;
+}
+
+static int senml_get_objlnk(anjay_input_ctx_t *ctx,
+                            anjay_oid_t *out_oid, anjay_iid_t *out_iid) {
+    const senml_record_t *record;
+    int result = get_value((senml_in_t *) ctx, &record);
+    if (result) {
+        return result;
+    }
+    if (record->type != SENML_VALUE_OBJLNK) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out_oid = record->value.objlnk.oid;
+    *out_iid = record->value.objlnk.iid;
+    return 0;
+}
+
+static int senml_attach_child(anjay_input_ctx_t *ctx_,
+                              anjay_input_ctx_t *child) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    int retval = _anjay_input_ctx_destroy(&ctx->child);
+    if (retval) {
+        return retval;
+    }
+    ctx->child = child;
+    return 0;
+}
+
+static int senml_in_close(anjay_input_ctx_t *ctx_) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    _anjay_input_ctx_destroy(&ctx->child);
+    if (ctx->state == &ctx->state_storage) {
+        ctx->state->reader->vtable->cleanup(ctx->state->reader);
+        avs_free(ctx->state->reader);
+    }
+    return 0;
+}
+
+static anjay_input_ctx_t *senml_nested_ctx(anjay_input_ctx_t *ctx_);
+
+static const anjay_input_ctx_vtable_t SENML_IN_VTABLE = {
+    .some_bytes = senml_get_some_bytes,
+    .string = senml_get_string,
+    .i32 = senml_get_i32,
+    .i64 = senml_get_i64,
+    .f32 = senml_get_float,
+    .f64 = senml_get_double,
+    .boolean = senml_get_bool,
+    .objlnk = senml_get_objlnk,
+    .attach_child = senml_attach_child,
+    .get_id = senml_get_id,
+    .next_entry = senml_next_entry,
+    .close = senml_in_close,
+    .nested_ctx = senml_nested_ctx
+};
+
+static anjay_input_ctx_t *senml_nested_ctx(anjay_input_ctx_t *ctx_) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    anjay_id_type_t type;
+    uint16_t id;
+    if (ctx->level >= LEVEL_RIID || senml_get_id(ctx_, &type, &id)) {
+        return NULL;
+    }
+    senml_in_t *nested = (senml_in_t *) avs_calloc(1, sizeof(senml_in_t));
+    if (!nested) {
+        return NULL;
+    }
+    nested->vtable = &SENML_IN_VTABLE;
+    nested->state = ctx->state;
+    nested->level = ctx->level + 1;
+    memcpy(nested->prefix, ctx->prefix, sizeof(nested->prefix));
+    nested->prefix[ctx->level] = id;
+    nested->id = -1;
+    if (senml_attach_child(ctx_, (anjay_input_ctx_t *) nested)) {
+        avs_free(nested);
+        return NULL;
+    }
+    return (anjay_input_ctx_t *) nested;
+}
+
+int _anjay_input_senml_create(anjay_input_ctx_t **out, senml_reader_t *reader) {
+    senml_in_t *ctx = (senml_in_t *) avs_calloc(1, sizeof(senml_in_t));
+    *out = (anjay_input_ctx_t *) ctx;
+    if (!ctx) {
+        reader->vtable->cleanup(reader);
+        avs_free(reader);
+        return -1;
+    }
+    ctx->vtable = &SENML_IN_VTABLE;
+    ctx->state = &ctx->state_storage;
+    ctx->state->reader = reader;
+    ctx->state->oid = -1;
+    ctx->level = LEVEL_IID;
+    ctx->id = -1;
+    return 0;
+}
+
+int _anjay_input_senml_expect_oid(anjay_input_ctx_t *ctx, anjay_oid_t oid) {
+    senml_in_t *senml = (senml_in_t *) ctx;
+    if (senml->vtable != &SENML_IN_VTABLE) {
+        return 0;
+    }
+    if (senml->state->oid >= 0 && senml->state->oid != oid) {
+        anjay_log(DEBUG, "SenML Records do not refer to Object %u", oid);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    senml->state->oid = oid;
+    return 0;
+}
+
+int _anjay_input_senml_enter_resource(anjay_input_ctx_t *ctx,
+                                      const anjay_uri_path_t *uri,
+                                      anjay_input_ctx_t **out_resource_ctx) {
+    assert(_anjay_uri_path_has_rid(uri));
+    senml_in_t *senml = (senml_in_t *) ctx;
+    if (senml->vtable != &SENML_IN_VTABLE || senml->level != LEVEL_IID) {
+        return ANJAY_ERR_INTERNAL;
+    }
+    int result = _anjay_input_senml_expect_oid(ctx, uri->oid);
+    if (result) {
+        return result;
+    }
+    anjay_id_type_t type;
+    uint16_t id;
+    result = senml_get_id(ctx, &type, &id);
+    if (result == ANJAY_GET_INDEX_END || (!result && id != uri->iid)) {
+        return ANJAY_ERR_BAD_REQUEST;
+    } else if (result) {
+        return result;
+    }
+    anjay_input_ctx_t *nested = senml_nested_ctx(ctx);
+    if (!nested) {
+        return ANJAY_ERR_INTERNAL;
+    }
+    if ((result = _anjay_dm_check_if_tlv_rid_matches_uri_rid(nested,
+                                                             uri->rid))) {
+        return result;
+    }
+    *out_resource_ctx = nested;
+    return 0;
+}
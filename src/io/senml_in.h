@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_IO_SENML_IN_H
+#define ANJAY_IO_SENML_IN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <anjay/io.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/** Maximum length of a resolved SenML name, i.e. base name + name */
+#define SENML_MAX_NAME_SIZE sizeof("/65535/65535/65535/65535")
+
+typedef enum {
+    SENML_VALUE_NONE,
+    SENML_VALUE_INT,
+    SENML_VALUE_DOUBLE,
+    SENML_VALUE_BOOL,
+    SENML_VALUE_STRING,
+    SENML_VALUE_BYTES,
+    SENML_VALUE_OBJLNK
+} senml_value_type_t;
+
+/**
+ * A single SenML Record, with its name already resolved against the base name
+ * and parsed as an LwM2M path.
+ */
+typedef struct {
+    /** OID, IID, RID and RIID, in that order; -1 for missing components */
+    int32_t path[4];
+    senml_value_type_t type;
+    union {
+        int64_t i;
+        double d;
+        bool b;
+        struct {
+            anjay_oid_t oid;
+            anjay_iid_t iid;
+        } objlnk;
+    } value;
+    /** String or bytes value; owned by the reader, valid until the next call
+     * to @ref senml_reader_vtable_t::next_record */
+    const char *data;
+    size_t data_length;
+    /** If true, a string value read as bytes is decoded from base64 */
+    bool string_is_base64;
+} senml_record_t;
+
+typedef struct senml_reader_vtable_struct senml_reader_vtable_t;
+
+/**
+ * Format-specific source of SenML Records. Concrete readers shall be allocated
+ * using avs_malloc() or avs_calloc(), and shall have this type as their first
+ * member.
+ */
+typedef struct {
+    const senml_reader_vtable_t *vtable;
+} senml_reader_t;
+
+struct senml_reader_vtable_struct {
+    /**
+     * @returns 0 on success, ANJAY_GET_INDEX_END if there are no more Records,
+     *          or a negative value (preferably one of ANJAY_ERR_* constants) in
+     *          case of error.
+     */
+    int (*next_record)(senml_reader_t *reader, senml_record_t *out_record);
+
+    /** Releases resources owned by the reader, but not the reader itself. */
+    void (*cleanup)(senml_reader_t *reader);
+};
+
+/**
+ * Parses an LwM2M path in a resolved SenML name, e.g. "/3/0/7/1".
+ *
+ * @returns 0 on success, ANJAY_ERR_BAD_REQUEST if @p name is not a valid path
+ *          of up to four components.
+ */
+int _anjay_senml_parse_path(const char *name, int32_t out_path[4]);
+
+/**
+ * Creates an input context that exposes Records read from @p reader in the
+ * same hierarchical manner as TLV: the top-level context iterates over Object
+ * Instances, and nested contexts over Resources and Resource Instances.
+ *
+ * Takes ownership of @p reader, even in case of error.
+ */
+int _anjay_input_senml_create(anjay_input_ctx_t **out, senml_reader_t *reader);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_IO_SENML_IN_H */
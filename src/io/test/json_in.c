@@ -0,0 +1,213 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/unit/memstream.h>
+#include <avsystem/commons/unit/test.h>
+
+#define TEST_ENV(Data) \
+    avs_stream_abstract_t *stream = NULL; \
+    AVS_UNIT_ASSERT_SUCCESS(avs_unit_memstream_alloc(&stream, sizeof(Data))); \
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, Data, sizeof(Data) - 1)); \
+    anjay_input_ctx_t *in; \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_json_create(&in, &stream, false))
+
+#define TEST_TEARDOWN do { \
+    _anjay_input_ctx_destroy(&in); \
+    avs_stream_cleanup(&stream); \
+} while (0)
+
+#define ASSERT_ID(Ctx, IdType, Id) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_get_id((Ctx), &type, &id)); \
+    AVS_UNIT_ASSERT_EQUAL(type, (IdType)); \
+    AVS_UNIT_ASSERT_EQUAL(id, (Id)); \
+} while (0)
+
+#define ASSERT_END(Ctx) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id((Ctx), &type, &id), \
+                          ANJAY_GET_INDEX_END); \
+} while (0)
+
+AVS_UNIT_TEST(json_in, instance) {
+    TEST_ENV("{\"bn\":\"/3/0/\",\"e\":["
+             "{\"n\":\"1\",\"v\":42},"
+             "{\"n\":\"2\",\"sv\":\"a\\\"b\\u00e9\"},\n"
+             " {\"n\":\"7/0\",\"v\":-1.5e1}, {\"n\":\"7/1\",\"v\":2},"
+             "{\"t\":0,\"bv\":true,\"n\":\"8\"},"
+             "{\"n\":\"9\",\"ov\":\"1:2\"}]}\n");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+
+    int64_t i64;
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i64(instance, &i64));
+    AVS_UNIT_ASSERT_EQUAL(i64, 42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    char buf[16];
+    ASSERT_ID(instance, ANJAY_ID_RID, 2);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(instance, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "a\"b\xC3\xA9");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    anjay_riid_t riid;
+    double d;
+    ASSERT_ID(instance, ANJAY_ID_RID, 7);
+    anjay_input_ctx_t *array = anjay_get_array(instance);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 0);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_double(array, &d));
+    AVS_UNIT_ASSERT_EQUAL(d, -15.0);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_double(array, &d));
+    AVS_UNIT_ASSERT_EQUAL(d, 2.0);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_array_index(array, &riid),
+                          ANJAY_GET_INDEX_END);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    bool value;
+    ASSERT_ID(instance, ANJAY_ID_RID, 8);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bool(instance, &value));
+    AVS_UNIT_ASSERT_TRUE(value);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    ASSERT_ID(instance, ANJAY_ID_RID, 9);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_objlnk(instance, &oid, &iid));
+    AVS_UNIT_ASSERT_EQUAL(oid, 1);
+    AVS_UNIT_ASSERT_EQUAL(iid, 2);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    ASSERT_END(instance);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_END(in);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, output_style_names) {
+    // the format produced by json_out.c
+    TEST_ENV("{\"bn\":\"/3/0\",\"e\":[{\"n\":\"/1\",\"v\":42}]}");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, long_string) {
+    TEST_ENV("{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\",\"sv\":\""
+             "0123456789012345678901234567890123456789"
+             "0123456789012345678901234567890123456789"
+             "0123456789012345678901234567890123456789"
+             "\"}]}");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+
+    char buf[100];
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_string(instance, buf, sizeof(buf)),
+                          ANJAY_BUFFER_TOO_SHORT);
+    AVS_UNIT_ASSERT_EQUAL(strlen(buf), 99);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(instance, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "901234567890123456789");
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, opaque_resource) {
+    TEST_ENV("{\"bn\":\"/5/0/0\",\"e\":[{\"sv\":\"AQIDBA==\"}]}");
+
+    const anjay_uri_path_t uri = MAKE_RESOURCE_PATH(5, 0, 0);
+    anjay_input_ctx_t *resource;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_input_senml_enter_resource(in, &uri, &resource));
+
+    char buf[8];
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes(resource, &bytes_read,
+                                            &message_finished,
+                                            buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 4);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "\x01\x02\x03\x04", 4);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, base_name_after_entries) {
+    TEST_ENV("{\"e\":[{\"n\":\"/3/0/1\",\"v\":1}],\"bn\":\"/4/0/\"}");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_next_entry(instance),
+                          ANJAY_ERR_BAD_REQUEST);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, malformed) {
+    static const char *const PAYLOADS[] = {
+        "{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\",\"v\":01}]}",
+        "{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\",\"v\":1.}]}",
+        "{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\",\"bv\":yes}]}",
+        "{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\"}]}",
+        "{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\",\"v\":1,\"sv\":\"\"}]}",
+        "{\"bn\":\"/3/0/\",\"e\":[,{\"n\":\"1\",\"v\":1}]}",
+        "{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\",\"sv\":\"\\ud800\"}]}",
+        "{\"bn\":\"/3/0/\",\"e\":[{\"n\":\"1\",\"v\":1}"
+    };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(PAYLOADS); ++i) {
+        avs_stream_abstract_t *stream = NULL;
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_unit_memstream_alloc(&stream, strlen(PAYLOADS[i]) + 1));
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_stream_write(stream, PAYLOADS[i], strlen(PAYLOADS[i])));
+        anjay_input_ctx_t *in;
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_input_json_create(&in, &stream, false));
+
+        anjay_id_type_t type;
+        uint16_t id;
+        int result = _anjay_input_get_id(in, &type, &id);
+        if (!result) {
+            // the last payload is only found to be truncated after the entry
+            anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+            AVS_UNIT_ASSERT_NOT_NULL(instance);
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_input_get_id(instance, &type, &id));
+            result = _anjay_input_next_entry(instance);
+        }
+        AVS_UNIT_ASSERT_EQUAL(result, ANJAY_ERR_BAD_REQUEST);
+
+        TEST_TEARDOWN;
+    }
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/unit/memstream.h>
+#include <avsystem/commons/unit/test.h>
+
+#define TEST_ENV(Data) \
+    avs_stream_abstract_t *stream = NULL; \
+    AVS_UNIT_ASSERT_SUCCESS(avs_unit_memstream_alloc(&stream, sizeof(Data))); \
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, Data, sizeof(Data) - 1)); \
+    anjay_input_ctx_t *in; \
+    AVS_UNIT_ASSERT_SUCCESS( \
+            _anjay_input_senml_cbor_create(&in, &stream, false))
+
+#define TEST_TEARDOWN do { \
+    _anjay_input_ctx_destroy(&in); \
+    avs_stream_cleanup(&stream); \
+} while (0)
+
+#define ASSERT_ID(Ctx, IdType, Id) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_get_id((Ctx), &type, &id)); \
+    AVS_UNIT_ASSERT_EQUAL(type, (IdType)); \
+    AVS_UNIT_ASSERT_EQUAL(id, (Id)); \
+} while (0)
+
+#define ASSERT_END(Ctx) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id((Ctx), &type, &id), \
+                          ANJAY_GET_INDEX_END); \
+} while (0)
+
+AVS_UNIT_TEST(senml_cbor_in, hierarchy) {
+    TEST_ENV("\x83"
+             "\xA3\x21\x65/3/0/\x00\x61" "1" "\x02\x18\x2A"
+             "\xA2\x00\x63" "5/7" "\x03\x62" "ab"
+             "\xA2\x00\x63" "5/8" "\x03\x60");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+
+    int32_t i32;
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(instance, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    ASSERT_ID(instance, ANJAY_ID_RID, 5);
+    anjay_input_ctx_t *array = anjay_get_array(instance);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    anjay_riid_t riid;
+    char buf[8];
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 7);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(array, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "ab");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 8);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(array, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "");
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_array_index(array, &riid),
+                          ANJAY_GET_INDEX_END);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_END(instance);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_END(in);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, indefinite_and_unknown_labels) {
+    TEST_ENV("\x9F"
+             "\xBF\x21\x65/3/0/\x00\x61" "2" "\x06\x01\x04\xF5\xFF"
+             "\xBF\x00\x61" "3" "\x02\xF9\x3E\x00\xFF"
+             "\xA3\x00\x61" "4" "\x22\x82\x01\x02\x63vlo\x63" "1:2"
+             "\xA2\x00\x61" "6" "\x08\x43" "xyz"
+             "\xFF");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+
+    bool value;
+    ASSERT_ID(instance, ANJAY_ID_RID, 2);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bool(instance, &value));
+    AVS_UNIT_ASSERT_TRUE(value);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    double d;
+    ASSERT_ID(instance, ANJAY_ID_RID, 3);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_double(instance, &d));
+    AVS_UNIT_ASSERT_EQUAL(d, 1.5);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    ASSERT_ID(instance, ANJAY_ID_RID, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_objlnk(instance, &oid, &iid));
+    AVS_UNIT_ASSERT_EQUAL(oid, 1);
+    AVS_UNIT_ASSERT_EQUAL(iid, 2);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    char buf[8];
+    size_t bytes_read;
+    bool message_finished;
+    ASSERT_ID(instance, ANJAY_ID_RID, 6);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes(instance, &bytes_read,
+                                            &message_finished,
+                                            buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "xyz", 3);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_END(instance);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, type_mismatch) {
+    TEST_ENV("\x81"
+             "\xA3\x21\x65/3/0/\x00\x61" "1" "\x03\x62" "ab");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    int32_t i32;
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_i32(instance, &i32),
+                          ANJAY_ERR_BAD_REQUEST);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, record_without_value) {
+    TEST_ENV("\x81"
+             "\xA2\x21\x65/3/0/\x00\x61" "1");
+
+    anjay_id_type_t type;
+    uint16_t id;
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(in, &type, &id),
+                          ANJAY_ERR_BAD_REQUEST);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, multiple_objects) {
+    TEST_ENV("\x82"
+             "\xA3\x21\x65/3/0/\x00\x61" "1" "\x02\x01"
+             "\xA3\x21\x65/4/0/\x00\x61" "1" "\x02\x01");
+
+    ASSERT_ID(in, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_next_entry(instance),
+                          ANJAY_ERR_BAD_REQUEST);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, enter_resource) {
+    TEST_ENV("\x81"
+             "\xA3\x21\x65/3/0/\x00\x61" "1" "\x02\x18\x2A");
+
+    const anjay_uri_path_t uri = MAKE_RESOURCE_PATH(3, 0, 1);
+    anjay_input_ctx_t *resource;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_input_senml_enter_resource(in, &uri, &resource));
+    int32_t i32;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(resource, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 42);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, enter_resource_mismatch) {
+    TEST_ENV("\x81"
+             "\xA3\x21\x65/3/0/\x00\x61" "2" "\x02\x18\x2A");
+
+    const anjay_uri_path_t uri = MAKE_RESOURCE_PATH(3, 0, 1);
+    anjay_input_ctx_t *resource;
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_input_senml_enter_resource(in, &uri, &resource),
+            ANJAY_ERR_BAD_REQUEST);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, expect_oid_mismatch) {
+    TEST_ENV("\x81"
+             "\xA3\x21\x65/4/0/\x00\x61" "1" "\x02\x18\x2A");
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_senml_expect_oid(in, 3));
+    anjay_id_type_t type;
+    uint16_t id;
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(in, &type, &id),
+                          ANJAY_ERR_BAD_REQUEST);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_senml_expect_oid(in, 4),
+                          ANJAY_ERR_BAD_REQUEST);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, string_longer_than_payload) {
+    // declared length of the string value is 2 GB
+    TEST_ENV("\x81"
+             "\xA3\x21\x65/3/0/\x00\x61" "1" "\x03\x7A\x7F\xFF\xFF\xFF" "ab");
+
+    anjay_id_type_t type;
+    uint16_t id;
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(in, &type, &id),
+                          ANJAY_ERR_BAD_REQUEST);
+
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_parse_path, valid_and_invalid) {
+    int32_t path[4];
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_parse_path("/3/0/7/1", path));
+    AVS_UNIT_ASSERT_EQUAL(path[0], 3);
+    AVS_UNIT_ASSERT_EQUAL(path[1], 0);
+    AVS_UNIT_ASSERT_EQUAL(path[2], 7);
+    AVS_UNIT_ASSERT_EQUAL(path[3], 1);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_parse_path("/65535", path));
+    AVS_UNIT_ASSERT_EQUAL(path[0], 65535);
+    AVS_UNIT_ASSERT_EQUAL(path[1], -1);
+
+    AVS_UNIT_ASSERT_FAILED(_anjay_senml_parse_path("", path));
+    AVS_UNIT_ASSERT_FAILED(_anjay_senml_parse_path("3/0", path));
+    AVS_UNIT_ASSERT_FAILED(_anjay_senml_parse_path("/3/0/", path));
+    AVS_UNIT_ASSERT_FAILED(_anjay_senml_parse_path("/3//0", path));
+    AVS_UNIT_ASSERT_FAILED(_anjay_senml_parse_path("/65536", path));
+    AVS_UNIT_ASSERT_FAILED(_anjay_senml_parse_path("/1/2/3/4/5", path));
+    AVS_UNIT_ASSERT_FAILED(_anjay_senml_parse_path("/1/x", path));
+}
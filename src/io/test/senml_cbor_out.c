@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/stream/stream_outbuf.h>
+#include <avsystem/commons/stream_v_table.h>
+#include <avsystem/commons/unit/test.h>
+
+static int test_setup_for_sending(avs_stream_abstract_t *stream,
+                                  const anjay_msg_details_t *details) {
+    (void) stream;
+    AVS_UNIT_ASSERT_EQUAL(details->format, ANJAY_COAP_FORMAT_SENML_CBOR);
+    return 0;
+}
+
+static const anjay_coap_stream_ext_t COAPIZATION = {
+    .setup_response = test_setup_for_sending,
+};
+
+static const avs_stream_v_table_extension_t COAPIZED_VTABLE_EXT[] = {
+    { ANJAY_COAP_STREAM_EXTENSION, &COAPIZATION },
+    AVS_STREAM_V_TABLE_EXTENSION_NULL
+};
+
+static avs_stream_v_table_t COAPIZED_VTABLE;
+
+AVS_UNIT_SUITE_INIT(senml_cbor_out, verbose) {
+    (void) verbose;
+    memcpy(&COAPIZED_VTABLE, AVS_STREAM_OUTBUF_STATIC_INITIALIZER.vtable,
+           sizeof(COAPIZED_VTABLE));
+
+    COAPIZED_VTABLE.extension_list = COAPIZED_VTABLE_EXT;
+}
+
+static const avs_stream_outbuf_t COAPIZED_OUTBUF
+        = {&COAPIZED_VTABLE, NULL, 0, 0, 0};
+
+#define TEST_ENV(Size, Uri) \
+    char buf[Size]; \
+    anjay_msg_details_t details = { \
+        .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT, \
+        .format = AVS_COAP_FORMAT_NONE \
+    }; \
+    avs_stream_outbuf_t outbuf = COAPIZED_OUTBUF; \
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf)); \
+    int outctx_errno = 0; \
+    anjay_uri_path_t uri = (Uri); \
+    anjay_output_ctx_t *out = _anjay_output_senml_cbor_create( \
+            (avs_stream_abstract_t *) &outbuf, &outctx_errno, &details, \
+            &uri); \
+    AVS_UNIT_ASSERT_NOT_NULL(out)
+
+#define VERIFY_BYTES(Data) do { \
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), \
+                          sizeof(Data) - 1); \
+    AVS_UNIT_ASSERT_EQUAL_BYTES(buf, Data); \
+} while (0)
+
+AVS_UNIT_TEST(senml_cbor_out, base_name_compression) {
+    TEST_ENV(512, MAKE_OBJECT_PATH(3));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 42));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 2));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(out, "ab"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 3));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_objlnk(out, 1, 2));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x65/3/0/\x00\x61" "1" "\x02\x18\x2A"
+                 "\xA2\x00\x61" "2" "\x03\x62" "ab"
+                 "\xA3\x21\x65/3/1/\x00\x61" "3" "\x63vlo\x63" "1:2"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, values) {
+    TEST_ENV(512, MAKE_RESOURCE_PATH(3, 0, 5));
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, -500));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_float(out, 1.5f));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_double(out, 1.1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bool(out, true));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes(out, "xyz", 3));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x65/3/0/\x00\x61" "5" "\x02\x39\x01\xF3"
+                 "\xA2\x00\x61" "5" "\x02\xFA\x3F\xC0\x00\x00"
+                 "\xA2\x00\x61" "5"
+                         "\x02\xFB\x3F\xF1\x99\x99\x99\x99\x99\x9A"
+                 "\xA2\x00\x61" "5" "\x04\xF5"
+                 "\xA2\x00\x61" "5" "\x08\x43" "xyz"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, array) {
+    TEST_ENV(512, MAKE_RESOURCE_PATH(3, 0, 7));
+
+    anjay_output_ctx_t *array = anjay_ret_array_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 3000));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 2));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 5));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_finish(array));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x65/3/0/\x00\x63" "7/1" "\x02\x19\x0B\xB8"
+                 "\xA2\x00\x63" "7/2" "\x02\x05"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, unfinished_bytes) {
+    TEST_ENV(512, MAKE_RESOURCE_PATH(3, 0, 5));
+
+    anjay_ret_bytes_ctx_t *bytes = anjay_ret_bytes_begin(out, 4);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "ab", 2));
+    AVS_UNIT_ASSERT_FAILED(anjay_ret_i32(out, 1));
+    AVS_UNIT_ASSERT_FAILED(_anjay_output_ctx_destroy(&out));
+}
+
+AVS_UNIT_TEST(senml_cbor_out, no_resource_path) {
+    TEST_ENV(512, MAKE_INSTANCE_PATH(3, 0));
+
+    AVS_UNIT_ASSERT_FAILED(anjay_ret_i32(out, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+}
@@ -24,13 +24,9 @@
 ///////////////////////////////////////////////////////////// ENCODING // SIMPLE
 
 static anjay_output_ctx_t *new_tlv_out(avs_stream_abstract_t *stream) {
-    tlv_out_t *out = (tlv_out_t *) avs_calloc(1, sizeof(tlv_out_t));
+    anjay_output_ctx_t *out = _anjay_output_raw_tlv_create(stream);
     AVS_UNIT_ASSERT_NOT_NULL(out);
-    out->vtable = &TLV_OUT_VTABLE;
-    out->next_entry_ptr = &out->entries;
-    out->stream = stream;
-    out->next_id.id = -1;
-    return (anjay_output_ctx_t *) out;
+    return out;
 }
 
 #define TEST_ENV_COMMON(Size) \
@@ -329,3 +325,94 @@ AVS_UNIT_TEST(tlv_out, object_with_empty_bytes) {
 
     AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
 }
+
+AVS_UNIT_TEST(tlv_out, objects_with_array) {
+    TEST_ENV(512);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 1));
+    anjay_output_ctx_t *obj = _anjay_output_object_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(obj, 5));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 1));
+    anjay_output_ctx_t *array = anjay_ret_array_start(obj);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 7));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_finish(array));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_object_finish(obj));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 2));
+    obj = _anjay_output_object_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(obj, 6));
+    // unfinished array shall not be a part of the Instance
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 1));
+    array = anjay_ret_array_start(obj);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 8));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_object_finish(obj));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x08\x01\x08" // first instance
+                 "\xC1\x00\x05"
+                 "\x83\x01" "\x41\x00\x07"
+                 "\x03\x02" // second instance
+                 "\xC1\x00\x06");
+}
+
+AVS_UNIT_TEST(tlv_out, object_with_long_resource_and_16bit_ids) {
+    TEST_ENV(2048);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 258));
+    anjay_output_ctx_t *obj = _anjay_output_object_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 300));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(obj, DATA1kB));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_object_finish(obj));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 2));
+    obj = _anjay_output_object_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(obj, 6));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_object_finish(obj));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x30\x01\x02\x03\xED" // first instance
+                 "\xF0\x01\x2C\x03\xE8" DATA1kB
+                 "\x03\x02" // second instance
+                 "\xC1\x00\x06");
+}
+
+AVS_UNIT_TEST(tlv_out, object_with_long_array_and_16bit_ids) {
+    TEST_ENV(2048);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 1));
+    anjay_output_ctx_t *obj = _anjay_output_object_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 300));
+    anjay_output_ctx_t *array = anjay_ret_array_start(obj);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 1000));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 7));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 256));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(array, DATA1kB));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_finish(array));
+    // written after the array, which is compacted within the Instance
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(obj, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(obj, 5));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_object_finish(obj));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x10\x01\x03\xF9" // instance
+                 "\xB0\x01\x2C\x03\xF1" // array
+                 "\x61\x03\xE8\x07"
+                 "\x70\x01\x00\x03\xE8" DATA1kB
+                 "\xC1\x01\x05");
+}
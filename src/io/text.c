@@ -29,6 +29,7 @@
 #include <anjay/core.h>
 
 #include "../coap/content_format.h"
+#include "../number_format.h"
 #include "../utils_core.h"
 #include "base64_out.h"
 #include "vtable.h"
@@ -73,58 +74,45 @@ static int text_ret_string(anjay_output_ctx_t *ctx_, const char *value) {
     return retval;
 }
 
-static int text_ret_i32(anjay_output_ctx_t *ctx_, int32_t value) {
-    text_out_t *ctx = (text_out_t *) ctx_;
+static int text_ret_formatted(text_out_t *ctx,
+                              const char *value,
+                              size_t length) {
     if (ctx->bytes) {
         return -1;
     }
 
     int retval = -1;
     if (!ctx->finished
-            && !(retval = avs_stream_write_f(ctx->stream, "%" PRId32, value))) {
+            && !(retval = avs_stream_write(ctx->stream, value, length))) {
         ctx->finished = true;
     }
     return retval;
 }
 
-static int text_ret_i64(anjay_output_ctx_t *ctx_, int64_t value) {
-    text_out_t *ctx = (text_out_t *) ctx_;
-    if (ctx->bytes) {
-        return -1;
-    }
-
-    int retval = -1;
-    if (!ctx->finished
-            && !(retval = avs_stream_write_f(ctx->stream, "%" PRId64, value))) {
-        ctx->finished = true;
-    }
-    return retval;
+static int text_ret_i64(anjay_output_ctx_t *ctx, int64_t value) {
+    char buf[ANJAY_INT_STRING_BUF_SIZE];
+    return text_ret_formatted((text_out_t *) ctx, buf,
+                              _anjay_int64_as_string(value, buf));
 }
 
-static inline int text_ret_floating_point(text_out_t *ctx, double value,
-                                          int precision) {
-    if (ctx->bytes) {
-        return -1;
-    }
-    int retval = -1;
-    // FIXME: The spec calls for a "decimal" representation, which, in my
-    // understanding, excludes exponential representation.
-    // As printing floating-point numbers in C as pure decimal with sane
-    // precision is tricky, let's take the spec a bit loosely for now.
-    if (!ctx->finished
-            && !(retval = avs_stream_write_f(ctx->stream, "%.*g",
-                                             precision, value))) {
-        ctx->finished = true;
-    }
-    return retval;
+static int text_ret_i32(anjay_output_ctx_t *ctx, int32_t value) {
+    return text_ret_i64(ctx, value);
 }
 
+// FIXME: The spec calls for a "decimal" representation, which, in my
+// understanding, excludes exponential representation. Values below 1e-6 and
+// above 1e21 are still printed in exponential notation, as the pure decimal
+// form of these would be unreasonably long.
 static int text_ret_float(anjay_output_ctx_t *ctx, float value) {
-    return text_ret_floating_point((text_out_t *) ctx, value, 9);
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE];
+    return text_ret_formatted((text_out_t *) ctx, buf,
+                              _anjay_float_as_string(value, buf));
 }
 
 static int text_ret_double(anjay_output_ctx_t *ctx, double value) {
-    return text_ret_floating_point((text_out_t *) ctx, value, 17);
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE];
+    return text_ret_formatted((text_out_t *) ctx, buf,
+                              _anjay_double_as_string(value, buf));
 }
 
 static int text_ret_bool(anjay_output_ctx_t *ctx, bool value) {
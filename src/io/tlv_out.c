@@ -17,9 +17,9 @@
 #include <anjay_config.h>
 
 #include <assert.h>
+#include <stdint.h>
 #include <string.h>
 
-#include <avsystem/commons/list.h>
 #include <avsystem/commons/memory.h>
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/utils.h>
@@ -36,11 +36,18 @@ typedef struct {
     int32_t id;
 } tlv_id_t;
 
+/**
+ * Growable buffer shared by a root TLV context and all its nested contexts.
+ * Entries of Object Instances and Multiple Resources are encoded into it
+ * directly, after a space reserved for the header of the enclosing entry. The
+ * header is filled in when the nested context is finished and its length is
+ * known.
+ */
 typedef struct {
-    size_t data_length;
-    tlv_id_t id;
-    char data[];
-} tlv_entry_t;
+    char *data;
+    size_t size;
+    size_t capacity;
+} tlv_arena_t;
 
 typedef struct {
     const anjay_ret_bytes_ctx_vtable_t *vtable;
@@ -56,8 +63,9 @@ typedef struct tlv_out_struct {
     int *errno_ptr;
     struct tlv_out_struct *parent;
     anjay_output_ctx_t *slave;
-    AVS_LIST(tlv_entry_t) entries;
-    AVS_LIST(tlv_entry_t) *next_entry_ptr;
+    tlv_arena_t *arena;
+    tlv_arena_t arena_storage;
+    size_t header_offset;
     avs_stream_abstract_t *stream;
     tlv_id_t next_id;
     tlv_bytes_t bytes_ctx;
@@ -83,7 +91,10 @@ static inline uint8_t typefield_length(uint32_t length) {
     }
 }
 
-static int write_shortened_u32(avs_stream_abstract_t *stream, uint32_t value) {
+// type field + 16-bit identifier + 24-bit length
+#define TLV_MAX_HEADER_SIZE 6
+
+static size_t encode_shortened_u32(char *out, uint32_t value) {
     uint8_t length = u32_length(value);
     assert(length <= 4);
     union {
@@ -91,33 +102,65 @@ static int write_shortened_u32(avs_stream_abstract_t *stream, uint32_t value) {
         char tab[4];
     } value32;
     value32.uval = avs_convert_be32(value);
-    return avs_stream_write(stream, value32.tab + (4 - length), length);
+    memcpy(out, value32.tab + (4 - length), length);
+    return length;
 }
 
-static size_t header_size(uint16_t id, size_t length) {
-    assert(length == (uint32_t) length);
-    return 1 + (size_t) u32_length(id) +
-            ((length > 7) ? (size_t) u32_length((uint32_t) length) : 0);
+/**
+ * Encodes the TLV header into @p out, which must have room for at least
+ * TLV_MAX_HEADER_SIZE bytes.
+ *
+ * @returns Size of the encoded header, or 0 if @p id or @p length cannot be
+ *          represented in TLV.
+ */
+static size_t encode_header(char *out, const tlv_id_t *id, size_t length) {
+    if (id->id != (uint16_t) id->id || length >> 24) {
+        return 0;
+    }
+    out[0] = (char) (uint8_t) (
+            ((id->type & 3) << 6) |
+            ((id->id > UINT8_MAX) ? 0x20 : 0) |
+            typefield_length((uint32_t) length));
+    size_t size = 1 + encode_shortened_u32(&out[1], (uint16_t) id->id);
+    if (length > 7) {
+        size += encode_shortened_u32(&out[size], (uint32_t) length);
+    }
+    assert(size <= TLV_MAX_HEADER_SIZE);
+    return size;
 }
 
 static int write_header(avs_stream_abstract_t *stream,
                         const tlv_id_t *id,
                         size_t length) {
-    if (id->id != (uint16_t) id->id || length >> 24) {
+    char header[TLV_MAX_HEADER_SIZE];
+    size_t size = encode_header(header, id, length);
+    if (!size) {
         return -1;
     }
-    uint8_t typefield = (uint8_t) (
-            ((id->type & 3) << 6) |
-            ((id->id > UINT8_MAX) ? 0x20 : 0) |
-            typefield_length((uint32_t) length));
-    int retval = avs_stream_write(stream, &typefield, 1);
-    if (!retval) {
-        retval = write_shortened_u32(stream, (uint16_t) id->id);
+    return avs_stream_write(stream, header, size);
+}
+
+static int arena_reserve(tlv_arena_t *arena, size_t length) {
+    if (length > SIZE_MAX - arena->size) {
+        return -1;
     }
-    if (!retval && length > 7) {
-        retval = write_shortened_u32(stream, (uint32_t) length);
+    if (arena->size + length > arena->capacity) {
+        size_t new_capacity = arena->capacity ? arena->capacity : 256;
+        while (new_capacity < arena->size + length) {
+            if (new_capacity > SIZE_MAX / 2) {
+                new_capacity = arena->size + length;
+                break;
+            }
+            new_capacity *= 2;
+        }
+        char *new_data = (char *) avs_realloc(arena->data, new_capacity);
+        if (!new_data) {
+            return -1;
+        }
+        arena->data = new_data;
+        arena->capacity = new_capacity;
     }
-    return retval;
+    return 0;
 }
 
 static inline int ensure_valid_for_value(tlv_out_t *ctx) {
@@ -127,29 +170,21 @@ static inline int ensure_valid_for_value(tlv_out_t *ctx) {
             || ctx->next_id.id < 0) ? -1 : 0;
 }
 
-static int write_entry(avs_stream_abstract_t *stream,
-                       const tlv_id_t *id,
-                       const void *buf,
-                       size_t length) {
-    int retval = write_header(stream, id, length);
-    if (!retval) {
-        retval = avs_stream_write(stream, buf, length);
-    }
-    return retval;
-}
-
 static char *add_buffered_entry(tlv_out_t *ctx, size_t length) {
-    tlv_entry_t *new_entry = (tlv_entry_t *)
-            AVS_LIST_NEW_BUFFER(sizeof(tlv_entry_t) + length);
-    if (!new_entry) {
+    tlv_arena_t *arena = ctx->arena;
+    if (length > SIZE_MAX - TLV_MAX_HEADER_SIZE
+            || arena_reserve(arena, TLV_MAX_HEADER_SIZE + length)) {
         return NULL;
     }
-    new_entry->data_length = length;
-    new_entry->id = ctx->next_id;
+    size_t size = encode_header(&arena->data[arena->size],
+                                &ctx->next_id, length);
     ctx->next_id.id = -1;
-    *ctx->next_entry_ptr = new_entry;
-    AVS_LIST_ADVANCE_PTR(&ctx->next_entry_ptr);
-    return new_entry->data;
+    if (!size) {
+        return NULL;
+    }
+    char *data = &arena->data[arena->size + size];
+    arena->size += size + length;
+    return data;
 }
 
 static int streamed_bytes_append(anjay_ret_bytes_ctx_t *ctx_,
@@ -292,37 +327,44 @@ static anjay_output_ctx_t *tlv_slave_start(tlv_out_t *ctx,
                                            tlv_id_type_t inner_type);
 
 static int tlv_slave_finish(tlv_out_t *ctx, tlv_id_type_t next_id_type) {
-    if (!ctx->parent) {
+    tlv_out_t *parent = ctx->parent;
+    if (!parent) {
         return -1;
     }
-    size_t data_size = 0;
-    {
-        tlv_entry_t *entry = NULL;
-        AVS_LIST_FOREACH(entry, ctx->entries) {
-            data_size += header_size((uint16_t) entry->id.id,
-                                     entry->data_length) +
-                    entry->data_length;
-        }
-    }
-    char *buffer = (char *) (data_size ? avs_malloc(data_size) : NULL);
-    int retval = ((!data_size || buffer) ? 0 : -1);
-    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
-    avs_stream_outbuf_set_buffer(&outbuf, buffer, data_size);
-    AVS_LIST_CLEAR(&ctx->entries) {
-        if (!retval) {
-            retval = write_entry((avs_stream_abstract_t *) &outbuf,
-                                 &ctx->entries->id,
-                                 ctx->entries->data,
-                                 ctx->entries->data_length);
+    // entries of an unfinished nested context are not part of this one
+    _anjay_output_ctx_destroy(&ctx->slave);
+    tlv_arena_t *arena = ctx->arena;
+    const size_t data_offset = ctx->header_offset + TLV_MAX_HEADER_SIZE;
+    const size_t length = arena->size - data_offset;
+    char header[TLV_MAX_HEADER_SIZE];
+    size_t size = encode_header(header, &parent->next_id, length);
+    int retval = -1;
+    if (size) {
+        // back-patch the header so that it immediately precedes the data
+        const size_t entry_offset = data_offset - size;
+        memcpy(&arena->data[entry_offset], header, size);
+        if (parent->stream) {
+            retval = avs_stream_write(parent->stream,
+                                      &arena->data[entry_offset],
+                                      size + length);
+            arena->size = ctx->header_offset;
+        } else {
+            // compact the unused part of the reserved header space
+            if (entry_offset > ctx->header_offset) {
+                memmove(&arena->data[ctx->header_offset],
+                        &arena->data[entry_offset], size + length);
+            }
+            arena->size = ctx->header_offset + size + length;
+            retval = 0;
         }
     }
+    parent->next_id.id = -1;
+    parent->next_id.type = next_id_type;
     if (!retval) {
-        size_t length = avs_stream_outbuf_offset(&outbuf);
-        anjay_ret_bytes_ctx_t *bytes = add_entry(ctx->parent, length);
-        retval = !bytes ? -1 : anjay_ret_bytes_append(bytes, buffer, length);
+        // the encoded data now belongs to the parent; make sure that closing
+        // this context does not discard it
+        ctx->header_offset = arena->size;
     }
-    avs_free(buffer);
-    ctx->parent->next_id.type = next_id_type;
     _anjay_output_ctx_destroy((anjay_output_ctx_t **) &ctx);
     return retval;
 }
@@ -380,11 +422,15 @@ static int tlv_set_id(anjay_output_ctx_t *ctx_,
 
 static int tlv_output_close(anjay_output_ctx_t *ctx_) {
     tlv_out_t *ctx = (tlv_out_t *) ctx_;
-    AVS_LIST_CLEAR(&ctx->entries);
     int retval = _anjay_output_ctx_destroy(&ctx->slave);
     if (ctx->parent) {
+        // discard any entries of an unfinished nested context
+        assert(ctx->header_offset <= ctx->arena->size);
+        ctx->arena->size = ctx->header_offset;
         ctx->parent->next_id.id = -1;
         ctx->parent->slave = NULL;
+    } else {
+        avs_free(ctx->arena_storage.data);
     }
     return retval;
 }
@@ -413,15 +459,19 @@ static anjay_output_ctx_t *tlv_slave_start(tlv_out_t *ctx,
                                            tlv_id_type_t inner_type) {
     tlv_out_t *object = NULL;
     if (ctx->slave
+            || ctx->bytes_ctx.bytes_left
             || ctx->next_id.type != expected_type
             || ctx->next_id.id < 0
+            || arena_reserve(ctx->arena, TLV_MAX_HEADER_SIZE)
             || !(object = (tlv_out_t *) avs_calloc(1, sizeof(tlv_out_t)))) {
         return NULL;
     }
     object->vtable = &TLV_OUT_VTABLE;
     object->errno_ptr = ctx->errno_ptr;
     object->parent = ctx;
-    object->next_entry_ptr = &object->entries;
+    object->arena = ctx->arena;
+    object->header_offset = ctx->arena->size;
+    ctx->arena->size += TLV_MAX_HEADER_SIZE;
     object->next_id.type = inner_type;
     object->next_id.id = -1;
     ctx->next_id.type = new_type;
@@ -435,7 +485,7 @@ _anjay_output_raw_tlv_create(avs_stream_abstract_t *stream) {
     if (ctx) {
         ctx->vtable = &TLV_OUT_VTABLE;
         ctx->errno_ptr = NULL;
-        ctx->next_entry_ptr = &ctx->entries;
+        ctx->arena = &ctx->arena_storage;
         ctx->stream = stream;
         ctx->next_id.id = -1;
     }
@@ -87,6 +87,7 @@ typedef int (*anjay_input_ctx_get_id_t)(anjay_input_ctx_t *,
                                         anjay_id_type_t *, uint16_t *);
 typedef int (*anjay_input_ctx_next_entry_t)(anjay_input_ctx_t *);
 typedef int (*anjay_input_ctx_close_t)(anjay_input_ctx_t *);
+typedef anjay_input_ctx_t *(*anjay_input_ctx_nested_ctx_t)(anjay_input_ctx_t *);
 
 typedef struct {
     anjay_input_ctx_bytes_t some_bytes;
@@ -101,6 +102,8 @@ typedef struct {
     anjay_input_ctx_get_id_t get_id;
     anjay_input_ctx_next_entry_t next_entry;
     anjay_input_ctx_close_t close;
+    /* optional; if NULL, nested entries are parsed as TLV */
+    anjay_input_ctx_nested_ctx_t nested_ctx;
 } anjay_input_ctx_vtable_t;
 
 VISIBILITY_PRIVATE_HEADER_END
@@ -216,6 +216,10 @@ int anjay_ret_objlnk(anjay_output_ctx_t *ctx,
     return ctx->vtable->objlnk(ctx, oid, iid);
 }
 
+int anjay_ret_resource_id(anjay_output_ctx_t *ctx, anjay_rid_t rid) {
+    return _anjay_output_set_id(ctx, ANJAY_ID_RID, rid);
+}
+
 anjay_output_ctx_t *anjay_ret_array_start(anjay_output_ctx_t *ctx) {
     if (!ctx->vtable->array_start) {
         set_errno_not_implemented(ctx);
@@ -428,6 +432,9 @@ int _anjay_input_attach_child(anjay_input_ctx_t *ctx,
 }
 
 anjay_input_ctx_t *_anjay_input_nested_ctx(anjay_input_ctx_t *ctx) {
+    if (ctx->vtable->nested_ctx) {
+        return ctx->vtable->nested_ctx(ctx);
+    }
     anjay_input_ctx_t *retval = NULL;
     avs_stream_abstract_t *stream = _anjay_input_bytes_stream(ctx);
     if (stream && _anjay_input_tlv_create(&retval, &stream, true)) {
@@ -87,6 +87,43 @@ _anjay_output_json_create(avs_stream_abstract_t *stream,
                           int *errno_ptr,
                           anjay_msg_details_t *inout_details,
                           const anjay_uri_path_t *uri);
+
+anjay_input_ctx_constructor_t _anjay_input_json_create;
+#endif
+
+#ifdef WITH_SENML_CBOR
+anjay_output_ctx_t *
+_anjay_output_senml_cbor_create(avs_stream_abstract_t *stream,
+                                int *errno_ptr,
+                                anjay_msg_details_t *inout_details,
+                                const anjay_uri_path_t *uri);
+
+anjay_input_ctx_constructor_t _anjay_input_senml_cbor_create;
+#endif
+
+#if defined(WITH_JSON) || defined(WITH_SENML_CBOR)
+/**
+ * Unlike TLV, SenML payloads name the Object explicitly. If @p ctx is a SenML
+ * input context, this function makes it reject Records that refer to any
+ * Object other than @p oid, i.e. the one from the request URI. For other input
+ * contexts it does nothing.
+ *
+ * @returns 0 on success, or ANJAY_ERR_BAD_REQUEST if a Record for another
+ *          Object has already been read.
+ */
+int _anjay_input_senml_expect_oid(anjay_input_ctx_t *ctx, anjay_oid_t oid);
+
+/**
+ * SenML input contexts expose Object Instances at the top level. When writing
+ * a single Resource, this function validates that the payload refers to the
+ * Resource identified by @p uri, and returns the nested context that reads it
+ * (owned by @p ctx).
+ */
+int _anjay_input_senml_enter_resource(anjay_input_ctx_t *ctx,
+                                      const anjay_uri_path_t *uri,
+                                      anjay_input_ctx_t **out_resource_ctx);
+#else
+#define _anjay_input_senml_expect_oid(ctx, oid) ((void) (ctx), (void) (oid), 0)
 #endif
 
 int *_anjay_output_ctx_errno_ptr(anjay_output_ctx_t *ctx);
@@ -21,7 +21,9 @@
 
 #include "coap/content_format.h"
 
+#include "access_control_utils.h"
 #include "anjay_core.h"
+#include "interface/register.h"
 #include "servers_utils.h"
 #include "observe/observe_core.h"
 
@@ -39,6 +41,15 @@ static int observe_notify(anjay_t *anjay,
     };
     int ret = 0;
     AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, queue) {
+        // Server object holds the default Minimum and Maximum Period, and
+        // presence of instances affects which attributes are effective
+        if (it->oid == ANJAY_DM_OID_SERVER
+                || it->instance_set_changes.instance_set_changed) {
+            _anjay_observe_invalidate_attrs(anjay);
+            break;
+        }
+    }
     AVS_LIST_FOREACH(it, queue) {
         observe_key.oid = it->oid;
         if (it->instance_set_changes.instance_set_changed) {
@@ -117,12 +128,19 @@ int _anjay_notify_perform(anjay_t *anjay,
     int ret = 0;
     AVS_LIST(anjay_notify_queue_object_entry_t) it;
     AVS_LIST_FOREACH(it, queue) {
-        if (it->oid > 1) {
+        if (it->instance_set_changes.instance_set_changed) {
+            _anjay_registration_dm_cache_update(anjay, it->oid);
+        }
+    }
+    AVS_LIST_FOREACH(it, queue) {
+        if (it->oid > ANJAY_DM_OID_ACCESS_CONTROL) {
             break;
         } else if (it->oid == ANJAY_DM_OID_SECURITY) {
             _anjay_update_ret(&ret, security_modified_notify(anjay, it));
         } else if (it->oid == ANJAY_DM_OID_SERVER) {
             _anjay_update_ret(&ret, server_modified_notify(anjay, it));
+        } else if (it->oid == ANJAY_DM_OID_ACCESS_CONTROL) {
+            _anjay_access_control_index_update(anjay, queue, it);
         }
     }
     _anjay_update_ret(&ret, observe_notify(anjay, queue));
@@ -320,7 +338,10 @@ static void notify_clb(anjay_t *anjay, const void *dummy) {
     _anjay_notify_flush(anjay, &anjay->scheduled_notify.queue);
 }
 
-static int reschedule_notify(anjay_t *anjay) {
+static int reschedule_notify(anjay_t *anjay, anjay_oid_t oid) {
+    if (oid == ANJAY_DM_OID_ACCESS_CONTROL) {
+        _anjay_access_control_index_changes_scheduled(anjay);
+    }
     if (anjay->scheduled_notify.handle) {
         return 0;
     }
@@ -334,7 +355,7 @@ int _anjay_notify_instance_created(anjay_t *anjay,
     int retval;
     (void) ((retval = _anjay_notify_queue_instance_created(
                     &anjay->scheduled_notify.queue, oid, iid))
-            || (retval = reschedule_notify(anjay)));
+            || (retval = reschedule_notify(anjay, oid)));
     return retval;
 }
 
@@ -345,7 +366,7 @@ int anjay_notify_changed(anjay_t *anjay,
     int retval;
     (void) ((retval = _anjay_notify_queue_resource_change(
                     &anjay->scheduled_notify.queue, oid, iid, rid))
-            || (retval = reschedule_notify(anjay)));
+            || (retval = reschedule_notify(anjay, oid)));
     return retval;
 }
 
@@ -353,6 +374,6 @@ int anjay_notify_instances_changed(anjay_t *anjay, anjay_oid_t oid) {
     int retval;
     (void) ((retval = _anjay_notify_queue_instance_set_unknown_change(
                     &anjay->scheduled_notify.queue, oid))
-            || (retval = reschedule_notify(anjay)));
+            || (retval = reschedule_notify(anjay, oid)));
     return retval;
 }
@@ -0,0 +1,495 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <avsystem/commons/defs.h>
+
+#include "number_format.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+static const char DIGIT_PAIRS[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+/**
+ * Writes @p value so that its last digit ends just before @p end, two digits
+ * at a time. Returns pointer to the first written character.
+ */
+static char *write_uint32_backwards(uint32_t value, char *end) {
+    while (value >= 100) {
+        const uint32_t pair = (value % 100) * 2;
+        value /= 100;
+        end -= 2;
+        memcpy(end, &DIGIT_PAIRS[pair], 2);
+    }
+    if (value >= 10) {
+        end -= 2;
+        memcpy(end, &DIGIT_PAIRS[value * 2], 2);
+    } else {
+        *--end = (char) ('0' + value);
+    }
+    return end;
+}
+
+size_t _anjay_uint64_as_string(uint64_t value, char *buf) {
+    char tmp[ANJAY_INT_STRING_BUF_SIZE];
+    char *const end = tmp + sizeof(tmp);
+    char *ptr = end;
+    // 64-bit division is a library call on most 32-bit targets, so it is only
+    // used to split off 8-digit chunks until the rest fits in 32 bits
+    while (value > UINT32_MAX) {
+        char *const chunk_end = ptr;
+        ptr = write_uint32_backwards((uint32_t) (value % 100000000), ptr);
+        value /= 100000000;
+        while (ptr > chunk_end - 8) {
+            *--ptr = '0';
+        }
+    }
+    ptr = write_uint32_backwards((uint32_t) value, ptr);
+
+    const size_t length = (size_t) (end - ptr);
+    memcpy(buf, ptr, length);
+    buf[length] = '\0';
+    return length;
+}
+
+size_t _anjay_int64_as_string(int64_t value, char *buf) {
+    if (value < 0) {
+        *buf = '-';
+        return 1 + _anjay_uint64_as_string((uint64_t) 0 - (uint64_t) value,
+                                           buf + 1);
+    }
+    return _anjay_uint64_as_string((uint64_t) value, buf);
+}
+
+/*
+ * Floating-point formatting below is the Grisu2 algorithm by Florian Loitsch
+ * ("Printing Floating-Point Numbers Quickly and Accurately with Integers",
+ * PLDI 2010). It only uses 64-bit integer arithmetic, always produces output
+ * that round-trips exactly, and in the vast majority of cases that output is
+ * also the shortest possible one.
+ */
+
+typedef struct {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+static diy_fp_t diy_fp_normalize(diy_fp_t value) {
+    while (!(value.f & UINT64_C(0xFFC0000000000000))) {
+        value.f <<= 10;
+        value.e -= 10;
+    }
+    while (!(value.f & (UINT64_C(1) << 63))) {
+        value.f <<= 1;
+        --value.e;
+    }
+    return value;
+}
+
+/** Upper 64 bits of the 128-bit product, rounded. */
+static diy_fp_t diy_fp_mul(diy_fp_t x, diy_fp_t y) {
+    const uint64_t mask32 = UINT32_MAX;
+    const uint64_t a = x.f >> 32;
+    const uint64_t b = x.f & mask32;
+    const uint64_t c = y.f >> 32;
+    const uint64_t d = y.f & mask32;
+    const uint64_t ac = a * c;
+    const uint64_t bc = b * c;
+    const uint64_t ad = a * d;
+    const uint64_t bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+    tmp += UINT64_C(1) << 31;
+    return (diy_fp_t) {
+        .f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32),
+        .e = x.e + y.e + 64
+    };
+}
+
+/**
+ * Normalized 64-bit approximations of 10^(-348 + 8 * i); the binary exponents
+ * are stored separately in @ref CACHED_POWERS_E.
+ */
+static const uint64_t CACHED_POWERS_F[] = {
+    UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76),
+    UINT64_C(0x8b16fb203055ac76), UINT64_C(0xcf42894a5dce35ea),
+    UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+    UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f),
+    UINT64_C(0xbe5691ef416bd60c), UINT64_C(0x8dd01fad907ffc3c),
+    UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+    UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d),
+    UINT64_C(0x823c12795db6ce57), UINT64_C(0xc21094364dfb5637),
+    UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+    UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5),
+    UINT64_C(0xb23867fb2a35b28e), UINT64_C(0x84c8d4dfd2c63f3b),
+    UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+    UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6),
+    UINT64_C(0xf3e2f893dec3f126), UINT64_C(0xb5b5ada8aaff80b8),
+    UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+    UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd),
+    UINT64_C(0xa6dfbd9fb8e5b88f), UINT64_C(0xf8a95fcf88747d94),
+    UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+    UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac),
+    UINT64_C(0xe45c10c42a2b3b06), UINT64_C(0xaa242499697392d3),
+    UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+    UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c),
+    UINT64_C(0x9c40000000000000), UINT64_C(0xe8d4a51000000000),
+    UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+    UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70),
+    UINT64_C(0xd5d238a4abe98068), UINT64_C(0x9f4f2726179a2245),
+    UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+    UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a),
+    UINT64_C(0x924d692ca61be758), UINT64_C(0xda01ee641a708dea),
+    UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+    UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2),
+    UINT64_C(0xc83553c5c8965d3d), UINT64_C(0x952ab45cfa97a0b3),
+    UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+    UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece),
+    UINT64_C(0x88fcf317f22241e2), UINT64_C(0xcc20ce9bd35c78a5),
+    UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+    UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c),
+    UINT64_C(0xbb764c4ca7a44410), UINT64_C(0x8bab8eefb6409c1a),
+    UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+    UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429),
+    UINT64_C(0x80444b5e7aa7cf85), UINT64_C(0xbf21e44003acdd2d),
+    UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+    UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9),
+    UINT64_C(0xaf87023b9bf0ee6b)
+};
+
+static const int16_t CACHED_POWERS_E[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954,
+    -927, -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635,
+    -608, -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316,
+    -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30, 56,
+    83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+    481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853,
+    880, 907, 933, 960, 986, 1013, 1039, 1066
+};
+
+#define CACHED_POWERS_MIN_DEC_EXP (-348)
+#define CACHED_POWERS_DEC_EXP_STEP 8
+
+/**
+ * Returns c = 10^-k such that the binary exponent of w * c lies in the range
+ * [-60, -32] for w with binary exponent @p e.
+ */
+static diy_fp_t get_cached_power(int e, int *out_k) {
+    // ceil((-61 - e) * log10(2)), offset so that the truncation is positive
+    const double dk = (-61 - e) * 0.30102999566398114
+                      - (CACHED_POWERS_MIN_DEC_EXP + 1);
+    int k = (int) dk;
+    if (dk - k > 0.0) {
+        ++k;
+    }
+    const size_t index = (size_t) ((k >> 3) + 1);
+    assert(index < AVS_ARRAY_SIZE(CACHED_POWERS_F));
+    *out_k = -(CACHED_POWERS_MIN_DEC_EXP
+               + (int) index * CACHED_POWERS_DEC_EXP_STEP);
+    return (diy_fp_t) {
+        .f = CACHED_POWERS_F[index],
+        .e = CACHED_POWERS_E[index]
+    };
+}
+
+static const uint64_t POW10[] = {
+    UINT64_C(1),
+    UINT64_C(10),
+    UINT64_C(100),
+    UINT64_C(1000),
+    UINT64_C(10000),
+    UINT64_C(100000),
+    UINT64_C(1000000),
+    UINT64_C(10000000),
+    UINT64_C(100000000),
+    UINT64_C(1000000000),
+    UINT64_C(10000000000),
+    UINT64_C(100000000000),
+    UINT64_C(1000000000000),
+    UINT64_C(10000000000000),
+    UINT64_C(100000000000000),
+    UINT64_C(1000000000000000),
+    UINT64_C(10000000000000000),
+    UINT64_C(100000000000000000),
+    UINT64_C(1000000000000000000),
+    UINT64_C(10000000000000000000)
+};
+
+static int count_decimal_digits(uint32_t value) {
+    int digits = 1;
+    while (digits < 10 && value >= POW10[digits]) {
+        ++digits;
+    }
+    return digits;
+}
+
+/**
+ * Moves the last generated digit towards the exact value as long as the result
+ * stays within the rounding interval.
+ */
+static void grisu_round(char *digits,
+                        int length,
+                        uint64_t delta,
+                        uint64_t rest,
+                        uint64_t ten_kappa,
+                        uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa
+           && (rest + ten_kappa < wp_w
+               || wp_w - rest > rest + ten_kappa - wp_w)) {
+        --digits[length - 1];
+        rest += ten_kappa;
+    }
+}
+
+static int generate_digits(diy_fp_t w,
+                           diy_fp_t upper,
+                           uint64_t delta,
+                           char *digits,
+                           int *inout_k) {
+    const int shift = -upper.e;
+    const uint64_t one = UINT64_C(1) << shift;
+    const uint64_t wp_w = upper.f - w.f;
+    uint32_t p1 = (uint32_t) (upper.f >> shift);
+    uint64_t p2 = upper.f & (one - 1);
+    int kappa = count_decimal_digits(p1);
+    int length = 0;
+
+    while (kappa > 0) {
+        const uint32_t divisor = (uint32_t) POW10[kappa - 1];
+        const uint32_t digit = p1 / divisor;
+        p1 %= divisor;
+        if (digit || length) {
+            digits[length++] = (char) ('0' + digit);
+        }
+        --kappa;
+        const uint64_t rest = ((uint64_t) p1 << shift) + p2;
+        if (rest <= delta) {
+            *inout_k += kappa;
+            grisu_round(digits, length, delta, rest,
+                        POW10[kappa] << shift, wp_w);
+            return length;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        const char digit = (char) (p2 >> shift);
+        if (digit || length) {
+            digits[length++] = (char) ('0' + digit);
+        }
+        p2 &= one - 1;
+        --kappa;
+        if (p2 < delta) {
+            *inout_k += kappa;
+            const int index = -kappa;
+            grisu_round(digits, length, delta, p2, one,
+                        index < (int) AVS_ARRAY_SIZE(POW10)
+                                ? wp_w * POW10[index]
+                                : 0);
+            return length;
+        }
+    }
+}
+
+/**
+ * Generates decimal digits of v = @p significand * 2^@p exponent into
+ * @p digits. Returns the number of digits; the value is equal to
+ * digits * 10^*out_k.
+ *
+ * @p lower_boundary_closer shall be true if the distance to the next smaller
+ * representable value is half the distance to the next larger one, i.e. if
+ * @p significand is an exact power of two and not the smallest normal value.
+ */
+static int grisu2(uint64_t significand,
+                  int exponent,
+                  bool lower_boundary_closer,
+                  char *digits,
+                  int *out_k) {
+    const diy_fp_t v = diy_fp_normalize((diy_fp_t) {
+        .f = significand,
+        .e = exponent
+    });
+    const diy_fp_t upper = diy_fp_normalize((diy_fp_t) {
+        .f = (significand << 1) + 1,
+        .e = exponent - 1
+    });
+    diy_fp_t lower = lower_boundary_closer
+            ? (diy_fp_t) { .f = (significand << 2) - 1, .e = exponent - 2 }
+            : (diy_fp_t) { .f = (significand << 1) - 1, .e = exponent - 1 };
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
+    assert(v.e == upper.e);
+
+    const diy_fp_t c_mk = get_cached_power(upper.e, out_k);
+    const diy_fp_t w = diy_fp_mul(v, c_mk);
+    diy_fp_t w_plus = diy_fp_mul(upper, c_mk);
+    diy_fp_t w_minus = diy_fp_mul(lower, c_mk);
+    // shrink the interval by one unit on both sides to account for the
+    // imprecision of the cached power
+    ++w_minus.f;
+    --w_plus.f;
+    return generate_digits(w, w_plus, w_plus.f - w_minus.f, digits, out_k);
+}
+
+static char *write_exponent(int exponent, char *out) {
+    *out++ = 'e';
+    if (exponent < 0) {
+        *out++ = '-';
+        exponent = -exponent;
+    } else {
+        *out++ = '+';
+    }
+    // at least two digits, like printf("%g") does
+    if (exponent < 10) {
+        *out++ = '0';
+    }
+    char *const end = out + count_decimal_digits((uint32_t) exponent);
+    write_uint32_backwards((uint32_t) exponent, end);
+    return end;
+}
+
+/**
+ * Rewrites @p length raw digits, already stored at the beginning of @p buf and
+ * representing digits * 10^k, into plain or exponential notation.
+ */
+static size_t prettify(char *buf, int length, int k) {
+    // 10^(kk - 1) <= value < 10^kk
+    const int kk = length + k;
+    char *end;
+    if (k >= 0 && kk <= 21) {
+        // 1234e7 -> 12340000000
+        memset(&buf[length], '0', (size_t) (kk - length));
+        end = &buf[kk];
+    } else if (kk > 0 && kk <= 21) {
+        // 1234e-2 -> 12.34
+        memmove(&buf[kk + 1], &buf[kk], (size_t) (length - kk));
+        buf[kk] = '.';
+        end = &buf[length + 1];
+    } else if (kk > -6 && kk <= 0) {
+        // 1234e-6 -> 0.001234
+        const int offset = 2 - kk;
+        memmove(&buf[offset], buf, (size_t) length);
+        buf[0] = '0';
+        buf[1] = '.';
+        memset(&buf[2], '0', (size_t) (offset - 2));
+        end = &buf[length + offset];
+    } else if (length == 1) {
+        // 1e30
+        end = write_exponent(kk - 1, &buf[1]);
+    } else {
+        // 1234e30 -> 1.234e+33
+        memmove(&buf[2], &buf[1], (size_t) (length - 1));
+        buf[1] = '.';
+        end = write_exponent(kk - 1, &buf[length + 1]);
+    }
+    *end = '\0';
+    return (size_t) (end - buf);
+}
+
+static size_t write_literal(const char *literal, char *buf) {
+    const size_t length = strlen(literal);
+    memcpy(buf, literal, length + 1);
+    return length;
+}
+
+static size_t format_binary_fp(bool negative,
+                               uint64_t significand,
+                               int exponent,
+                               bool lower_boundary_closer,
+                               char *buf) {
+    char *digits = buf;
+    if (negative) {
+        *digits++ = '-';
+    }
+    if (!significand) {
+        digits[0] = '0';
+        digits[1] = '\0';
+        return (size_t) (digits - buf) + 1;
+    }
+    int k;
+    const int length = grisu2(significand, exponent, lower_boundary_closer,
+                              digits, &k);
+    return (size_t) (digits - buf) + prettify(digits, length, k);
+}
+
+size_t _anjay_double_as_string(double value, char *buf) {
+    if (isnan(value)) {
+        return write_literal("nan", buf);
+    } else if (isinf(value)) {
+        return write_literal(value < 0.0 ? "-inf" : "inf", buf);
+    }
+
+    AVS_STATIC_ASSERT(sizeof(double) == sizeof(uint64_t), double_sane);
+    union {
+        double d;
+        uint64_t ieee;
+    } conv;
+    conv.d = value;
+    const uint64_t fraction = conv.ieee & ((UINT64_C(1) << 52) - 1);
+    const int biased_exponent = (int) ((conv.ieee >> 52) & 0x7FF);
+    if (biased_exponent) {
+        return format_binary_fp(conv.ieee >> 63,
+                                fraction | (UINT64_C(1) << 52),
+                                biased_exponent - 1075,
+                                !fraction && biased_exponent > 1, buf);
+    } else {
+        return format_binary_fp(conv.ieee >> 63, fraction, -1074, false, buf);
+    }
+}
+
+size_t _anjay_float_as_string(float value, char *buf) {
+    if (isnan(value)) {
+        return write_literal("nan", buf);
+    } else if (isinf(value)) {
+        return write_literal(value < 0.0f ? "-inf" : "inf", buf);
+    }
+
+    AVS_STATIC_ASSERT(sizeof(float) == sizeof(uint32_t), float_sane);
+    union {
+        float f;
+        uint32_t ieee;
+    } conv;
+    conv.f = value;
+    const uint32_t fraction = conv.ieee & ((UINT32_C(1) << 23) - 1);
+    const int biased_exponent = (int) ((conv.ieee >> 23) & 0xFF);
+    if (biased_exponent) {
+        return format_binary_fp(conv.ieee >> 31,
+                                fraction | (UINT32_C(1) << 23),
+                                biased_exponent - 150,
+                                !fraction && biased_exponent > 1, buf);
+    } else {
+        return format_binary_fp(conv.ieee >> 31, fraction, -149, false, buf);
+    }
+}
+
+#ifdef ANJAY_TEST
+#include "test/number_format.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_NUMBER_FORMAT_H
+#define ANJAY_NUMBER_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Buffer size sufficient for any value formatted by
+ * @ref _anjay_uint64_as_string or @ref _anjay_int64_as_string, including the
+ * terminating nullbyte ("-9223372036854775808").
+ */
+#define ANJAY_INT_STRING_BUF_SIZE 21
+
+/**
+ * Buffer size sufficient for any value formatted by
+ * @ref _anjay_double_as_string or @ref _anjay_float_as_string, including the
+ * terminating nullbyte (e.g. "-0.0000012345678901234567").
+ */
+#define ANJAY_FLOAT_STRING_BUF_SIZE 32
+
+/**
+ * Writes decimal representation of @p value into @p buf, which MUST be at least
+ * @ref ANJAY_INT_STRING_BUF_SIZE bytes long.
+ *
+ * @returns Length of the written string, not including the terminating
+ *          nullbyte.
+ */
+size_t _anjay_uint64_as_string(uint64_t value, char *buf);
+
+/** Signed variant of @ref _anjay_uint64_as_string . */
+size_t _anjay_int64_as_string(int64_t value, char *buf);
+
+/**
+ * Writes the shortest decimal representation of @p value that parses back
+ * (e.g. using strtod()) to exactly the same double into @p buf, which MUST be
+ * at least @ref ANJAY_FLOAT_STRING_BUF_SIZE bytes long.
+ *
+ * Plain decimal notation is used for values between 1e-6 and 1e21, and
+ * exponential notation ("1.5e+30") otherwise. Non-finite values are written as
+ * "nan", "inf" or "-inf".
+ *
+ * @returns Length of the written string, not including the terminating
+ *          nullbyte.
+ */
+size_t _anjay_double_as_string(double value, char *buf);
+
+/**
+ * Same as @ref _anjay_double_as_string, but the output is the shortest string
+ * that parses back (e.g. using strtof()) to exactly the same float.
+ */
+size_t _anjay_float_as_string(float value, char *buf);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_NUMBER_FORMAT_H
@@ -19,10 +19,12 @@
 #include <inttypes.h>
 #include <math.h>
 
+#include <avsystem/commons/memory.h>
 #include <avsystem/commons/stream_v_table.h>
 
 #include <anjay_modules/time_defs.h>
 
+#include "../access_control_utils.h"
 #include "../servers_utils.h"
 #include "../coap/content_format.h"
 #include "../anjay_core.h"
@@ -46,7 +48,7 @@ static int connection_key_cmp(const anjay_connection_key_t *left,
     return tmp_diff;
 }
 
-static int connection_state_cmp(const void *left, const void *right) {
+int _anjay_observe_connection_entry_cmp(const void *left, const void *right) {
     return connection_key_cmp(
             &((const anjay_observe_connection_entry_t *) left)->key,
             &((const anjay_observe_connection_entry_t *) right)->key);
@@ -80,15 +82,117 @@ int _anjay_observe_entry_cmp(const void *left, const void *right) {
             &((const anjay_observe_entry_t *) right)->key);
 }
 
+anjay_observe_payload_t *_anjay_observe_create_payload(const void *data,
+                                                       size_t size) {
+    anjay_observe_payload_t *payload = (anjay_observe_payload_t *) avs_malloc(
+            offsetof(anjay_observe_payload_t, data) + size);
+    if (!payload) {
+        anjay_log(ERROR, "Out of memory");
+        return NULL;
+    }
+    payload->refcount = 1;
+    payload->queued_refs = 0;
+    payload->size = size;
+    if (data && size) {
+        memcpy(payload->data, data, size);
+    }
+    return payload;
+}
+
+static anjay_observe_payload_t *ref_payload(anjay_observe_payload_t *payload) {
+    ++payload->refcount;
+    return payload;
+}
+
+static void release_payload(anjay_observe_payload_t **payload_ptr) {
+    if (*payload_ptr && !--(*payload_ptr)->refcount) {
+        avs_free(*payload_ptr);
+    }
+    *payload_ptr = NULL;
+}
+
+static void
+delete_resource_value(AVS_LIST(anjay_observe_resource_value_t) *value_ptr) {
+    release_payload(&(*value_ptr)->payload);
+    AVS_LIST_DELETE(value_ptr);
+}
+
+static void
+clear_resource_values(AVS_LIST(anjay_observe_resource_value_t) *list_ptr) {
+    while (*list_ptr) {
+        delete_resource_value(list_ptr);
+    }
+}
+
+static inline bool is_error_value(const anjay_observe_resource_value_t *value) {
+    return avs_coap_msg_code_get_class(value->details.msg_code) >= 4;
+}
+
+static int path_entry_cmp(const void *left_, const void *right_) {
+    const anjay_observe_path_entry_t *left =
+            (const anjay_observe_path_entry_t *) left_;
+    const anjay_observe_path_entry_t *right =
+            (const anjay_observe_path_entry_t *) right_;
+    if (left->oid != right->oid) {
+        return left->oid < right->oid ? -1 : 1;
+    } else if (left->iid != right->iid) {
+        return left->iid < right->iid ? -1 : 1;
+    } else if (left->rid != right->rid) {
+        return left->rid < right->rid ? -1 : 1;
+    }
+    return 0;
+}
+
+static int read_cache_entry_cmp(const void *left_, const void *right_) {
+    const anjay_observe_read_cache_entry_t *left =
+            (const anjay_observe_read_cache_entry_t *) left_;
+    const anjay_observe_read_cache_entry_t *right =
+            (const anjay_observe_read_cache_entry_t *) right_;
+    if (left->ssid != right->ssid) {
+        return left->ssid < right->ssid ? -1 : 1;
+    } else if (left->oid != right->oid) {
+        return left->oid < right->oid ? -1 : 1;
+    } else if (left->iid != right->iid) {
+        return left->iid < right->iid ? -1 : 1;
+    } else if (left->rid != right->rid) {
+        return left->rid < right->rid ? -1 : 1;
+    } else if (left->format != right->format) {
+        return left->format < right->format ? -1 : 1;
+    }
+    return 0;
+}
+
 int _anjay_observe_init(anjay_observe_state_t *observe,
-                        bool confirmable_notifications) {
+                        bool confirmable_notifications,
+                        size_t max_in_flight,
+                        bool coalesce_notifications,
+                        bool cache_attrs,
+                        const anjay_notify_queue_limits_t *conn_queue_limits,
+                        const anjay_notify_queue_limits_t *total_queue_limits,
+                        anjay_notify_queue_policy_t queue_policy) {
     if (!(observe->connection_entries =
             AVS_RBTREE_NEW(anjay_observe_connection_entry_t,
-                           connection_state_cmp))) {
+                           _anjay_observe_connection_entry_cmp))
+            || !(observe->path_index =
+                    AVS_RBTREE_NEW(anjay_observe_path_entry_t,
+                                   path_entry_cmp))
+            || !(observe->read_cache =
+                    AVS_RBTREE_NEW(anjay_observe_read_cache_entry_t,
+                                   read_cache_entry_cmp))) {
         anjay_log(ERROR, "Could not initialize Observe structures");
+        AVS_RBTREE_DELETE(&observe->path_index);
+        AVS_RBTREE_DELETE(&observe->connection_entries);
         return -1;
     }
     observe->confirmable_notifications = confirmable_notifications;
+    observe->max_in_flight = max_in_flight ? max_in_flight : 1;
+    observe->coalesce_notifications = coalesce_notifications;
+    observe->cache_attrs = cache_attrs;
+    // entries are created with attrs_generation == 0, i.e. no cached value
+    observe->attrs_generation = 1;
+    observe->queue_limits_per_connection = *conn_queue_limits;
+    observe->queue_limits_total = *total_queue_limits;
+    observe->queue_policy = queue_policy;
     return 0;
 }
 
@@ -105,12 +209,12 @@ void _anjay_observe_cleanup_connection(anjay_sched_t *sched,
         if ((*conn->entries)->notify_task) {
             _anjay_sched_del(sched, &(*conn->entries)->notify_task);
         }
-        AVS_LIST_CLEAR(&(*conn->entries)->last_sent);
+        clear_resource_values(&(*conn->entries)->last_sent);
     }
     if (conn->flush_task) {
         _anjay_sched_del(sched, &conn->flush_task);
     }
-    AVS_LIST_CLEAR(&conn->unsent);
+    clear_resource_values(&conn->unsent);
 }
 
 void _anjay_observe_cleanup(anjay_observe_state_t *observe,
@@ -118,6 +222,85 @@ void _anjay_observe_cleanup(anjay_observe_state_t *observe,
     AVS_RBTREE_DELETE(&observe->connection_entries) {
         _anjay_observe_cleanup_connection(sched, *observe->connection_entries);
     }
+    AVS_RBTREE_DELETE(&observe->path_index) {
+        AVS_LIST_CLEAR(&(*observe->path_index)->refs);
+    }
+    _anjay_observe_read_cache_clear(observe);
+    AVS_RBTREE_DELETE(&observe->read_cache);
+    observe->unsent_count = 0;
+    observe->unsent_bytes = 0;
+}
+
+void _anjay_observe_read_cache_clear(anjay_observe_state_t *observe) {
+    anjay_observe_read_cache_entry_t *cached;
+    while (observe->read_cache
+            && (cached = AVS_RBTREE_FIRST(observe->read_cache))) {
+        release_payload(&cached->payload);
+        AVS_RBTREE_DELETE_ELEM(observe->read_cache, &cached);
+    }
+}
+
+static inline anjay_observe_path_entry_t
+path_query(const anjay_observe_key_t *key) {
+    return (anjay_observe_path_entry_t) {
+        .oid = key->oid,
+        .iid = key->iid,
+        .rid = key->rid
+    };
+}
+
+int _anjay_observe_index_add(anjay_observe_state_t *observe,
+                             anjay_observe_entry_t *entry) {
+    const anjay_observe_path_entry_t query = path_query(&entry->key);
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) path =
+            AVS_RBTREE_FIND(observe->path_index, &query);
+    if (!path) {
+        if (!(path = AVS_RBTREE_ELEM_NEW(anjay_observe_path_entry_t))) {
+            anjay_log(ERROR, "Out of memory");
+            return -1;
+        }
+        *path = query;
+        AVS_RBTREE_INSERT(observe->path_index, path);
+    }
+
+    AVS_LIST(anjay_observe_entry_t *) *ref_ptr;
+    AVS_LIST_FOREACH_PTR(ref_ptr, &path->refs) {
+        if (_anjay_observe_key_cmp(&(**ref_ptr)->key, &entry->key) > 0) {
+            break;
+        }
+    }
+    AVS_LIST(anjay_observe_entry_t *) ref =
+            AVS_LIST_NEW_ELEMENT(anjay_observe_entry_t *);
+    if (!ref) {
+        anjay_log(ERROR, "Out of memory");
+        if (!path->refs) {
+            AVS_RBTREE_DELETE_ELEM(observe->path_index, &path);
+        }
+        return -1;
+    }
+    *ref = entry;
+    AVS_LIST_INSERT(ref_ptr, ref);
+    return 0;
+}
+
+void _anjay_observe_index_remove(anjay_observe_state_t *observe,
+                                 const anjay_observe_entry_t *entry) {
+    const anjay_observe_path_entry_t query = path_query(&entry->key);
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) path =
+            AVS_RBTREE_FIND(observe->path_index, &query);
+    if (!path) {
+        return;
+    }
+    AVS_LIST(anjay_observe_entry_t *) *ref_ptr;
+    AVS_LIST_FOREACH_PTR(ref_ptr, &path->refs) {
+        if (**ref_ptr == entry) {
+            AVS_LIST_DELETE(ref_ptr);
+            break;
+        }
+    }
+    if (!path->refs) {
+        AVS_RBTREE_DELETE_ELEM(observe->path_index, &path);
+    }
 }
 
 static int observe_setup_for_sending(avs_stream_abstract_t *stream,
@@ -154,32 +337,118 @@ const anjay_observe_stream_t *_anjay_observe_stream_initializer__(void) {
     return &initializer;
 }
 
+/**
+ * Returns the last element of the unsent list that refers to @p entry, or the
+ * last element overall if @p entry is NULL.
+ */
+static AVS_LIST(anjay_observe_resource_value_t)
+find_last_unsent(anjay_observe_connection_entry_t *connection,
+                 const anjay_observe_entry_t *entry) {
+    AVS_LIST(anjay_observe_resource_value_t) result = NULL;
+    AVS_LIST(anjay_observe_resource_value_t) it;
+    AVS_LIST_FOREACH(it, connection->unsent) {
+        if (!entry || it->ref == entry) {
+            result = it;
+        }
+    }
+    return result;
+}
+
+/**
+ * Accounts a value with @p payload, added to any send queue, in the totals
+ * checked against queue_limits_total. A payload shared by values queued for
+ * multiple connections is only counted once.
+ */
+static void charge_queued_payload(anjay_observe_state_t *observe,
+                                  anjay_observe_payload_t *payload) {
+    ++observe->unsent_count;
+    if (!payload->queued_refs++) {
+        observe->unsent_bytes += payload->size;
+    }
+}
+
+static void uncharge_queued_payload(anjay_observe_state_t *observe,
+                                    anjay_observe_payload_t *payload) {
+    assert(observe->unsent_count > 0);
+    assert(payload->queued_refs > 0);
+    --observe->unsent_count;
+    if (!--payload->queued_refs) {
+        assert(observe->unsent_bytes >= payload->size);
+        observe->unsent_bytes -= payload->size;
+    }
+}
+
+static anjay_observe_resource_value_t *
+detach_unsent_value(anjay_t *anjay,
+                    anjay_observe_connection_entry_t *connection,
+                    AVS_LIST(anjay_observe_resource_value_t) *value_ptr) {
+    assert(value_ptr && *value_ptr);
+    anjay_observe_entry_t *entry = (*value_ptr)->ref;
+    anjay_observe_resource_value_t *result = AVS_LIST_DETACH(value_ptr);
+    assert(connection->unsent_count > 0);
+    assert(connection->unsent_bytes >= result->payload->size);
+    --connection->unsent_count;
+    connection->unsent_bytes -= result->payload->size;
+    uncharge_queued_payload(&anjay->observe, result->payload);
+    if (result->in_flight) {
+        assert(connection->in_flight_count > 0);
+        --connection->in_flight_count;
+        result->in_flight = false;
+    }
+    if (entry->last_unsent == result) {
+        entry->last_unsent = find_last_unsent(connection, entry);
+    }
+    if (connection->unsent_last == result) {
+        connection->unsent_last = find_last_unsent(connection, NULL);
+    }
+    return result;
+}
+
+static void
+delete_unsent_value(anjay_t *anjay,
+                    anjay_observe_connection_entry_t *connection,
+                    AVS_LIST(anjay_observe_resource_value_t) *value_ptr) {
+    if ((*value_ptr)->in_flight) {
+        _anjay_coap_async_cancel(anjay, connection->key,
+                                 (*value_ptr)->identity.msg_id);
+    }
+    AVS_LIST(anjay_observe_resource_value_t) value =
+            detach_unsent_value(anjay, connection, value_ptr);
+    delete_resource_value(&value);
+}
+
 static void clear_entry(anjay_t *anjay,
                         anjay_observe_connection_entry_t *connection,
                         anjay_observe_entry_t *entry) {
     _anjay_sched_del(anjay->sched, &entry->notify_task);
-    AVS_LIST_CLEAR(&entry->last_sent);
+    clear_resource_values(&entry->last_sent);
 
-    if (entry->last_unsent) {
-        anjay_observe_resource_value_t **unsent_ptr;
-        anjay_observe_resource_value_t *helper;
-        anjay_observe_resource_value_t *server_last_unsent = NULL;
-        AVS_LIST_DELETABLE_FOREACH_PTR(unsent_ptr, helper,
-                                       &connection->unsent) {
-            if ((*unsent_ptr)->ref != entry) {
-                server_last_unsent = *unsent_ptr;
-            } else {
-                AVS_LIST_DELETE(unsent_ptr);
-            }
+    AVS_LIST(anjay_observe_resource_value_t) *unsent_ptr = &connection->unsent;
+    while (entry->last_unsent && *unsent_ptr) {
+        if ((*unsent_ptr)->ref == entry) {
+            delete_unsent_value(anjay, connection, unsent_ptr);
+        } else {
+            AVS_LIST_ADVANCE_PTR(&unsent_ptr);
         }
-        connection->unsent_last = server_last_unsent;
-        entry->last_unsent = NULL;
     }
+    assert(!entry->last_unsent);
 }
 
 static void delete_connection(
         anjay_t *anjay,
         AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) *conn_ptr) {
+    AVS_LIST(anjay_observe_resource_value_t) value;
+    AVS_LIST_FOREACH(value, (*conn_ptr)->unsent) {
+        if (value->in_flight) {
+            _anjay_coap_async_cancel(anjay, (*conn_ptr)->key,
+                                     value->identity.msg_id);
+        }
+        uncharge_queued_payload(&anjay->observe, value->payload);
+    }
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry;
+    AVS_RBTREE_FOREACH(entry, (*conn_ptr)->entries) {
+        _anjay_observe_index_remove(&anjay->observe, entry);
+    }
     _anjay_observe_cleanup_connection(anjay->sched, *conn_ptr);
     AVS_RBTREE_DELETE_ELEM(anjay->observe.connection_entries, conn_ptr);
 }
@@ -240,10 +509,9 @@ create_resource_value(const anjay_msg_details_t *details,
                       anjay_observe_entry_t *ref,
                       const avs_coap_msg_identity_t *identity,
                       double numeric,
-                      const void *data, size_t size) {
+                      anjay_observe_payload_t *payload) {
     AVS_LIST(anjay_observe_resource_value_t) result =
-            (anjay_observe_resource_value_t *) AVS_LIST_NEW_BUFFER(
-                    offsetof(anjay_observe_resource_value_t, value) + size);
+            AVS_LIST_NEW_ELEMENT(anjay_observe_resource_value_t);
     if (!result) {
         anjay_log(ERROR, "Out of memory");
         return NULL;
@@ -252,36 +520,143 @@ create_resource_value(const anjay_msg_details_t *details,
     result->ref = ref;
     result->identity = *identity;
     result->numeric = numeric;
-    AVS_STATIC_ASSERT(sizeof(result->value_length) == sizeof(size),
-                      length_size);
-    memcpy((void *) (intptr_t) &result->value_length, &size, sizeof(size));
-    assert(data || !size);
-    if (data) {
-        memcpy(result->value, data, size);
-    }
+    result->payload = ref_payload(payload);
     result->timestamp = avs_time_real_now();
     return result;
 }
 
-static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
+static inline bool
+queue_limits_exceeded(const anjay_notify_queue_limits_t *limits,
+                      size_t count,
+                      size_t bytes) {
+    return (limits->max_values && count > limits->max_values)
+            || (limits->max_bytes && bytes > limits->max_bytes);
+}
+
+static bool fits_in_queue(anjay_t *anjay,
+                          anjay_observe_connection_entry_t *conn_state,
+                          const anjay_observe_payload_t *payload) {
+    // a payload already queued for another connection is not counted again
+    // in the total
+    const size_t total_size = payload->queued_refs ? 0 : payload->size;
+    return !queue_limits_exceeded(&anjay->observe.queue_limits_per_connection,
+                                  conn_state->unsent_count + 1,
+                                  conn_state->unsent_bytes + payload->size)
+            && !queue_limits_exceeded(&anjay->observe.queue_limits_total,
+                                      anjay->observe.unsent_count + 1,
+                                      anjay->observe.unsent_bytes
+                                              + total_size);
+}
+
+static inline bool
+is_droppable_value(const anjay_observe_resource_value_t *value) {
+    return !value->in_flight && !is_error_value(value);
+}
+
+/**
+ * Returns pointer to the oldest droppable unsent value that refers to
+ * @p entry, or to any entry if @p entry is NULL.
+ */
+static AVS_LIST(anjay_observe_resource_value_t) *
+find_droppable_value_ptr(anjay_observe_connection_entry_t *conn_state,
+                         const anjay_observe_entry_t *entry) {
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr;
+    AVS_LIST_FOREACH_PTR(value_ptr, &conn_state->unsent) {
+        if ((!entry || (*value_ptr)->ref == entry)
+                && is_droppable_value(*value_ptr)) {
+            return value_ptr;
+        }
+    }
+    return NULL;
+}
+
+static void
+drop_unsent_value(anjay_t *anjay,
+                  anjay_observe_connection_entry_t *conn_state,
+                  AVS_LIST(anjay_observe_resource_value_t) *value_ptr) {
+    assert(is_droppable_value(*value_ptr));
+    delete_unsent_value(anjay, conn_state, value_ptr);
+    ++anjay->observe.stats.values_dropped;
+}
+
+/**
+ * Drops unsent values of @p conn_state according to the configured policy,
+ * until a new value of @p entry, with @p payload, fits within the queue
+ * limits.
+ *
+ * @returns true if the new value may be stored, false otherwise.
+ */
+static bool make_room_in_queue(anjay_t *anjay,
+                               anjay_observe_connection_entry_t *conn_state,
+                               const anjay_observe_entry_t *entry,
+                               const anjay_observe_payload_t *payload) {
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr;
+    switch (anjay->observe.queue_policy) {
+    case ANJAY_NOTIFY_QUEUE_DROP_OLDEST:
+        while (!fits_in_queue(anjay, conn_state, payload)
+                && ((value_ptr = find_droppable_value_ptr(conn_state, entry))
+                        || (value_ptr = find_droppable_value_ptr(conn_state,
+                                                                 NULL)))) {
+            drop_unsent_value(anjay, conn_state, value_ptr);
+        }
+        break;
+    case ANJAY_NOTIFY_QUEUE_KEEP_LATEST:
+        value_ptr = &conn_state->unsent;
+        while (!fits_in_queue(anjay, conn_state, payload) && *value_ptr) {
+            if (is_droppable_value(*value_ptr)
+                    && ((*value_ptr)->ref == entry
+                            || (*value_ptr)->ref->last_unsent != *value_ptr)) {
+                drop_unsent_value(anjay, conn_state, value_ptr);
+            } else {
+                AVS_LIST_ADVANCE_PTR(&value_ptr);
+            }
+        }
+        break;
+    case ANJAY_NOTIFY_QUEUE_REJECT:
+        break;
+    }
+    return fits_in_queue(anjay, conn_state, payload);
+}
+
+static void
+append_unsent_value(anjay_t *anjay,
+                    anjay_observe_connection_entry_t *conn_state,
+                    AVS_LIST(anjay_observe_resource_value_t) res_value) {
+    AVS_LIST_APPEND(&conn_state->unsent_last, res_value);
+    conn_state->unsent_last = res_value;
+    if (!conn_state->unsent) {
+        conn_state->unsent = res_value;
+    }
+    res_value->ref->last_unsent = res_value;
+    ++conn_state->unsent_count;
+    conn_state->unsent_bytes += res_value->payload->size;
+    charge_queued_payload(&anjay->observe, res_value->payload);
+}
+
+static int insert_new_value(anjay_t *anjay,
+                            anjay_observe_connection_entry_t *conn_state,
                             anjay_observe_entry_t *entry,
                             const anjay_msg_details_t *details,
                             const avs_coap_msg_identity_t *identity,
                             double numeric,
-                            const void *data,
-                            size_t size) {
+                            anjay_observe_payload_t *payload) {
+    // error values cancel the observation, so they are always stored
+    if (avs_coap_msg_code_get_class(details->msg_code) < 4
+            && !make_room_in_queue(anjay, conn_state, entry, payload)) {
+        anjay_log(WARNING, "Notification queue full, dropping new value of %s "
+                  "(SSID %" PRIu16 ")",
+                  ANJAY_DEBUG_MAKE_PATH(&MAKE_INSTANCE_OR_RESOURCE_PATH(
+                          entry->key.oid, entry->key.iid, entry->key.rid)),
+                  entry->key.connection.ssid);
+        ++anjay->observe.stats.values_dropped;
+        return 0;
+    }
     AVS_LIST(anjay_observe_resource_value_t) res_value =
-            create_resource_value(details, entry, identity,
-                                  numeric, data, size);
+            create_resource_value(details, entry, identity, numeric, payload);
     if (!res_value) {
         return -1;
     }
-    AVS_LIST_APPEND(&conn_state->unsent_last, res_value);
-    conn_state->unsent_last = res_value;
-    if (!conn_state->unsent) {
-        conn_state->unsent = res_value;
-    }
-    entry->last_unsent = res_value;
+    append_unsent_value(anjay, conn_state, res_value);
     return 0;
 }
 
@@ -296,8 +671,14 @@ static int insert_error(anjay_t *anjay,
         .msg_code = _anjay_make_error_response_code(outer_result),
         .format = AVS_COAP_FORMAT_NONE
     };
-    return insert_new_value(conn_state, entry, &details, identity,
-                            NAN, NULL, 0);
+    anjay_observe_payload_t *payload = _anjay_observe_create_payload(NULL, 0);
+    if (!payload) {
+        return -1;
+    }
+    int result = insert_new_value(anjay, conn_state, entry, &details,
+                                  identity, NAN, payload);
+    release_payload(&payload);
+    return result;
 }
 
 static int get_effective_attrs(anjay_t *anjay,
@@ -343,12 +724,40 @@ static int get_effective_attrs(anjay_t *anjay,
     return _anjay_dm_effective_attrs(anjay, &details, out_attrs);
 }
 
+void _anjay_observe_invalidate_attrs(anjay_t *anjay) {
+    ++anjay->observe.attrs_generation;
+}
+
+static int get_entry_attrs(anjay_t *anjay,
+                           anjay_dm_internal_res_attrs_t *out_attrs,
+                           const anjay_dm_object_def_t *const *obj,
+                           anjay_observe_entry_t *entry) {
+    if (!anjay->observe.cache_attrs) {
+        return get_effective_attrs(anjay, out_attrs, obj, &entry->key);
+    }
+    if (entry->attrs_generation != anjay->observe.attrs_generation) {
+        int result = get_effective_attrs(anjay, &entry->attrs, obj,
+                                         &entry->key);
+        if (result) {
+            return result;
+        }
+        entry->attrs_generation = anjay->observe.attrs_generation;
+    }
+    *out_attrs = entry->attrs;
+    return 0;
+}
+
 static inline int get_attrs(anjay_t *anjay,
                             anjay_dm_internal_res_attrs_t *out_attrs,
-                            const anjay_observe_key_t *key) {
+                            anjay_observe_entry_t *entry) {
+    if (anjay->observe.cache_attrs
+            && entry->attrs_generation == anjay->observe.attrs_generation) {
+        *out_attrs = entry->attrs;
+        return 0;
+    }
     const anjay_dm_object_def_t *const *obj =
-            _anjay_dm_find_object_by_oid(anjay, key->oid);
-    return get_effective_attrs(anjay, out_attrs, obj, key);
+            _anjay_dm_find_object_by_oid(anjay, entry->key.oid);
+    return get_entry_attrs(anjay, out_attrs, obj, entry);
 }
 
 int _anjay_observe_schedule_trigger(anjay_t *anjay,
@@ -356,7 +765,7 @@ int _anjay_observe_schedule_trigger(anjay_t *anjay,
     anjay_dm_internal_res_attrs_t attrs;
     int result;
 
-    (void)((result = get_attrs(anjay, &attrs, &entry->key))
+    (void)((result = get_attrs(anjay, &attrs, entry))
             || (result = schedule_trigger(anjay, entry,
                                           attrs.standard.common.max_period)));
 
@@ -378,20 +787,26 @@ static int insert_initial_value(
     avs_time_real_t now = avs_time_real_now();
 
     int result = -1;
+    anjay_observe_payload_t *payload =
+            _anjay_observe_create_payload(data, size);
     // we assume that the initial value should be treated as sent,
     // even though we haven't actually sent it ourselves
-    if ((entry->last_sent = create_resource_value(details, entry, identity,
-                                                  numeric, data, size))
+    if (payload
+            && (entry->last_sent = create_resource_value(details, entry,
+                                                         identity, numeric,
+                                                         payload))
             && !(result = _anjay_observe_schedule_trigger(anjay, entry))) {
         entry->last_confirmable = now;
     } else {
         clear_entry(anjay, conn_state, entry);
     }
+    release_payload(&payload);
     return result;
 }
 
 static AVS_RBTREE_ELEM(anjay_observe_entry_t)
-find_or_create_observe_entry(anjay_observe_connection_entry_t *connection,
+find_or_create_observe_entry(anjay_t *anjay,
+                             anjay_observe_connection_entry_t *connection,
                              const anjay_observe_key_t *key) {
     AVS_RBTREE_ELEM(anjay_observe_entry_t) new_entry =
             AVS_RBTREE_ELEM_NEW(anjay_observe_entry_t);
@@ -406,6 +821,9 @@ find_or_create_observe_entry(anjay_observe_connection_entry_t *connection,
             AVS_RBTREE_INSERT(connection->entries, new_entry);
     if (entry != new_entry) {
         AVS_RBTREE_ELEM_DELETE_DETACHED(&new_entry);
+    } else if (_anjay_observe_index_add(&anjay->observe, entry)) {
+        AVS_RBTREE_DELETE_ELEM(connection->entries, &entry);
+        return NULL;
     }
     return entry;
 }
@@ -445,7 +863,7 @@ int _anjay_observe_put_entry(anjay_t *anjay,
     }
 
     AVS_RBTREE_ELEM(anjay_observe_entry_t) entry =
-            find_or_create_observe_entry(conn, key);
+            find_or_create_observe_entry(anjay, conn, key);
     if (!entry) {
         delete_connection_if_empty(anjay, &conn);
         return -1;
@@ -459,6 +877,7 @@ int _anjay_observe_put_entry(anjay_t *anjay,
     }
 
     anjay_log(ERROR, "Could not put OBSERVE entry");
+    _anjay_observe_index_remove(&anjay->observe, entry);
     AVS_RBTREE_DELETE_ELEM(conn->entries, &entry);
     delete_connection_if_empty(anjay, &conn);
     return result;
@@ -469,6 +888,7 @@ delete_entry(anjay_t *anjay,
              AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) *conn_ptr,
              AVS_RBTREE_ELEM(anjay_observe_entry_t) *entry_ptr) {
     clear_entry(anjay, *conn_ptr, *entry_ptr);
+    _anjay_observe_index_remove(&anjay->observe, *entry_ptr);
     AVS_RBTREE_DELETE_ELEM((*conn_ptr)->entries, entry_ptr);
     delete_connection_if_empty(anjay, conn_ptr);
 }
@@ -558,8 +978,8 @@ static bool should_update(const anjay_observe_resource_value_t *previous,
                           const char *data,
                           size_t length) {
     if (details->format == previous->details.format
-            && length == previous->value_length
-            && memcmp(data, previous->value, length) == 0) {
+            && length == previous->payload->size
+            && memcmp(data, previous->payload->data, length) == 0) {
         return false;
     }
 
@@ -576,20 +996,70 @@ static bool should_update(const anjay_observe_resource_value_t *previous,
             || process_ltgt(previous, attrs->greater_than, numeric);
 }
 
-static inline ssize_t read_new_value(anjay_t *anjay,
-                                     const anjay_dm_object_def_t *const *obj,
-                                     const anjay_observe_entry_t *entry,
-                                     anjay_msg_details_t *out_details,
-                                     double *out_numeric,
-                                     char *buffer,
-                                     size_t size) {
+static void cache_read(anjay_t *anjay,
+                       const anjay_observe_read_cache_entry_t *query,
+                       const anjay_msg_details_t *details,
+                       double numeric,
+                       anjay_observe_payload_t *payload) {
+    AVS_RBTREE_ELEM(anjay_observe_read_cache_entry_t) cached =
+            AVS_RBTREE_ELEM_NEW(anjay_observe_read_cache_entry_t);
+    if (!cached) {
+        // not an error - the value just won't be shared
+        anjay_log(WARNING, "Out of memory, cannot cache value of %s",
+                  ANJAY_DEBUG_MAKE_PATH(&MAKE_INSTANCE_OR_RESOURCE_PATH(
+                          query->oid, query->iid, query->rid)));
+        return;
+    }
+    *cached = *query;
+    cached->details = *details;
+    cached->numeric = numeric;
+    cached->payload = ref_payload(payload);
+    // read_new_value() looked the path up before reading, so it is not there
+    AVS_RBTREE_INSERT(anjay->observe.read_cache, cached);
+}
+
+/**
+ * Reads the current value for @p entry. Values read during a single scheduler
+ * run are cached, so if multiple entries (in different connections) observe the
+ * same path in the same format, the data model is only queried once.
+ *
+ * @returns 0 on success, in which case @p *out_payload is set to a new
+ *          reference that shall be released by the caller, or a negative
+ *          error code.
+ */
+static int read_new_value(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj,
+                          const anjay_observe_entry_t *entry,
+                          anjay_msg_details_t *out_details,
+                          double *out_numeric,
+                          anjay_observe_payload_t **out_payload) {
+    const anjay_observe_read_cache_entry_t query = {
+        // results of the read may differ between servers only because of
+        // access control
+        .ssid = _anjay_access_control_required(anjay)
+                ? entry->key.connection.ssid : ANJAY_SSID_ANY,
+        .oid = entry->key.oid,
+        .iid = entry->key.iid,
+        .rid = entry->key.rid,
+        .format = entry->key.format
+    };
+    const anjay_observe_read_cache_entry_t *cached =
+            AVS_RBTREE_FIND(anjay->observe.read_cache, &query);
+    if (cached) {
+        *out_details = cached->details;
+        *out_numeric = cached->numeric;
+        *out_payload = ref_payload(cached->payload);
+        return 0;
+    }
+
     anjay_uri_path_type_t path_type = ANJAY_PATH_OBJECT;
     if (entry->key.rid >= 0) {
         path_type = ANJAY_PATH_RESOURCE;
     } else if (entry->key.iid != ANJAY_IID_INVALID) {
         path_type = ANJAY_PATH_INSTANCE;
     }
-    return _anjay_dm_read_for_observe(
+    char buf[ANJAY_MAX_OBSERVABLE_RESOURCE_SIZE];
+    ssize_t size = _anjay_dm_read_for_observe(
             anjay, obj,
             &(const anjay_dm_read_args_t) {
                 .ssid = entry->key.connection.ssid,
@@ -601,7 +1071,15 @@ static inline ssize_t read_new_value(anjay_t *anjay,
                 },
                 .requested_format = entry->key.format,
                 .observe_serial = true
-            }, out_details, out_numeric, buffer, size);
+            }, out_details, out_numeric, buf, sizeof(buf));
+    if (size < 0) {
+        return (int) size;
+    }
+    if (!(*out_payload = _anjay_observe_create_payload(buf, (size_t) size))) {
+        return -1;
+    }
+    cache_read(anjay, &query, out_details, *out_numeric, *out_payload);
+    return 0;
 }
 
 static int get_conn_ref(anjay_t *anjay,
@@ -648,36 +1126,99 @@ static bool confirmable_required(const avs_time_real_t now,
             avs_time_duration_from_scalar(1, AVS_TIME_DAY));
 }
 
-static anjay_observe_resource_value_t *
-detach_first_unsent_value(anjay_observe_connection_entry_t *conn_state) {
-    assert(conn_state->unsent);
-    anjay_observe_entry_t *entry = conn_state->unsent->ref;
-    if (entry->last_unsent == conn_state->unsent) {
-        entry->last_unsent = NULL;
+static AVS_LIST(anjay_observe_resource_value_t) *
+find_in_flight_ptr(anjay_observe_connection_entry_t *conn_state,
+                   uint16_t msg_id) {
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr;
+    AVS_LIST_FOREACH_PTR(value_ptr, &conn_state->unsent) {
+        if ((*value_ptr)->in_flight
+                && (*value_ptr)->identity.msg_id == msg_id) {
+            return value_ptr;
+        }
     }
-    anjay_observe_resource_value_t *result =
-            AVS_LIST_DETACH(&conn_state->unsent);
-    if (conn_state->unsent_last == result) {
-        assert(!conn_state->unsent);
-        conn_state->unsent_last = NULL;
+    return NULL;
+}
+
+static AVS_LIST(anjay_observe_resource_value_t) *
+next_value_to_send_ptr(anjay_observe_connection_entry_t *conn_state) {
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr;
+    AVS_LIST_FOREACH_PTR(value_ptr, &conn_state->unsent) {
+        if (!(*value_ptr)->in_flight) {
+            return value_ptr;
+        }
     }
-    return result;
+    return NULL;
 }
 
-static void value_sent(anjay_observe_connection_entry_t *conn_state) {
-    anjay_observe_resource_value_t *sent =
-            detach_first_unsent_value(conn_state);
+static void value_sent(anjay_t *anjay,
+                       anjay_observe_connection_entry_t *conn_state,
+                       anjay_observe_resource_value_t *sent) {
     anjay_observe_entry_t *entry = sent->ref;
+    // with more than one notification in flight, acknowledgements may arrive
+    // out of order - older values of the same resource are obsolete by now
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr = &conn_state->unsent;
+    while (*value_ptr != sent) {
+        assert(*value_ptr);
+        if ((*value_ptr)->ref == entry) {
+            delete_unsent_value(anjay, conn_state, value_ptr);
+        } else {
+            AVS_LIST_ADVANCE_PTR(&value_ptr);
+        }
+    }
+    detach_unsent_value(anjay, conn_state, value_ptr);
     assert(AVS_LIST_SIZE(entry->last_sent) <= 1);
-    AVS_LIST_CLEAR(&entry->last_sent);
+    clear_resource_values(&entry->last_sent);
     entry->last_sent = sent;
 }
 
 static int sched_flush_send_queue(anjay_t *anjay,
                                   anjay_observe_connection_entry_t *conn);
 
+static anjay_coap_async_handler_t confirmable_notification_finished;
+
+static int finish_notification(anjay_t *anjay,
+                               anjay_observe_connection_entry_t *conn_state,
+                               avs_coap_msg_type_t msg_type,
+                               bool *out_in_flight) {
+    *out_in_flight = false;
+    const avs_coap_msg_t *msg = NULL;
+    int result = _anjay_coap_stream_build_request(anjay->comm_stream, &msg);
+    if (result < 0) {
+        return result;
+    }
+
+    // size of a block-wise transfer is not known at this point, so only the
+    // packet itself is accounted for
+    size_t msg_size = 0;
+    if (result == ANJAY_COAP_STREAM_BLOCKWISE) {
+        // block-wise transfer has already been started - the stream needs to
+        // handle it synchronously
+        result = avs_stream_finish_message(anjay->comm_stream);
+    } else if (msg_type == AVS_COAP_MSG_CONFIRMABLE) {
+        msg_size = msg->length;
+        // don't wait for the Acknowledgement, it will be handled in
+        // anjay_serve()
+        if (!(result = _anjay_coap_async_send(
+                anjay, conn_state->key, msg,
+                confirmable_notification_finished))) {
+            *out_in_flight = true;
+        }
+    } else {
+        msg_size = msg->length;
+        result = avs_stream_finish_message(anjay->comm_stream);
+    }
+
+    if (!result) {
+        ++anjay->observe.stats.packets_sent;
+        anjay->observe.stats.bytes_sent += msg_size;
+    }
+    return result;
+}
+
 static int send_entry(anjay_t *anjay,
-                      anjay_observe_connection_entry_t *conn_state) {
+                      anjay_observe_connection_entry_t *conn_state,
+                      anjay_observe_resource_value_t *value,
+                      bool *out_in_flight) {
     int result;
     anjay_connection_ref_t ref;
     if ((result = get_conn_ref(anjay, &ref,
@@ -687,10 +1228,10 @@ static int send_entry(anjay_t *anjay,
         return result;
     }
     anjay_server_info_t *server = anjay->current_connection.server;
-    assert(conn_state->unsent);
-    anjay_observe_entry_t *entry = conn_state->unsent->ref;
-    const avs_coap_msg_identity_t *id = &conn_state->unsent->identity;
-    anjay_msg_details_t details = conn_state->unsent->details;
+    assert(value && !value->in_flight);
+    anjay_observe_entry_t *entry = value->ref;
+    const avs_coap_msg_identity_t *id = &value->identity;
+    anjay_msg_details_t details = value->details;
     avs_coap_msg_identity_t notify_id;
 
     avs_time_real_t now = avs_time_real_now();
@@ -702,19 +1243,24 @@ static int send_entry(anjay_t *anjay,
     (void) ((result = _anjay_coap_stream_setup_request(
                     anjay->comm_stream, &details, &id->token))
             || (result = avs_stream_write(anjay->comm_stream,
-                                          conn_state->unsent->value,
-                                          conn_state->unsent->value_length))
+                                          value->payload->data,
+                                          value->payload->size))
             || (result = _anjay_coap_stream_get_request_identity(
                     anjay->comm_stream, &notify_id))
-            || (result = avs_stream_finish_message(anjay->comm_stream)));
+            || (result = finish_notification(anjay, conn_state,
+                                             details.msg_type, out_in_flight)));
 
     _anjay_release_server_stream(anjay);
 
-    if (!result) {
+    if (!result && *out_in_flight) {
+        value->in_flight = true;
+        value->identity.msg_id = notify_id.msg_id;
+        ++conn_state->in_flight_count;
+    } else if (!result) {
         if (details.msg_type == AVS_COAP_MSG_CONFIRMABLE) {
             entry->last_confirmable = now;
         }
-        value_sent(conn_state);
+        value_sent(anjay, conn_state, value);
         entry->last_sent->identity.msg_id = notify_id.msg_id;
     } else if (result == AVS_COAP_CTX_ERR_NETWORK
             || result == AVS_COAP_CTX_ERR_TIMEOUT) {
@@ -774,25 +1320,34 @@ static observe_server_state_t server_state(anjay_t *anjay, anjay_ssid_t ssid) {
     return result;
 }
 
-static inline bool is_error_value(const anjay_observe_resource_value_t *value) {
-    return avs_coap_msg_code_get_class(value->details.msg_code) >= 4;
-}
-
-static void remove_all_unsent_values(anjay_observe_connection_entry_t *conn) {
-    while (conn->unsent) {
-        AVS_LIST(anjay_observe_resource_value_t) value =
-                detach_first_unsent_value(conn);
-        AVS_LIST_DELETE(&value);
+/**
+ * Removes all values that have not been sent yet. Notifications that are
+ * already in flight are left intact.
+ */
+static void remove_all_unsent_values(anjay_t *anjay,
+                                     anjay_observe_connection_entry_t *conn) {
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr = &conn->unsent;
+    while (*value_ptr) {
+        if ((*value_ptr)->in_flight) {
+            AVS_LIST_ADVANCE_PTR(&value_ptr);
+        } else {
+            delete_unsent_value(anjay, conn, value_ptr);
+        }
     }
 }
 
 static int handle_send_queue_entry(anjay_t *anjay,
                                    anjay_observe_connection_entry_t *conn_state,
+                                   anjay_observe_resource_value_t *value,
                                    observe_server_state_t observe_state) {
-    assert(conn_state->unsent);
     assert(observe_state.server_active);
-    bool is_error = is_error_value(conn_state->unsent);
-    int result = send_entry(anjay, conn_state);
+    bool is_error = is_error_value(value);
+    bool in_flight = false;
+    int result = send_entry(anjay, conn_state, value, &in_flight);
+    if (!result && in_flight) {
+        // the outcome will be handled in confirmable_notification_finished()
+        return 0;
+    }
     if (result > 0) {
         anjay_log(INFO, "Reset received as reply to notification, result == %d",
                   result);
@@ -801,7 +1356,7 @@ static int handle_send_queue_entry(anjay_t *anjay,
                   result);
         if (result != AVS_COAP_CTX_ERR_NETWORK
                 && !observe_state.notification_storing_enabled) {
-            remove_all_unsent_values(conn_state);
+            remove_all_unsent_values(anjay, conn_state);
         }
     }
     if (is_error
@@ -822,7 +1377,7 @@ static void schedule_all_triggers(anjay_t *anjay,
     AVS_RBTREE_FOREACH(entry, conn->entries) {
         if (!entry->notify_task) {
             anjay_dm_internal_res_attrs_t attrs;
-            if (get_attrs(anjay, &attrs, &entry->key)
+            if (get_attrs(anjay, &attrs, entry)
                     || schedule_trigger(anjay, entry,
                                         attrs.standard.common.max_period)) {
                 anjay_log(ERROR,
@@ -837,9 +1392,20 @@ static void flush_send_queue(anjay_t *anjay,
                              const observe_server_state_t *observe_state) {
     int result = 0;
     observe_server_state_t observe_state_buf;
-
-    while (result >= 0 && conn && conn->unsent) {
-        anjay_observe_key_t key = conn->unsent->ref->key;
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr;
+
+    while (result >= 0 && conn
+            && conn->in_flight_count < anjay->observe.max_in_flight
+            && (value_ptr = next_value_to_send_ptr(conn))) {
+        if (anjay->observe.coalesce_notifications
+                && (*value_ptr)->ref->last_unsent != *value_ptr) {
+            // a newer value for the same observation is due as well, so only
+            // that one will be sent
+            delete_unsent_value(anjay, conn, value_ptr);
+            ++anjay->observe.stats.values_coalesced;
+            continue;
+        }
+        anjay_observe_key_t key = (*value_ptr)->ref->key;
         if (!observe_state) {
             observe_state_buf = server_state(anjay, key.connection.ssid);
             observe_state = &observe_state_buf;
@@ -847,7 +1413,7 @@ static void flush_send_queue(anjay_t *anjay,
                 break;
             }
         }
-        if ((result = handle_send_queue_entry(anjay, conn,
+        if ((result = handle_send_queue_entry(anjay, conn, *value_ptr,
                                               *observe_state)) > 0) {
             _anjay_observe_remove_entry(anjay, &key);
             // the above might've deleted the connection entry,
@@ -883,6 +1449,153 @@ static int sched_flush_send_queue(anjay_t *anjay,
     return 0;
 }
 
+/**
+ * Queues the values restored into @p conn->unsent again, subject to the
+ * configured queue limits and overflow policy, as if they were notified anew.
+ */
+static void enqueue_restored_values(anjay_t *anjay,
+                                    anjay_observe_connection_entry_t *conn) {
+    AVS_LIST(anjay_observe_resource_value_t) restored = conn->unsent;
+    conn->unsent = NULL;
+    conn->unsent_last = NULL;
+    conn->unsent_count = 0;
+    conn->unsent_bytes = 0;
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry;
+    AVS_RBTREE_FOREACH(entry, conn->entries) {
+        entry->last_unsent = NULL;
+    }
+
+    while (restored) {
+        AVS_LIST(anjay_observe_resource_value_t) value =
+                AVS_LIST_DETACH(&restored);
+        if (is_error_value(value)
+                || make_room_in_queue(anjay, conn, value->ref,
+                                      value->payload)) {
+            append_unsent_value(anjay, conn, value);
+        } else {
+            anjay_log(WARNING, "Notification queue full, dropping restored "
+                      "value of %s (SSID %" PRIu16 ")",
+                      ANJAY_DEBUG_MAKE_PATH(&MAKE_INSTANCE_OR_RESOURCE_PATH(
+                              value->ref->key.oid, value->ref->key.iid,
+                              value->ref->key.rid)),
+                      conn->key.ssid);
+            ++anjay->observe.stats.values_dropped;
+            delete_resource_value(&value);
+        }
+    }
+}
+
+int _anjay_observe_replace_connections(
+        anjay_t *anjay,
+        AVS_RBTREE(anjay_observe_connection_entry_t) *connections_ptr) {
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn;
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry;
+    AVS_RBTREE_FOREACH(conn, *connections_ptr) {
+        AVS_RBTREE_FOREACH(entry, conn->entries) {
+            if (_anjay_observe_index_add(&anjay->observe, entry)) {
+                // entries that have not been added are simply not found
+                AVS_RBTREE_FOREACH(conn, *connections_ptr) {
+                    AVS_RBTREE_FOREACH(entry, conn->entries) {
+                        _anjay_observe_index_remove(&anjay->observe, entry);
+                    }
+                }
+                return -1;
+            }
+        }
+    }
+
+    while ((conn = AVS_RBTREE_FIRST(anjay->observe.connection_entries))) {
+        delete_connection(anjay, &conn);
+    }
+    AVS_RBTREE_DELETE(&anjay->observe.connection_entries);
+    anjay->observe.connection_entries = *connections_ptr;
+    *connections_ptr = NULL;
+
+    AVS_RBTREE_FOREACH(conn, anjay->observe.connection_entries) {
+        enqueue_restored_values(anjay, conn);
+        AVS_RBTREE_FOREACH(entry, conn->entries) {
+            if (_anjay_observe_schedule_trigger(anjay, entry)) {
+                anjay_log(ERROR,
+                          "Could not schedule automatic notification trigger");
+            }
+        }
+        if (conn->unsent) {
+            sched_flush_send_queue(anjay, conn);
+        }
+    }
+    return 0;
+}
+
+static void
+confirmable_notification_finished(anjay_t *anjay,
+                                  anjay_connection_key_t key,
+                                  uint16_t msg_id,
+                                  anjay_coap_async_result_t result,
+                                  const avs_coap_msg_t *response) {
+    (void) response;
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn =
+            AVS_RBTREE_FIND(anjay->observe.connection_entries,
+                            connection_query(&key));
+    AVS_LIST(anjay_observe_resource_value_t) *value_ptr = NULL;
+    if (!conn || !(value_ptr = find_in_flight_ptr(conn, msg_id))) {
+        anjay_log(DEBUG, "notification id = %" PRIu16 " no longer in flight",
+                  msg_id);
+        return;
+    }
+
+    anjay_observe_resource_value_t *value = *value_ptr;
+    anjay_observe_entry_t *entry = value->ref;
+    const anjay_observe_key_t observe_key = entry->key;
+    bool remove_entry = false;
+    bool flush = true;
+    switch (result) {
+    case ANJAY_COAP_ASYNC_ACKED:
+        remove_entry = is_error_value(value);
+        entry->last_confirmable = avs_time_real_now();
+        value_sent(anjay, conn, value);
+        break;
+    case ANJAY_COAP_ASYNC_RESET:
+        anjay_log(INFO, "Reset received as reply to notification id = %" PRIu16,
+                  msg_id);
+        remove_entry = true;
+        break;
+    case ANJAY_COAP_ASYNC_TIMEOUT:
+    case ANJAY_COAP_ASYNC_NETWORK_ERROR: {
+        anjay_log(ERROR, "Could not deliver Observe notification id = %" PRIu16,
+                  msg_id);
+        // the rest of the queue will be flushed after reconnecting
+        flush = false;
+        anjay_server_info_t *server =
+                _anjay_servers_find_active(anjay, key.ssid);
+        if (server) {
+            _anjay_schedule_server_reconnect(anjay, server);
+        }
+        // the value will be sent again, unless it is to be dropped
+        value->in_flight = false;
+        --conn->in_flight_count;
+        if (result == ANJAY_COAP_ASYNC_TIMEOUT
+                && !server_state(anjay, key.ssid)
+                        .notification_storing_enabled) {
+            remove_entry = is_error_value(value);
+            remove_all_unsent_values(anjay, conn);
+        }
+        break;
+    }
+    }
+
+    if (remove_entry) {
+        _anjay_observe_remove_entry(anjay, &observe_key);
+        // the above might've deleted the connection entry
+        conn = AVS_RBTREE_FIND(anjay->observe.connection_entries,
+                               connection_query(&key));
+    }
+    if (flush) {
+        // this may be called from within anjay_serve(), while the stream is
+        // bound, so the rest of the queue can only be flushed from a job
+        sched_flush_send_queue(anjay, conn);
+    }
+}
+
 int _anjay_observe_sched_flush_current_connection(anjay_t *anjay) {
     const anjay_connection_key_t query_key = {
         .ssid = _anjay_dm_current_ssid(anjay),
@@ -916,20 +1629,19 @@ update_notification_value(anjay_t *anjay,
     }
 
     anjay_dm_internal_res_attrs_t attrs;
-    int result = get_effective_attrs(anjay, &attrs, obj, &entry->key);
+    int result = get_entry_attrs(anjay, &attrs, obj, entry);
     if (result) {
         return result;
     }
 
     bool pmax_expired = has_pmax_expired(newest_value(entry),
                                          &attrs.standard.common);
-    char buf[ANJAY_MAX_OBSERVABLE_RESOURCE_SIZE];
     anjay_msg_details_t observe_details;
     double numeric = NAN;
-    ssize_t size = read_new_value(anjay, obj, entry, &observe_details, &numeric,
-                                  buf, sizeof(buf));
-    if (size < 0) {
-        return (int) size;
+    anjay_observe_payload_t *payload = NULL;
+    if ((result = read_new_value(anjay, obj, entry, &observe_details, &numeric,
+                                 &payload))) {
+        return result;
     }
 #ifdef WITH_CON_ATTR
     if (attrs.custom.data.con >= 0) {
@@ -944,11 +1656,12 @@ update_notification_value(anjay_t *anjay,
 
     if (pmax_expired || should_update(newest_value(entry), &attrs.standard,
                                       &observe_details, numeric,
-                                      buf, (size_t) size)) {
-        result = insert_new_value(conn_state, entry, &observe_details,
+                                      payload->data, payload->size)) {
+        result = insert_new_value(anjay, conn_state, entry, &observe_details,
                                   &newest_value(entry)->identity, numeric,
-                                  buf, (size_t) size);
+                                  payload);
     }
+    release_payload(&payload);
 
     if (schedule_trigger(anjay, entry, attrs.standard.common.max_period)) {
         anjay_log(ERROR, "Could not schedule automatic notification trigger");
@@ -986,7 +1699,7 @@ static inline int notify_entry(anjay_t *anjay,
                                anjay_observe_entry_t *entry) {
     anjay_dm_internal_res_attrs_t attrs = ANJAY_DM_INTERNAL_RES_ATTRS_EMPTY;
     int32_t period = 0;
-    if (!get_effective_attrs(anjay, &attrs, obj, &entry->key)
+    if (!get_entry_attrs(anjay, &attrs, obj, entry)
             && attrs.standard.common.min_period > 0) {
         period = attrs.standard.common.min_period;
     }
@@ -997,69 +1710,49 @@ static inline int notify_entry(anjay_t *anjay,
 #include "test/observe_mock.h"
 #endif // ANJAY_TEST
 
-static int observe_notify_bound(anjay_t *anjay,
-                                anjay_observe_connection_entry_t *connection,
-                                const anjay_observe_key_t *lower_bound,
-                                const anjay_observe_key_t *upper_bound,
-                                const anjay_dm_object_def_t *const *obj) {
-    int retval = 0;
-    AVS_RBTREE_ELEM(anjay_observe_entry_t) it =
-            AVS_RBTREE_LOWER_BOUND(connection->entries,
-                                   _anjay_observe_entry_query(lower_bound));
-    AVS_RBTREE_ELEM(anjay_observe_entry_t) end =
-            AVS_RBTREE_UPPER_BOUND(connection->entries,
-                                   _anjay_observe_entry_query(upper_bound));
-    // if it == NULL, end must also be NULL
-    assert(it || !end);
-
-    for (; it != end; it = AVS_RBTREE_ELEM_NEXT(it)) {
-        assert(it);
-        _anjay_update_ret(&retval, notify_entry(anjay, obj, it));
-    }
-    return retval;
+typedef struct {
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) begin;
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) end;
+} path_range_t;
+
+#define MAX_PATH_RANGES 3
+
+static path_range_t find_path_range(anjay_t *anjay,
+                                    anjay_oid_t oid,
+                                    anjay_iid_t lower_iid,
+                                    int32_t lower_rid,
+                                    anjay_iid_t upper_iid,
+                                    int32_t upper_rid) {
+    const anjay_observe_path_entry_t lower_bound = {
+        .oid = oid,
+        .iid = lower_iid,
+        .rid = lower_rid
+    };
+    const anjay_observe_path_entry_t upper_bound = {
+        .oid = oid,
+        .iid = upper_iid,
+        .rid = upper_rid
+    };
+    path_range_t result = {
+        .begin = AVS_RBTREE_LOWER_BOUND(anjay->observe.path_index,
+                                        &lower_bound),
+        .end = AVS_RBTREE_UPPER_BOUND(anjay->observe.path_index, &upper_bound)
+    };
+    // if begin == NULL, end must also be NULL
+    assert(result.begin || !result.end);
+    return result;
 }
 
-static int
-observe_notify_wildcard_impl(anjay_t *anjay,
-                             anjay_observe_connection_entry_t *connection,
-                             const anjay_observe_key_t *specimen_key,
-                             const anjay_dm_object_def_t *const *obj,
-                             bool iid_wildcard) {
-    anjay_observe_key_t lower_bound = *specimen_key;
-    anjay_observe_key_t upper_bound = *specimen_key;
-    lower_bound.format = 0;
-    upper_bound.format = UINT16_MAX;
-    if (iid_wildcard) {
-        lower_bound.iid = ANJAY_IID_INVALID;
-        upper_bound.iid = ANJAY_IID_INVALID;
-    }
-    lower_bound.rid = -1;
-    upper_bound.rid = -1;
-    return observe_notify_bound(anjay, connection,
-                                &lower_bound, &upper_bound, obj);
-}
-
-static inline int
-observe_notify_iid_wildcard(anjay_t *anjay,
-                            anjay_observe_connection_entry_t *connection,
-                            const anjay_observe_key_t *specimen_key,
-                            const anjay_dm_object_def_t *const *obj) {
-    return observe_notify_wildcard_impl(anjay, connection,
-                                        specimen_key, obj, true);
-}
-
-static inline int
-observe_notify_rid_wildcard(anjay_t *anjay,
-                            anjay_observe_connection_entry_t *connection,
-                            const anjay_observe_key_t *specimen_key,
-                            const anjay_dm_object_def_t *const *obj) {
-    return observe_notify_wildcard_impl(anjay, connection,
-                                        specimen_key, obj, false);
+static inline path_range_t find_path(anjay_t *anjay,
+                                     anjay_oid_t oid,
+                                     anjay_iid_t iid,
+                                     int32_t rid) {
+    return find_path_range(anjay, oid, iid, rid, iid, rid);
 }
 
 /**
- * Calls <c>notify_entry()</c> on all registered Observe entries that match
- * <c>key</c>.
+ * Finds all path index entries that match <c>key</c>, and returns them as
+ * a list of ranges, in order in which they shall be notified.
  *
  * This is harder than may seem at the first glance, because both <c>key</c>
  * (the query) and keys of the registered Observe entries may contain wildcards.
@@ -1068,130 +1761,250 @@ observe_notify_rid_wildcard(anjay_t *anjay,
  * - A whole object (OID)
  * - A whole object instance (OID+IID)
  * - A specific resource (OID+IID+RID)
- * Each of those may also have either explicit or implicit Content-Format, so in
- * the end, there are six types of observation entry keys:
- * - OID
- * - OID+format
- * - OID+IID
- * - OID+IID+format
- * - OID+IID+RID
- * - OID+IID+RID+format
  *
  * The query is guaranteed to never have an explicit Content-Format
- * specification (and we <c>assert()</c> that), but still, we have three
- * possible types of those:
+ * specification, but still, we have three possible types of those:
  * - OID
  * - OID+IID
  * - OID+IID+RID
  *
- * Each of these cases needs to be addressed in a slightly different manner.
- *
- * Wildcard representation
- * -----------------------
  * A wildcard for IID is represented as the number 65535. A wildcard for RID is
- * represented as the number -1. The registered observation entries are stored
- * in a sorted tree, with the sort key being (SSID, conn_type, OID, IID, RID,
- * Content-Format) - in lexicographical order over all elements of that tuple -
- * much like C++11's <c>std::tuple</c> comparison operators.
+ * represented as the number -1. The path index is sorted by (OID, IID, RID), in
+ * lexicographical order over all elements of that tuple.
  *
  * Querying for just OID
  * ---------------------
- * It is sufficient to search for the whole range of possible keys that match
- * (SSID, conn_type, OID). We will find all entries, including those registered
- * for OID, OID+IID and OID+IID+RID.
- *
- * So the lower bound for search is (SSID, conn_type, OID, 0, I32_MIN, 0) and
- * the upper bound is (SSID, conn_type, OID, U16_MAX, I32_MAX, U16_MAX). All
- * entries within this inclusive range will be notified.
+ * All paths within the range (OID, 0, I32_MIN) - (OID, U16_MAX, I32_MAX)
+ * match, including those registered for OID, OID+IID and OID+IID+RID.
  *
  * Querying for OID+IID
  * --------------------
- * With the fixed IID, in a similar manner, we set the lower bound for search to
- * (SSID, conn_type, OID, IID, I32_MIN, 0) and the upper bound to
- * (SSID, conn_type, OID, IID, I32_MAX, U16_MAX). This covers entries registered
- * for OID+IID and OID+IID+RID keys, but the entries registered on a wildcard
- * IID will get omitted, as 65535 is not equal to the specified IID.
- *
- * Because of this, we need to call notification on an additional range with the
- * lower bound set to (SSID, conn_type, OID, 65535, I32_MIN, 0) and the upper
- * bound to (SSID, conn_type, OID, 65535, I32_MAX, U16_MAX).
+ * The entries registered for the whole object, i.e. path (OID, 65535, -1),
+ * match. So do all paths within the range (OID, IID, I32_MIN) -
+ * (OID, IID, I32_MAX), which covers entries registered for OID+IID and
+ * OID+IID+RID keys.
  *
  * Querying for OID+IID+RID
  * ------------------------
- * Similarly, the natural query for OID+IID+RID, with the lower bound set to
- * (SSID, conn_type, OID, IID, RID, 0) and the upper bound to
- * (SSID, conn_type, OID, IID, RID, U16_MAX), will miss all the wildcards.
- *
- * We also need to notify the OID+IID entries (with wildcard RID), so we do
- * another search, with the lower bound at (SSID, conn_type, OID, IID, -1, 0)
- * and the upper bound at (SSID, conn_type, OID, IID, -1, U16_MAX).
+ * Three paths match: (OID, IID, -1) for the observations of the whole instance,
+ * (OID, 65535, -1) for the whole object, and (OID, IID, RID) itself.
  *
- * We also need to notify the OID entries (with wildcard IID and RID), so we do
- * yet another search, with lower bound at (SSID, conn_type, OID, 65535, -1, 0)
- * and the upper bound at (SSID, conn_type, OID, 65535, -1, U16_MAX).
+ * @returns Number of ranges written to @p out_ranges, or 0 if nothing in the
+ *          object designated by <c>key->oid</c> is observed at all.
  */
-static int observe_notify(anjay_t *anjay,
-                          anjay_observe_connection_entry_t *connection,
-                          const anjay_observe_key_t *key,
-                          const anjay_dm_object_def_t *const *obj) {
-    assert(key->format == AVS_COAP_FORMAT_NONE);
-    assert(!obj || !*obj || (*obj)->oid == key->oid);
-    assert(key->rid >= -1 && key->rid <= UINT16_MAX);
-
-    int retval = 0;
+static size_t find_path_ranges(anjay_t *anjay,
+                               const anjay_observe_key_t *key,
+                               path_range_t out_ranges[MAX_PATH_RANGES]) {
+    const anjay_observe_path_entry_t object_start = {
+        .oid = key->oid,
+        .iid = 0,
+        .rid = INT32_MIN
+    };
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) first =
+            AVS_RBTREE_LOWER_BOUND(anjay->observe.path_index, &object_start);
+    if (!first || first->oid != key->oid) {
+        return 0;
+    }
 
-    anjay_observe_key_t lower_bound = *key;
-    anjay_observe_key_t upper_bound = *key;
-    lower_bound.format = 0;
-    upper_bound.format = UINT16_MAX;
+    size_t num_ranges = 0;
     if (key->rid < 0) {
-        lower_bound.rid = INT32_MIN;
-        upper_bound.rid = INT32_MAX;
         if (key->iid == ANJAY_IID_INVALID) {
-            lower_bound.iid = 0;
-            upper_bound.iid = ANJAY_IID_INVALID;
+            out_ranges[num_ranges++] =
+                    find_path_range(anjay, key->oid, 0, INT32_MIN,
+                                    ANJAY_IID_INVALID, INT32_MAX);
         } else {
-            _anjay_update_ret(&retval,
-                              observe_notify_iid_wildcard(anjay, connection,
-                                                          key, obj));
+            out_ranges[num_ranges++] =
+                    find_path(anjay, key->oid, ANJAY_IID_INVALID, -1);
+            out_ranges[num_ranges++] =
+                    find_path_range(anjay, key->oid, key->iid, INT32_MIN,
+                                    key->iid, INT32_MAX);
         }
     } else {
-        _anjay_update_ret(&retval,
-                          observe_notify_rid_wildcard(anjay, connection,
-                                                      key, obj));
-        _anjay_update_ret(&retval,
-                          observe_notify_iid_wildcard(anjay, connection,
-                                                      key, obj));
+        out_ranges[num_ranges++] = find_path(anjay, key->oid, key->iid, -1);
+        out_ranges[num_ranges++] =
+                find_path(anjay, key->oid, ANJAY_IID_INVALID, -1);
+        out_ranges[num_ranges++] =
+                find_path(anjay, key->oid, key->iid, key->rid);
+    }
+    assert(num_ranges <= MAX_PATH_RANGES);
+    return num_ranges;
+}
+
+/**
+ * Path index entry whose references are being merged by
+ * _anjay_observe_notify(). The entries are kept in a binary min-heap, ordered
+ * by the connection currently pointed to by the entry's cursor, and then by
+ * <c>order</c>, i.e. the position of the entry within the matching ranges.
+ */
+typedef struct {
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) path;
+    size_t order;
+} path_cursor_t;
+
+static const anjay_connection_key_t *
+path_cursor_connection(const path_cursor_t *cursor) {
+    return &(*cursor->path->cursor)->key.connection;
+}
+
+static bool path_cursor_before(const path_cursor_t *left,
+                               const path_cursor_t *right) {
+    int cmp = connection_key_cmp(path_cursor_connection(left),
+                                 path_cursor_connection(right));
+    return cmp < 0 || (cmp == 0 && left->order < right->order);
+}
+
+static void path_heap_push(path_cursor_t *heap,
+                           size_t *heap_size,
+                           path_cursor_t cursor) {
+    size_t index = (*heap_size)++;
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!path_cursor_before(&cursor, &heap[parent])) {
+            break;
+        }
+        heap[index] = heap[parent];
+        index = parent;
     }
+    heap[index] = cursor;
+}
 
-    _anjay_update_ret(&retval,
-                      observe_notify_bound(anjay, connection, &lower_bound,
-                                           &upper_bound, obj));
-    return retval;
+static path_cursor_t path_heap_pop(path_cursor_t *heap, size_t *heap_size) {
+    assert(*heap_size > 0);
+    const path_cursor_t result = heap[0];
+    const path_cursor_t last = heap[--*heap_size];
+    size_t index = 0;
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= *heap_size) {
+            break;
+        }
+        if (child + 1 < *heap_size
+                && path_cursor_before(&heap[child + 1], &heap[child])) {
+            ++child;
+        }
+        if (!path_cursor_before(&heap[child], &last)) {
+            break;
+        }
+        heap[index] = heap[child];
+        index = child;
+    }
+    if (*heap_size > 0) {
+        heap[index] = last;
+    }
+    return result;
+}
+
+/**
+ * Resets the cursors of all path index entries in @p ranges and builds a heap
+ * of those that are referenced by any Observe entry. If there are none,
+ * @p *out_heap is set to NULL.
+ */
+static int build_path_heap(const path_range_t *ranges,
+                           size_t num_ranges,
+                           path_cursor_t **out_heap,
+                           size_t *out_heap_size) {
+    *out_heap = NULL;
+    *out_heap_size = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < num_ranges; ++i) {
+        AVS_RBTREE_ELEM(anjay_observe_path_entry_t) it;
+        for (it = ranges[i].begin; it != ranges[i].end;
+                it = AVS_RBTREE_ELEM_NEXT(it)) {
+            if ((it->cursor = it->refs)) {
+                ++count;
+            }
+        }
+    }
+    if (!count) {
+        return 0;
+    }
+
+    path_cursor_t *heap =
+            (path_cursor_t *) avs_malloc(count * sizeof(path_cursor_t));
+    if (!heap) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    size_t order = 0;
+    for (size_t i = 0; i < num_ranges; ++i) {
+        AVS_RBTREE_ELEM(anjay_observe_path_entry_t) it;
+        for (it = ranges[i].begin; it != ranges[i].end;
+                it = AVS_RBTREE_ELEM_NEXT(it)) {
+            if (it->cursor) {
+                path_heap_push(heap, out_heap_size, (path_cursor_t) {
+                    .path = it,
+                    .order = order++
+                });
+            }
+        }
+    }
+    *out_heap = heap;
+    return 0;
 }
 
+/**
+ * Calls <c>notify_entry()</c> on all registered Observe entries that match
+ * <c>key</c>, using the path index, so that no work is done for connections
+ * that do not observe anything relevant.
+ *
+ * The entries are notified in the same order as if each connection was
+ * processed separately: connection by connection, and within each connection,
+ * range by range, in order returned by <c>find_path_ranges()</c>. To achieve
+ * that, the reference lists of all matching paths, each sorted by connection,
+ * are merged using a heap (see <c>path_cursor_t</c>).
+ */
 int _anjay_observe_notify(anjay_t *anjay,
                           const anjay_observe_key_t *key,
                           bool invert_server_match) {
     assert(key->format == AVS_COAP_FORMAT_NONE);
+    assert(key->rid >= -1 && key->rid <= UINT16_MAX);
+
+    path_range_t ranges[MAX_PATH_RANGES];
+    const size_t num_ranges = find_path_ranges(anjay, key, ranges);
+    if (!num_ranges) {
+        return 0;
+    }
+    // some of the values read earlier may be outdated now
+    _anjay_observe_read_cache_clear(&anjay->observe);
+
     const anjay_dm_object_def_t *const *obj =
             _anjay_dm_find_object_by_oid(anjay, key->oid);
+    assert(!obj || !*obj || (*obj)->oid == key->oid);
 
-    // iterate through all SSIDs we have
-    int result = 0;
-    anjay_observe_key_t modified_key = *key;
-    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) connection;
-    AVS_RBTREE_FOREACH(connection, anjay->observe.connection_entries) {
+    path_cursor_t *heap;
+    size_t heap_size;
+    int result = build_path_heap(ranges, num_ranges, &heap, &heap_size);
+    if (result) {
+        return result;
+    }
+
+    while (heap_size) {
+        const anjay_connection_key_t connection =
+                *path_cursor_connection(&heap[0]);
         /* Some compilers complain about promotion of comparison result, so
          * we're casting it to bool explicitly */
-        if ((bool)(connection->key.ssid == key->connection.ssid)
-                == invert_server_match) {
-            continue;
-        }
-        modified_key.connection = connection->key;
-        _anjay_update_ret(&result, observe_notify(anjay, connection,
-                                                  &modified_key, obj));
+        const bool matches = ((bool) (connection.ssid == key->connection.ssid)
+                              != invert_server_match);
+        do {
+            path_cursor_t cursor = path_heap_pop(heap, &heap_size);
+            while (cursor.path->cursor
+                    && !connection_key_cmp(path_cursor_connection(&cursor),
+                                           &connection)) {
+                if (matches) {
+                    _anjay_update_ret(&result,
+                                      notify_entry(anjay, obj,
+                                                   *cursor.path->cursor));
+                }
+                cursor.path->cursor = AVS_LIST_NEXT(cursor.path->cursor);
+            }
+            if (cursor.path->cursor) {
+                path_heap_push(heap, &heap_size, cursor);
+            }
+        } while (heap_size
+                 && !connection_key_cmp(path_cursor_connection(&heap[0]),
+                                        &connection));
     }
+    avs_free(heap);
     return result;
 }
 
@@ -47,20 +47,69 @@ _anjay_new_observe_stream(anjay_msg_details_t *details) {
 typedef struct anjay_observe_entry_struct anjay_observe_entry_t;
 typedef struct anjay_observe_connection_entry_struct
         anjay_observe_connection_entry_t;
+typedef struct anjay_observe_path_entry_struct anjay_observe_path_entry_t;
+typedef struct anjay_observe_read_cache_entry_struct
+        anjay_observe_read_cache_entry_t;
+
+typedef struct {
+    uint64_t packets_sent;
+    uint64_t bytes_sent;
+    uint64_t values_coalesced;
+    uint64_t values_dropped;
+} anjay_observe_stats_t;
 
 typedef struct {
     AVS_RBTREE(anjay_observe_connection_entry_t) connection_entries;
+    // reverse index of all entries in connection_entries, by observed path
+    AVS_RBTREE(anjay_observe_path_entry_t) path_index;
     bool confirmable_notifications;
+    size_t max_in_flight;
+    bool coalesce_notifications;
+    anjay_observe_stats_t stats;
+    // if true, anjay_observe_entry_t::attrs is used to cache the effective
+    // attributes; the cached values are valid only if attrs_generation of the
+    // entry is equal to the one below
+    bool cache_attrs;
+    uint64_t attrs_generation;
+    // values read from the data model during the current scheduler run,
+    // shared between entries that observe the same path in the same format;
+    // keyed by (ssid, oid, iid, rid, format)
+    AVS_RBTREE(anjay_observe_read_cache_entry_t) read_cache;
+    // limits of anjay_observe_connection_entry_t::unsent, and their sum
+    anjay_notify_queue_limits_t queue_limits_per_connection;
+    anjay_notify_queue_limits_t queue_limits_total;
+    anjay_notify_queue_policy_t queue_policy;
+    // number of values in all send queues, and total size of their distinct
+    // payloads
+    size_t unsent_count;
+    size_t unsent_bytes;
 } anjay_observe_state_t;
 
+/**
+ * Encoded notification payload. A single payload may be referenced by values
+ * of multiple entries, if they observe the same path in the same format.
+ */
+typedef struct {
+    size_t refcount;
+    // number of values in the send queues of all connections that reference
+    // this payload; it is counted in anjay_observe_state_t::unsent_bytes once
+    // for all of them
+    size_t queued_refs;
+    size_t size;
+    char data[1]; // actually a FAM
+} anjay_observe_payload_t;
+
 typedef struct {
     anjay_observe_entry_t *ref;
     anjay_msg_details_t details;
     avs_coap_msg_identity_t identity;
+    // true if the value has been sent as a Confirmable notification and is
+    // waiting for the Acknowledgement; identity.msg_id is its Message ID
+    bool in_flight;
     avs_time_real_t timestamp;
     double numeric;
-    const size_t value_length;
-    char value[1]; // actually a FAM
+    // never NULL; holds a reference
+    anjay_observe_payload_t *payload;
 } anjay_observe_resource_value_t;
 
 typedef struct {
@@ -72,11 +121,23 @@ typedef struct {
 } anjay_observe_key_t;
 
 int _anjay_observe_init(anjay_observe_state_t *observe,
-                        bool confirmable_notifications);
+                        bool confirmable_notifications,
+                        size_t max_in_flight,
+                        bool coalesce_notifications,
+                        bool cache_attrs,
+                        const anjay_notify_queue_limits_t *conn_queue_limits,
+                        const anjay_notify_queue_limits_t *total_queue_limits,
+                        anjay_notify_queue_policy_t queue_policy);
 
 void _anjay_observe_cleanup(anjay_observe_state_t *observe,
                             anjay_sched_t *sched);
 
+/**
+ * Drops all values cached by _anjay_observe_read_cache_*. Shall be called after
+ * each scheduler run, so that values are never shared across runs.
+ */
+void _anjay_observe_read_cache_clear(anjay_observe_state_t *observe);
+
 int _anjay_observe_put_entry(anjay_t *anjay,
                              const anjay_observe_key_t *key,
                              const anjay_msg_details_t *details,
@@ -103,11 +164,16 @@ int _anjay_observe_notify(anjay_t *anjay,
 anjay_output_ctx_t *_anjay_observe_decorate_ctx(anjay_output_ctx_t *backend,
                                                 double *out_numeric);
 
+int _anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out);
+
+int _anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in);
+
 
 #else // WITH_OBSERVE
 
 #define _anjay_observe_init(...) 0
 #define _anjay_observe_cleanup(...) ((void) 0)
+#define _anjay_observe_read_cache_clear(...) ((void) 0)
 #define _anjay_observe_sched_flush_current_connection(...) 0
 #define _anjay_observe_sched_flush(...) 0
 #define _anjay_observe_persist(...) 0
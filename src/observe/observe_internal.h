@@ -17,6 +17,8 @@
 #ifndef ANJAY_OBSERVE_INTERNAL_H
 #define ANJAY_OBSERVE_INTERNAL_H
 
+#include <anjay_modules/dm/attributes.h>
+
 #include "observe_core.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -37,6 +39,10 @@ struct anjay_observe_entry_struct {
     // (depending on whether the last unsent value in the server refers
     // to this resource+format or not)
     AVS_LIST(anjay_observe_resource_value_t) last_unsent;
+
+    // cached effective attributes, see anjay_observe_state_t::cache_attrs
+    anjay_dm_internal_res_attrs_t attrs;
+    uint64_t attrs_generation;
 };
 
 struct anjay_observe_connection_entry_struct {
@@ -47,6 +53,43 @@ struct anjay_observe_connection_entry_struct {
     AVS_LIST(anjay_observe_resource_value_t) unsent;
     // pointer to the last element of unsent
     AVS_LIST(anjay_observe_resource_value_t) unsent_last;
+
+    // number of elements of unsent that have the in_flight flag set;
+    // no more than anjay_observe_state_t::max_in_flight
+    size_t in_flight_count;
+
+    // number of elements of unsent and total size of their payloads
+    size_t unsent_count;
+    size_t unsent_bytes;
+};
+
+struct anjay_observe_path_entry_struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    int32_t rid;
+
+    // all entries observing this exact path, in all connections;
+    // sorted in the same order as anjay_observe_connection_entry_t::entries,
+    // so that entries of a single connection are always adjacent
+    AVS_LIST(anjay_observe_entry_t *) refs;
+
+    // iteration state, only meaningful during _anjay_observe_notify()
+    AVS_LIST(anjay_observe_entry_t *) cursor;
+};
+
+struct anjay_observe_read_cache_entry_struct {
+    // ANJAY_SSID_ANY if the value may be shared between all servers, i.e. if
+    // no access control is in effect
+    anjay_ssid_t ssid;
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    int32_t rid;
+    uint16_t format;
+
+    anjay_msg_details_t details;
+    double numeric;
+    // holds a reference
+    anjay_observe_payload_t *payload;
 };
 
 static inline const anjay_observe_entry_t *
@@ -60,10 +103,36 @@ void _anjay_observe_cleanup_connection(anjay_sched_t *sched,
 int _anjay_observe_key_cmp(const anjay_observe_key_t *left,
                            const anjay_observe_key_t *right);
 int _anjay_observe_entry_cmp(const void *left, const void *right);
+int _anjay_observe_connection_entry_cmp(const void *left, const void *right);
+
+/**
+ * Allocates a payload with a reference count of 1. If @p data is NULL, the
+ * contents are left uninitialized.
+ */
+anjay_observe_payload_t *_anjay_observe_create_payload(const void *data,
+                                                       size_t size);
+
+int _anjay_observe_index_add(anjay_observe_state_t *observe,
+                             anjay_observe_entry_t *entry);
+
+void _anjay_observe_index_remove(anjay_observe_state_t *observe,
+                                 const anjay_observe_entry_t *entry);
 
 int _anjay_observe_schedule_trigger(anjay_t *anjay,
                                     anjay_observe_entry_t *entry);
 
+/**
+ * Replaces all Observe entries with the ones in @p connections_ptr, which
+ * shall be fully initialized except for the path index, queue accounting and
+ * scheduler jobs. Values in the unsent queues are queued again, subject to the
+ * configured queue limits and overflow policy. On success, the tree is taken
+ * over and *connections_ptr is set to NULL. On failure, the current state is
+ * left intact.
+ */
+int _anjay_observe_replace_connections(
+        anjay_t *anjay,
+        AVS_RBTREE(anjay_observe_connection_entry_t) *connections_ptr);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* ANJAY_OBSERVE_INTERNAL_H */
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+#ifdef WITH_AVS_PERSISTENCE
+#include <avsystem/commons/persistence.h>
+#endif // WITH_AVS_PERSISTENCE
+
+#include "../anjay_core.h"
+
+#include "observe_internal.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_AVS_PERSISTENCE
+
+static const char MAGIC[] = { 'O', 'B', 'S', '\1' };
+
+static int handle_time(avs_persistence_context_t *ctx, avs_time_real_t *time) {
+    uint64_t seconds = (uint64_t) time->since_real_epoch.seconds;
+    uint32_t seconds_hi = (uint32_t) (seconds >> 32);
+    uint32_t seconds_lo = (uint32_t) seconds;
+    uint32_t nanoseconds = (uint32_t) time->since_real_epoch.nanoseconds;
+    int retval;
+    (void) ((retval = avs_persistence_u32(ctx, &seconds_hi))
+            || (retval = avs_persistence_u32(ctx, &seconds_lo))
+            || (retval = avs_persistence_u32(ctx, &nanoseconds)));
+    if (!retval && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        seconds = ((uint64_t) seconds_hi << 32) | seconds_lo;
+        time->since_real_epoch.seconds = (int64_t) seconds;
+        time->since_real_epoch.nanoseconds = (int32_t) nanoseconds;
+    }
+    return retval;
+}
+
+static int handle_path(avs_persistence_context_t *ctx,
+                       anjay_observe_key_t *key) {
+    uint32_t rid = (uint32_t) key->rid;
+    int retval;
+    (void) ((retval = avs_persistence_u16(ctx, &key->oid))
+            || (retval = avs_persistence_u16(ctx, &key->iid))
+            || (retval = avs_persistence_u32(ctx, &rid))
+            || (retval = avs_persistence_u16(ctx, &key->format)));
+    if (!retval && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        key->rid = (int32_t) rid;
+        if (key->rid < -1 || key->rid > UINT16_MAX) {
+            anjay_log(ERROR, "invalid Resource ID in persisted Observe entry");
+            retval = -1;
+        }
+    }
+    return retval;
+}
+
+static int handle_value(avs_persistence_context_t *ctx,
+                        anjay_observe_resource_value_t *value) {
+    const bool restore =
+            (avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE);
+    uint8_t msg_type = (uint8_t) value->details.msg_type;
+    uint32_t payload_size = 0;
+    if (!restore) {
+        payload_size = (uint32_t) value->payload->size;
+        if (payload_size != value->payload->size) {
+            return -1;
+        }
+    }
+
+    avs_coap_token_t *token = &value->identity.token;
+    int retval;
+    (void) ((retval = avs_persistence_bytes(ctx, &msg_type, 1))
+            || (retval = avs_persistence_bytes(ctx, &value->details.msg_code,
+                                               1))
+            || (retval = avs_persistence_u16(ctx, &value->details.format))
+            || (retval = avs_persistence_bool(ctx,
+                                              &value->details.observe_serial))
+            || (retval = avs_persistence_u16(ctx, &value->identity.msg_id))
+            || (retval = avs_persistence_bytes(ctx, &token->size, 1))
+            || (retval = (token->size > AVS_COAP_MAX_TOKEN_LENGTH ? -1 : 0))
+            || (retval = avs_persistence_bytes(ctx, (uint8_t *) token->bytes,
+                                               token->size))
+            || (retval = handle_time(ctx, &value->timestamp))
+            || (retval = avs_persistence_double(ctx, &value->numeric))
+            || (retval = avs_persistence_u32(ctx, &payload_size)));
+    if (retval) {
+        return retval;
+    }
+    if (restore) {
+        const int code_class =
+                avs_coap_msg_code_get_class(value->details.msg_code);
+        if (msg_type != AVS_COAP_MSG_CONFIRMABLE
+                && msg_type != AVS_COAP_MSG_NON_CONFIRMABLE) {
+            anjay_log(ERROR, "invalid message type in persisted notification");
+            return -1;
+        }
+        if (code_class != 2 && code_class != 4 && code_class != 5) {
+            anjay_log(ERROR, "invalid message code in persisted notification");
+            return -1;
+        }
+        // values are never read into buffers larger than that
+        if (payload_size > ANJAY_MAX_OBSERVABLE_RESOURCE_SIZE) {
+            anjay_log(ERROR, "persisted notification payload too large: %"
+                      PRIu32 " B", payload_size);
+            return -1;
+        }
+        value->details.msg_type = (avs_coap_msg_type_t) msg_type;
+        if (!(value->payload =
+                _anjay_observe_create_payload(NULL, payload_size))) {
+            return -1;
+        }
+    }
+    return avs_persistence_bytes(ctx, (uint8_t *) value->payload->data,
+                                 value->payload->size);
+}
+
+static int persist_entry(avs_persistence_context_t *ctx,
+                         anjay_observe_entry_t *entry) {
+    anjay_observe_key_t key = entry->key;
+    int retval;
+    (void) ((retval = handle_path(ctx, &key))
+            || (retval = handle_time(ctx, &entry->last_confirmable))
+            || (retval = handle_value(ctx, entry->last_sent)));
+    return retval;
+}
+
+static int persist_connection(avs_persistence_context_t *ctx,
+                              anjay_observe_connection_entry_t *conn) {
+    uint32_t type = (uint32_t) conn->key.type;
+    uint32_t num_entries = (uint32_t) AVS_RBTREE_SIZE(conn->entries);
+    uint32_t num_unsent = (uint32_t) AVS_LIST_SIZE(conn->unsent);
+    int retval;
+    if ((retval = avs_persistence_u16(ctx, &conn->key.ssid))
+            || (retval = avs_persistence_u32(ctx, &type))
+            || (retval = avs_persistence_u32(ctx, &num_entries))) {
+        return retval;
+    }
+
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry;
+    AVS_RBTREE_FOREACH(entry, conn->entries) {
+        if ((retval = persist_entry(ctx, entry))) {
+            return retval;
+        }
+    }
+
+    if ((retval = avs_persistence_u32(ctx, &num_unsent))) {
+        return retval;
+    }
+    // notifications in flight are persisted as not yet sent
+    AVS_LIST(anjay_observe_resource_value_t) value;
+    AVS_LIST_FOREACH(value, conn->unsent) {
+        anjay_observe_key_t key = value->ref->key;
+        if ((retval = handle_path(ctx, &key))
+                || (retval = handle_value(ctx, value))) {
+            return retval;
+        }
+    }
+    return 0;
+}
+
+int _anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out) {
+    int retval = avs_stream_write(out, MAGIC, sizeof(MAGIC));
+    if (retval) {
+        return retval;
+    }
+    avs_persistence_context_t *ctx = avs_persistence_store_context_new(out);
+    if (!ctx) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+
+    uint32_t num_connections =
+            (uint32_t) AVS_RBTREE_SIZE(anjay->observe.connection_entries);
+    if (!(retval = avs_persistence_u32(ctx, &num_connections))) {
+        AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn;
+        AVS_RBTREE_FOREACH(conn, anjay->observe.connection_entries) {
+            if ((retval = persist_connection(ctx, conn))) {
+                break;
+            }
+        }
+    }
+    if (!retval) {
+        anjay_log(INFO, "Observe state persisted");
+    }
+    avs_persistence_context_delete(ctx);
+    return retval;
+}
+
+static int restore_value(avs_persistence_context_t *ctx,
+                         anjay_observe_entry_t *entry,
+                         AVS_LIST(anjay_observe_resource_value_t) *out_value) {
+    AVS_LIST(anjay_observe_resource_value_t) value =
+            AVS_LIST_NEW_ELEMENT(anjay_observe_resource_value_t);
+    if (!value) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    value->ref = entry;
+    int retval = handle_value(ctx, value);
+    if (retval) {
+        // the payload, if any, is not shared with anything yet
+        avs_free(value->payload);
+        AVS_LIST_CLEAR(&value);
+        return retval;
+    }
+    *out_value = value;
+    return 0;
+}
+
+static int restore_entry(avs_persistence_context_t *ctx,
+                         anjay_observe_connection_entry_t *conn) {
+    anjay_observe_key_t key;
+    memset(&key, 0, sizeof(key));
+    key.connection = conn->key;
+    int retval = handle_path(ctx, &key);
+    if (retval) {
+        return retval;
+    }
+
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry =
+            AVS_RBTREE_ELEM_NEW(anjay_observe_entry_t);
+    if (!entry) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    memcpy((void *) (intptr_t) (const void *) &entry->key, &key, sizeof(key));
+    if (AVS_RBTREE_INSERT(conn->entries, entry) != entry) {
+        anjay_log(ERROR, "duplicate persisted Observe entry");
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
+        return -1;
+    }
+
+    // the entry is now owned by conn, so it is cleaned up along with it
+    (void) ((retval = handle_time(ctx, &entry->last_confirmable))
+            || (retval = restore_value(ctx, entry, &entry->last_sent)));
+    return retval;
+}
+
+static int restore_unsent_value(avs_persistence_context_t *ctx,
+                                anjay_observe_connection_entry_t *conn) {
+    anjay_observe_key_t key;
+    memset(&key, 0, sizeof(key));
+    key.connection = conn->key;
+    int retval = handle_path(ctx, &key);
+    if (retval) {
+        return retval;
+    }
+
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry =
+            AVS_RBTREE_FIND(conn->entries, _anjay_observe_entry_query(&key));
+    if (!entry) {
+        anjay_log(ERROR, "persisted notification refers to a nonexistent "
+                  "Observe entry");
+        return -1;
+    }
+
+    AVS_LIST(anjay_observe_resource_value_t) value;
+    if ((retval = restore_value(ctx, entry, &value))) {
+        return retval;
+    }
+    // queue limits are applied when the values are installed, see
+    // _anjay_observe_replace_connections()
+    AVS_LIST_APPEND(&conn->unsent_last, value);
+    conn->unsent_last = value;
+    if (!conn->unsent) {
+        conn->unsent = value;
+    }
+    return 0;
+}
+
+static int restore_connection(
+        avs_persistence_context_t *ctx,
+        AVS_RBTREE(anjay_observe_connection_entry_t) connections) {
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn =
+            AVS_RBTREE_ELEM_NEW(anjay_observe_connection_entry_t);
+    if (!conn || !(conn->entries = AVS_RBTREE_NEW(anjay_observe_entry_t,
+                                                  _anjay_observe_entry_cmp))) {
+        anjay_log(ERROR, "Out of memory");
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&conn);
+        return -1;
+    }
+
+    uint32_t type;
+    int retval;
+    (void) ((retval = avs_persistence_u16(ctx, &conn->key.ssid))
+            || (retval = avs_persistence_u32(ctx, &type)));
+    if (!retval && (type < ANJAY_CONNECTION_FIRST_VALID_
+                        || type >= ANJAY_CONNECTION_LIMIT_)) {
+        anjay_log(ERROR, "invalid connection type in persisted Observe state");
+        retval = -1;
+    }
+    if (!retval) {
+        conn->key.type = (anjay_connection_type_t) type;
+        if (AVS_RBTREE_INSERT(connections, conn) != conn) {
+            anjay_log(ERROR, "duplicate persisted Observe connection");
+            retval = -1;
+        }
+    }
+    if (retval) {
+        _anjay_observe_cleanup_connection(NULL, conn);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&conn);
+        return retval;
+    }
+
+    // the connection is now owned by connections
+    uint32_t count;
+    if (!(retval = avs_persistence_u32(ctx, &count))) {
+        while (!retval && count--) {
+            retval = restore_entry(ctx, conn);
+        }
+    }
+    if (!retval && !(retval = avs_persistence_u32(ctx, &count))) {
+        while (!retval && count--) {
+            retval = restore_unsent_value(ctx, conn);
+        }
+    }
+    return retval;
+}
+
+int _anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in) {
+    char magic_header[sizeof(MAGIC)];
+    int retval = avs_stream_read_reliably(in,
+                                          magic_header, sizeof(magic_header));
+    if (retval) {
+        anjay_log(ERROR, "magic constant not found");
+        return retval;
+    }
+    if (memcmp(magic_header, MAGIC, sizeof(MAGIC))) {
+        anjay_log(ERROR, "header magic constant mismatch");
+        return -1;
+    }
+
+    avs_persistence_context_t *ctx = avs_persistence_restore_context_new(in);
+    AVS_RBTREE(anjay_observe_connection_entry_t) connections =
+            AVS_RBTREE_NEW(anjay_observe_connection_entry_t,
+                           _anjay_observe_connection_entry_cmp);
+    retval = -1;
+    uint32_t num_connections;
+    if (!ctx || !connections) {
+        anjay_log(ERROR, "Out of memory");
+    } else if (!(retval = avs_persistence_u32(ctx, &num_connections))) {
+        while (!retval && num_connections--) {
+            retval = restore_connection(ctx, connections);
+        }
+    }
+    if (!retval
+            && !(retval = _anjay_observe_replace_connections(anjay,
+                                                             &connections))) {
+        anjay_log(INFO, "Observe state restored");
+    }
+
+    if (connections) {
+        // no scheduler jobs are ever created for entries that are not
+        // installed, hence the NULL scheduler
+        AVS_RBTREE_DELETE(&connections) {
+            _anjay_observe_cleanup_connection(NULL, *connections);
+        }
+    }
+    avs_persistence_context_delete(ctx);
+    return retval;
+}
+
+#else // WITH_AVS_PERSISTENCE
+
+int _anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out) {
+    (void) anjay; (void) out;
+    anjay_log(ERROR, "Persistence not compiled in");
+    return -1;
+}
+
+int _anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in) {
+    (void) anjay; (void) in;
+    anjay_log(ERROR, "Persistence not compiled in");
+    return -1;
+}
+
+#endif // WITH_AVS_PERSISTENCE
@@ -20,8 +20,11 @@
 #include <math.h>
 #include <stdarg.h>
 
+#include <avsystem/commons/stream/stream_membuf.h>
 #include <avsystem/commons/unit/test.h>
 
+#include <anjay/stats.h>
+
 #include <anjay_test/dm.h>
 #include <anjay_test/mock_clock.h>
 
@@ -42,6 +45,21 @@ static void assert_observe_size(anjay_t *anjay, size_t sz) {
         result += local_size;
     }
     AVS_UNIT_ASSERT_EQUAL(result, sz);
+
+    // the path index shall always refer to exactly the same entries
+    size_t indexed = 0;
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) path;
+    AVS_RBTREE_FOREACH(path, anjay->observe.path_index) {
+        AVS_UNIT_ASSERT_NOT_NULL(path->refs);
+        AVS_LIST(anjay_observe_entry_t *) ref;
+        AVS_LIST_FOREACH(ref, path->refs) {
+            AVS_UNIT_ASSERT_EQUAL((*ref)->key.oid, path->oid);
+            AVS_UNIT_ASSERT_EQUAL((*ref)->key.iid, path->iid);
+            AVS_UNIT_ASSERT_EQUAL((*ref)->key.rid, path->rid);
+            ++indexed;
+        }
+    }
+    AVS_UNIT_ASSERT_EQUAL(indexed, sz);
 }
 
 static void assert_msg_details_equal(const anjay_msg_details_t *a,
@@ -85,8 +103,9 @@ static void assert_observe(anjay_t *anjay,
     AVS_UNIT_ASSERT_NULL(entity->last_unsent);
     AVS_UNIT_ASSERT_NOT_NULL(entity->last_sent);
     assert_msg_details_equal(&entity->last_sent->details, details);
-    AVS_UNIT_ASSERT_EQUAL(entity->last_sent->value_length, length);
-    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(entity->last_sent->value, data, length);
+    AVS_UNIT_ASSERT_EQUAL(entity->last_sent->payload->size, length);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(entity->last_sent->payload->data, data,
+                                      length);
 }
 
 static void expect_server_res_read(anjay_t *anjay,
@@ -294,16 +313,16 @@ AVS_UNIT_TEST(observe, cancel_deregister) {
 }
 
 static inline void
-remove_server(AVS_LIST(anjay_server_info_t) *server_ptr) {
+remove_server(anjay_t *anjay, AVS_LIST(anjay_server_info_t) *server_ptr) {
     _anjay_connection_internal_clean_socket(
-            &(*server_ptr)->data_active.udp_connection);
+            anjay, &(*server_ptr)->data_active.udp_connection);
     AVS_LIST_DELETE(server_ptr);
 }
 
 AVS_UNIT_TEST(observe, gc) {
     SUCCESS_TEST(14, 69, 514, 666, 777);
 
-    remove_server(&anjay->servers->servers);
+    remove_server(anjay, &anjay->servers->servers);
 
     _anjay_observe_gc(anjay);
     assert_observe_size(anjay, 4);
@@ -312,7 +331,7 @@ AVS_UNIT_TEST(observe, gc) {
     ASSERT_SUCCESS_TEST_RESULT(666);
     ASSERT_SUCCESS_TEST_RESULT(777);
 
-    remove_server(AVS_LIST_NTH_PTR(&anjay->servers->servers, 3));
+    remove_server(anjay, AVS_LIST_NTH_PTR(&anjay->servers->servers, 3));
 
     _anjay_observe_gc(anjay);
     assert_observe_size(anjay, 3);
@@ -320,7 +339,7 @@ AVS_UNIT_TEST(observe, gc) {
     ASSERT_SUCCESS_TEST_RESULT(514);
     ASSERT_SUCCESS_TEST_RESULT(666);
 
-    remove_server(AVS_LIST_NTH_PTR(&anjay->servers->servers, 1));
+    remove_server(anjay, AVS_LIST_NTH_PTR(&anjay->servers->servers, 1));
 
     _anjay_observe_gc(anjay);
     assert_observe_size(anjay, 2);
@@ -436,8 +455,13 @@ static void notify_max_period_test(const char *con_notify_ack,
                                                          PAYLOAD("Hi!"));
     avs_unit_mocksock_expect_output(mocksocks[0], con_notify_response->content,
                                     con_notify_response->length);
-    avs_unit_mocksock_input(mocksocks[0], con_notify_ack, con_notify_ack_size);
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 1);
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_FIRST(anjay->observe.connection_entries)->in_flight_count, 1);
+
+    // the response is handled asynchronously
+    avs_unit_mocksock_input(mocksocks[0], con_notify_ack, con_notify_ack_size);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
     assert_observe_size(anjay, observe_size_after_ack);
     if (observe_size_after_ack) {
         AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_FIRST(AVS_RBTREE_FIRST(anjay->observe.connection_entries)->entries)->last_confirmable.since_real_epoch.seconds,
@@ -517,6 +541,68 @@ AVS_UNIT_TEST(notify, min_period) {
     DM_TEST_FINISH;
 }
 
+AVS_UNIT_TEST(notify, min_period_cached_attrs) {
+    static const anjay_dm_internal_res_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 10,
+                .max_period = 365 * 24 * 60 * 60 // a year
+            },
+            .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.cache_observe_attributes = true));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_put_entry(
+            anjay, &(const anjay_observe_key_t) {
+                { 14, ANJAY_CONNECTION_UDP }, 42, 69, 4, AVS_COAP_FORMAT_NONE
+            }, &(const anjay_msg_details_t) {
+                .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = ANJAY_COAP_FORMAT_PLAINTEXT,
+                .observe_serial = true
+            }, &NULL_IDENTITY, 514.0, "514", 3));
+    _anjay_mock_dm_expect_clean();
+    assert_observe_size(anjay, 1);
+
+    ////// PMIN NOT REACHED - ATTRIBUTES ARE CACHED //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(5, AVS_TIME_S));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    ////// PMIN REACHED //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(5, AVS_TIME_S));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hi!"));
+    const avs_coap_msg_t *notify_response = COAP_MSG(NON, CONTENT, ID(0x69ED),
+                                                     OBSERVE(0xF90000),
+                                                     CONTENT_FORMAT(PLAINTEXT),
+                                                     PAYLOAD("Hi!"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 1);
+
+    ////// AFTER INVALIDATION, ATTRIBUTES ARE READ AGAIN //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    _anjay_observe_invalidate_attrs(anjay);
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hi!"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 1);
+
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(notify, confirmable) {
     ////// INITIALIZATION //////
     DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
@@ -552,9 +638,146 @@ AVS_UNIT_TEST(notify, confirmable) {
                                                      PAYLOAD("42"));
     avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
                                     notify_response->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    const avs_coap_msg_t *notify_ack = COAP_MSG(ACK, EMPTY, ID(0x69ED));
+    avs_unit_mocksock_input(mocksocks[0], notify_ack->content,
+                            notify_ack->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, confirmable_retransmission) {
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.confirmable_notifications = true));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_put_entry(
+            anjay, &(const anjay_observe_key_t) {
+                { 14, ANJAY_CONNECTION_UDP }, 42, 69, 4, AVS_COAP_FORMAT_NONE
+            }, &(const anjay_msg_details_t) {
+                .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = ANJAY_COAP_FORMAT_PLAINTEXT,
+                .observe_serial = true
+            }, &(avs_coap_msg_identity_t) {}, 514.0, "514", 3));
+
+    ////// CONFIRMABLE NOTIFICATION //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 42));
+    const avs_coap_msg_t *notify_response = COAP_MSG(CON, CONTENT, ID(0x69ED),
+                                                     OBSERVE(0xF90000),
+                                                     CONTENT_FORMAT(PLAINTEXT),
+                                                     PAYLOAD("42"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    ////// RETRANSMISSION //////
+    // initial ACK timeout is at most ACK_TIMEOUT * ACK_RANDOM_FACTOR = 3s
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(3, AVS_TIME_S));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 1);
+
+    ////// ACKNOWLEDGEMENT //////
     const avs_coap_msg_t *notify_ack = COAP_MSG(ACK, EMPTY, ID(0x69ED));
     avs_unit_mocksock_input(mocksocks[0], notify_ack->content,
                             notify_ack->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_EQUAL(
+            AVS_RBTREE_FIRST(anjay->observe.connection_entries)
+                    ->in_flight_count, 0);
+    AVS_UNIT_ASSERT_NULL(anjay->coap_async.exchanges);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, confirmable_window) {
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.confirmable_notifications = true,
+                          .max_notifications_in_flight = 2));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_put_entry(
+            anjay, &(const anjay_observe_key_t) {
+                { 14, ANJAY_CONNECTION_UDP }, 42, 69, 4, AVS_COAP_FORMAT_NONE
+            }, &(const anjay_msg_details_t) {
+                .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = ANJAY_COAP_FORMAT_PLAINTEXT,
+                .observe_serial = true
+            }, &(avs_coap_msg_identity_t) {}, 514.0, "514", 3));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_put_entry(
+            anjay, &(const anjay_observe_key_t) {
+                { 14, ANJAY_CONNECTION_UDP }, 42, 69, 4,
+                ANJAY_COAP_FORMAT_PLAINTEXT
+            }, &(const anjay_msg_details_t) {
+                .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = ANJAY_COAP_FORMAT_PLAINTEXT,
+                .observe_serial = true
+            }, &(avs_coap_msg_identity_t) {}, 514.0, "514", 3));
+    assert_observe_size(anjay, 2);
+
+    ////// TWO NOTIFICATIONS SENT WITHOUT WAITING //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    const avs_coap_msg_t *notify1 = COAP_MSG(CON, CONTENT, ID(0x69ED),
+                                             OBSERVE(0xF90000),
+                                             CONTENT_FORMAT(PLAINTEXT),
+                                             PAYLOAD("42"));
+    const avs_coap_msg_t *notify2 = COAP_MSG(CON, CONTENT, ID(0x69EE),
+                                             OBSERVE(0xF90000),
+                                             CONTENT_FORMAT(PLAINTEXT),
+                                             PAYLOAD("42"));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 42));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify1->content,
+                                    notify1->length);
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 42));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify2->content,
+                                    notify2->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_FIRST(anjay->observe.connection_entries)
+                                  ->in_flight_count, 2);
+
+    ////// ACKNOWLEDGEMENTS IN REVERSE ORDER //////
+    const avs_coap_msg_t *ack2 = COAP_MSG(ACK, EMPTY, ID(0x69EE));
+    avs_unit_mocksock_input(mocksocks[0], ack2->content, ack2->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_FIRST(anjay->observe.connection_entries)
+                                  ->in_flight_count, 1);
+
+    const avs_coap_msg_t *ack1 = COAP_MSG(ACK, EMPTY, ID(0x69ED));
+    avs_unit_mocksock_input(mocksocks[0], ack1->content, ack1->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_FIRST(anjay->observe.connection_entries)
+                                  ->in_flight_count, 0);
+    AVS_UNIT_ASSERT_NULL(
+            AVS_RBTREE_FIRST(anjay->observe.connection_entries)->unsent);
+    AVS_UNIT_ASSERT_NULL(anjay->coap_async.exchanges);
+    assert_observe_size(anjay, 2);
+
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
 
@@ -1181,24 +1404,18 @@ static void test_observe_entry(anjay_t *anjay,
                     anjay, &(const anjay_connection_key_t) { ssid, conn_type });
     AVS_UNIT_ASSERT_NOT_NULL(conn);
 
-    AVS_RBTREE_ELEM(anjay_observe_entry_t) new_entry =
-            AVS_RBTREE_ELEM_NEW(anjay_observe_entry_t);
-    AVS_UNIT_ASSERT_NOT_NULL(new_entry);
-
-    memcpy((void *) (intptr_t) (const void *) &new_entry->key,
-            (&(const anjay_observe_key_t) {
+    AVS_UNIT_ASSERT_NOT_NULL(find_or_create_observe_entry(
+            anjay, conn, &(const anjay_observe_key_t) {
                 { ssid, conn_type }, oid, iid, rid, AVS_COAP_FORMAT_NONE
-            }), sizeof(anjay_observe_key_t));
-    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry =
-            AVS_RBTREE_INSERT(conn->entries, new_entry);
-    if (entry != new_entry) {
-        AVS_RBTREE_ELEM_DELETE_DETACHED(&new_entry);
-    }
+            }));
 }
 
 static anjay_t *create_test_env(void) {
     anjay_t *anjay = (anjay_t *) avs_calloc(1, sizeof(anjay_t));
-    _anjay_observe_init(&anjay->observe, false);
+    _anjay_observe_init(&anjay->observe, false, 1, false, false,
+                        &(const anjay_notify_queue_limits_t) { 0, 0 },
+                        &(const anjay_notify_queue_limits_t) { 0, 0 },
+                        ANJAY_NOTIFY_QUEUE_DROP_OLDEST);
     test_observe_entry(anjay, 1, ANJAY_CONNECTION_UDP, 2, 3, 1);
     test_observe_entry(anjay, 1, ANJAY_CONNECTION_UDP, 2, 3, 2);
     test_observe_entry(anjay, 1, ANJAY_CONNECTION_UDP, 2, 9, 4);
@@ -1323,6 +1540,34 @@ AVS_UNIT_TEST(notify, notify_changed) {
             }, true), -42);
     expect_notify_clear();
 
+    expect_notify_entry(1, 2, 3, 1, AVS_COAP_FORMAT_NONE, 0);
+    expect_notify_entry(1, 2, 3, 2, AVS_COAP_FORMAT_NONE, 0);
+    expect_notify_entry(3, 2, 3, -1, AVS_COAP_FORMAT_NONE, 0);
+    expect_notify_entry(3, 2, 3, 3, AVS_COAP_FORMAT_NONE, 0);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_notify(anjay,
+            &(const anjay_observe_key_t) {
+                { 8, ANJAY_CONNECTION_UNSET },
+                2, 3, -1, AVS_COAP_FORMAT_NONE
+            }, true));
+    expect_notify_clear();
+
+    expect_notify_entry(8, 4, ANJAY_IID_INVALID, -1, AVS_COAP_FORMAT_NONE, 0);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_notify(anjay,
+            &(const anjay_observe_key_t) {
+                { 8, ANJAY_CONNECTION_UNSET },
+                4, 1, 1, AVS_COAP_FORMAT_NONE
+            }, false));
+    expect_notify_clear();
+
+    // nothing observed in this object at all
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_notify(anjay,
+            &(const anjay_observe_key_t) {
+                { 8, ANJAY_CONNECTION_UNSET },
+                5, 0, 1, AVS_COAP_FORMAT_NONE
+            }, true));
+    expect_notify_clear();
+
+    assert_observe_size(anjay, 11);
     destroy_test_env(anjay);
 }
 
@@ -1351,19 +1596,15 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
     _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
                                         ANJAY_MOCK_DM_STRING(0, "Rin"));
 
+    // the value read for the first server is reused
     expect_read_notif_storing(anjay, &FAKE_SERVER, 34, true);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
-    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
-    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
-    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
-                                        ANJAY_MOCK_DM_STRING(0, "Len"));
     const avs_coap_msg_t *notify_response = COAP_MSG(NON, CONTENT, ID(0x69ED),
                                                      OBSERVE(0xF48000),
                                                      CONTENT_FORMAT(PLAINTEXT),
-                                                     PAYLOAD("Len"));
+                                                     PAYLOAD("Rin"));
     avs_unit_mocksock_expect_output(mocksocks[1], notify_response->content,
-                                
-                                                                notify_response->length);
+                                    notify_response->length);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
 
@@ -1384,14 +1625,10 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
 
     expect_read_notif_storing(anjay, &FAKE_SERVER, 34, true);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
-    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
-    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
-    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
-                                        ANJAY_MOCK_DM_STRING(0, "Luka"));
     const avs_coap_msg_t *notify_response2 = COAP_MSG(NON, CONTENT, ID(0x69EE),
                                                       OBSERVE(0xF50000),
                                                       CONTENT_FORMAT(PLAINTEXT),
-                                                      PAYLOAD("Luka"));
+                                                      PAYLOAD("Miku"));
     avs_unit_mocksock_expect_output(mocksocks[1], notify_response2->content,
                                     notify_response2->length);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
@@ -1425,6 +1662,278 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
     DM_TEST_FINISH;
 }
 
+AVS_UNIT_TEST(notify, storing_coalesced) {
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.coalesce_notifications = true));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3E), OBSERVE(0),
+                    PATH("42", "69", "4"));
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_INT(0, 514));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID(0xFA3E),
+                            OBSERVE(0xF40000), CONTENT_FORMAT(PLAINTEXT),
+                            PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    assert_observe_size(anjay, 1);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    // deactivate the server
+    avs_net_abstract_socket_t *socket14 =
+            anjay->servers->servers->data_active.udp_connection.conn_socket_;
+    anjay->servers->servers->data_active.udp_connection.conn_socket_ = NULL;
+    _anjay_observe_gc(anjay);
+    assert_observe_size(anjay, 1);
+
+    // first notification
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Rin"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    // second notification
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Miku"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    // reactivate the server - only the newest value is sent
+    anjay->servers->servers->data_active.udp_connection.conn_socket_ = socket14;
+    _anjay_observe_gc(anjay);
+    assert_observe_size(anjay, 1);
+    anjay->current_connection.server = anjay->servers->servers;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_UDP;
+    _anjay_observe_sched_flush_current_connection(anjay);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    const avs_coap_msg_t *notify_response = COAP_MSG(NON, CONTENT, ID(0x69ED),
+                                                     OBSERVE(0xF50000),
+                                                     CONTENT_FORMAT(PLAINTEXT),
+                                                     PAYLOAD("Miku"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_num_coalesced_notifications(anjay), 1);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_num_notifications_sent(anjay), 1);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_notifications_tx_bytes(anjay),
+                          notify_response->length);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, storing_queue_limit) {
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.notify_queue_limits_per_connection = {
+                             .max_values = 2
+                         }));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3E), OBSERVE(0),
+                    PATH("42", "69", "4"));
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_INT(0, 514));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID(0xFA3E),
+                            OBSERVE(0xF40000), CONTENT_FORMAT(PLAINTEXT),
+                            PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    assert_observe_size(anjay, 1);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    // deactivate the server
+    avs_net_abstract_socket_t *socket14 =
+            anjay->servers->servers->data_active.udp_connection.conn_socket_;
+    anjay->servers->servers->data_active.udp_connection.conn_socket_ = NULL;
+    _anjay_observe_gc(anjay);
+    assert_observe_size(anjay, 1);
+
+    // three values are stored; the oldest one does not fit in the queue
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Rin"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Miku"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Luka"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 2);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_bytes,
+                          sizeof("Miku") - 1 + sizeof("Luka") - 1);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_num_dropped_notifications(anjay), 1);
+
+    // reactivate the server
+    anjay->servers->servers->data_active.udp_connection.conn_socket_ = socket14;
+    _anjay_observe_gc(anjay);
+    assert_observe_size(anjay, 1);
+    anjay->current_connection.server = anjay->servers->servers;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_UDP;
+    _anjay_observe_sched_flush_current_connection(anjay);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    const avs_coap_msg_t *notify_response = COAP_MSG(NON, CONTENT, ID(0x69ED),
+                                                     OBSERVE(0xF58000),
+                                                     CONTENT_FORMAT(PLAINTEXT),
+                                                     PAYLOAD("Miku"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    const avs_coap_msg_t *notify_response2 = COAP_MSG(NON, CONTENT, ID(0x69EE),
+                                                      OBSERVE(0xF58000),
+                                                      CONTENT_FORMAT(PLAINTEXT),
+                                                      PAYLOAD("Luka"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response2->content,
+                                    notify_response2->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 0);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_bytes, 0);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, storing_shared_payload) {
+    SUCCESS_TEST(14, 34);
+
+    // deactivate both servers
+    anjay_server_info_t *server14 = anjay->servers->servers;
+    anjay_server_info_t *server34 = AVS_LIST_NEXT(server14);
+    avs_net_abstract_socket_t *socket14 =
+            server14->data_active.udp_connection.conn_socket_;
+    avs_net_abstract_socket_t *socket34 =
+            server34->data_active.udp_connection.conn_socket_;
+    server14->data_active.udp_connection.conn_socket_ = NULL;
+    server34->data_active.udp_connection.conn_socket_ = NULL;
+    _anjay_observe_gc(anjay);
+    assert_observe_size(anjay, 2);
+
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Rin"));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 34, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    // the payload shared by both queues is counted once in the total
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 2);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_bytes, sizeof("Rin") - 1);
+
+    // reactivate the first server
+    server14->data_active.udp_connection.conn_socket_ = socket14;
+    _anjay_observe_gc(anjay);
+    assert_observe_size(anjay, 2);
+    anjay->current_connection.server = server14;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_UDP;
+    _anjay_observe_sched_flush_current_connection(anjay);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    const avs_coap_msg_t *notify_response = COAP_MSG(NON, CONTENT, ID(0x69ED),
+                                                     OBSERVE(0xF48000),
+                                                     CONTENT_FORMAT(PLAINTEXT),
+                                                     PAYLOAD("Rin"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    // the payload is still queued for the second server
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 1);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_bytes, sizeof("Rin") - 1);
+
+    // reactivate the second server
+    server34->data_active.udp_connection.conn_socket_ = socket34;
+    _anjay_observe_gc(anjay);
+    assert_observe_size(anjay, 2);
+    anjay->current_connection.server = server34;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_UDP;
+    _anjay_observe_sched_flush_current_connection(anjay);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 34, true);
+    const avs_coap_msg_t *notify_response2 = COAP_MSG(NON, CONTENT, ID(0x69EE),
+                                                      OBSERVE(0xF48000),
+                                                      CONTENT_FORMAT(PLAINTEXT),
+                                                      PAYLOAD("Rin"));
+    avs_unit_mocksock_expect_output(mocksocks[1], notify_response2->content,
+                                    notify_response2->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 0);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_bytes, 0);
+
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(notify, no_storing_when_disabled) {
     SUCCESS_TEST(14, 34);
 
@@ -1655,9 +2164,10 @@ AVS_UNIT_TEST(notify, storing_of_errors) {
                                                          ID(0x69EE));
     avs_unit_mocksock_expect_output(mocksocks[0], con_notify_response->content,
                                     con_notify_response->length);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
     const avs_coap_msg_t *con_ack = COAP_MSG(ACK, EMPTY, ID(0x69EE));
     avs_unit_mocksock_input(mocksocks[0], con_ack->content, con_ack->length);
-    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
 
     // now the notification shall be gone
     assert_observe_size(anjay, 0);
@@ -1708,9 +2218,9 @@ AVS_UNIT_TEST(notify, reconnect) {
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
 
     // mocking reconnect is rather hard, so let's just check it's scheduled
-    AVS_UNIT_ASSERT_TRUE(anjay->sched->entries
+    AVS_UNIT_ASSERT_TRUE(anjay->sched->heap[0]
             == anjay->servers->servers->next_action_handle);
-    AVS_UNIT_ASSERT_EQUAL(*(anjay_ssid_t *) &anjay->sched->entries->clb_data,
+    AVS_UNIT_ASSERT_EQUAL(*(anjay_ssid_t *) &anjay->sched->heap[0]->clb_data,
                           14);
     _anjay_sched_del(anjay->sched,
                      &anjay->servers->servers->next_action_handle);
@@ -1718,7 +2228,85 @@ AVS_UNIT_TEST(notify, reconnect) {
     // we cannot check if notifications will be re-sent, as they are sent from
     // within the reconnect routine
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
-    AVS_UNIT_ASSERT_NULL(anjay->sched->entries);
+    AVS_UNIT_ASSERT_EQUAL(anjay->sched->heap_size, 0);
+
+    DM_TEST_FINISH;
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+AVS_UNIT_TEST(observe_persistence, persist_and_restore) {
+    SUCCESS_TEST(14, 34);
+
+    avs_coap_msg_identity_t identities[2];
+    size_t i = 0;
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn;
+    AVS_RBTREE_FOREACH(conn, anjay->observe.connection_entries) {
+        identities[i++] = AVS_RBTREE_FIRST(conn->entries)->last_sent->identity;
+    }
+
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_persist(anjay, stream));
+
+    // notification triggers are scheduled anew
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_restore(anjay, stream));
+    assert_observe_size(anjay, 2);
+    ASSERT_SUCCESS_TEST_RESULT(14);
+    ASSERT_SUCCESS_TEST_RESULT(34);
+
+    i = 0;
+    AVS_RBTREE_FOREACH(conn, anjay->observe.connection_entries) {
+        const avs_coap_msg_identity_t *restored =
+                &AVS_RBTREE_FIRST(conn->entries)->last_sent->identity;
+        AVS_UNIT_ASSERT_EQUAL(restored->msg_id, identities[i].msg_id);
+        AVS_UNIT_ASSERT_EQUAL(restored->token.size, identities[i].token.size);
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(restored->token.bytes,
+                                          identities[i].token.bytes,
+                                          identities[i].token.size);
+        ++i;
+    }
+
+    avs_stream_cleanup(&stream);
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(observe_persistence, restore_truncated) {
+    SUCCESS_TEST(14);
+
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    // valid header, followed by a connection count but no connections
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "OBS\1\0\0\0\1", 8));
+    AVS_UNIT_ASSERT_FAILED(_anjay_observe_restore(anjay, stream));
+
+    assert_observe_size(anjay, 1);
+    ASSERT_SUCCESS_TEST_RESULT(14);
+
+    avs_stream_cleanup(&stream);
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(observe_persistence, restore_invalid_msg_type) {
+    SUCCESS_TEST(14);
+
+    anjay_observe_resource_value_t *last_sent =
+            AVS_RBTREE_FIRST(AVS_RBTREE_FIRST(
+                    anjay->observe.connection_entries)->entries)->last_sent;
+    const avs_coap_msg_type_t msg_type = last_sent->details.msg_type;
+    last_sent->details.msg_type = AVS_COAP_MSG_RESET;
+
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_persist(anjay, stream));
+    AVS_UNIT_ASSERT_FAILED(_anjay_observe_restore(anjay, stream));
+
+    last_sent->details.msg_type = msg_type;
+    assert_observe_size(anjay, 1);
+    ASSERT_SUCCESS_TEST_RESULT(14);
 
+    avs_stream_cleanup(&stream);
     DM_TEST_FINISH;
 }
+#endif // WITH_AVS_PERSISTENCE
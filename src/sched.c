@@ -16,11 +16,14 @@
 
 #include <anjay_config.h>
 
+#include <assert.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
 
-#include <avsystem/commons/list.h>
+#include <avsystem/commons/memory.h>
 
 #include <anjay/core.h>
 
@@ -41,34 +44,190 @@ anjay_sched_t *_anjay_sched_get(anjay_t *anjay) {
     return anjay->sched;
 }
 
-anjay_sched_t *_anjay_sched_new(anjay_t *anjay) {
+#define SCHED_ENTRY_SIZE(DataSize) \
+    (offsetof(anjay_sched_entry_t, clb_data) + (DataSize))
+
+static int pool_init(anjay_sched_pool_t *pool, size_t slot_count) {
+    if (!slot_count) {
+        return 0;
+    }
+    /* round up, so that each slot is suitably aligned for an entry */
+    const size_t slot_size =
+            (SCHED_ENTRY_SIZE(ANJAY_SCHED_POOL_SLOT_DATA_SIZE)
+                    + sizeof(avs_max_align_t) - 1)
+            / sizeof(avs_max_align_t) * sizeof(avs_max_align_t);
+    if (slot_count > SIZE_MAX / slot_size
+            || !(pool->storage = (char *) avs_malloc(slot_count * slot_size))) {
+        sched_log(ERROR, "could not allocate scheduler pool");
+        return -1;
+    }
+    pool->slot_size = slot_size;
+    pool->slot_count = slot_count;
+    for (size_t i = slot_count; i-- > 0;) {
+        void *slot = pool->storage + i * slot_size;
+        *(void **) slot = pool->free_list;
+        pool->free_list = slot;
+    }
+    return 0;
+}
+
+static bool pool_owns(const anjay_sched_pool_t *pool, const void *ptr) {
+    return pool->storage && (const char *) ptr >= pool->storage
+            && (const char *) ptr
+                    < pool->storage + pool->slot_count * pool->slot_size;
+}
+
+anjay_sched_t *_anjay_sched_new(anjay_t *anjay, size_t pool_size) {
     anjay_sched_t *sched = (anjay_sched_t *) avs_calloc(1, sizeof(anjay_sched_t));
     if (sched) {
         sched->anjay = anjay;
+        if (pool_init(&sched->pool, pool_size)) {
+            avs_free(sched);
+            return NULL;
+        }
     }
     return sched;
 }
 
+void _anjay_sched_pool_stats(anjay_sched_t *sched,
+                             uint64_t *out_hits,
+                             uint64_t *out_misses) {
+    if (out_hits) {
+        *out_hits = sched->pool.hits;
+    }
+    if (out_misses) {
+        *out_misses = sched->pool.misses;
+    }
+}
+
+/*
+ * Jobs are kept in a binary min-heap ordered by (when, seq). Each entry stores
+ * its own position in the heap, so that a job handle (which is a pointer to
+ * the entry) can be used to remove the job in O(log n) without searching.
+ *
+ * The handle variable passed to _anjay_sched() is cleared whenever the job is
+ * executed or deleted, so a non-NULL value stored there always points to a
+ * live entry. Such an entry can thus be safely dereferenced; its handle_ptr
+ * back-pointer is then used to reject attempts to delete it through a copy of
+ * the original handle.
+ *
+ * The sequence number guarantees FIFO execution order of jobs scheduled for
+ * the same point in time.
+ */
+static bool entry_before(const anjay_sched_entry_t *a,
+                         const anjay_sched_entry_t *b) {
+    if (avs_time_monotonic_before(a->when, b->when)) {
+        return true;
+    } else if (avs_time_monotonic_before(b->when, a->when)) {
+        return false;
+    }
+    return a->seq < b->seq;
+}
+
+static void heap_put(anjay_sched_t *sched,
+                     size_t index,
+                     anjay_sched_entry_t *entry) {
+    sched->heap[index] = entry;
+    entry->heap_index = index;
+}
+
+static void heap_sift_up(anjay_sched_t *sched, size_t index) {
+    anjay_sched_entry_t *entry = sched->heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!entry_before(entry, sched->heap[parent])) {
+            break;
+        }
+        heap_put(sched, index, sched->heap[parent]);
+        index = parent;
+    }
+    heap_put(sched, index, entry);
+}
+
+static void heap_sift_down(anjay_sched_t *sched, size_t index) {
+    anjay_sched_entry_t *entry = sched->heap[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= sched->heap_size) {
+            break;
+        }
+        if (child + 1 < sched->heap_size
+                && entry_before(sched->heap[child + 1], sched->heap[child])) {
+            ++child;
+        }
+        if (!entry_before(sched->heap[child], entry)) {
+            break;
+        }
+        heap_put(sched, index, sched->heap[child]);
+        index = child;
+    }
+    heap_put(sched, index, entry);
+}
+
+static int heap_reserve(anjay_sched_t *sched, size_t size) {
+    if (size <= sched->heap_capacity) {
+        return 0;
+    }
+    size_t new_capacity = sched->heap_capacity
+            ? 2 * sched->heap_capacity : ANJAY_SCHED_HEAP_INITIAL_CAPACITY;
+    if (new_capacity < sched->heap_capacity
+            || new_capacity > SIZE_MAX / sizeof(*sched->heap)) {
+        return -1;
+    }
+    anjay_sched_entry_t **new_heap = (anjay_sched_entry_t **)
+            avs_realloc(sched->heap, new_capacity * sizeof(*sched->heap));
+    if (!new_heap) {
+        return -1;
+    }
+    sched->heap = new_heap;
+    sched->heap_capacity = new_capacity;
+    return 0;
+}
+
+static int heap_insert(anjay_sched_t *sched, anjay_sched_entry_t *entry) {
+    if (heap_reserve(sched, sched->heap_size + 1)) {
+        return -1;
+    }
+    heap_put(sched, sched->heap_size++, entry);
+    heap_sift_up(sched, entry->heap_index);
+    return 0;
+}
+
+static anjay_sched_entry_t *heap_remove(anjay_sched_t *sched, size_t index) {
+    assert(index < sched->heap_size);
+    anjay_sched_entry_t *entry = sched->heap[index];
+    anjay_sched_entry_t *last = sched->heap[--sched->heap_size];
+    if (index < sched->heap_size) {
+        heap_put(sched, index, last);
+        heap_sift_up(sched, index);
+        heap_sift_down(sched, last->heap_index);
+    }
+    sched->heap[sched->heap_size] = NULL;
+    return entry;
+}
+
 static anjay_sched_entry_t *fetch_task(anjay_sched_t *sched,
                                        const avs_time_monotonic_t *now) {
-    if (sched->entries
-            && !avs_time_monotonic_before(*now, sched->entries->when)) {
-        return AVS_LIST_DETACH(&sched->entries);
+    if (sched->heap_size > 0
+            && !avs_time_monotonic_before(*now, sched->heap[0]->when)) {
+        return heap_remove(sched, 0);
     } else {
         return NULL;
     }
 }
 
-static anjay_sched_handle_t
-sched_delayed(anjay_sched_t *sched,
-              avs_time_duration_t delay,
-              AVS_LIST(anjay_sched_entry_t) entry);
-
-static void execute_task(anjay_sched_t *sched,
-                         AVS_LIST(anjay_sched_entry_t) entry) {
-    /* make sure the task is detached */
-    assert(AVS_LIST_NEXT(entry) == NULL);
+static void delete_entry(anjay_sched_t *sched,
+                         anjay_sched_entry_t **entry_ptr) {
+    if (sched && pool_owns(&sched->pool, *entry_ptr)) {
+        *(void **) *entry_ptr = sched->pool.free_list;
+        sched->pool.free_list = *entry_ptr;
+    } else {
+        avs_free(*entry_ptr);
+    }
+    *entry_ptr = NULL;
+}
 
+static void execute_task(anjay_sched_t *sched, anjay_sched_entry_t *entry) {
     sched_log(TRACE, "executing task %p", (void *) entry);
 
     if (entry->handle_ptr) {
@@ -76,7 +235,7 @@ static void execute_task(anjay_sched_t *sched,
     }
 
     entry->clb(sched->anjay, &entry->clb_data);
-    AVS_LIST_DELETE(&entry);
+    delete_entry(sched, &entry);
 }
 
 ssize_t _anjay_sched_run(anjay_sched_t *sched) {
@@ -99,7 +258,7 @@ ssize_t _anjay_sched_run(anjay_sched_t *sched) {
     _anjay_sched_time_to_next(sched, &delay);
     sched_log(TRACE, "%lu scheduled tasks remain; next after "
                      "%" PRId64 ".%09" PRId32,
-              (unsigned long)AVS_LIST_SIZE(sched->entries),
+              (unsigned long) sched->heap_size,
               delay.seconds, delay.nanoseconds);
     return tasks_executed;
 }
@@ -113,44 +272,61 @@ void _anjay_sched_delete(anjay_sched_t **sched_ptr) {
 
     /* execute any remaining tasks */
     _anjay_sched_run(*sched_ptr);
-    AVS_LIST_CLEAR(&(*sched_ptr)->entries) {
-        if ((*sched_ptr)->entries->handle_ptr) {
-            *(*sched_ptr)->entries->handle_ptr = NULL;
+    while ((*sched_ptr)->heap_size > 0) {
+        anjay_sched_entry_t *entry =
+                heap_remove(*sched_ptr, (*sched_ptr)->heap_size - 1);
+        if (entry->handle_ptr) {
+            *entry->handle_ptr = NULL;
         }
+        delete_entry(*sched_ptr, &entry);
     }
+    avs_free((*sched_ptr)->heap);
+    avs_free((*sched_ptr)->pool.storage);
     avs_free(*sched_ptr);
     *sched_ptr = NULL;
 }
 
-static anjay_sched_handle_t
-insert_entry(anjay_sched_t *sched,
-             AVS_LIST(anjay_sched_entry_t) entry) {
-    anjay_sched_entry_t **entry_ptr = NULL;
-
+static anjay_sched_handle_t insert_entry(anjay_sched_t *sched,
+                                         anjay_sched_entry_t *entry) {
     if (!sched || sched->shut_down) {
         sched_log(DEBUG, "scheduler already shut down");
         return NULL;
     }
 
-    AVS_LIST_FOREACH_PTR(entry_ptr, &sched->entries) {
-        if (avs_time_monotonic_before(entry->when, (*entry_ptr)->when)) {
-            break;
-        }
+    entry->seq = sched->next_seq++;
+    if (heap_insert(sched, entry)) {
+        sched_log(ERROR, "could not grow scheduler queue");
+        return NULL;
     }
-
-    AVS_LIST_INSERT(entry_ptr, entry);
     sched_log(TRACE, "%p inserted; %lu tasks scheduled",
-              (void*)entry, (unsigned long)AVS_LIST_SIZE(sched->entries));
+              (void *) entry, (unsigned long) sched->heap_size);
     return entry;
 }
 
-static AVS_LIST(anjay_sched_entry_t)
-create_entry(anjay_sched_clb_t clb,
-             const void *clb_data,
-             size_t clb_data_size) {
-    AVS_LIST(anjay_sched_entry_t) entry = (anjay_sched_entry_t *)
-            AVS_LIST_NEW_BUFFER(offsetof(anjay_sched_entry_t, clb_data)
-                                        + clb_data_size);
+static anjay_sched_entry_t *alloc_entry(anjay_sched_t *sched,
+                                        size_t clb_data_size) {
+    if (sched && sched->pool.free_list
+            && clb_data_size <= ANJAY_SCHED_POOL_SLOT_DATA_SIZE) {
+        anjay_sched_entry_t *entry =
+                (anjay_sched_entry_t *) sched->pool.free_list;
+        sched->pool.free_list = *(void **) entry;
+        ++sched->pool.hits;
+        memset(entry, 0, SCHED_ENTRY_SIZE(clb_data_size));
+        return entry;
+    }
+
+    if (sched) {
+        ++sched->pool.misses;
+    }
+    return (anjay_sched_entry_t *) avs_calloc(
+            1, SCHED_ENTRY_SIZE(clb_data_size));
+}
+
+static anjay_sched_entry_t *create_entry(anjay_sched_t *sched,
+                                         anjay_sched_clb_t clb,
+                                         const void *clb_data,
+                                         size_t clb_data_size) {
+    anjay_sched_entry_t *entry = alloc_entry(sched, clb_data_size);
 
     if (!entry) {
         sched_log(ERROR, "Could not allocate scheduler task");
@@ -165,10 +341,9 @@ create_entry(anjay_sched_clb_t clb,
     return entry;
 }
 
-static anjay_sched_handle_t
-sched_delayed(anjay_sched_t *sched,
-              avs_time_duration_t delay,
-              AVS_LIST(anjay_sched_entry_t) entry) {
+static anjay_sched_handle_t sched_delayed(anjay_sched_t *sched,
+                                          avs_time_duration_t delay,
+                                          anjay_sched_entry_t *entry) {
     avs_time_monotonic_t sched_time = avs_time_monotonic_now();
     sched_log(TRACE, "current time %" PRId64 ".%09" PRId32,
               sched_time.since_monotonic_epoch.seconds,
@@ -200,8 +375,8 @@ int _anjay_sched(anjay_sched_t *sched,
     }
     AVS_ASSERT((!out_handle || *out_handle == NULL),
                "Dangerous non-initialized out_handle");
-    AVS_LIST(anjay_sched_entry_t) entry =
-            create_entry(clb, clb_data, clb_data_size);
+    anjay_sched_entry_t *entry =
+            create_entry(sched, clb, clb_data, clb_data_size);
     if (!entry) {
         sched_log(ERROR, "cannot schedule task: out of memory");
         return -1;
@@ -209,7 +384,7 @@ int _anjay_sched(anjay_sched_t *sched,
     entry->handle_ptr = out_handle;
     anjay_sched_handle_t task = sched_delayed(sched, delay, entry);
     if (!task) {
-        AVS_LIST_DELETE(&entry);
+        delete_entry(sched, &entry);
         return -1;
     }
     if (out_handle) {
@@ -218,13 +393,10 @@ int _anjay_sched(anjay_sched_t *sched,
     return 0;
 }
 
-static anjay_sched_entry_t **find_task_entry_ptr(anjay_sched_t *sched,
-                                                 anjay_sched_handle_t *handle) {
-    // IAR compiler does not support typeof, so AVS_LIST_FIND_PTR
-    // returns void**, which is not implicitly-convertible
-    return (AVS_LIST(anjay_sched_entry_t) *)
-            AVS_LIST_FIND_PTR(&sched->entries,
-                              *((anjay_sched_entry_t **) handle));
+static bool is_entry_scheduled(anjay_sched_t *sched,
+                               const anjay_sched_entry_t *entry) {
+    return entry->heap_index < sched->heap_size
+            && sched->heap[entry->heap_index] == entry;
 }
 
 int _anjay_sched_del(anjay_sched_t *sched, anjay_sched_handle_t *handle) {
@@ -233,39 +405,39 @@ int _anjay_sched_del(anjay_sched_t *sched, anjay_sched_handle_t *handle) {
     }
     sched_log(TRACE, "canceling task %p", *handle);
     int result = 0;
-    anjay_sched_entry_t **task_ptr = find_task_entry_ptr(sched, handle);
-    if (!task_ptr) {
+    anjay_sched_entry_t *task = (anjay_sched_entry_t *) *handle;
+    if (handle != task->handle_ptr) {
+        AVS_UNREACHABLE("Removing task via non-original handle");
+        result = -1;
+    } else if (!is_entry_scheduled(sched, task)) {
         sched_log(ERROR, "cannot delete task %p - not found", *handle);
         AVS_UNREACHABLE("Dangling handle detected");
         result = -1;
-    } else if (handle != (*task_ptr)->handle_ptr) {
-        AVS_UNREACHABLE("Removing task via non-original handle");
-        result = -1;
     } else {
-        if ((*task_ptr)->handle_ptr) {
-            *(*task_ptr)->handle_ptr = NULL;
+        heap_remove(sched, task->heap_index);
+        if (task->handle_ptr) {
+            *task->handle_ptr = NULL;
         }
-        AVS_LIST_DELETE(task_ptr);
+        delete_entry(sched, &task);
     }
     return result;
 }
 
 int _anjay_sched_time_to_next(anjay_sched_t *sched,
                               avs_time_duration_t *delay) {
-    anjay_sched_entry_t *elem;
     avs_time_monotonic_t now = avs_time_monotonic_now();
 
-    AVS_LIST_FOREACH(elem, sched->entries) {
-        if (delay) {
-            *delay = avs_time_monotonic_diff(elem->when, now);
-            if (avs_time_duration_less(*delay, AVS_TIME_DURATION_ZERO)) {
-                *delay = AVS_TIME_DURATION_ZERO;
-            }
-        }
-        return 0;
+    if (sched->heap_size == 0) {
+        return -1;
     }
 
-    return -1;
+    if (delay) {
+        *delay = avs_time_monotonic_diff(sched->heap[0]->when, now);
+        if (avs_time_duration_less(*delay, AVS_TIME_DURATION_ZERO)) {
+            *delay = AVS_TIME_DURATION_ZERO;
+        }
+    }
+    return 0;
 }
 
 #ifdef ANJAY_TEST
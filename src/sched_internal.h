@@ -23,16 +23,38 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 #error "sched_internal.h is not meant to be included from outside sched.c"
 #endif
 
+#define ANJAY_SCHED_HEAP_INITIAL_CAPACITY 16
+
 typedef struct {
     anjay_sched_handle_t *handle_ptr;
     avs_time_monotonic_t when;
+    /* tie-breaker for jobs scheduled at the same time; keeps FIFO order */
+    uint64_t seq;
+    /* position of this entry in anjay_sched_t::heap */
+    size_t heap_index;
     anjay_sched_clb_t clb;
     avs_max_align_t clb_data;
 } anjay_sched_entry_t;
 
+typedef struct {
+    /* single buffer holding all preallocated slots */
+    char *storage;
+    size_t slot_size;
+    size_t slot_count;
+    /* singly linked list of unused slots, threaded through the slots */
+    void *free_list;
+    uint64_t hits;
+    uint64_t misses;
+} anjay_sched_pool_t;
+
 struct anjay_sched_struct {
     anjay_t *anjay;
-    AVS_LIST(anjay_sched_entry_t) entries;
+    anjay_sched_pool_t pool;
+    /* binary min-heap of scheduled jobs, ordered by (when, seq) */
+    anjay_sched_entry_t **heap;
+    size_t heap_size;
+    size_t heap_capacity;
+    uint64_t next_seq;
     bool shut_down;
 };
 
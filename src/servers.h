@@ -78,9 +78,44 @@ typedef struct {
     AVS_LIST(anjay_iid_t) instances;
 } anjay_dm_cache_object_t;
 
+/**
+ * List of Objects and Object Instances advertised in Register and Update
+ * messages. It is built lazily on first use and then kept up to date by
+ * _anjay_registration_dm_cache_update(), called for every Object whose set of
+ * Instances is reported as changed through the notify queue, and whenever an
+ * Object is registered.
+ */
+typedef struct {
+    AVS_LIST(anjay_dm_cache_object_t) objects;
+
+    /**
+     * Incremented each time the contents of the list change. Each server
+     * remembers the generation it has last been sent (see
+     * anjay_update_parameters_t::dm_generation), so deciding whether the list
+     * needs to be included in an Update does not require comparing the lists.
+     */
+    uint64_t generation;
+
+    /**
+     * CoRE Link Format representation of the list, as sent in the payload of
+     * Register and Update messages (not null-terminated). It is rendered on
+     * first use after each change, and is up to date if links_generation is
+     * equal to generation.
+     */
+    char *links;
+    size_t links_size;
+    uint64_t links_generation;
+
+    /**
+     * False if the list has not been built yet, or if keeping it up to date
+     * failed - in which case it will be rebuilt from scratch on next use.
+     */
+    bool valid;
+} anjay_registration_dm_cache_t;
+
 typedef struct {
     int64_t lifetime_s;
-    AVS_LIST(anjay_dm_cache_object_t) dm;
+    uint64_t dm_generation;
     anjay_binding_mode_t binding_mode;
 } anjay_update_parameters_t;
 
@@ -90,6 +125,62 @@ typedef struct {
     anjay_update_parameters_t last_update_params;
 } anjay_registration_info_t;
 
+typedef struct anjay_dtls_session_cache_entry_struct
+        anjay_dtls_session_cache_entry_t;
+
+/**
+ * DTLS sessions most recently negotiated with servers, keyed by server
+ * hostname and port.
+ *
+ * A session is stored after each successful handshake, and loaded into the
+ * session resumption buffer of a connection whenever its socket is recreated.
+ * If no session is cached for the server, the buffer is kept as long as the
+ * connection still points at the same host and port, and cleared otherwise.
+ * This way, sessions survive removal of server entries (e.g. when servers are
+ * reconfigured by the Bootstrap Server), and - thanks to
+ * anjay_dtls_sessions_persist() and anjay_dtls_sessions_restore() - restarts
+ * of the application.
+ *
+ * At most ANJAY_DTLS_SESSION_CACHE_SIZE entries are kept; the least recently
+ * used ones are dropped first.
+ */
+typedef struct {
+    /**
+     * Cached sessions, most recently used first.
+     */
+    AVS_LIST(anjay_dtls_session_cache_entry_t) entries;
+
+    /**
+     * Number of DTLS handshakes performed, including abbreviated ones.
+     */
+    uint64_t num_handshakes;
+
+    /**
+     * Number of DTLS handshakes that resumed a previous session.
+     */
+    uint64_t num_resumed;
+} anjay_dtls_session_cache_t;
+
+void _anjay_dtls_session_cache_cleanup(anjay_dtls_session_cache_t *cache);
+
+/**
+ * Stores all cached sessions in @p out .
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int _anjay_dtls_session_cache_persist(anjay_dtls_session_cache_t *cache,
+                                      avs_stream_abstract_t *out);
+
+/**
+ * Replaces the contents of @p cache with sessions previously stored using
+ * _anjay_dtls_session_cache_persist(). Handshake statistics are not affected.
+ *
+ * @returns 0 on success, a negative value in case of error. In the latter case,
+ *          @p cache is left intact.
+ */
+int _anjay_dtls_session_cache_restore(anjay_dtls_session_cache_t *cache,
+                                      avs_stream_abstract_t *in);
+
 typedef enum {
     ANJAY_CONNECTION_DISABLED,
     ANJAY_CONNECTION_ONLINE,
@@ -263,33 +354,51 @@ int _anjay_servers_foreach_active(anjay_t *anjay,
  *    active.
  * 6. Clean up.
  *
- * The "server reactivation" procedure is performed within the
- * activate_server_job() function and basically consists of the following:
+ * The "server reactivation" procedure is split into two scheduler jobs, and
+ * the Register and Update messages are sent without waiting for the response,
+ * so that waiting for the Register responses from multiple servers does not
+ * block the event loop. Note that the connections themselves are still set up
+ * synchronously, one server at a time: avs_net_socket_connect() resolves the
+ * hostname, connects the socket and performs the DTLS handshake in a single
+ * blocking call, and avs_net does not provide any API to perform these steps
+ * incrementally. A server that is slow to respond thus still delays the
+ * activation of the remaining ones. It basically consists of the following:
  *
- * 1. Call initialize_active_server(), which does:
+ * 1. activate_server_job() calls connect_active_server(), which does:
  * 1.1. Fail immediately if we're in offline mode.
  * 1.2. Read the URI from the Security instance.
  * 1.3. Call _anjay_active_server_refresh(), returning a failure (but see notes
  *      below) if it fails
- * 1.4. If it's not a Bootstrap Server, call
- *      _anjay_server_ensure_valid_registration(), which:
- *      - will do nothing if the server has valid registration and there is no
- *        need to send the Update message whatsoever
- *      - will send UPDATE message if the server has valid registration but some
- *        of its details has changed (i.e., the values sent within the Update
- *        message)
- *      - will send REGISTER message if the server has no valid registration
- *        (i.e. it's new or its session has been replaced instead of resumed),
- *        or if the aforementioned attept to send Update failed (Updates
- *        automatically degenerate to Registers within this function, and
- *        internal structures tracking registration state are updated
- *        accordingly) - NOTE THAT THIS IS THE **ONLY** PLACE IN THE ENTIRE CODE
- *        FLOW IN WHICH THE REGISTER MESSAGE MAY BE SENT
- * 1.5. If it is a Bootstrap Server, call _anjay_bootstrap_account_prepare(),
- *      which will schedule Client-Initiated Bootstrap if applicable.
- * 1.6. If the above was a success, reset the reactivate_failed flag, the
- *      num_icmp_failures counter and the reactivate_time value.
- * 2. If stage 1 was unsuccessful:
+ * 1.4. On success, register_server_job() is scheduled for immediate execution
+ *      (in data_active.register_job_handle, so that it is not cancelled if
+ *      another job is scheduled in next_action_handle in the meantime), and
+ *      activate_server_job() returns. Note that the server is considered
+ *      active from this point on, as it has a connected socket.
+ * 1.5. register_server_job() is executed, which:
+ * 1.5.1. If it's not a Bootstrap Server, calls
+ *        _anjay_server_ensure_valid_registration(), which (see the docs at the
+ *        top of servers/register_internal.c for details):
+ *        - will do nothing if the server has valid registration and there
+ *          is no need to send the Update message whatsoever
+ *        - will send UPDATE message if the server has valid registration but
+ *          some of its details has changed (i.e., the values sent within the
+ *          Update message)
+ *        - will send REGISTER message if the server has no valid registration
+ *          (i.e. it's new or its session has been replaced instead of
+ *          resumed), or if the aforementioned attept to send Update failed
+ *          (Updates automatically degenerate to Registers within this
+ *          function, and internal structures tracking registration state are
+ *          updated accordingly) - NOTE THAT THIS IS THE **ONLY** PLACE IN THE
+ *          ENTIRE CODE FLOW IN WHICH THE REGISTER MESSAGE MAY BE SENT
+ *        The outcome is reported to _anjay_server_registration_finished()
+ *        when the response is received, which concludes the activation.
+ * 1.5.2. If it is a Bootstrap Server, calls
+ *        _anjay_bootstrap_account_prepare(), which will schedule
+ *        Client-Initiated Bootstrap if applicable.
+ * 1.5.3. If the above was a success, the reactivate_failed flag, the
+ *        num_icmp_failures counter and the reactivate_time value are reset.
+ * 2. If any step of stage 1 was unsuccessful, handle_activation_failure() is
+ *    called, which does:
  * 2.1. Clean up the sockets (essentially deactivating the server).
  * 2.2. If there was an ECONNREFUSED error during _anjay_active_server_refresh()
  *      (which covers DTLS handshake, but NOT the Register/Update messages -
@@ -324,8 +433,8 @@ int _anjay_servers_foreach_active(anjay_t *anjay,
  *
  * Server deactivation is normally handled by _anjay_server_deactivate(). The
  * server might also enter inactive state through enter_offline_job(), or in
- * case of failure in activate_server_job(). Still, _anjay_server_deactivate()
- * works as follows:
+ * case of failure in activate_server_job() or register_server_job(). Still,
+ * _anjay_server_deactivate() works as follows:
  *
  * 1. If the server has a valid registration - send Deregister. Intentionally
  *    ignore errors if it fails for any reason - Deregister is optional anyway.
@@ -362,7 +471,7 @@ anjay_ssid_t _anjay_server_ssid(anjay_server_info_t *server);
 
 /**
  * Returns the CACHED URI of the given server - the one that was most recently
- * read in initialize_active_server().
+ * read in connect_active_server().
  *
  * It is called from send_request_bootstrap() and send_register() to fill the
  * Uri-Path option in the outgoing messages.
@@ -415,8 +524,8 @@ _anjay_server_registration_info(anjay_server_info_t *server);
  * NOTE: If any of the move_* parameters are NULL, the relevant fields are NOT
  * updated, i.e., they are left untouched rather than being replaced with NULLs.
  *
- * This is called from _anjay_register() and _anjay_update_registration() to
- * update the internally stored values with actual negotiated data, and from
+ * This is called after successful Register and Update exchanges to update the
+ * internally stored values with actual negotiated data, and from
  * _anjay_schedule_socket_update() to invalidate registration.
  */
 void _anjay_server_update_registration_info(
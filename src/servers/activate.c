@@ -74,7 +74,7 @@ static int read_server_uri(anjay_t *anjay,
 }
 
 static initialize_active_server_result_t
-initialize_active_server(anjay_t *anjay, anjay_server_info_t *server) {
+connect_active_server(anjay_t *anjay, anjay_server_info_t *server) {
     if (anjay_is_offline(anjay)) {
         anjay_log(TRACE,
                   "Anjay is offline, not initializing server SSID %" PRIu16,
@@ -84,56 +84,27 @@ initialize_active_server(anjay_t *anjay, anjay_server_info_t *server) {
 
     assert(!_anjay_server_active(server));
     assert(server->ssid != ANJAY_SSID_ANY);
-    initialize_active_server_result_t result = IAS_FAILED;
     anjay_iid_t security_iid;
-    int refresh_result;
     if (_anjay_find_security_iid(anjay, server->ssid, &security_iid)) {
         anjay_log(ERROR, "could not find server Security IID");
-    } else if (!read_server_uri(anjay, security_iid, &server->data_active.uri)) {
-        if ((refresh_result = _anjay_active_server_refresh(anjay, server))) {
-            anjay_log(TRACE, "could not initialize sockets for SSID %u",
-                      server->ssid);
-            if (refresh_result == EPROTO || refresh_result == ETIMEDOUT) {
-                result = IAS_CONNECTION_ERROR;
-            } else if (refresh_result == ECONNREFUSED) {
-                result = IAS_CONNECTION_REFUSED;
-            } else {
-                result = IAS_FAILED;
-            }
-        } else if (server->ssid != ANJAY_SSID_BOOTSTRAP) {
-            switch (_anjay_server_ensure_valid_registration(anjay, server)) {
-            case ANJAY_REGISTRATION_SUCCESS:
-                result = IAS_SUCCESS;
-                break;
-            case ANJAY_REGISTRATION_FAILED:
-                result = IAS_FAILED;
-                break;
-            case ANJAY_REGISTRATION_FORBIDDEN:
-                result = IAS_FORBIDDEN;
-                break;
-            }
-            if (result != IAS_SUCCESS) {
-                anjay_log(ERROR,
-                          "could not ensure registration to server SSID %u",
-                          server->ssid);
-            }
-        } else {
-            if (!_anjay_bootstrap_account_prepare(anjay)) {
-                result = IAS_SUCCESS;
-            } else {
-                anjay_log(ERROR,
-                          "could not prepare bootstrap account for SSID %u",
-                          server->ssid);
-            }
-        }
+        return IAS_FAILED;
+    }
+    if (read_server_uri(anjay, security_iid, &server->data_active.uri)) {
+        return IAS_FAILED;
     }
 
-    if (result == IAS_SUCCESS) {
-        server->data_inactive.reactivate_time = AVS_TIME_REAL_INVALID;
-        server->data_inactive.reactivate_failed = false;
-        server->data_inactive.num_icmp_failures = 0;
+    int refresh_result = _anjay_active_server_refresh(anjay, server);
+    if (!refresh_result) {
+        return IAS_SUCCESS;
+    }
+    anjay_log(TRACE, "could not initialize sockets for SSID %u", server->ssid);
+    if (refresh_result == EPROTO || refresh_result == ETIMEDOUT) {
+        return IAS_CONNECTION_ERROR;
+    } else if (refresh_result == ECONNREFUSED) {
+        return IAS_CONNECTION_REFUSED;
+    } else {
+        return IAS_FAILED;
     }
-    return result;
 }
 
 bool _anjay_can_retry_with_normal_server(anjay_t *anjay) {
@@ -196,32 +167,20 @@ bool anjay_all_connections_failed(anjay_t *anjay) {
     return true;
 }
 
-static void activate_server_job(anjay_t *anjay, const void *ssid_ptr) {
-    anjay_ssid_t ssid = *(const anjay_ssid_t *) ssid_ptr;
-
-    AVS_LIST(anjay_server_info_t) *server_ptr =
-            _anjay_servers_find_ptr(anjay->servers, ssid);
-
-    if (!server_ptr || _anjay_server_active(*server_ptr)) {
-        anjay_log(TRACE, "not an inactive server: SSID = %u", ssid);
-        return;
-    }
-
-    initialize_active_server_result_t registration_result =
-            initialize_active_server(anjay, *server_ptr);
-    if (registration_result == IAS_SUCCESS) {
-        return;
-    }
+static void activate_server_job(anjay_t *anjay, const void *ssid_ptr);
 
-    _anjay_server_clean_active_data(anjay, *server_ptr);
-    (*server_ptr)->data_inactive.reactivate_failed = true;
-    uint32_t *num_icmp_failures =
-            &(*server_ptr)->data_inactive.num_icmp_failures;
+static void
+handle_activation_failure(anjay_t *anjay,
+                          anjay_server_info_t *server,
+                          initialize_active_server_result_t result) {
+    const anjay_ssid_t ssid = server->ssid;
+    _anjay_server_clean_active_data(anjay, server);
+    server->data_inactive.reactivate_failed = true;
+    uint32_t *num_icmp_failures = &server->data_inactive.num_icmp_failures;
 
-    if (registration_result == IAS_CONNECTION_REFUSED) {
+    if (result == IAS_CONNECTION_REFUSED) {
         ++*num_icmp_failures;
-    } else if (registration_result == IAS_FORBIDDEN
-            || registration_result == IAS_CONNECTION_ERROR) {
+    } else if (result == IAS_FORBIDDEN || result == IAS_CONNECTION_ERROR) {
         *num_icmp_failures = anjay->max_icmp_failures;
     }
 
@@ -229,7 +188,7 @@ static void activate_server_job(anjay_t *anjay, const void *ssid_ptr) {
         // We had a failure with either a bootstrap or a non-bootstrap server,
         // retry till it's possible.
         if (_anjay_servers_schedule_next_retryable(
-                anjay->sched, *server_ptr, activate_server_job, ssid)) {
+                anjay->sched, server, activate_server_job, ssid)) {
             anjay_log(ERROR,
                       "could not reschedule reactivate job for server SSID %u",
                       ssid);
@@ -254,7 +213,103 @@ static void activate_server_job(anjay_t *anjay, const void *ssid_ptr) {
                   ssid);
     }
     // kill this job.
-    (*server_ptr)->data_inactive.reactivate_time = AVS_TIME_REAL_INVALID;
+    server->data_inactive.reactivate_time = AVS_TIME_REAL_INVALID;
+}
+
+static void finish_activation(anjay_t *anjay,
+                              anjay_server_info_t *server,
+                              initialize_active_server_result_t result) {
+    if (result == IAS_SUCCESS) {
+        server->data_inactive.reactivate_time = AVS_TIME_REAL_INVALID;
+        server->data_inactive.reactivate_failed = false;
+        server->data_inactive.num_icmp_failures = 0;
+    } else {
+        handle_activation_failure(anjay, server, result);
+    }
+}
+
+void _anjay_server_registration_finished(
+        anjay_t *anjay,
+        anjay_server_info_t *server,
+        anjay_registration_result_t registration_result) {
+    initialize_active_server_result_t result = IAS_FAILED;
+    switch (registration_result) {
+    case ANJAY_REGISTRATION_SUCCESS:
+        result = IAS_SUCCESS;
+        break;
+    case ANJAY_REGISTRATION_FAILED:
+        result = IAS_FAILED;
+        break;
+    case ANJAY_REGISTRATION_FORBIDDEN:
+        result = IAS_FORBIDDEN;
+        break;
+    }
+    if (result != IAS_SUCCESS) {
+        anjay_log(ERROR, "could not ensure registration to server SSID %u",
+                  server->ssid);
+    }
+    finish_activation(anjay, server, result);
+}
+
+/**
+ * Second phase of server activation, scheduled by activate_server_job() after
+ * the connection has been set up. Note that the connection itself is still set
+ * up synchronously, one server at a time - only the Register and Update
+ * exchanges started here do not block until the response arrives.
+ *
+ * For non-Bootstrap servers, it only starts the Register or Update exchange -
+ * the activation is concluded in _anjay_server_registration_finished().
+ */
+static void register_server_job(anjay_t *anjay, const void *ssid_ptr) {
+    anjay_ssid_t ssid = *(const anjay_ssid_t *) ssid_ptr;
+
+    anjay_server_info_t *server = _anjay_servers_find_active(anjay, ssid);
+    if (!server) {
+        anjay_log(TRACE, "server SSID %u lost its connection before "
+                         "registration", ssid);
+        return;
+    }
+
+    if (ssid != ANJAY_SSID_BOOTSTRAP) {
+        _anjay_server_ensure_valid_registration(anjay, server);
+        return;
+    }
+
+    initialize_active_server_result_t result = IAS_FAILED;
+    if (!_anjay_bootstrap_account_prepare(anjay)) {
+        result = IAS_SUCCESS;
+    } else {
+        anjay_log(ERROR, "could not prepare bootstrap account for SSID %u",
+                  ssid);
+    }
+    finish_activation(anjay, server, result);
+}
+
+static void activate_server_job(anjay_t *anjay, const void *ssid_ptr) {
+    anjay_ssid_t ssid = *(const anjay_ssid_t *) ssid_ptr;
+
+    AVS_LIST(anjay_server_info_t) *server_ptr =
+            _anjay_servers_find_ptr(anjay->servers, ssid);
+
+    if (!server_ptr || _anjay_server_active(*server_ptr)) {
+        anjay_log(TRACE, "not an inactive server: SSID = %u", ssid);
+        return;
+    }
+
+    anjay_server_info_t *server = *server_ptr;
+    initialize_active_server_result_t result =
+            connect_active_server(anjay, server);
+    if (result == IAS_SUCCESS
+            && _anjay_sched_now(anjay->sched,
+                                &server->data_active.register_job_handle,
+                                register_server_job, &ssid, sizeof(ssid))) {
+        anjay_log(ERROR, "could not schedule registration to server SSID %u",
+                  ssid);
+        result = IAS_FAILED;
+    }
+    if (result != IAS_SUCCESS) {
+        handle_activation_failure(anjay, server, result);
+    }
 }
 
 int _anjay_server_sched_activate(anjay_t *anjay,
@@ -310,6 +365,7 @@ void _anjay_servers_add(anjay_servers_t *servers,
                "entry");
 
     AVS_LIST_INSERT(insert_ptr, server);
+    _anjay_servers_index_invalidate(servers);
 }
 
 int _anjay_server_deactivate(anjay_t *anjay,
@@ -339,6 +395,7 @@ int _anjay_server_deactivate(anjay_t *anjay,
         // not much we can do other than removing the server altogether
         anjay_log(ERROR, "could not reschedule server reactivation");
         AVS_LIST_DELETE(server_ptr);
+        _anjay_servers_index_invalidate(anjay->servers);
         return -1;
     }
     return 0;
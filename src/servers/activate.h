@@ -22,6 +22,8 @@
 #include "../anjay_core.h"
 #include "../utils_core.h"
 
+#include "register_internal.h"
+
 #ifndef ANJAY_SERVERS_INTERNALS
 #error "Headers from servers/ are not meant to be included from outside"
 #endif
@@ -43,6 +45,16 @@ int _anjay_server_sched_activate(anjay_t *anjay,
 
 int _anjay_servers_sched_reactivate_all_given_up(anjay_t *anjay);
 
+/**
+ * Concludes the activation of a non-Bootstrap @p server, started by
+ * register_server_job(), with the result of the registration started using
+ * _anjay_server_ensure_valid_registration().
+ */
+void _anjay_server_registration_finished(
+        anjay_t *anjay,
+        anjay_server_info_t *server,
+        anjay_registration_result_t registration_result);
+
 /**
  * Inserts an active server entry into @p servers .
  *
@@ -30,6 +30,7 @@
 
 #include "connection_info.h"
 #include "connections_internal.h"
+#include "dtls_session_cache.h"
 #include "reload.h"
 #include "servers_internal.h"
 
@@ -41,7 +42,15 @@ avs_net_abstract_socket_t *_anjay_connection_internal_get_socket(
 }
 
 void
-_anjay_connection_internal_clean_socket(anjay_server_connection_t *connection) {
+_anjay_connection_internal_clean_socket(const anjay_t *anjay,
+                                        anjay_server_connection_t *connection) {
+    if (connection->conn_socket_ && anjay->comm_stream) {
+        _anjay_coap_stream_forget_socket(anjay->comm_stream,
+                                         connection->conn_socket_);
+    }
+    if (connection->conn_socket_) {
+        _anjay_servers_index_invalidate(anjay->servers);
+    }
     avs_net_socket_cleanup(&connection->conn_socket_);
 }
 
@@ -91,6 +100,25 @@ bool _anjay_connection_is_online(anjay_server_connection_t *connection) {
     return opt.state == AVS_NET_SOCKET_STATE_CONNECTED;
 }
 
+static void load_dtls_session(anjay_t *anjay,
+                              anjay_server_connection_t *connection,
+                              const anjay_url_t *uri) {
+    anjay_server_connection_nontransient_state_t *state =
+            &connection->nontransient_state;
+    if (_anjay_dtls_session_cache_load(&anjay->dtls_session_cache,
+                                       uri->host, uri->port,
+                                       &state->dtls_session_buffer)
+            && (strcmp(state->dtls_session_host, uri->host)
+                    || strcmp(state->dtls_session_port, uri->port))) {
+        // not cached, and the session in the buffer (if any) has been
+        // negotiated with a different server - do not offer it
+        memset(state->dtls_session_buffer, 0,
+               sizeof(state->dtls_session_buffer));
+    }
+    strcpy(state->dtls_session_host, uri->host);
+    strcpy(state->dtls_session_port, uri->port);
+}
+
 static int recreate_socket(anjay_t *anjay,
                            const anjay_connection_type_definition_t *def,
                            anjay_server_connection_t *connection,
@@ -106,7 +134,8 @@ static int recreate_socket(anjay_t *anjay,
                   def->name, ANJAY_DM_OID_SECURITY, inout_info->security_iid);
         return -1;
     }
-    _anjay_connection_internal_clean_socket(connection);
+    _anjay_connection_internal_clean_socket(anjay, connection);
+    load_dtls_session(anjay, connection, inout_info->uri);
 
     // Socket configuration is slightly different between UDP and SMS
     // connections. That's why we do the common configuration here...
@@ -124,6 +153,7 @@ static int recreate_socket(anjay_t *anjay,
     if (!result) {
         result = def->create_connected_socket(anjay, connection, &socket_config,
                                               inout_info);
+        _anjay_servers_index_invalidate(anjay->servers);
     }
     if (!result) {
         avs_net_socket_opt_value_t session_resumed;
@@ -133,6 +163,11 @@ static int recreate_socket(anjay_t *anjay,
             *out_session_resumed = false;
         } else {
             *out_session_resumed = session_resumed.flag;
+            _anjay_dtls_session_cache_handshake_done(
+                    &anjay->dtls_session_cache, inout_info->uri->host,
+                    inout_info->uri->port,
+                    connection->nontransient_state.dtls_session_buffer,
+                    session_resumed.flag);
         }
     } else {
         avs_net_abstract_socket_t *sock = connection->conn_socket_;
@@ -260,7 +295,7 @@ refresh_connection(anjay_t *anjay,
     out_connection->mode = _anjay_get_connection_mode(inout_info->binding_mode,
                                                       ref.conn_type);
     if (out_connection->mode == ANJAY_CONNECTION_DISABLED) {
-        _anjay_connection_internal_clean_socket(out_connection);
+        _anjay_connection_internal_clean_socket(anjay, out_connection);
     } else {
         result = ensure_socket_connected(anjay, def, out_connection, inout_info,
                                          out_socket_errno);
@@ -425,6 +460,10 @@ _anjay_connection_internal_bring_online(anjay_t *anjay,
         *out_session_resumed = !*remote_port;
     } else {
         *out_session_resumed = session_resumed.flag;
+        _anjay_dtls_session_cache_handshake_done(
+                &anjay->dtls_session_cache, remote_hostname, remote_port,
+                connection->nontransient_state.dtls_session_buffer,
+                session_resumed.flag);
     }
     anjay_log(INFO, "%s to %s:%s",
               *out_session_resumed ? "resumed connection" : "reconnected",
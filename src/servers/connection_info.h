@@ -29,6 +29,9 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 typedef struct {
     avs_net_resolved_endpoint_t preferred_endpoint;
     char dtls_session_buffer[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    // peer that dtls_session_buffer has been most recently used with
+    char dtls_session_host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char dtls_session_port[ANJAY_MAX_URL_PORT_SIZE];
     char last_local_port[ANJAY_MAX_URL_PORT_SIZE];
 } anjay_server_connection_nontransient_state_t;
 
@@ -122,7 +125,8 @@ avs_net_abstract_socket_t *_anjay_connection_internal_get_socket(
         const anjay_server_connection_t *connection);
 
 void
-_anjay_connection_internal_clean_socket(anjay_server_connection_t *connection);
+_anjay_connection_internal_clean_socket(const anjay_t *anjay,
+                                        anjay_server_connection_t *connection);
 
 bool _anjay_connection_is_online(anjay_server_connection_t *connection);
 
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+#ifdef WITH_AVS_PERSISTENCE
+#include <avsystem/commons/persistence.h>
+#endif // WITH_AVS_PERSISTENCE
+
+#define ANJAY_SERVERS_INTERNALS
+
+#include "dtls_session_cache.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+struct anjay_dtls_session_cache_entry_struct {
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char port[ANJAY_MAX_URL_PORT_SIZE];
+    char session[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+};
+
+#if ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+static AVS_LIST(anjay_dtls_session_cache_entry_t) *
+find_entry_ptr(anjay_dtls_session_cache_t *cache,
+               const char *host,
+               const char *port) {
+    AVS_LIST(anjay_dtls_session_cache_entry_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &cache->entries) {
+        if (!strcmp((*entry_ptr)->host, host)
+                && !strcmp((*entry_ptr)->port, port)) {
+            return entry_ptr;
+        }
+    }
+    return NULL;
+}
+
+static bool session_empty(const char *session) {
+    for (size_t i = 0; i < ANJAY_DTLS_SESSION_BUFFER_SIZE; ++i) {
+        if (session[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void store_session(anjay_dtls_session_cache_t *cache,
+                          const char *host,
+                          const char *port,
+                          const char *session) {
+    if (session_empty(session)
+            || strlen(host) >= ANJAY_MAX_URL_HOSTNAME_SIZE
+            || strlen(port) >= ANJAY_MAX_URL_PORT_SIZE) {
+        return;
+    }
+
+    AVS_LIST(anjay_dtls_session_cache_entry_t) entry = NULL;
+    AVS_LIST(anjay_dtls_session_cache_entry_t) *entry_ptr =
+            find_entry_ptr(cache, host, port);
+    if (entry_ptr) {
+        entry = AVS_LIST_DETACH(entry_ptr);
+    } else if (AVS_LIST_SIZE(cache->entries)
+                   >= ANJAY_DTLS_SESSION_CACHE_SIZE) {
+        // reuse the least recently used entry
+        entry = AVS_LIST_DETACH(AVS_LIST_NTH_PTR(
+                &cache->entries, (size_t) ANJAY_DTLS_SESSION_CACHE_SIZE - 1));
+    } else if (!(entry = AVS_LIST_NEW_ELEMENT(
+                        anjay_dtls_session_cache_entry_t))) {
+        anjay_log(ERROR, "out of memory");
+        return;
+    }
+    // the entry may be a reused one; clear it so that no bytes of the previous
+    // host name or port past the terminator are ever persisted
+    memset(entry, 0, sizeof(*entry));
+    strcpy(entry->host, host);
+    strcpy(entry->port, port);
+    memcpy(entry->session, session, sizeof(entry->session));
+    AVS_LIST_INSERT(&cache->entries, entry);
+}
+#endif // ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+
+int _anjay_dtls_session_cache_load(
+        anjay_dtls_session_cache_t *cache,
+        const char *host,
+        const char *port,
+        char (*out_session)[ANJAY_DTLS_SESSION_BUFFER_SIZE]) {
+#if ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+    AVS_LIST(anjay_dtls_session_cache_entry_t) *entry_ptr =
+            find_entry_ptr(cache, host, port);
+    if (entry_ptr) {
+        memcpy(*out_session, (*entry_ptr)->session, sizeof(*out_session));
+        return 0;
+    }
+#else // ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+    (void) cache; (void) host; (void) port; (void) out_session;
+#endif // ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+    return -1;
+}
+
+void _anjay_dtls_session_cache_handshake_done(
+        anjay_dtls_session_cache_t *cache,
+        const char *host,
+        const char *port,
+        const char *session,
+        bool resumed) {
+    ++cache->num_handshakes;
+    if (resumed) {
+        ++cache->num_resumed;
+    }
+#if ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+    store_session(cache, host, port, session);
+#else // ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+    (void) host; (void) port; (void) session;
+#endif // ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+}
+
+void _anjay_dtls_session_cache_cleanup(anjay_dtls_session_cache_t *cache) {
+    AVS_LIST_CLEAR(&cache->entries);
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+
+static const char MAGIC[] = { 'D', 'T', 'S', '\1' };
+
+static int handle_sized_field(avs_persistence_context_t *ctx,
+                              char *field,
+                              uint32_t size) {
+    uint32_t stored_size = size;
+    int retval = avs_persistence_u32(ctx, &stored_size);
+    if (!retval && stored_size != size) {
+        anjay_log(ERROR, "invalid field size in persisted DTLS session");
+        retval = -1;
+    }
+    if (!retval) {
+        retval = avs_persistence_bytes(ctx, (uint8_t *) field, size);
+    }
+    return retval;
+}
+
+static int handle_entry(avs_persistence_context_t *ctx,
+                        anjay_dtls_session_cache_entry_t *entry) {
+    int retval;
+    (void) ((retval = handle_sized_field(ctx, entry->host,
+                                         sizeof(entry->host)))
+            || (retval = handle_sized_field(ctx, entry->port,
+                                            sizeof(entry->port)))
+            || (retval = handle_sized_field(ctx, entry->session,
+                                            sizeof(entry->session))));
+    if (!retval && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE
+            && (!memchr(entry->host, '\0', sizeof(entry->host))
+                    || !memchr(entry->port, '\0', sizeof(entry->port)))) {
+        anjay_log(ERROR, "malformed persisted DTLS session");
+        retval = -1;
+    }
+    return retval;
+}
+
+int _anjay_dtls_session_cache_persist(anjay_dtls_session_cache_t *cache,
+                                      avs_stream_abstract_t *out) {
+    int retval = avs_stream_write(out, MAGIC, sizeof(MAGIC));
+    if (retval) {
+        return retval;
+    }
+    avs_persistence_context_t *ctx = avs_persistence_store_context_new(out);
+    if (!ctx) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+
+    uint32_t count = (uint32_t) AVS_LIST_SIZE(cache->entries);
+    if (!(retval = avs_persistence_u32(ctx, &count))) {
+        AVS_LIST(anjay_dtls_session_cache_entry_t) entry;
+        AVS_LIST_FOREACH(entry, cache->entries) {
+            if ((retval = handle_entry(ctx, entry))) {
+                break;
+            }
+        }
+    }
+    avs_persistence_context_delete(ctx);
+    return retval;
+}
+
+int _anjay_dtls_session_cache_restore(anjay_dtls_session_cache_t *cache,
+                                      avs_stream_abstract_t *in) {
+    char magic_header[sizeof(MAGIC)];
+    int retval = avs_stream_read_reliably(in,
+                                          magic_header, sizeof(magic_header));
+    if (retval) {
+        anjay_log(ERROR, "magic constant not found");
+        return retval;
+    }
+    if (memcmp(magic_header, MAGIC, sizeof(MAGIC))) {
+        anjay_log(ERROR, "header magic constant mismatch");
+        return -1;
+    }
+
+    avs_persistence_context_t *ctx = avs_persistence_restore_context_new(in);
+    if (!ctx) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+
+    AVS_LIST(anjay_dtls_session_cache_entry_t) entries = NULL;
+    AVS_LIST(anjay_dtls_session_cache_entry_t) *tail_ptr = &entries;
+    uint32_t count;
+    uint32_t restored = 0;
+    if (!(retval = avs_persistence_u32(ctx, &count))) {
+        while (!retval && restored < count) {
+            AVS_LIST(anjay_dtls_session_cache_entry_t) entry =
+                    AVS_LIST_NEW_ELEMENT(anjay_dtls_session_cache_entry_t);
+            if (!entry) {
+                anjay_log(ERROR, "out of memory");
+                retval = -1;
+            } else if ((retval = handle_entry(ctx, entry))) {
+                AVS_LIST_DELETE(&entry);
+            } else if (++restored > ANJAY_DTLS_SESSION_CACHE_SIZE) {
+                // stored by a build with a larger cache; keep the most
+                // recently used entries only
+                AVS_LIST_DELETE(&entry);
+            } else {
+                AVS_LIST_INSERT(tail_ptr, entry);
+                tail_ptr = AVS_LIST_NEXT_PTR(tail_ptr);
+            }
+        }
+    }
+    avs_persistence_context_delete(ctx);
+
+    if (retval) {
+        AVS_LIST_CLEAR(&entries);
+        return retval;
+    }
+    AVS_LIST_CLEAR(&cache->entries);
+    cache->entries = entries;
+    anjay_log(INFO, "%lu DTLS sessions restored",
+              (unsigned long) AVS_LIST_SIZE(entries));
+    return 0;
+}
+
+#else // WITH_AVS_PERSISTENCE
+
+int _anjay_dtls_session_cache_persist(anjay_dtls_session_cache_t *cache,
+                                      avs_stream_abstract_t *out) {
+    (void) cache; (void) out;
+    anjay_log(ERROR, "Persistence not compiled in");
+    return -1;
+}
+
+int _anjay_dtls_session_cache_restore(anjay_dtls_session_cache_t *cache,
+                                      avs_stream_abstract_t *in) {
+    (void) cache; (void) in;
+    anjay_log(ERROR, "Persistence not compiled in");
+    return -1;
+}
+
+#endif // WITH_AVS_PERSISTENCE
+
+#ifdef ANJAY_TEST
+#include "test/dtls_session_cache.c"
+#endif // ANJAY_TEST
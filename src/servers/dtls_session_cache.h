@@ -0,0 +1,57 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_SERVERS_DTLS_SESSION_CACHE_H
+#define ANJAY_SERVERS_DTLS_SESSION_CACHE_H
+
+#include "../servers.h"
+
+#if !defined(ANJAY_SERVERS_INTERNALS) && !defined(ANJAY_TEST)
+#error "Headers from servers/ are not meant to be included from outside"
+#endif
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Fills @p out_session with the session cached for @p host and @p port , if
+ * there is one.
+ *
+ * @returns 0 on success, or -1 if no session is cached for that server (which
+ *          is always the case if ANJAY_DTLS_SESSION_CACHE_SIZE is 0). In the
+ *          latter case, @p out_session is left intact.
+ */
+int _anjay_dtls_session_cache_load(
+        anjay_dtls_session_cache_t *cache,
+        const char *host,
+        const char *port,
+        char (*out_session)[ANJAY_DTLS_SESSION_BUFFER_SIZE]);
+
+/**
+ * Records a successful DTLS handshake with @p host and @p port in the
+ * statistics, and stores @p session - the contents of the session resumption
+ * buffer used for the handshake, ANJAY_DTLS_SESSION_BUFFER_SIZE bytes long - as
+ * the most recently used cache entry.
+ */
+void _anjay_dtls_session_cache_handshake_done(
+        anjay_dtls_session_cache_t *cache,
+        const char *host,
+        const char *port,
+        const char *session,
+        bool resumed);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_SERVERS_DTLS_SESSION_CACHE_H
@@ -51,7 +51,8 @@ static void enter_offline_job(anjay_t *anjay, const void *dummy) {
                 anjay_server_connection_t *connection =
                         _anjay_get_server_connection(ref);
                 if (connection) {
-                    _anjay_connection_internal_clean_socket(connection);
+                    _anjay_connection_internal_clean_socket(anjay,
+                                                            connection);
                 }
             }
             server->data_inactive.reactivate_time = now;
@@ -17,6 +17,7 @@
 #include <anjay_config.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 #include <anjay_modules/time_defs.h>
 
@@ -24,6 +25,7 @@
 
 #include "../anjay_core.h"
 #include "../servers.h"
+#include "../coap_async.h"
 #include "../servers_utils.h"
 #include "../interface/register.h"
 
@@ -44,42 +46,7 @@ VISIBILITY_SOURCE_BEGIN
  * seconds. */
 #define ANJAY_MIN_UPDATE_INTERVAL_S 1
 
-static void send_update_sched_job(anjay_t *anjay, const void *ssid_ptr) {
-    anjay_ssid_t ssid = *(const anjay_ssid_t *) ssid_ptr;
-    assert(ssid != ANJAY_SSID_ANY);
-
-    AVS_LIST(anjay_server_info_t) server =
-            _anjay_servers_find_active(anjay, ssid);
-    if (!server) {
-        return;
-    }
-
-    if (_anjay_active_server_refresh(anjay, server)) {
-        if (!_anjay_server_registration_expired(server)) {
-            goto retry;
-        }
-    } else if (ssid == ANJAY_SSID_BOOTSTRAP) {
-        return;
-    } else {
-        switch (_anjay_server_registration_update(anjay, server)) {
-        case ANJAY_UPDATE_SUCCESS:
-            return;
-        case ANJAY_UPDATE_NEEDS_REGISTRATION:
-            break;
-        case ANJAY_UPDATE_FAILED:
-            goto retry;
-        }
-    }
-    // mark that the registration is expired; prevents superfluous Deregister
-    server->data_active.registration_info.expire_time = AVS_TIME_REAL_INVALID;
-    _anjay_server_deactivate(anjay, ssid, AVS_TIME_DURATION_ZERO);
-    return;
-retry:
-    if (_anjay_servers_schedule_next_retryable(anjay->sched, server,
-                                               send_update_sched_job, ssid)) {
-        anjay_log(ERROR, "could not reschedule send_update_sched_job");
-    }
-}
+static void send_update_sched_job(anjay_t *anjay, const void *ssid_ptr);
 
 /**
  * Returns the duration that we should reserve before expiration of lifetime for
@@ -237,19 +204,122 @@ int _anjay_schedule_server_reconnect(anjay_t *anjay,
     return _anjay_schedule_reload_server(anjay, server);
 }
 
-static int registration_update_with_ctx(anjay_registration_update_ctx_t *ctx,
-                                        anjay_server_info_t *server) {
-    int retval = _anjay_update_registration(ctx);
-    switch (retval) {
+/**
+ * Register and Update messages are sent without waiting for the response, so
+ * that other servers and incoming requests can be handled in the meantime. The
+ * exchanges themselves are performed by the coap_async module, and their state
+ * is kept in anjay_server_info_t::data_active.registration_exchange:
+ *
+ * 1. An action is started either by send_update_sched_job()
+ *    (ANJAY_REGISTRATION_ACTION_UPDATE), or by
+ *    _anjay_server_ensure_valid_registration() during server activation
+ *    (ANJAY_REGISTRATION_ACTION_ENSURE_VALID).
+ * 2. start_exchange() sends the Register or Update message.
+ * 3. registration_response_handler() is called when the exchange is finished.
+ *    As it might be called from within anjay_serve(), it only interprets the
+ *    response and schedules registration_response_job().
+ * 4. registration_response_job() calls handle_register_result() or
+ *    handle_update_result(). These either send Register if an Update sent
+ *    during activation has been rejected, or call finish_action().
+ * 5. finish_action() reschedules the Update job and, in case of activation,
+ *    reports the result using _anjay_server_registration_finished().
+ *
+ * Deactivating the server aborts the action in progress - see
+ * _anjay_server_registration_abort().
+ */
+static anjay_coap_async_handler_t registration_response_handler;
+
+static void reset_exchange(anjay_registration_exchange_t *exchange) {
+    AVS_LIST_CLEAR(&exchange->endpoint_path);
+    memset(exchange, 0, sizeof(*exchange));
+}
+
+static void finish_action(anjay_t *anjay,
+                          anjay_server_info_t *server,
+                          anjay_registration_result_t result) {
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    assert(exchange->action != ANJAY_REGISTRATION_ACTION_NONE);
+    const anjay_registration_action_t action = exchange->action;
+    const bool update_requested = exchange->update_requested;
+    reset_exchange(exchange);
+
+    if (result == ANJAY_REGISTRATION_SUCCESS) {
+        // Ignore errors, failure to flush notifications is not fatal.
+        _anjay_observe_sched_flush(anjay, (anjay_connection_key_t) {
+            .ssid = server->ssid,
+            .type = server->data_active.primary_conn_type
+        });
+        // Updates are retryable, we only need to reschedule after success
+        if (update_requested ? reschedule_update_for_server(anjay, server)
+                             : _anjay_server_reschedule_update_job(anjay,
+                                                                   server)) {
+            result = ANJAY_REGISTRATION_FAILED;
+        }
+    }
+
+    if (action == ANJAY_REGISTRATION_ACTION_ENSURE_VALID) {
+        _anjay_server_registration_finished(anjay, server, result);
+    } else if (result != ANJAY_REGISTRATION_SUCCESS) {
+        _anjay_sched_del(anjay->sched, &server->next_action_handle);
+        if (_anjay_servers_schedule_next_retryable(anjay->sched, server,
+                                                   send_update_sched_job,
+                                                   server->ssid)) {
+            anjay_log(ERROR, "could not reschedule send_update_sched_job");
+        }
+    }
+}
+
+static void handle_register_result(anjay_t *anjay,
+                                   anjay_server_info_t *server,
+                                   int result) {
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    if (result) {
+        anjay_log(DEBUG, "re-registration failed");
+        finish_action(anjay, server,
+                      result == ANJAY_ERR_FORBIDDEN
+                              ? ANJAY_REGISTRATION_FORBIDDEN
+                              : ANJAY_REGISTRATION_FAILED);
+        return;
+    }
+
+    _anjay_server_update_registration_info(server, &exchange->endpoint_path,
+                                           &exchange->new_params);
+    // Failure to handle Bootstrap state is not a failure of the
+    // Register operation - hence, not checking return value.
+    _anjay_bootstrap_notify_regular_connection_available(anjay);
+    finish_action(anjay, server, ANJAY_REGISTRATION_SUCCESS);
+}
+
+static void start_register(anjay_t *anjay, anjay_server_info_t *server);
+
+static void handle_update_result(anjay_t *anjay,
+                                 anjay_server_info_t *server,
+                                 int result) {
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    switch (result) {
     case 0:
-        return (int) ANJAY_UPDATE_SUCCESS;
+        _anjay_server_update_registration_info(server, NULL,
+                                               &exchange->new_params);
+        finish_action(anjay, server, ANJAY_REGISTRATION_SUCCESS);
+        return;
 
     case ANJAY_REGISTRATION_UPDATE_REJECTED:
         anjay_log(DEBUG, "update rejected for SSID = %u; "
                          "needs re-registration", server->ssid);
         server->data_active.registration_info.expire_time =
                 AVS_TIME_REAL_INVALID;
-        return (int) ANJAY_UPDATE_NEEDS_REGISTRATION;
+        if (exchange->action == ANJAY_REGISTRATION_ACTION_ENSURE_VALID) {
+            start_register(anjay, server);
+        } else {
+            // Register is only sent during activation
+            reset_exchange(exchange);
+            _anjay_server_deactivate(anjay, server->ssid,
+                                     AVS_TIME_DURATION_ZERO);
+        }
+        return;
 
     case AVS_COAP_CTX_ERR_NETWORK:
         anjay_log(ERROR, "network communication error while updating "
@@ -263,142 +333,210 @@ static int registration_update_with_ctx(anjay_registration_update_ctx_t *ctx,
             .server = server,
             .conn_type = server->data_active.primary_conn_type
         });
-        return (int) ANJAY_UPDATE_FAILED;
+        break;
 
     default:
-        anjay_log(ERROR, "could not send registration update: %d", retval);
-        return (int) ANJAY_UPDATE_FAILED;
+        anjay_log(ERROR, "could not send registration update: %d", result);
+        break;
     }
+    finish_action(anjay, server, ANJAY_REGISTRATION_FAILED);
 }
 
-static int
-ensure_valid_registration_with_ctx(anjay_t *anjay,
-                                   anjay_registration_update_ctx_t *ctx,
-                                   anjay_server_info_t *server) {
-    anjay_update_result_t update_result;
-
-    if (!_anjay_server_primary_connection_valid(server)) {
-        anjay_log(INFO, "No valid existing connection to Registration "
-                  "Interface for SSID = %u, needs re-registration",
-                  server->ssid);
-        server->data_active.registration_info.expire_time =
-                AVS_TIME_REAL_INVALID;
-        update_result = ANJAY_UPDATE_NEEDS_REGISTRATION;
-    } else if (_anjay_server_registration_expired(server)) {
-        update_result = ANJAY_UPDATE_NEEDS_REGISTRATION;
-    } else if (!_anjay_needs_registration_update(ctx)) {
-        update_result = ANJAY_UPDATE_SUCCESS;
+static void handle_result(anjay_t *anjay,
+                          anjay_server_info_t *server,
+                          int result) {
+    if (server->data_active.registration_exchange.registering) {
+        handle_register_result(anjay, server, result);
     } else {
-        update_result = (anjay_update_result_t)
-                registration_update_with_ctx(ctx, server);
+        handle_update_result(anjay, server, result);
     }
+}
 
-    switch (update_result) {
-    case (int) ANJAY_UPDATE_SUCCESS:
-        return (int) ANJAY_REGISTRATION_SUCCESS;
-    case (int) ANJAY_UPDATE_NEEDS_REGISTRATION: {
-        if (!_anjay_server_primary_connection_valid(server)
-                && _anjay_server_setup_primary_connection(server)) {
-            return (int) ANJAY_REGISTRATION_FAILED;
-        }
-        int retval = _anjay_register(ctx);
-        if (retval) {
-            anjay_log(DEBUG, "re-registration failed");
-            if (retval == ANJAY_ERR_FORBIDDEN) {
-                return (int) ANJAY_REGISTRATION_FORBIDDEN;
-            } else {
-                return (int) ANJAY_REGISTRATION_FAILED;
-            }
-        } else {
-            // Failure to handle Bootstrap state is not a failure of the
-            // Register operation - hence, not checking return value.
-            _anjay_bootstrap_notify_regular_connection_available(anjay);
-            return (int) ANJAY_REGISTRATION_SUCCESS;
-        }
-    }
-    default:
-        AVS_UNREACHABLE("Invalid value of anjay_update_result_t");
-        // fall-through
-    case (int) ANJAY_UPDATE_FAILED:
-        return (int) ANJAY_REGISTRATION_FAILED;
+static void start_exchange(anjay_t *anjay, anjay_server_info_t *server) {
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    exchange->conn_type = server->data_active.primary_conn_type;
+    // set before sending, as block-wise transfers call the handler right away
+    exchange->awaiting_response = true;
+    int result = exchange->registering
+            ? _anjay_register(anjay, server, &exchange->new_params,
+                              registration_response_handler,
+                              &exchange->msg_id)
+            : _anjay_update_registration(anjay, server, &exchange->new_params,
+                                         registration_response_handler,
+                                         &exchange->msg_id);
+    if (result) {
+        exchange->awaiting_response = false;
+        handle_result(anjay, server, result);
     }
 }
 
-typedef int registration_action_t(anjay_t *anjay,
-                                  anjay_registration_update_ctx_t *ctx,
-                                  anjay_server_info_t *server);
+static void start_register(anjay_t *anjay, anjay_server_info_t *server) {
+    server->data_active.registration_exchange.registering = true;
+    if (!_anjay_server_primary_connection_valid(server)
+            && _anjay_server_setup_primary_connection(server)) {
+        finish_action(anjay, server, ANJAY_REGISTRATION_FAILED);
+        return;
+    }
+    start_exchange(anjay, server);
+}
 
-static int perform_registration_action(anjay_t *anjay,
-                                       anjay_server_info_t *server,
-                                       registration_action_t *action) {
-    assert(_anjay_server_active(server));
-    assert(server->ssid != ANJAY_SSID_BOOTSTRAP);
+static void registration_response_job(anjay_t *anjay, const void *ssid_ptr) {
+    anjay_ssid_t ssid = *(const anjay_ssid_t *) ssid_ptr;
 
-    anjay_registration_update_ctx_t ctx;
-    if (_anjay_registration_update_ctx_init(anjay, &ctx, server)) {
-        return -1;
+    anjay_server_info_t *server = _anjay_servers_find_active(anjay, ssid);
+    if (server) {
+        handle_result(anjay, server,
+                      server->data_active.registration_exchange
+                              .response_result);
     }
+}
 
-    int retval = action(anjay, &ctx, server);
-    if (!retval) {
-        // Ignore errors, failure to flush notifications is not fatal.
-        _anjay_observe_sched_flush(anjay, (anjay_connection_key_t) {
-            .ssid = server->ssid,
-            .type = server->data_active.primary_conn_type
-        });
+static void registration_response_handler(anjay_t *anjay,
+                                          anjay_connection_key_t key,
+                                          uint16_t msg_id,
+                                          anjay_coap_async_result_t result,
+                                          const avs_coap_msg_t *response) {
+    anjay_server_info_t *server = _anjay_servers_find_active(anjay, key.ssid);
+    if (!server) {
+        return;
     }
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    if (!exchange->awaiting_response
+            || exchange->conn_type != key.type
+            || exchange->msg_id != msg_id) {
+        anjay_log(DEBUG, "ignoring stale registration response for SSID %u",
+                  key.ssid);
+        return;
+    }
+    exchange->awaiting_response = false;
 
-    _anjay_registration_update_ctx_release(&ctx);
-
-    if (!retval && _anjay_server_reschedule_update_job(anjay, server)) {
-        // Updates are retryable, we only need to reschedule after success
-        retval = -1;
+    if (exchange->registering) {
+        exchange->response_result = _anjay_register_check_response(
+                result, response, &exchange->endpoint_path);
+    } else {
+        exchange->response_result =
+                _anjay_update_check_response(result, response);
+    }
+    if (_anjay_sched_now(anjay->sched, &exchange->response_job,
+                         registration_response_job,
+                         &key.ssid, sizeof(key.ssid))) {
+        anjay_log(ERROR, "could not schedule registration_response_job");
+        // don't leave the server waiting for a response forever; failing the
+        // action does not involve sending anything, so it's safe to do here
+        finish_action(anjay, server, ANJAY_REGISTRATION_FAILED);
     }
-    return retval;
 }
 
-static int
-registration_update_if_possible_with_ctx(anjay_t *anjay,
-                                         anjay_registration_update_ctx_t *ctx,
-                                         anjay_server_info_t *server) {
-    (void) anjay;
-
-    if (!_anjay_server_primary_connection_valid(server)) {
+void _anjay_server_ensure_valid_registration(anjay_t *anjay,
+                                             anjay_server_info_t *server) {
+    assert(_anjay_server_active(server));
+    assert(server->ssid != ANJAY_SSID_BOOTSTRAP);
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    assert(exchange->action == ANJAY_REGISTRATION_ACTION_NONE);
+
+    exchange->action = ANJAY_REGISTRATION_ACTION_ENSURE_VALID;
+    if (_anjay_registration_update_params_init(anjay, server,
+                                               &exchange->new_params)) {
+        finish_action(anjay, server, ANJAY_REGISTRATION_FAILED);
+    } else if (!_anjay_server_primary_connection_valid(server)) {
         anjay_log(INFO, "No valid existing connection to Registration "
                   "Interface for SSID = %u, needs re-registration",
                   server->ssid);
         server->data_active.registration_info.expire_time =
                 AVS_TIME_REAL_INVALID;
-        return (int) ANJAY_UPDATE_NEEDS_REGISTRATION;
+        start_register(anjay, server);
+    } else if (_anjay_server_registration_expired(server)) {
+        start_register(anjay, server);
+    } else if (!_anjay_needs_registration_update(server,
+                                                 &exchange->new_params)) {
+        finish_action(anjay, server, ANJAY_REGISTRATION_SUCCESS);
+    } else {
+        start_exchange(anjay, server);
     }
+}
 
-    if (_anjay_server_registration_expired(server)) {
-        return (int) ANJAY_UPDATE_NEEDS_REGISTRATION;
+static void send_update_sched_job(anjay_t *anjay, const void *ssid_ptr) {
+    anjay_ssid_t ssid = *(const anjay_ssid_t *) ssid_ptr;
+    assert(ssid != ANJAY_SSID_ANY);
+
+    AVS_LIST(anjay_server_info_t) server =
+            _anjay_servers_find_active(anjay, ssid);
+    if (!server) {
+        return;
+    }
+
+    if (server->data_active.register_job_handle) {
+        // register_server_job() will send Update anyway if it is necessary
+        return;
+    }
+
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    if (exchange->action != ANJAY_REGISTRATION_ACTION_NONE) {
+        // finish_action() will reschedule this job
+        exchange->update_requested = true;
+        return;
     }
 
-    return registration_update_with_ctx(ctx, server);
+    if (_anjay_active_server_refresh(anjay, server)) {
+        if (!_anjay_server_registration_expired(server)) {
+            goto retry;
+        }
+    } else if (ssid == ANJAY_SSID_BOOTSTRAP) {
+        return;
+    } else if (!_anjay_server_primary_connection_valid(server)) {
+        anjay_log(INFO, "No valid existing connection to Registration "
+                  "Interface for SSID = %u, needs re-registration",
+                  server->ssid);
+    } else if (!_anjay_server_registration_expired(server)) {
+        exchange->action = ANJAY_REGISTRATION_ACTION_UPDATE;
+        if (_anjay_registration_update_params_init(anjay, server,
+                                                   &exchange->new_params)) {
+            finish_action(anjay, server, ANJAY_REGISTRATION_FAILED);
+        } else {
+            start_exchange(anjay, server);
+        }
+        return;
+    }
+    // mark that the registration is expired; prevents superfluous Deregister
+    server->data_active.registration_info.expire_time = AVS_TIME_REAL_INVALID;
+    _anjay_server_deactivate(anjay, ssid, AVS_TIME_DURATION_ZERO);
+    return;
+retry:
+    if (_anjay_servers_schedule_next_retryable(anjay->sched, server,
+                                               send_update_sched_job, ssid)) {
+        anjay_log(ERROR, "could not reschedule send_update_sched_job");
+    }
 }
 
-anjay_update_result_t
-_anjay_server_registration_update(anjay_t *anjay,
-                                  anjay_server_info_t *server) {
-    int result = perform_registration_action(
-            anjay, server, registration_update_if_possible_with_ctx);
-    return result >= 0 ? (anjay_update_result_t) result : ANJAY_UPDATE_FAILED;
+bool _anjay_server_registration_in_progress(anjay_server_info_t *server) {
+    return server->data_active.register_job_handle
+            || server->data_active.registration_exchange.action
+                       != ANJAY_REGISTRATION_ACTION_NONE;
 }
 
-anjay_registration_result_t
-_anjay_server_ensure_valid_registration(anjay_t *anjay,
-                                        anjay_server_info_t *server) {
-    int result = perform_registration_action(
-            anjay, server, ensure_valid_registration_with_ctx);
-    return result >= 0
-            ? (anjay_registration_result_t) result : ANJAY_REGISTRATION_FAILED;
+void _anjay_server_registration_abort(anjay_t *anjay,
+                                      anjay_server_info_t *server) {
+    anjay_registration_exchange_t *exchange =
+            &server->data_active.registration_exchange;
+    if (exchange->awaiting_response) {
+        _anjay_coap_async_cancel(anjay, (anjay_connection_key_t) {
+            .ssid = server->ssid,
+            .type = exchange->conn_type
+        }, exchange->msg_id);
+    }
+    _anjay_sched_del(anjay->sched, &exchange->response_job);
+    reset_exchange(exchange);
 }
 
 int _anjay_server_deregister(anjay_t *anjay,
                              anjay_server_info_t *server) {
     assert(_anjay_server_active(server));
+    // Deregister supersedes any Register or Update still in progress
+    _anjay_server_registration_abort(anjay, server);
     anjay_connection_ref_t connection = {
         .server = server,
         .conn_type = server->data_active.primary_conn_type
@@ -446,16 +584,7 @@ void _anjay_server_update_registration_info(
     }
 
     if (move_params && move_params != &info->last_update_params) {
-        AVS_LIST(anjay_dm_cache_object_t) tmp = info->last_update_params.dm;
-        info->last_update_params.dm = move_params->dm;
-        move_params->dm = tmp;
-
-        info->last_update_params.lifetime_s = move_params->lifetime_s;
-        memcpy(&info->last_update_params.binding_mode,
-               &move_params->binding_mode,
-               sizeof(info->last_update_params.binding_mode));
-
-        _anjay_update_parameters_cleanup(move_params);
+        info->last_update_params = *move_params;
     }
 
     info->expire_time =
@@ -28,22 +28,6 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 bool
 _anjay_server_primary_connection_valid(anjay_server_info_t *server);
 
-typedef enum {
-    ANJAY_UPDATE_SUCCESS = 0,
-    ANJAY_UPDATE_NEEDS_REGISTRATION,
-    ANJAY_UPDATE_FAILED
-} anjay_update_result_t;
-
-/**
- * Sends the Update message.
- *
- * @param anjay  Anjay object to operate on.
- * @param server Active non-bootstrap server for which to manage the
- *               registration state.
- */
-anjay_update_result_t
-_anjay_server_registration_update(anjay_t *anjay, anjay_server_info_t *server);
-
 typedef enum {
     ANJAY_REGISTRATION_SUCCESS = 0,
     ANJAY_REGISTRATION_FAILED,
@@ -51,18 +35,34 @@ typedef enum {
 } anjay_registration_result_t;
 
 /**
- * Makes sure that the @p server has a valid registration state. May send
- * Register or Update messages as necessary. If the server is already properly
- * registered, does nothing - unless
- * server->data_active.registration_info.needs_update is set.
+ * Starts making sure that the @p server has a valid registration state. May
+ * send Register or Update messages as necessary. If the server is already
+ * properly registered, does nothing - unless the Lifetime, Binding or the list
+ * of Objects and Object Instances changed since the last Register or Update.
+ *
+ * The messages are sent asynchronously. The result is reported by calling
+ * _anjay_server_registration_finished(), possibly before this function
+ * returns.
  *
  * @param anjay  Anjay object to operate on.
  * @param server Active non-bootstrap server for which to manage the
  *               registration state.
  */
-anjay_registration_result_t
-_anjay_server_ensure_valid_registration(anjay_t *anjay,
-                                        anjay_server_info_t *server);
+void _anjay_server_ensure_valid_registration(anjay_t *anjay,
+                                             anjay_server_info_t *server);
+
+/**
+ * Checks whether a Register or Update exchange with @p server is in progress,
+ * or about to be started by register_server_job().
+ */
+bool _anjay_server_registration_in_progress(anjay_server_info_t *server);
+
+/**
+ * Aborts the Register or Update exchange with @p server that is in progress, if
+ * any. Its result is not reported anywhere.
+ */
+void _anjay_server_registration_abort(anjay_t *anjay,
+                                      anjay_server_info_t *server);
 
 int _anjay_server_reschedule_update_job(anjay_t *anjay,
                                         anjay_server_info_t *server);
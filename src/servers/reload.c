@@ -33,9 +33,11 @@ static int reload_active_server(anjay_t *anjay,
                                 anjay_server_info_t *server) {
     assert(_anjay_server_active(server));
     if (server->ssid != ANJAY_SSID_BOOTSTRAP
+            && !_anjay_server_registration_in_progress(server)
             && _anjay_server_registration_expired(server)) {
         // Registration expired - we need to re-register, but we only call
         // Register from activate_server, so we need to deactivate first.
+        // That's not necessary if the Register is already in progress.
         goto deactivate;
     }
 
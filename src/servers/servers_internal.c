@@ -72,18 +72,20 @@ int _anjay_servers_schedule_next_retryable(anjay_sched_t *sched,
 
 static void connection_cleanup(const anjay_t *anjay,
                                anjay_server_connection_t *connection) {
-    _anjay_connection_internal_clean_socket(connection);
+    _anjay_connection_internal_clean_socket(anjay, connection);
     _anjay_sched_del(anjay->sched,
                      &connection->queue_mode_close_socket_clb_handle);
 }
 
-void _anjay_server_clean_active_data(const anjay_t *anjay,
+void _anjay_server_clean_active_data(anjay_t *anjay,
                                      anjay_server_info_t *server) {
     _anjay_sched_del(anjay->sched, &server->next_action_handle);
+    _anjay_sched_del(anjay->sched, &server->data_active.register_job_handle);
+    _anjay_server_registration_abort(anjay, server);
     connection_cleanup(anjay, &server->data_active.udp_connection);
 }
 
-void _anjay_server_cleanup(const anjay_t *anjay, anjay_server_info_t *server) {
+void _anjay_server_cleanup(anjay_t *anjay, anjay_server_info_t *server) {
     anjay_log(TRACE, "clear_server SSID %u", server->ssid);
 
     _anjay_server_clean_active_data(anjay, server);
@@ -95,6 +97,112 @@ anjay_servers_t *_anjay_servers_create(void) {
     return (anjay_servers_t *) avs_calloc(1, sizeof(anjay_servers_t));
 }
 
+void _anjay_servers_index_invalidate(anjay_servers_t *servers) {
+    if (servers) {
+        servers->index_valid = false;
+    }
+}
+
+static avs_net_abstract_socket_t *
+get_udp_socket(anjay_server_info_t *server) {
+    const anjay_connection_ref_t ref = {
+        .server = server,
+        .conn_type = ANJAY_CONNECTION_UDP
+    };
+    anjay_server_connection_t *connection = _anjay_get_server_connection(ref);
+    assert(connection);
+    return _anjay_connection_internal_get_socket(connection);
+}
+
+static int rebuild_index(anjay_servers_t *servers) {
+    _anjay_hash_index_clear(&servers->index_by_ssid);
+    _anjay_hash_index_clear(&servers->index_by_udp_socket);
+
+    AVS_LIST(anjay_server_info_t) server;
+    AVS_LIST_FOREACH(server, servers->servers) {
+        avs_net_abstract_socket_t *socket = get_udp_socket(server);
+        if (_anjay_hash_index_put(&servers->index_by_ssid,
+                                  (uintptr_t) server->ssid, server)
+                || (socket
+                    && _anjay_hash_index_put(&servers->index_by_udp_socket,
+                                             (uintptr_t) socket, server))) {
+            _anjay_hash_index_clear(&servers->index_by_ssid);
+            _anjay_hash_index_clear(&servers->index_by_udp_socket);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @returns true if the indexes may be used for lookups, false if they could not
+ *          be rebuilt (which may only happen due to an out-of-memory
+ *          condition), in which case the servers list needs to be searched
+ *          directly.
+ */
+static bool ensure_index_valid(anjay_servers_t *servers) {
+    if (!servers->index_valid) {
+        if (rebuild_index(servers)) {
+            anjay_log(DEBUG, "could not rebuild servers index");
+            return false;
+        }
+        servers->index_valid = true;
+    }
+    return true;
+}
+
+static void index_cleanup(anjay_servers_t *servers) {
+    _anjay_hash_index_cleanup(&servers->index_by_ssid);
+    _anjay_hash_index_cleanup(&servers->index_by_udp_socket);
+    servers->index_valid = false;
+}
+
+anjay_server_info_t *
+_anjay_servers_find_by_udp_socket(anjay_t *anjay,
+                                  avs_net_abstract_socket_t *socket) {
+    assert(socket);
+    anjay_server_info_t *server = NULL;
+    if (ensure_index_valid(anjay->servers)) {
+        server = (anjay_server_info_t *) _anjay_hash_index_get(
+                &anjay->servers->index_by_udp_socket, (uintptr_t) socket);
+    } else {
+        AVS_LIST_FOREACH(server, anjay->servers->servers) {
+            if (get_udp_socket(server) == socket) {
+                break;
+            }
+        }
+    }
+
+    const anjay_connection_ref_t ref = {
+        .server = server,
+        .conn_type = ANJAY_CONNECTION_UDP
+    };
+    if (server && _anjay_connection_get_online_socket(ref) == socket) {
+        return server;
+    }
+    return NULL;
+}
+
+anjay_server_info_t *_anjay_servers_find_active(anjay_t *anjay,
+                                                anjay_ssid_t ssid) {
+    anjay_server_info_t *server = NULL;
+    if (ensure_index_valid(anjay->servers)) {
+        server = (anjay_server_info_t *) _anjay_hash_index_get(
+                &anjay->servers->index_by_ssid, (uintptr_t) ssid);
+    } else {
+        AVS_LIST(anjay_server_info_t) *server_ptr =
+                _anjay_servers_find_ptr(anjay->servers, ssid);
+        if (server_ptr) {
+            server = *server_ptr;
+        }
+    }
+
+    if (server && server->ssid == ssid && _anjay_server_active(server)) {
+        return server;
+    }
+    return NULL;
+}
+
 void _anjay_servers_internal_deregister(anjay_t *anjay,
                                         anjay_servers_t *servers) {
     AVS_LIST(anjay_server_info_t) server;
@@ -115,6 +223,7 @@ void _anjay_servers_internal_cleanup(anjay_t *anjay,
         _anjay_server_cleanup(anjay, servers->servers);
     }
     AVS_LIST_CLEAR(&servers->public_sockets);
+    index_cleanup(servers);
 }
 
 void _anjay_servers_deregister(anjay_t *anjay) {
@@ -139,6 +248,7 @@ void _anjay_servers_cleanup_inactive(anjay_t *anjay) {
         if (!_anjay_server_active(*server_ptr)) {
             _anjay_server_cleanup(anjay, *server_ptr);
             AVS_LIST_DELETE(server_ptr);
+            _anjay_servers_index_invalidate(anjay->servers);
         }
     }
 }
@@ -19,6 +19,7 @@
 
 #include <anjay/core.h>
 
+#include "../hash_index.h"
 #include "../servers.h"
 
 #include "connection_info.h"
@@ -46,8 +47,82 @@ struct anjay_servers_struct {
      * without requiring the user to clean it up.
      */
     AVS_LIST(anjay_socket_entry_t) public_sockets;
+
+    /**
+     * Indexes of the servers list, keyed by SSID and by UDP socket, so that
+     * _anjay_servers_find_active() and _anjay_servers_find_by_udp_socket() -
+     * the latter used for dispatching every incoming packet - do not need to
+     * walk the whole list.
+     *
+     * They are rebuilt lazily, on the first lookup after being invalidated.
+     * Any code that adds or removes entries from the servers list, or creates
+     * or destroys a server socket, MUST call _anjay_servers_index_invalidate().
+     * The values found in the indexes are still verified against the actual
+     * server state.
+     */
+    anjay_hash_index_t index_by_ssid;
+    anjay_hash_index_t index_by_udp_socket;
+    bool index_valid;
 };
 
+typedef enum {
+    ANJAY_REGISTRATION_ACTION_NONE = 0,
+    ANJAY_REGISTRATION_ACTION_UPDATE,
+    ANJAY_REGISTRATION_ACTION_ENSURE_VALID
+} anjay_registration_action_t;
+
+/**
+ * State of the Register or Update exchange in progress with a server. See the
+ * docs at the top of register_internal.c for details.
+ */
+typedef struct {
+    /**
+     * What the exchange has been started for: either a standalone Update
+     * (send_update_sched_job()) or the registration phase of server activation
+     * (_anjay_server_ensure_valid_registration()). If no exchange is in
+     * progress, it is ANJAY_REGISTRATION_ACTION_NONE and all the other fields
+     * are unused.
+     */
+    anjay_registration_action_t action;
+
+    /**
+     * True if the message in flight is Register, false if it is Update.
+     */
+    bool registering;
+
+    /**
+     * True while the message is in flight, i.e. after it has been sent and
+     * before the response handler is called. The exchange itself is managed by
+     * the coap_async module, identified by conn_type and msg_id.
+     */
+    bool awaiting_response;
+    anjay_connection_type_t conn_type;
+    uint16_t msg_id;
+
+    /**
+     * Parameters sent in the message in flight, to be stored in
+     * registration_info once it succeeds.
+     */
+    anjay_update_parameters_t new_params;
+
+    /**
+     * Job that processes the response, scheduled by the response handler
+     * (which runs inside anjay_serve() and thus cannot send anything itself).
+     * The result of checking the response and, for Register, the received
+     * endpoint path are stored in response_result and endpoint_path.
+     */
+    anjay_sched_handle_t response_job;
+    int response_result;
+    AVS_LIST(const anjay_string_t) endpoint_path;
+
+    /**
+     * Set if send_update_sched_job() has been executed while the exchange has
+     * been in progress. A new Update is then sent right after the current
+     * exchange succeeds.
+     */
+    bool update_requested;
+} anjay_registration_exchange_t;
+
 /**
  * Information about a known LwM2M server.
  *
@@ -65,7 +140,7 @@ struct anjay_servers_struct {
  *   reaction to an Execute operation on the Disable resource in the Server
  *   object.
  * - When Re-Registration to the server is necessary - it will be deactivated
- *   and activated again for Registration, as initialize_active_server() is the
+ *   and activated again for Registration, as register_server_job() is the
  *   only place in the codebase that may order sending Register message.
  * - When the library is ordered to enter into Offline mode using
  *   anjay_enter_offline() - all servers are deactivated then.
@@ -88,7 +163,9 @@ struct anjay_server_info_struct {
      *   for active servers. Scheduled either immediately (normally via
      *   anjay_schedule_registration_update()), when Update is forced, or
      *   delayed by "lifetime minus eta", scheduled after a successful Register
-     *   or Update operation.
+     *   or Update operation. While a Register or Update exchange is in
+     *   progress (see data_active.registration_exchange), it only marks that
+     *   another Update is necessary.
      * - reload_server_by_ssid_job() - reloading the server without deactivating
      *   it. It is only ever used during the _anjay_schedule_server_reconnect()
      *   execution path, so see the docs there for details.
@@ -101,8 +178,9 @@ struct anjay_server_info_struct {
      * this fields contain the delay to use for the next retry of the action
      * currently scheduled in next_action_handle.
      *
-     * That mechanism is currently in use by all the three functions mentioned
-     * above in docs for next_action_handle.
+     * That mechanism is currently in use by activate_server_job(),
+     * send_update_sched_job() and reload_server_by_ssid_job(). Failures in
+     * register_server_job() are retried via activate_server_job().
      */
     avs_time_duration_t next_retry_delay;
 
@@ -143,6 +221,21 @@ struct anjay_server_info_struct {
          * _anjay_server_update_registration_info() for details.
          */
         anjay_registration_info_t registration_info;
+
+        /**
+         * Handle to register_server_job(), i.e. the second phase of server
+         * reactivation: starting Register or Update, or Bootstrap
+         * preparation. It is scheduled immediately by activate_server_job()
+         * after the connection has been set up. It is kept separate from
+         * next_action_handle, so that scheduling e.g. an Update in the
+         * meantime does not cancel it.
+         */
+        anjay_sched_handle_t register_job_handle;
+
+        /**
+         * Register or Update exchange currently in progress, if any.
+         */
+        anjay_registration_exchange_t registration_exchange;
     } data_active;
 
     /**
@@ -219,19 +312,26 @@ int _anjay_servers_schedule_next_retryable(anjay_sched_t *sched,
                                            anjay_sched_clb_t clb,
                                            anjay_ssid_t ssid);
 
+/**
+ * Marks the indexes of @p servers as outdated. See the docs for
+ * anjay_servers_t::index_valid for details. @p servers may be NULL, in which
+ * case nothing happens.
+ */
+void _anjay_servers_index_invalidate(anjay_servers_t *servers);
+
 void _anjay_servers_internal_deregister(anjay_t *anjay,
                                         anjay_servers_t *servers);
 
 void _anjay_servers_internal_cleanup(anjay_t *anjay,
                                      anjay_servers_t *servers);
 
-void _anjay_server_clean_active_data(const anjay_t *anjay,
+void _anjay_server_clean_active_data(anjay_t *anjay,
                                      anjay_server_info_t *server);
 
 /**
  * Cleans up server data. Does not send De-Register message.
  */
-void _anjay_server_cleanup(const anjay_t *anjay, anjay_server_info_t *server);
+void _anjay_server_cleanup(anjay_t *anjay, anjay_server_info_t *server);
 
 bool _anjay_server_active(anjay_server_info_t *server);
 
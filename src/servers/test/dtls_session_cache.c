@@ -0,0 +1,164 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <stdio.h>
+
+#include <avsystem/commons/stream/stream_membuf.h>
+#include <avsystem/commons/unit/test.h>
+
+#if ANJAY_DTLS_SESSION_CACHE_SIZE > 0
+
+static void make_session(char (*out_session)[ANJAY_DTLS_SESSION_BUFFER_SIZE],
+                         char fill) {
+    memset(*out_session, fill, sizeof(*out_session));
+}
+
+static void assert_cached(anjay_dtls_session_cache_t *cache,
+                          const char *host,
+                          char fill) {
+    char expected[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    char actual[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    make_session(&expected, fill);
+    make_session(&actual, 'x');
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dtls_session_cache_load(cache, host, "5684", &actual));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(actual, expected, sizeof(expected));
+}
+
+static void assert_not_cached(anjay_dtls_session_cache_t *cache,
+                              const char *host) {
+    char expected[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    char actual[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    make_session(&expected, 'x');
+    make_session(&actual, 'x');
+    AVS_UNIT_ASSERT_FAILED(
+            _anjay_dtls_session_cache_load(cache, host, "5684", &actual));
+    // the caller decides whether to keep the current session
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(actual, expected, sizeof(expected));
+}
+
+AVS_UNIT_TEST(dtls_session_cache, store_and_load) {
+    anjay_dtls_session_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+    char session[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+
+    assert_not_cached(&cache, "example.com");
+
+    // empty sessions are counted, but not cached
+    make_session(&session, '\0');
+    _anjay_dtls_session_cache_handshake_done(&cache, "example.com", "5684",
+                                             session, false);
+    AVS_UNIT_ASSERT_NULL(cache.entries);
+
+    make_session(&session, 'a');
+    _anjay_dtls_session_cache_handshake_done(&cache, "example.com", "5684",
+                                             session, false);
+    make_session(&session, 'b');
+    _anjay_dtls_session_cache_handshake_done(&cache, "example.com", "5684",
+                                             session, true);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(cache.entries), 1);
+    assert_cached(&cache, "example.com", 'b');
+    assert_not_cached(&cache, "example.org");
+
+    AVS_UNIT_ASSERT_EQUAL(cache.num_handshakes, 3);
+    AVS_UNIT_ASSERT_EQUAL(cache.num_resumed, 1);
+
+    _anjay_dtls_session_cache_cleanup(&cache);
+}
+
+AVS_UNIT_TEST(dtls_session_cache, least_recently_used_dropped) {
+    anjay_dtls_session_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+    char session[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    char host[32];
+
+    for (int i = 0; i < ANJAY_DTLS_SESSION_CACHE_SIZE; ++i) {
+        snprintf(host, sizeof(host), "server%d", i);
+        make_session(&session, (char) ('a' + i));
+        _anjay_dtls_session_cache_handshake_done(&cache, host, "5684",
+                                                 session, false);
+    }
+    // make the first entry the most recently used one
+    make_session(&session, 'a');
+    _anjay_dtls_session_cache_handshake_done(&cache, "server0", "5684",
+                                             session, true);
+
+    make_session(&session, 'z');
+    _anjay_dtls_session_cache_handshake_done(&cache, "new", "5684",
+                                             session, false);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(cache.entries),
+                          ANJAY_DTLS_SESSION_CACHE_SIZE);
+    assert_cached(&cache, "new", 'z');
+    // the reused entry shall not retain any bytes of the previous host name
+    static const char EXPECTED_HOST[ANJAY_MAX_URL_HOSTNAME_SIZE] = "new";
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(cache.entries->host, EXPECTED_HOST,
+                                      sizeof(EXPECTED_HOST));
+#if ANJAY_DTLS_SESSION_CACHE_SIZE > 1
+    assert_cached(&cache, "server0", 'a');
+    assert_not_cached(&cache, "server1");
+#endif // ANJAY_DTLS_SESSION_CACHE_SIZE > 1
+
+    _anjay_dtls_session_cache_cleanup(&cache);
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+AVS_UNIT_TEST(dtls_session_cache, persist_and_restore) {
+    anjay_dtls_session_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+    char session[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    make_session(&session, 'a');
+    _anjay_dtls_session_cache_handshake_done(&cache, "example.com", "5684",
+                                             session, false);
+
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dtls_session_cache_persist(&cache, stream));
+
+    anjay_dtls_session_cache_t restored;
+    memset(&restored, 0, sizeof(restored));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dtls_session_cache_restore(&restored, stream));
+    assert_cached(&restored, "example.com", 'a');
+    AVS_UNIT_ASSERT_EQUAL(restored.num_handshakes, 0);
+
+    avs_stream_cleanup(&stream);
+    _anjay_dtls_session_cache_cleanup(&restored);
+    _anjay_dtls_session_cache_cleanup(&cache);
+}
+
+AVS_UNIT_TEST(dtls_session_cache, restore_truncated) {
+    anjay_dtls_session_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+    char session[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    make_session(&session, 'a');
+    _anjay_dtls_session_cache_handshake_done(&cache, "example.com", "5684",
+                                             session, false);
+
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    // valid header, followed by an entry count but no entries
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "DTS\1\0\0\0\1", 8));
+    AVS_UNIT_ASSERT_FAILED(_anjay_dtls_session_cache_restore(&cache, stream));
+    assert_cached(&cache, "example.com", 'a');
+
+    avs_stream_cleanup(&stream);
+    _anjay_dtls_session_cache_cleanup(&cache);
+}
+#endif // WITH_AVS_PERSISTENCE
+
+#endif // ANJAY_DTLS_SESSION_CACHE_SIZE > 0
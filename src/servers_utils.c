@@ -29,70 +29,6 @@
 
 VISIBILITY_SOURCE_BEGIN
 
-typedef struct {
-    avs_net_abstract_socket_t *socket;
-    anjay_server_info_t *out;
-} find_by_udp_socket_args_t;
-
-static int find_by_udp_socket_clb(anjay_t *anjay,
-                                  anjay_server_info_t *server,
-                                  void *args_) {
-    (void) anjay;
-    find_by_udp_socket_args_t *args = (find_by_udp_socket_args_t *) args_;
-    const anjay_connection_ref_t ref = {
-        .server = server,
-        .conn_type = ANJAY_CONNECTION_UDP
-    };
-    if (_anjay_connection_get_online_socket(ref) == args->socket) {
-        args->out = server;
-        return ANJAY_FOREACH_BREAK;
-    }
-    return ANJAY_FOREACH_CONTINUE;
-}
-
-anjay_server_info_t *
-_anjay_servers_find_by_udp_socket(anjay_t *anjay,
-                                  avs_net_abstract_socket_t *socket) {
-    assert(socket);
-    find_by_udp_socket_args_t arg = {
-        .socket = socket,
-        .out = NULL
-    };
-    if (_anjay_servers_foreach_active(anjay, find_by_udp_socket_clb, &arg)) {
-        return NULL;
-    }
-    return arg.out;
-}
-
-typedef struct {
-    anjay_ssid_t ssid;
-    anjay_server_info_t *out;
-} find_active_args_t;
-
-static int find_active_clb(anjay_t *anjay,
-                           anjay_server_info_t *server,
-                           void *args_) {
-    (void) anjay;
-    find_active_args_t *args = (find_active_args_t *) args_;
-    if (_anjay_server_ssid(server) == args->ssid) {
-        args->out = server;
-        return ANJAY_FOREACH_BREAK;
-    }
-    return ANJAY_FOREACH_CONTINUE;
-}
-
-anjay_server_info_t *_anjay_servers_find_active(anjay_t *anjay,
-                                                anjay_ssid_t ssid) {
-    find_active_args_t arg = {
-        .ssid = ssid,
-        .out = NULL
-    };
-    if (_anjay_servers_foreach_active(anjay, find_active_clb, &arg)) {
-        return NULL;
-    }
-    return arg.out;
-}
-
 bool _anjay_server_registration_expired(anjay_server_info_t *server) {
     const anjay_registration_info_t *registration_info =
             _anjay_server_registration_info(server);
@@ -23,6 +23,8 @@
 
 #include <anjay_test/dm.h>
 
+#include <anjay_modules/dm/modules.h>
+
 #include "../anjay_core.h"
 #include "../io/vtable.h"
 #include "../servers/servers_internal.h"
@@ -2130,6 +2132,120 @@ AVS_UNIT_TEST(dm_resource_operations, writable_resource) {
     DM_TEST_FINISH;
 }
 
+static const anjay_dm_object_def_t *const OBJ_WITH_STATIC_RIDS_INFO =
+        &(const anjay_dm_object_def_t) {
+            .oid = 668,
+            .supported_rids = ANJAY_DM_SUPPORTED_RIDS(4, 5),
+            .handlers = {
+                ANJAY_MOCK_DM_HANDLERS,
+                .resource_operations = _anjay_mock_dm_resource_operations
+            },
+            .static_rids_info = {
+                .operations = (const anjay_dm_resource_op_mask_t[]) {
+                    ANJAY_DM_RESOURCE_OP_BIT_R,
+                    ANJAY_DM_RESOURCE_OP_BIT_W
+                },
+                .always_present = (const uint8_t[]) { 0x01 }
+            }
+        };
+
+AVS_UNIT_TEST(dm_resource_operations, static_rids_info) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_STATIC_RIDS_INFO);
+    // neither resource_present nor resource_operations shall be called
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3E), PATH("668", "69", "4"),
+                    NO_PAYLOAD);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_STATIC_RIDS_INFO,
+                                           69, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ_WITH_STATIC_RIDS_INFO, 69,
+                                        4, 0, ANJAY_MOCK_DM_INT(0, 514));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID(0xFA3E),
+                            CONTENT_FORMAT(PLAINTEXT), PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    // Resource 5 is not always present, but its operations are still static
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3F), PATH("668", "69", "5"),
+                    NO_PAYLOAD);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_STATIC_RIDS_INFO,
+                                           69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ_WITH_STATIC_RIDS_INFO,
+                                           69, 5, 1);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, METHOD_NOT_ALLOWED, ID(0xFA3F),
+                            NO_PAYLOAD);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
+static const anjay_dm_module_t OVERLAY_MODULE;
+
+typedef struct {
+    int resource_present_calls;
+    int resource_operations_calls;
+} overlay_calls_t;
+
+static int overlay_resource_present(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    anjay_iid_t iid,
+                                    anjay_rid_t rid) {
+    overlay_calls_t *calls = (overlay_calls_t *)
+            _anjay_dm_module_get_arg(anjay, &OVERLAY_MODULE);
+    ++calls->resource_present_calls;
+    return _anjay_dm_resource_present(anjay, obj_ptr, iid, rid,
+                                      &OVERLAY_MODULE);
+}
+
+static int
+overlay_resource_operations(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_rid_t rid,
+                            anjay_dm_resource_op_mask_t *out) {
+    overlay_calls_t *calls = (overlay_calls_t *)
+            _anjay_dm_module_get_arg(anjay, &OVERLAY_MODULE);
+    ++calls->resource_operations_calls;
+    return _anjay_dm_resource_operations(anjay, obj_ptr, rid, out,
+                                         &OVERLAY_MODULE);
+}
+
+static const anjay_dm_module_t OVERLAY_MODULE = {
+    .overlay_handlers = {
+        .resource_present = overlay_resource_present,
+        .resource_operations = overlay_resource_operations
+    }
+};
+
+AVS_UNIT_TEST(dm_resource_operations, static_rids_info_with_overlay) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_STATIC_RIDS_INFO);
+    overlay_calls_t calls = { 0, 0 };
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_module_install(anjay, &OVERLAY_MODULE, &calls));
+
+    // the overlay handlers are called, and static information only stands in
+    // for the handlers of the Object itself
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_dm_resource_present(anjay, &OBJ_WITH_STATIC_RIDS_INFO, 69,
+                                       4, NULL),
+            1);
+    AVS_UNIT_ASSERT_EQUAL(calls.resource_present_calls, 1);
+
+    anjay_dm_resource_op_mask_t mask = ANJAY_DM_RESOURCE_OP_NONE;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_resource_operations(anjay, &OBJ_WITH_STATIC_RIDS_INFO,
+                                          5, &mask, NULL));
+    AVS_UNIT_ASSERT_EQUAL(mask, ANJAY_DM_RESOURCE_OP_BIT_W);
+    AVS_UNIT_ASSERT_EQUAL(calls.resource_operations_calls, 1);
+
+    // Resource 5 is not always present, so the Object's handler is called
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ_WITH_STATIC_RIDS_INFO,
+                                           69, 5, 0);
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_dm_resource_present(anjay, &OBJ_WITH_STATIC_RIDS_INFO, 69,
+                                       5, NULL),
+            0);
+    AVS_UNIT_ASSERT_EQUAL(calls.resource_present_calls, 2);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dm_module_uninstall(anjay, &OVERLAY_MODULE));
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(dm_res_read, no_space) {
     DM_TEST_INIT;
 
@@ -2163,3 +2279,152 @@ AVS_UNIT_TEST(dm_res_read, no_space) {
 
     DM_TEST_FINISH;
 }
+
+AVS_UNIT_TEST(dm_objects, lookup_and_unregister) {
+    DM_TEST_INIT;
+
+    static const anjay_oid_t OIDS[] = { 1000, 7, 65534, 500, 10, 32769 };
+    anjay_dm_object_def_t defs[AVS_ARRAY_SIZE(OIDS)];
+    const anjay_dm_object_def_t *def_ptrs[AVS_ARRAY_SIZE(OIDS)];
+    memset(defs, 0, sizeof(defs));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(OIDS); ++i) {
+        defs[i].oid = OIDS[i];
+        def_ptrs[i] = &defs[i];
+        AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &def_ptrs[i]));
+    }
+    AVS_UNIT_ASSERT_FAILED(anjay_register_object(anjay, &def_ptrs[3]));
+
+    for (size_t i = 1; i < anjay->dm.objects_count; ++i) {
+        AVS_UNIT_ASSERT_TRUE((*anjay->dm.objects[i - 1])->oid
+                             < (*anjay->dm.objects[i])->oid);
+    }
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(OIDS); ++i) {
+        AVS_UNIT_ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, OIDS[i])
+                             == &def_ptrs[i]);
+    }
+    AVS_UNIT_ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 8));
+    AVS_UNIT_ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 65535));
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_unregister_object(anjay, &def_ptrs[1]));
+    AVS_UNIT_ASSERT_FAILED(anjay_unregister_object(anjay, &def_ptrs[1]));
+    AVS_UNIT_ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 7));
+    AVS_UNIT_ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 10)
+                         == &def_ptrs[4]);
+
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(OIDS); ++i) {
+        if (i != 1) {
+            AVS_UNIT_ASSERT_SUCCESS(
+                    anjay_unregister_object(anjay, &def_ptrs[i]));
+        }
+    }
+    DM_TEST_FINISH;
+}
+
+static int bulk_resource_operations(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    anjay_rid_t rid,
+                                    anjay_dm_resource_op_mask_t *out) {
+    (void) anjay; (void) obj_ptr;
+    *out = (rid == 1 ? ANJAY_DM_RESOURCE_OP_BIT_W : ANJAY_DM_RESOURCE_OP_BIT_R);
+    return 0;
+}
+
+static int bulk_instance_read(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj_ptr,
+                              anjay_iid_t iid,
+                              const uint8_t *requested_rids,
+                              anjay_output_ctx_t *ctx) {
+    (void) anjay; (void) iid;
+    for (size_t i = 0; i < (*obj_ptr)->supported_rids.count; ++i) {
+        if (!ANJAY_DM_RID_REQUESTED(requested_rids, i)) {
+            continue;
+        }
+        const anjay_rid_t rid = (*obj_ptr)->supported_rids.rids[i];
+        AVS_UNIT_ASSERT_NOT_EQUAL(rid, 1);
+        int result = anjay_ret_resource_id(ctx, rid);
+        if (!result) {
+            result = anjay_ret_i32(ctx, 10 * rid + 5);
+        }
+        if (result) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+static const anjay_dm_object_def_t *const BULK_OBJ =
+        &(const anjay_dm_object_def_t) {
+            .oid = 1234,
+            .supported_rids = ANJAY_DM_SUPPORTED_RIDS(0, 1, 2),
+            .handlers = {
+                .instance_it = anjay_dm_instance_it_SINGLE,
+                .instance_present = anjay_dm_instance_present_SINGLE,
+                .resource_operations = bulk_resource_operations,
+                .instance_read = bulk_instance_read
+            }
+        };
+
+AVS_UNIT_TEST(dm_read, instance_read_handler) {
+    DM_TEST_INIT_WITH_OBJECTS(&BULK_OBJ);
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3E), PATH("1234", "0"),
+                    NO_PAYLOAD);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID(0xFA3E),
+                            CONTENT_FORMAT(TLV), PAYLOAD("\xc1\x00\x05"
+                                                         "\xc1\x02\x19"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3F), PATH("1234"),
+                    NO_PAYLOAD);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID(0xFA3F),
+                            CONTENT_FORMAT(TLV),
+                            PAYLOAD("\x08\x00\x06"
+                                    "\xc1\x00\x05"
+                                    "\xc1\x02\x19"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
+static int bulk_overlay_resource_present(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t iid,
+        anjay_rid_t rid) {
+    (void) anjay; (void) obj_ptr; (void) iid; (void) rid;
+    return 1;
+}
+
+static int bulk_overlay_resource_read(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t iid,
+        anjay_rid_t rid,
+        anjay_output_ctx_t *ctx) {
+    (void) anjay; (void) obj_ptr; (void) iid;
+    return anjay_ret_i32(ctx, 100 + rid);
+}
+
+static const anjay_dm_module_t BULK_OVERLAY_MODULE = {
+    .overlay_handlers = {
+        .resource_present = bulk_overlay_resource_present,
+        .resource_read = bulk_overlay_resource_read
+    }
+};
+
+AVS_UNIT_TEST(dm_read, instance_read_handler_with_overlay) {
+    DM_TEST_INIT_WITH_OBJECTS(&BULK_OBJ);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_module_install(anjay, &BULK_OVERLAY_MODULE, NULL));
+
+    // the overlay does not implement instance_read, so the Object's one shall
+    // not be called, as it would bypass the overlay's resource_read
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3E), PATH("1234", "0"),
+                    NO_PAYLOAD);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID(0xFA3E),
+                            CONTENT_FORMAT(TLV), PAYLOAD("\xc1\x00\x64"
+                                                         "\xc1\x02\x66"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_module_uninstall(anjay, &BULK_OVERLAY_MODULE));
+    DM_TEST_FINISH;
+}
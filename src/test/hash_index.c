@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+AVS_UNIT_TEST(hash_index, empty) {
+    anjay_hash_index_t index = { NULL, 0, 0 };
+    AVS_UNIT_ASSERT_NULL(_anjay_hash_index_get(&index, 0));
+    AVS_UNIT_ASSERT_NULL(_anjay_hash_index_get(&index, 42));
+    _anjay_hash_index_clear(&index);
+    _anjay_hash_index_cleanup(&index);
+}
+
+AVS_UNIT_TEST(hash_index, put_get_replace) {
+    int values[1000];
+    anjay_hash_index_t index = { NULL, 0, 0 };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(values); ++i) {
+        // keys resembling aligned pointers, and zero
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_hash_index_put(&index, (uintptr_t) i * 16, &values[i]));
+    }
+    AVS_UNIT_ASSERT_EQUAL(index.size, AVS_ARRAY_SIZE(values));
+    AVS_UNIT_ASSERT_TRUE(index.capacity >= 2 * index.size);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(values); ++i) {
+        AVS_UNIT_ASSERT_TRUE(_anjay_hash_index_get(&index, (uintptr_t) i * 16)
+                             == &values[i]);
+        AVS_UNIT_ASSERT_NULL(
+                _anjay_hash_index_get(&index, (uintptr_t) i * 16 + 8));
+    }
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_hash_index_put(&index, 32, &values[0]));
+    AVS_UNIT_ASSERT_EQUAL(index.size, AVS_ARRAY_SIZE(values));
+    AVS_UNIT_ASSERT_TRUE(_anjay_hash_index_get(&index, 32) == &values[0]);
+
+    _anjay_hash_index_clear(&index);
+    AVS_UNIT_ASSERT_EQUAL(index.size, 0);
+    AVS_UNIT_ASSERT_NULL(_anjay_hash_index_get(&index, 32));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_hash_index_put(&index, 32, &values[1]));
+    AVS_UNIT_ASSERT_TRUE(_anjay_hash_index_get(&index, 32) == &values[1]);
+
+    _anjay_hash_index_cleanup(&index);
+    AVS_UNIT_ASSERT_NULL(index.entries);
+    AVS_UNIT_ASSERT_EQUAL(index.capacity, 0);
+}
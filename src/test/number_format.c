@@ -0,0 +1,170 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <float.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avsystem/commons/unit/test.h>
+
+static uint64_t xorshift64(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+#define ASSERT_INT64(Value, Expected) do { \
+    char buf[ANJAY_INT_STRING_BUF_SIZE]; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_int64_as_string((Value), buf), \
+                          sizeof(Expected) - 1); \
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, (Expected)); \
+} while (0)
+
+AVS_UNIT_TEST(number_format, int64) {
+    ASSERT_INT64(0, "0");
+    ASSERT_INT64(7, "7");
+    ASSERT_INT64(-7, "-7");
+    ASSERT_INT64(10, "10");
+    ASSERT_INT64(100, "100");
+    ASSERT_INT64(-4294967295LL, "-4294967295");
+    ASSERT_INT64(4294967296LL, "4294967296");
+    ASSERT_INT64(100000000000000000LL, "100000000000000000");
+    ASSERT_INT64(INT64_MAX, "9223372036854775807");
+    ASSERT_INT64(INT64_MIN, "-9223372036854775808");
+}
+
+#undef ASSERT_INT64
+
+AVS_UNIT_TEST(number_format, uint64) {
+    char buf[ANJAY_INT_STRING_BUF_SIZE];
+    AVS_UNIT_ASSERT_EQUAL(_anjay_uint64_as_string(UINT64_MAX, buf), 20);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "18446744073709551615");
+
+    char expected[ANJAY_INT_STRING_BUF_SIZE];
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < 10000; ++i) {
+        const uint64_t value = xorshift64(&state) >> (i % 64);
+        AVS_UNIT_ASSERT_EQUAL(_anjay_uint64_as_string(value, buf),
+                              (size_t) snprintf(expected, sizeof(expected),
+                                                "%" PRIu64, value));
+        AVS_UNIT_ASSERT_EQUAL_STRING(buf, expected);
+    }
+}
+
+#define ASSERT_DOUBLE(Value, Expected) do { \
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE]; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_double_as_string((Value), buf), \
+                          sizeof(Expected) - 1); \
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, (Expected)); \
+} while (0)
+
+AVS_UNIT_TEST(number_format, double_shortest) {
+    ASSERT_DOUBLE(0.0, "0");
+    ASSERT_DOUBLE(-0.0, "-0");
+    ASSERT_DOUBLE(1.0, "1");
+    ASSERT_DOUBLE(-1.5, "-1.5");
+    ASSERT_DOUBLE(0.1, "0.1");
+    ASSERT_DOUBLE(0.3, "0.3");
+    ASSERT_DOUBLE(1.2, "1.2");
+    ASSERT_DOUBLE(4053.125267029, "4053.125267029");
+    ASSERT_DOUBLE(10000000000000.5, "10000000000000.5");
+    ASSERT_DOUBLE(123456789012345678.0, "123456789012345680");
+    ASSERT_DOUBLE(1e21, "1e+21");
+    ASSERT_DOUBLE(0.000001, "0.000001");
+    ASSERT_DOUBLE(1e-7, "1e-07");
+    ASSERT_DOUBLE(3.26e+218, "3.26e+218");
+    ASSERT_DOUBLE(5e-324, "5e-324");
+    ASSERT_DOUBLE(DBL_MIN, "2.2250738585072014e-308");
+    ASSERT_DOUBLE(DBL_MAX, "1.7976931348623157e+308");
+    ASSERT_DOUBLE(NAN, "nan");
+    ASSERT_DOUBLE(INFINITY, "inf");
+    ASSERT_DOUBLE(-INFINITY, "-inf");
+}
+
+#undef ASSERT_DOUBLE
+
+static void assert_double_round_trip(double value) {
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE];
+    const size_t length = _anjay_double_as_string(value, buf);
+    AVS_UNIT_ASSERT_EQUAL(length, strlen(buf));
+    AVS_UNIT_ASSERT_TRUE(length < sizeof(buf));
+    const double parsed = strtod(buf, NULL);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(&parsed, &value, sizeof(value));
+}
+
+AVS_UNIT_TEST(number_format, double_round_trip) {
+    static const double VALUES[] = {
+        1e23, 9007199254740993.0, 0.1 + 0.2, 1.0 / 3.0, -2.0 / 3.0,
+        4.9406564584124654e-324, 2.2250738585072009e-308, DBL_EPSILON,
+        1.0 + DBL_EPSILON, 1e15, 1e16, 1e17, 1e20, 1e22, 1e-5, 1e-6, 1e-7,
+        5e-7, 123.456e-300, 1.7976931348623155e+308
+    };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(VALUES); ++i) {
+        assert_double_round_trip(VALUES[i]);
+        assert_double_round_trip(-VALUES[i]);
+    }
+
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < 100000; ++i) {
+        union {
+            double d;
+            uint64_t ieee;
+        } conv;
+        conv.ieee = xorshift64(&state);
+        if (isfinite(conv.d)) {
+            assert_double_round_trip(conv.d);
+        }
+    }
+}
+
+static void assert_float_round_trip(float value) {
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE];
+    const size_t length = _anjay_float_as_string(value, buf);
+    AVS_UNIT_ASSERT_EQUAL(length, strlen(buf));
+    AVS_UNIT_ASSERT_TRUE(length < sizeof(buf));
+    const float parsed = strtof(buf, NULL);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(&parsed, &value, sizeof(value));
+}
+
+AVS_UNIT_TEST(number_format, float) {
+    char buf[ANJAY_FLOAT_STRING_BUF_SIZE];
+    _anjay_float_as_string(0.1f, buf);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "0.1");
+    _anjay_float_as_string(2.15625f, buf);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "2.15625");
+    _anjay_float_as_string(4.223e+37f, buf);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "4.223e+37");
+    _anjay_float_as_string(FLT_MAX, buf);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "3.4028235e+38");
+    _anjay_float_as_string(1e-45f, buf);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "1e-45");
+
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < 100000; ++i) {
+        union {
+            float f;
+            uint32_t ieee;
+        } conv;
+        conv.ieee = (uint32_t) xorshift64(&state);
+        if (isfinite(conv.f)) {
+            assert_float_round_trip(conv.f);
+        }
+    }
+}
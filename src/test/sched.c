@@ -31,13 +31,14 @@ typedef struct {
 static sched_test_env_t setup_test(void) {
     _anjay_mock_clock_start(avs_time_monotonic_from_scalar(0, AVS_TIME_S));
     return (sched_test_env_t){
-        _anjay_sched_new(NULL)
+        _anjay_sched_new(NULL, 0)
     };
 }
 
 static void teardown_test(sched_test_env_t *env) {
-    _anjay_mock_clock_finish();
+    // _anjay_sched_delete() runs the scheduler, which reads the clock
     _anjay_sched_delete(&env->sched);
+    _anjay_mock_clock_finish();
 }
 
 AVS_UNIT_TEST(sched, sched_now) {
@@ -126,3 +127,127 @@ AVS_UNIT_TEST(sched, oneshot_job_handle_nullification) {
     AVS_UNIT_ASSERT_NULL(global.task);
     teardown_test(&env);
 }
+
+#define MANY_JOBS_COUNT 100000
+#define MANY_JOBS_DELAY_SPREAD 1000
+
+typedef struct {
+    int key;
+    int index;
+} many_jobs_key_t;
+
+typedef struct {
+    many_jobs_key_t last;
+    int executed;
+} many_jobs_state_t;
+
+typedef struct {
+    many_jobs_state_t *state;
+    many_jobs_key_t key;
+} many_jobs_arg_t;
+
+static void many_jobs_task(anjay_t *anjay, const void *arg_) {
+    (void) anjay;
+    const many_jobs_arg_t *arg = (const many_jobs_arg_t *) arg_;
+    // jobs must execute in order of their due time, and in scheduling order
+    // if due at the same time
+    AVS_UNIT_ASSERT_TRUE(arg->state->last.key < arg->key.key
+                         || (arg->state->last.key == arg->key.key
+                             && arg->state->last.index < arg->key.index));
+    arg->state->last = arg->key;
+    ++arg->state->executed;
+}
+
+AVS_UNIT_TEST(sched, many_jobs) {
+    sched_test_env_t env = setup_test();
+
+    anjay_sched_handle_t *handles = (anjay_sched_handle_t *)
+            avs_calloc(MANY_JOBS_COUNT, sizeof(anjay_sched_handle_t));
+    AVS_UNIT_ASSERT_NOT_NULL(handles);
+
+    many_jobs_state_t state = {
+        .last = { -1, -1 },
+        .executed = 0
+    };
+    for (int i = 0; i < MANY_JOBS_COUNT; ++i) {
+        many_jobs_arg_t arg = {
+            .state = &state,
+            .key = {
+                .key = (int) (((unsigned) i * 7919u) % MANY_JOBS_DELAY_SPREAD),
+                .index = i
+            }
+        };
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_sched(
+                env.sched, &handles[i],
+                avs_time_duration_from_scalar(arg.key.key + 1, AVS_TIME_S),
+                many_jobs_task, &arg, sizeof(arg)));
+    }
+    AVS_UNIT_ASSERT_EQUAL(env.sched->heap_size, MANY_JOBS_COUNT);
+
+    // cancel every other job, in an order unrelated to the due times
+    int cancelled = 0;
+    for (int i = MANY_JOBS_COUNT - 1; i >= 0; i -= 2) {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_del(env.sched, &handles[i]));
+        AVS_UNIT_ASSERT_NULL(handles[i]);
+        ++cancelled;
+    }
+    AVS_UNIT_ASSERT_EQUAL(env.sched->heap_size, MANY_JOBS_COUNT - cancelled);
+
+    _anjay_mock_clock_advance(
+            avs_time_duration_from_scalar(MANY_JOBS_DELAY_SPREAD + 1,
+                                          AVS_TIME_S));
+    AVS_UNIT_ASSERT_EQUAL(_anjay_sched_run(env.sched),
+                          MANY_JOBS_COUNT - cancelled);
+    AVS_UNIT_ASSERT_EQUAL(state.executed, MANY_JOBS_COUNT - cancelled);
+    AVS_UNIT_ASSERT_EQUAL(env.sched->heap_size, 0);
+    for (int i = 0; i < MANY_JOBS_COUNT; ++i) {
+        AVS_UNIT_ASSERT_NULL(handles[i]);
+    }
+
+    avs_free(handles);
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, pool) {
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(0, AVS_TIME_S));
+    anjay_sched_t *sched = _anjay_sched_new(NULL, 2);
+    AVS_UNIT_ASSERT_NOT_NULL(sched);
+
+    int counter = 0;
+    anjay_sched_handle_t tasks[3] = { NULL };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(tasks); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_sched_now(sched, &tasks[i], increment_task,
+                                 &(int *) { &counter }, sizeof(int *)));
+    }
+    uint64_t hits, misses;
+    _anjay_sched_pool_stats(sched, &hits, &misses);
+    AVS_UNIT_ASSERT_EQUAL(hits, 2);
+    AVS_UNIT_ASSERT_EQUAL(misses, 1);
+
+    // a slot released by cancelling a job is reused
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_del(sched, &tasks[0]));
+    anjay_sched_handle_t reused = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_sched_now(sched, &reused, increment_task,
+                             &(int *) { &counter }, sizeof(int *)));
+    _anjay_sched_pool_stats(sched, &hits, &misses);
+    AVS_UNIT_ASSERT_EQUAL(hits, 3);
+    AVS_UNIT_ASSERT_EQUAL(misses, 1);
+
+    AVS_UNIT_ASSERT_EQUAL(3, _anjay_sched_run(sched));
+    AVS_UNIT_ASSERT_EQUAL(3, counter);
+
+    // job data that does not fit in a slot is allocated on the heap
+    char big_data[ANJAY_SCHED_POOL_SLOT_DATA_SIZE + 1] = "";
+    anjay_sched_handle_t big = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(sched, &big, increment_task,
+                                             big_data, sizeof(big_data)));
+    _anjay_sched_pool_stats(sched, &hits, &misses);
+    AVS_UNIT_ASSERT_EQUAL(hits, 3);
+    AVS_UNIT_ASSERT_EQUAL(misses, 2);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_del(sched, &big));
+
+    _anjay_sched_delete(&sched);
+    _anjay_mock_clock_finish();
+}
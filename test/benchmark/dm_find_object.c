@@ -0,0 +1,105 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <anjay_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/time.h>
+
+#include <anjay/anjay.h>
+
+#include <anjay_modules/dm_utils.h>
+
+/*
+ * Measures the cost of looking up a registered Object by its OID, depending on
+ * the number of Objects registered in the data model.
+ */
+
+#define MAX_OBJECTS 256
+#define LOOKUPS_PER_RUN 1000000
+
+static anjay_oid_t oid_for_index(size_t index) {
+    // mix of standard and vendor-specific OIDs, registered out of order
+    return (anjay_oid_t) (index % 2 ? 10000 + index : 3 * index);
+}
+
+static double lookup_ns(anjay_t *anjay, size_t num_objects) {
+    volatile size_t found = 0;
+    const avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (size_t i = 0; i < LOOKUPS_PER_RUN; ++i) {
+        // every other lookup misses, to include the worst case of linear scans
+        anjay_oid_t oid = (i % 2) ? oid_for_index(i % num_objects)
+                                  : (anjay_oid_t) (65000 - i % num_objects);
+        if (_anjay_dm_find_object_by_oid(anjay, oid)) {
+            ++found;
+        }
+    }
+    double result;
+    if (avs_time_duration_to_scalar(
+                &result, AVS_TIME_NS,
+                avs_time_monotonic_diff(avs_time_monotonic_now(), start))) {
+        return -1.0;
+    }
+    return result / LOOKUPS_PER_RUN;
+}
+
+int main(void) {
+    static const anjay_configuration_t CONFIG = {
+        .endpoint_name = "urn:dev:os:anjay-benchmark"
+    };
+
+    anjay_t *anjay = anjay_new(&CONFIG);
+    anjay_dm_object_def_t *defs =
+            (anjay_dm_object_def_t *) avs_calloc(MAX_OBJECTS, sizeof(*defs));
+    const anjay_dm_object_def_t **def_ptrs = (const anjay_dm_object_def_t **)
+            avs_calloc(MAX_OBJECTS, sizeof(*def_ptrs));
+    int result = EXIT_FAILURE;
+    if (!anjay || !defs || !def_ptrs) {
+        fprintf(stderr, "out of memory\n");
+        goto finish;
+    }
+
+    printf("%10s %16s\n", "objects", "ns/lookup");
+    size_t registered = 0;
+    for (size_t num_objects = 1; num_objects <= MAX_OBJECTS;
+            num_objects *= 2) {
+        for (; registered < num_objects; ++registered) {
+            defs[registered].oid = oid_for_index(registered);
+            defs[registered].handlers.instance_it = anjay_dm_instance_it_SINGLE;
+            defs[registered].handlers.instance_present =
+                    anjay_dm_instance_present_SINGLE;
+            def_ptrs[registered] = &defs[registered];
+            if (anjay_register_object(anjay, &def_ptrs[registered])) {
+                fprintf(stderr, "could not register object /%u\n",
+                        (unsigned) defs[registered].oid);
+                goto finish;
+            }
+        }
+        printf("%10u %16.2f\n", (unsigned) num_objects,
+               lookup_ns(anjay, num_objects));
+    }
+    result = EXIT_SUCCESS;
+
+finish:
+    anjay_delete(anjay);
+    avs_free(def_ptrs);
+    avs_free(defs);
+    return result;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/time.h>
+
+#include <anjay/anjay.h>
+
+#include <anjay_modules/sched.h>
+
+/*
+ * Measures the cost of scheduling and cancelling jobs, depending on the number
+ * of jobs in the scheduler queue, both with and without the preallocated job
+ * pool.
+ */
+
+#define MAX_JOBS 65536
+
+static void noop_job(anjay_t *anjay, const void *data) {
+    (void) anjay; (void) data;
+}
+
+static double elapsed_ns(avs_time_monotonic_t start, size_t operations) {
+    double result;
+    if (avs_time_duration_to_scalar(
+                &result, AVS_TIME_NS,
+                avs_time_monotonic_diff(avs_time_monotonic_now(), start))) {
+        return -1.0;
+    }
+    return result / (double) operations;
+}
+
+static int run(anjay_sched_handle_t *handles,
+               size_t pool_size,
+               size_t num_jobs) {
+    const anjay_configuration_t config = {
+        .endpoint_name = "urn:dev:os:anjay-benchmark",
+        .sched_pool_size = pool_size
+    };
+    anjay_t *anjay = anjay_new(&config);
+    if (!anjay) {
+        fprintf(stderr, "could not create Anjay object\n");
+        return -1;
+    }
+    anjay_sched_t *sched = _anjay_sched_get(anjay);
+
+    // pseudo-random delays, so that insertions land all over the heap
+    uint32_t state = 2463534242U;
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (size_t i = 0; i < num_jobs; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        if (_anjay_sched(sched, &handles[i],
+                         avs_time_duration_from_scalar(1000 + state % 100000,
+                                                       AVS_TIME_S),
+                         noop_job, NULL, 0)) {
+            fprintf(stderr, "could not schedule job\n");
+            anjay_delete(anjay);
+            return -1;
+        }
+    }
+    const double sched_ns = elapsed_ns(start, num_jobs);
+
+    // cancel in an order unrelated to the heap layout
+    start = avs_time_monotonic_now();
+    for (size_t i = 0; i < num_jobs; i += 2) {
+        _anjay_sched_del(sched, &handles[i]);
+    }
+    for (size_t i = 1; i < num_jobs; i += 2) {
+        _anjay_sched_del(sched, &handles[i]);
+    }
+    const double del_ns = elapsed_ns(start, num_jobs);
+
+    printf("%10u %10u %16.2f %16.2f\n", (unsigned) pool_size,
+           (unsigned) num_jobs, sched_ns, del_ns);
+    anjay_delete(anjay);
+    return 0;
+}
+
+int main(void) {
+    anjay_sched_handle_t *handles = (anjay_sched_handle_t *)
+            avs_calloc(MAX_JOBS, sizeof(*handles));
+    if (!handles) {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    printf("%10s %10s %16s %16s\n", "pool size", "jobs", "ns/schedule",
+           "ns/cancel");
+    for (size_t num_jobs = 16; num_jobs <= MAX_JOBS; num_jobs *= 4) {
+        if (run(handles, 0, num_jobs) || run(handles, num_jobs, num_jobs)) {
+            result = EXIT_FAILURE;
+            break;
+        }
+    }
+    avs_free(handles);
+    return result;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream/stream_outbuf.h>
+#include <avsystem/commons/time.h>
+
+#include <anjay/anjay.h>
+
+#include "../../src/io_core.h"
+
+/*
+ * Measures the cost of encoding a Read of a whole Object as TLV, i.e. with
+ * every value nested in an Object Instance entry, and some of them
+ * additionally nested in Multiple Resource entries.
+ */
+
+#define RESOURCES_PER_INSTANCE 16
+#define MULTIPLE_RESOURCE_SIZE 8
+#define RUNS 100
+
+static size_t g_buffer_size;
+static char *g_buffer;
+
+static int encode_instance(anjay_output_ctx_t *out, anjay_iid_t iid) {
+    anjay_output_ctx_t *instance = NULL;
+    if (_anjay_output_set_id(out, ANJAY_ID_IID, iid)
+            || !(instance = _anjay_output_object_start(out))) {
+        return -1;
+    }
+    for (anjay_rid_t rid = 0; rid < RESOURCES_PER_INSTANCE; ++rid) {
+        if (_anjay_output_set_id(instance, ANJAY_ID_RID, rid)) {
+            return -1;
+        }
+        if (rid % 4) {
+            if (anjay_ret_i32(instance, 1000 * iid + rid)) {
+                return -1;
+            }
+            continue;
+        }
+        anjay_output_ctx_t *array = anjay_ret_array_start(instance);
+        if (!array) {
+            return -1;
+        }
+        for (anjay_riid_t riid = 0; riid < MULTIPLE_RESOURCE_SIZE; ++riid) {
+            if (anjay_ret_array_index(array, riid)
+                    || anjay_ret_string(array, "benchmark")) {
+                return -1;
+            }
+        }
+        if (anjay_ret_array_finish(array)) {
+            return -1;
+        }
+    }
+    return _anjay_output_object_finish(instance);
+}
+
+static double encode_us(size_t num_instances, size_t *out_size) {
+    const avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (size_t run = 0; run < RUNS; ++run) {
+        avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+        avs_stream_outbuf_set_buffer(&outbuf, g_buffer, g_buffer_size);
+        anjay_output_ctx_t *out =
+                _anjay_output_raw_tlv_create((avs_stream_abstract_t *) &outbuf);
+        if (!out) {
+            return -1.0;
+        }
+        int result = 0;
+        for (size_t i = 0; !result && i < num_instances; ++i) {
+            result = encode_instance(out, (anjay_iid_t) i);
+        }
+        if (_anjay_output_ctx_destroy(&out) || result) {
+            return -1.0;
+        }
+        *out_size = avs_stream_outbuf_offset(&outbuf);
+    }
+    double result;
+    if (avs_time_duration_to_scalar(
+                &result, AVS_TIME_US,
+                avs_time_monotonic_diff(avs_time_monotonic_now(), start))) {
+        return -1.0;
+    }
+    return result / RUNS;
+}
+
+int main(void) {
+    g_buffer_size = 16 * 1024 * 1024;
+    if (!(g_buffer = (char *) avs_malloc(g_buffer_size))) {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    printf("%10s %12s %16s\n", "instances", "bytes", "us/read");
+    for (size_t num_instances = 1; num_instances <= 1024;
+            num_instances *= 4) {
+        size_t size = 0;
+        double time = encode_us(num_instances, &size);
+        if (time < 0.0) {
+            fprintf(stderr, "encoding failed\n");
+            result = EXIT_FAILURE;
+            break;
+        }
+        printf("%10u %12lu %16.2f\n", (unsigned) num_instances,
+               (unsigned long) size, time);
+    }
+
+    avs_free(g_buffer);
+    return result;
+}
@@ -0,0 +1,53 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from framework.lwm2m_test import *
+
+
+class DtlsServersRegisterResponsesNotAwaited(test_suite.Lwm2mTest):
+    PSK_IDENTITY = b'test-identity'
+    PSK_KEY = b'test-key'
+    NUM_SERVERS = 3
+
+    def setUp(self):
+        self.setup_demo_with_servers(servers=[Lwm2mServer(coap.DtlsServer(psk_key=self.PSK_KEY,
+                                                                          psk_identity=self.PSK_IDENTITY))
+                                              for _ in range(self.NUM_SERVERS)],
+                                     extra_cmdline_args=['--identity',
+                                                         str(binascii.hexlify(self.PSK_IDENTITY), 'ascii'),
+                                                         '--key', str(binascii.hexlify(self.PSK_KEY), 'ascii')],
+                                     auto_register=False)
+
+    def runTest(self):
+        # DTLS handshakes with all servers shall be completed, and Register
+        # messages sent to all of them, without waiting for any response
+        for serv in self.servers:
+            serv.listen(timeout_s=5)
+
+        requests = [self.assertDemoRegisters(serv, respond=False)
+                    for serv in self.servers]
+
+        for serv, req in zip(self.servers, requests):
+            serv.send(Lwm2mCreated.matching(req)(location=self.DEFAULT_REGISTER_ENDPOINT))
+
+        # all servers are operational
+        for serv in self.servers:
+            req = Lwm2mRead('/3/0/0')
+            serv.send(req)
+            self.assertMsgEqual(Lwm2mContent.matching(req)(), serv.recv())
+
+    def tearDown(self):
+        self.teardown_demo_with_servers()
@@ -64,11 +64,9 @@ class SeparateResponseTest(test_suite.Lwm2mSingleServerTest):
 
         self.serv.send(invalid_req)
 
-        # it should trigger a Service Not Available response
-        self.assertMsgEqual(
-                Lwm2mErrorResponse.matching(invalid_req)(code=coap.Code.RES_SERVICE_UNAVAILABLE,
-                                                         options=ANY),
-                self.serv.recv())
+        # it does not match any request in progress, so it should be rejected
+        self.assertMsgEqual(Lwm2mReset.matching(invalid_req)(),
+                            self.serv.recv())
 
         # Separate Response: actual response
         req = Lwm2mChanged(msg_id=next(msg_id_generator),
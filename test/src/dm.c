@@ -59,6 +59,7 @@ avs_net_abstract_socket_t *_anjay_test_dm_install_socket(anjay_t *anjay,
     anjay->servers->servers->data_active.udp_connection.mode = ANJAY_CONNECTION_ONLINE;
     anjay->servers->servers->data_active.primary_conn_type = ANJAY_CONNECTION_UDP;
     anjay->servers->servers->data_active.registration_info.expire_time.since_real_epoch.seconds = INT64_MAX;
+    _anjay_servers_index_invalidate(anjay->servers);
     return _anjay_connection_internal_get_socket(
             &anjay->servers->servers->data_active.udp_connection);
 }
@@ -28,6 +28,14 @@ from typing import Mapping, Tuple, Optional
 from jinja2 import Environment
 
 C_OBJDEF_TEMPLATE = """\
+{% if resources %}
+static const anjay_dm_resource_op_mask_t OBJ_RID_OPERATIONS[] = {
+{% for res in resources %}
+    /* {{ res.name_upper }} */ {{ res.operations_mask }}{{ "" if loop.last else "," }}
+{% endfor %}
+};
+
+{% endif %}
 static const anjay_dm_object_def_t OBJ_DEF = {
     .oid = {{ oid }},
     .supported_rids = ANJAY_DM_SUPPORTED_RIDS(
@@ -43,7 +51,14 @@ static const anjay_dm_object_def_t OBJ_DEF = {
         {{ '.%s = %s' % handler }}{{ "" if loop.last else "," }}
 {% endif %}
 {% endfor %}
+{% if resources %}
+    },
+    .static_rids_info = {
+        .operations = OBJ_RID_OPERATIONS
+    }
+{% else %}
     }
+{% endif %}
 };
 """
 
@@ -56,12 +71,23 @@ const uint16_t OBJ_SUPPORTED_RIDS[] = {
 {% endfor %}
 };
 
+{% if resources %}
+const anjay_dm_resource_op_mask_t OBJ_RID_OPERATIONS[] = {
+{% for res in resources %}
+    /* {{ res.name_upper }} */ {{ res.operations_mask }}{{ "" if loop.last else "," }}
+{% endfor %}
+};
+
+{% endif %}
 struct ObjDef : public anjay_dm_object_def_t {
     ObjDef() :
             anjay_dm_object_def_t() {
         oid = {{ oid }};
         supported_rids.count = AVS_ARRAY_SIZE(OBJ_SUPPORTED_RIDS);
         supported_rids.rids = OBJ_SUPPORTED_RIDS;
+{% if resources %}
+        static_rids_info.operations = OBJ_RID_OPERATIONS;
+{% endif %}
 
 {% for handler in handlers %}
 {% if handler is string %}
@@ -452,6 +478,11 @@ class ResourceDef(collections.namedtuple('ResourceDef', ['rid', 'name', 'operati
     def name_upper(self) -> str:
         return _sanitize_macro_name('RID_' + self.name.upper())
 
+    @property
+    def operations_mask(self) -> str:
+        bits = ['ANJAY_DM_RESOURCE_OP_BIT_' + op for op in 'RWE' if op in self.operations]
+        return ' | '.join(bits) if bits else 'ANJAY_DM_RESOURCE_OP_NONE'
+
     @property
     def read_handler(self) -> Optional[str]:
         if 'R' not in self.operations: